@@ -6,8 +6,14 @@
 #include <vector>
 #include <numeric>
 #include <iostream>
+#include <iomanip>
 #include <algorithm>
 #include <unordered_map>
+#include <cstdint>
+#include <random>
+#include <chrono>
+
+#include "../12_DFT/dft.hpp"
 
 constexpr inline bool is_even(const std::size_t x) noexcept
 {
@@ -149,6 +155,249 @@ T mode(const std::vector<T>& data) noexcept
     return *mode_value;
 }
 
+/*
+    Kernel density estimation
+
+    https://en.wikipedia.org/wiki/Kernel_density_estimation
+    https://en.wikipedia.org/wiki/Kernel_(statistics)
+
+    f(x) = 1 / n * sum K_h(x - x_i), with K_h(u) = K(u / h) / h and h the bandwidth, the standard deviation of the kernel.
+
+    On a grid of G points the direct sum costs O(n G). Here the data are binned onto the grid in one pass,
+    each point split linearly between its two neighbours, then the counts are convolved with the kernel sampled
+    on the grid, through the FFT of dft.hpp: O(n + G log G). Binning moves points by at most half a step,
+    which is small against h when the grid is fine enough.
+*/
+
+enum KDEKernel : std::uint8_t
+{
+    KDEKernel_Gaussian,
+    KDEKernel_Epanechnikov,
+};
+
+const char* kde_kernel_to_string(std::uint8_t kernel)
+{
+    switch(kernel)
+    {
+        case KDEKernel_Gaussian:
+            return "Gaussian";
+        case KDEKernel_Epanechnikov:
+            return "Epanechnikov";
+        default:
+            return "Unknown Kernel";
+    }
+}
+
+/* Rules of thumb for the bandwidth, optimal for a normal distribution */
+enum KDEBandwidth : std::uint8_t
+{
+    KDEBandwidth_Silverman, /* 0.9 min(stdev, IQR / 1.34) n^(-1/5), robust to outliers and skew */
+    KDEBandwidth_Scott,     /* 1.06 stdev n^(-1/5) */
+};
+
+const char* kde_bandwidth_to_string(std::uint8_t rule)
+{
+    switch(rule)
+    {
+        case KDEBandwidth_Silverman:
+            return "Silverman";
+        case KDEBandwidth_Scott:
+            return "Scott";
+        default:
+            return "Unknown Bandwidth Rule";
+    }
+}
+
+/* Points of the grid, the default of R's density() */
+static constexpr std::size_t KDE_GRID_SIZE = 512;
+
+/* The grid goes that many bandwidths past the data, so that almost none of the mass falls off its ends */
+static constexpr double KDE_GRID_CUT = 3.0;
+
+/* The Gaussian kernel is cut at 4 standard deviations, what is left is below 1e-4 of the mass */
+static constexpr double KDE_GAUSSIAN_SUPPORT = 4.0;
+
+/* Epanechnikov kernel with unit standard deviation: 3 / (4 sqrt(5)) (1 - u² / 5) on |u| <= sqrt(5) */
+static constexpr double KDE_EPANECHNIKOV_SUPPORT = 2.2360679774997896;
+
+/* K(u) for a kernel of unit standard deviation */
+inline double kde_kernel(const KDEKernel kernel, const double u) noexcept
+{
+    switch(kernel)
+    {
+        case KDEKernel_Gaussian:
+            return std::exp(-0.5 * u * u) / std::sqrt(2.0 * M_PI);
+        case KDEKernel_Epanechnikov:
+            return std::abs(u) < KDE_EPANECHNIKOV_SUPPORT ? 0.75 * (1.0 - u * u / 5.0) / KDE_EPANECHNIKOV_SUPPORT : 0.0;
+        default:
+            return 0.0;
+    }
+}
+
+inline double kde_kernel_support(const KDEKernel kernel) noexcept
+{
+    return kernel == KDEKernel_Gaussian ? KDE_GAUSSIAN_SUPPORT : KDE_EPANECHNIKOV_SUPPORT;
+}
+
+/*
+    Bandwidth of rule for data. Samples too small for quartiles (n < 4) use the standard deviation alone,
+    samples without spread fall back to the magnitude of their value, or 1 for zeros, like R's bw.nrd0.
+    0 for an empty sample, which kde() rejects.
+*/
+template<typename T>
+double kde_bandwidth(const std::vector<T>& data, const KDEBandwidth rule = KDEBandwidth_Silverman) noexcept
+{
+    static_assert(std::is_arithmetic<T>::value, "Cannot compute bandwidth on non-arithmetic data");
+
+    if(data.empty())
+    {
+        return 0.0;
+    }
+
+    const double scale = std::pow(static_cast<double>(data.size()), -0.2);
+    const double sd = stdev(data);
+
+    double spread = sd;
+
+    /* A zero IQR leaves the standard deviation */
+    if(rule == KDEBandwidth_Silverman && data.size() >= 4)
+    {
+        const auto [low, med, up] = quartiles(data);
+
+        if(up > low)
+        {
+            spread = std::min(sd, (up - low) / 1.34);
+        }
+    }
+
+    /* No standard deviation: every value is data[0] */
+    if(spread <= 0.0)
+    {
+        spread = data[0] != 0 ? std::abs(static_cast<double>(data[0])) : 1.0;
+    }
+
+    return (rule == KDEBandwidth_Scott ? 1.06 : 0.9) * spread * scale;
+}
+
+/*
+    Convolution of a histogram of equal bins with a kernel of bandwidth bins standard deviation, normalized
+    to keep the total count. Bins past the ends count as empty.
+*/
+inline std::vector<double> smooth_histogram(const std::vector<double>& counts,
+                                            const double bandwidth,
+                                            const KDEKernel kernel = KDEKernel_Gaussian) noexcept
+{
+    if(counts.empty() || bandwidth <= 0.0)
+    {
+        return counts;
+    }
+
+    const std::size_t half = static_cast<std::size_t>(std::ceil(kde_kernel_support(kernel) * bandwidth));
+
+    std::vector<double> weights(2 * half + 1);
+
+    for(std::size_t i = 0; i < weights.size(); i++)
+    {
+        weights[i] = kde_kernel(kernel, (static_cast<double>(i) - static_cast<double>(half)) / bandwidth);
+    }
+
+    /* Sampled weights of a narrow kernel do not sum to 1 */
+    const double total = std::accumulate(weights.begin(), weights.end(), 0.0);
+
+    for(auto& w : weights)
+    {
+        w /= total;
+    }
+
+    /* Direct for short kernels, overlap-save FFT past FIR_DIRECT_MAX_TAPS taps */
+    const std::vector<double> full = convolve(counts, weights);
+
+    return std::vector<double>(full.begin() + static_cast<std::ptrdiff_t>(half),
+                               full.begin() + static_cast<std::ptrdiff_t>(half + counts.size()));
+}
+
+/* Density at x = min + i * step for the points i of the grid */
+struct KDEGrid
+{
+    double min;
+    double step;
+    std::vector<double> density;
+};
+
+template<typename T>
+KDEGrid kde(const std::vector<T>& data,
+            const double bandwidth,
+            const KDEKernel kernel = KDEKernel_Gaussian,
+            const std::size_t grid_size = KDE_GRID_SIZE) noexcept
+{
+    static_assert(std::is_arithmetic<T>::value, "Cannot compute density on non-arithmetic data");
+
+    if(data.empty() || grid_size < 2 || bandwidth <= 0.0)
+    {
+        return {};
+    }
+
+    const auto [data_min, data_max] = std::minmax_element(data.begin(), data.end());
+
+    KDEGrid grid;
+    grid.min = static_cast<double>(*data_min) - KDE_GRID_CUT * bandwidth;
+    grid.step = (static_cast<double>(*data_max) + KDE_GRID_CUT * bandwidth - grid.min) / static_cast<double>(grid_size - 1);
+
+    /* Linear binning, one pass */
+    std::vector<double> counts(grid_size, 0.0);
+
+    for(const auto& x : data)
+    {
+        const double position = (static_cast<double>(x) - grid.min) / grid.step;
+        const std::size_t i = std::min(static_cast<std::size_t>(position), grid_size - 2);
+        const double t = position - static_cast<double>(i);
+
+        counts[i] += 1.0 - t;
+        counts[i + 1] += t;
+    }
+
+    grid.density = smooth_histogram(counts, bandwidth / grid.step, kernel);
+
+    const double norm = 1.0 / (static_cast<double>(data.size()) * grid.step);
+
+    for(auto& d : grid.density)
+    {
+        d *= norm;
+    }
+
+    return grid;
+}
+
+template<typename T>
+KDEGrid kde(const std::vector<T>& data,
+            const KDEBandwidth rule = KDEBandwidth_Silverman,
+            const KDEKernel kernel = KDEKernel_Gaussian,
+            const std::size_t grid_size = KDE_GRID_SIZE) noexcept
+{
+    return kde(data, kde_bandwidth(data, rule), kernel, grid_size);
+}
+
+/* The O(n G) sum on the same grid, the reference for kde() */
+template<typename T>
+std::vector<double> kde_direct(const std::vector<T>& data, const KDEGrid& grid, const double bandwidth, const KDEKernel kernel) noexcept
+{
+    std::vector<double> density(grid.density.size(), 0.0);
+
+    for(std::size_t i = 0; i < density.size(); i++)
+    {
+        const double x = grid.min + static_cast<double>(i) * grid.step;
+
+        for(const auto& xi : data)
+        {
+            density[i] += kde_kernel(kernel, (x - static_cast<double>(xi)) / bandwidth);
+        }
+
+        density[i] /= static_cast<double>(data.size()) * bandwidth;
+    }
+
+    return density;
+}
+
 static constexpr std::size_t DATA_SIZE = 100000;
 
 int main(int argc, char** argv) noexcept
@@ -170,5 +419,64 @@ int main(int argc, char** argv) noexcept
     std::cout << "Range: " << range(data) << "\n";
     std::cout << "Mode: " << mode(data) << "\n";
 
+    /* Mixture of two normals, 70% around 0 and 30% around 5 */
+    std::mt19937 gen(42);
+    std::normal_distribution<double> low_mode(0.0, 1.0);
+    std::normal_distribution<double> high_mode(5.0, 0.5);
+    std::bernoulli_distribution pick_high(0.3);
+
+    std::vector<double> sample(DATA_SIZE);
+
+    for(auto& x : sample)
+    {
+        x = pick_high(gen) ? high_mode(gen) : low_mode(gen);
+    }
+
+    for(const KDEBandwidth rule : { KDEBandwidth_Silverman, KDEBandwidth_Scott })
+    {
+        std::cout << kde_bandwidth_to_string(rule) << " bandwidth: " << kde_bandwidth(sample, rule) << "\n";
+    }
+
+    /* Too small for quartiles, the bandwidth still follows the spread of the data */
+    for(const std::vector<double>& small : { std::vector<double>{ 2.5 },
+                                             std::vector<double>{ 100.0, 102.0 },
+                                             std::vector<double>{ 0.001, 0.002, 0.004 } })
+    {
+        std::cout << "Silverman bandwidth of " << small.size() << " points: " << kde_bandwidth(small) << "\n";
+    }
+
+    for(const KDEKernel kernel : { KDEKernel_Gaussian, KDEKernel_Epanechnikov })
+    {
+        const double bandwidth = kde_bandwidth(sample);
+
+        auto start = std::chrono::steady_clock::now();
+        const KDEGrid grid = kde(sample, bandwidth, kernel);
+        const double binned_time = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+        start = std::chrono::steady_clock::now();
+        const std::vector<double> direct = kde_direct(sample, grid, bandwidth, kernel);
+        const double direct_time = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+        double error = 0.0;
+        double peak = 0.0;
+
+        for(std::size_t i = 0; i < direct.size(); i++)
+        {
+            error = std::max(error, std::abs(grid.density[i] - direct[i]));
+            peak = std::max(peak, direct[i]);
+        }
+
+        std::cout << kde_kernel_to_string(kernel) << " KDE on " << grid.density.size() << " points: "
+                  << binned_time << " ms binned, " << direct_time << " ms direct, largest error "
+                  << error / peak << " of the peak\n";
+
+        /* The two modes, one row every 32 grid points */
+        for(std::size_t i = 0; i < grid.density.size(); i += 32)
+        {
+            std::cout << "  " << std::setw(6) << std::fixed << std::setprecision(2) << grid.min + static_cast<double>(i) * grid.step
+                      << std::defaultfloat << std::setprecision(6) << " " << std::string(static_cast<std::size_t>(grid.density[i] / peak * 60.0), '#') << "\n";
+        }
+    }
+
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,338 @@
+#pragma once
+
+#include <vector>
+#include <queue>
+#include <stack>
+#include <numeric>
+#include <limits>
+#include <cstdint>
+#include <cstddef>
+#include <algorithm>
+
+/*
+    Huffman tree builder, canonical code tables and the bit streams they are written to
+
+    https://en.wikipedia.org/wiki/Huffman_coding
+    https://en.wikipedia.org/wiki/Canonical_Huffman_code
+
+    Only the code lengths have to be stored with canonical codes: codes are given in order of length,
+    then symbol, each one the previous plus one, shifted left when the length grows (as in JPEG and Deflate).
+*/
+
+struct HuffmanNode
+{
+    static constexpr std::uint32_t NO_SYMBOL = 0;
+    static constexpr std::size_t NO_NODE = std::numeric_limits<std::size_t>::max();
+
+    std::size_t _left;
+    std::size_t _right;
+
+    std::size_t _frequency;
+
+    std::uint32_t _symbol;
+
+    char _padding[4]; /* For 32 bytes size */
+
+    HuffmanNode() : _left(NO_NODE),
+                    _right(NO_NODE),
+                    _frequency(0),
+                    _symbol(NO_SYMBOL)
+    {}
+
+    HuffmanNode(std::uint32_t symbol) : _left(NO_NODE),
+                                        _right(NO_NODE),
+                                        _frequency(0),
+                                        _symbol(symbol)
+    {}
+
+    HuffmanNode(std::size_t left, std::size_t right, std::size_t frequency) : _left(left),
+                                                                              _right(right),
+                                                                              _frequency(frequency),
+                                                                              _symbol(NO_SYMBOL)
+    {}
+
+    bool is_leaf() const noexcept { return this->_left == NO_NODE && this->_right == NO_NODE; }
+};
+
+/*
+    nodes holds the leaves with their frequencies, the internal nodes are appended to it by merging the
+    two least frequent nodes until one is left. Returns the index of the root, NO_NODE without leaves.
+*/
+inline std::size_t huffman_build_tree(std::vector<HuffmanNode>& nodes) noexcept
+{
+    auto comp = [&](const std::size_t lhs, const std::size_t rhs) { return nodes[lhs]._frequency > nodes[rhs]._frequency; };
+
+    std::vector<std::size_t> node_indices(nodes.size());
+    std::iota(node_indices.begin(), node_indices.end(), 0);
+
+    std::priority_queue<std::size_t, std::vector<std::size_t>, decltype(comp)> queue(node_indices.begin(), node_indices.end(), comp);
+
+    while(!queue.empty())
+    {
+        if(queue.size() == 1)
+        {
+            return queue.top();
+        }
+
+        std::size_t l = queue.top();
+        queue.pop();
+
+        std::size_t r = queue.top();
+        queue.pop();
+
+        nodes.emplace_back(l, r, nodes[l]._frequency + nodes[r]._frequency);
+
+        queue.push(nodes.size() - 1);
+    }
+
+    return HuffmanNode::NO_NODE;
+}
+
+/*
+    Code length of every symbol, 0 for the ones that never appear. A single used symbol still gets a 1 bit code.
+    With max_length != 0 no code is longer: while the tree is too deep, the frequencies are halved (rounded up)
+    and the tree rebuilt, flatter each time until every code fits.
+*/
+inline std::vector<std::uint8_t> huffman_code_lengths(const std::vector<std::size_t>& frequencies, const std::size_t max_length = 0) noexcept
+{
+    std::vector<std::uint8_t> lengths(frequencies.size(), 0);
+    std::vector<std::size_t> weights(frequencies);
+
+    while(true)
+    {
+        std::vector<HuffmanNode> nodes;
+
+        for(std::size_t symbol = 0; symbol < weights.size(); symbol++)
+        {
+            if(weights[symbol] > 0)
+            {
+                nodes.emplace_back(static_cast<std::uint32_t>(symbol));
+                nodes.back()._frequency = weights[symbol];
+            }
+        }
+
+        if(nodes.empty())
+        {
+            return lengths;
+        }
+
+        if(nodes.size() == 1)
+        {
+            lengths[nodes.front()._symbol] = 1;
+            return lengths;
+        }
+
+        const std::size_t root = huffman_build_tree(nodes);
+
+        std::size_t max_depth = 0;
+
+        std::stack<std::pair<std::size_t, std::size_t>> stack;
+        stack.emplace(root, 0);
+
+        while(!stack.empty())
+        {
+            const auto [node_index, depth] = stack.top();
+            stack.pop();
+
+            const HuffmanNode& node = nodes[node_index];
+
+            if(node.is_leaf())
+            {
+                lengths[node._symbol] = static_cast<std::uint8_t>(std::min<std::size_t>(depth, std::numeric_limits<std::uint8_t>::max()));
+                max_depth = std::max(max_depth, depth);
+                continue;
+            }
+
+            stack.emplace(node._left, depth + 1);
+            stack.emplace(node._right, depth + 1);
+        }
+
+        if(max_length == 0 || max_depth <= max_length)
+        {
+            return lengths;
+        }
+
+        for(auto& weight : weights)
+        {
+            weight = (weight + 1) / 2;
+        }
+    }
+}
+
+/* MSB first bit stream appended to a byte vector, the last byte is padded with 1 bits */
+class HuffmanBitWriter
+{
+    std::vector<std::uint8_t>* _bytes;
+    std::uint64_t _buffer;
+    std::size_t _bits;
+
+public:
+    explicit HuffmanBitWriter(std::vector<std::uint8_t>& bytes) : _bytes(&bytes), _buffer(0), _bits(0) {}
+
+    /* The length low bits of value, length <= 32 */
+    void put(const std::uint32_t value, const std::size_t length) noexcept
+    {
+        this->_buffer = (this->_buffer << length) | (value & ((std::uint64_t(1) << length) - 1));
+        this->_bits += length;
+
+        while(this->_bits >= 8)
+        {
+            this->_bits -= 8;
+            this->_bytes->push_back(static_cast<std::uint8_t>(this->_buffer >> this->_bits));
+        }
+    }
+
+    void flush() noexcept
+    {
+        if(this->_bits > 0)
+        {
+            this->put((1u << (8 - this->_bits)) - 1, 8 - this->_bits);
+        }
+
+        this->_buffer = 0;
+    }
+};
+
+/* Reads what HuffmanBitWriter wrote, past the end it reads 1 bits */
+class HuffmanBitReader
+{
+    const std::uint8_t* _data;
+    const std::uint8_t* _end;
+    std::uint64_t _buffer;
+    std::size_t _bits;
+
+    void _fill(const std::size_t count) noexcept
+    {
+        while(this->_bits < count)
+        {
+            const std::uint8_t byte = this->_data < this->_end ? *this->_data++ : 0xFF;
+
+            this->_buffer = (this->_buffer << 8) | byte;
+            this->_bits += 8;
+        }
+    }
+
+public:
+    HuffmanBitReader(const std::uint8_t* data, const std::size_t size) : _data(data), _end(data + size), _buffer(0), _bits(0) {}
+
+    /* The next count bits without consuming them, count <= 32 */
+    std::uint32_t peek(const std::size_t count) noexcept
+    {
+        this->_fill(count);
+
+        return static_cast<std::uint32_t>((this->_buffer >> (this->_bits - count)) & ((std::uint64_t(1) << count) - 1));
+    }
+
+    void skip(const std::size_t count) noexcept
+    {
+        this->_fill(count);
+        this->_bits -= count;
+    }
+
+    std::uint32_t read(const std::size_t count) noexcept
+    {
+        const std::uint32_t value = this->peek(count);
+        this->_bits -= count;
+        return value;
+    }
+};
+
+/* Longest code a HuffmanTable decodes, the limit of JPEG */
+static constexpr std::size_t HUFFMAN_MAX_LENGTH = 16;
+
+/* Codes up to this length are decoded with one lookup, longer ones length by length */
+static constexpr std::size_t HUFFMAN_LOOKUP_BITS = 9;
+
+/* Canonical codes of a set of code lengths (from huffman_code_lengths with max_length <= HUFFMAN_MAX_LENGTH) */
+class HuffmanTable
+{
+    std::vector<std::uint8_t> _lengths;
+    std::vector<std::uint32_t> _codes;
+
+    /* Per length: first code, number of codes and index of the first symbol in _sorted */
+    std::uint32_t _first[HUFFMAN_MAX_LENGTH + 1];
+    std::uint32_t _count[HUFFMAN_MAX_LENGTH + 1];
+    std::uint32_t _offset[HUFFMAN_MAX_LENGTH + 1];
+
+    /* Symbols by length, then value */
+    std::vector<std::uint32_t> _sorted;
+
+    /* Indexed by the next HUFFMAN_LOOKUP_BITS bits: symbol << 8 | length, 0 when the code is longer */
+    std::vector<std::uint32_t> _lookup;
+
+public:
+    explicit HuffmanTable(const std::vector<std::uint8_t>& lengths) : _lengths(lengths),
+                                                                      _codes(lengths.size(), 0),
+                                                                      _lookup(std::size_t(1) << HUFFMAN_LOOKUP_BITS, 0)
+    {
+        std::uint32_t code = 0;
+
+        for(std::size_t length = 1; length <= HUFFMAN_MAX_LENGTH; length++)
+        {
+            this->_first[length] = code;
+            this->_count[length] = 0;
+            this->_offset[length] = static_cast<std::uint32_t>(this->_sorted.size());
+
+            for(std::size_t symbol = 0; symbol < lengths.size(); symbol++)
+            {
+                if(lengths[symbol] != length)
+                {
+                    continue;
+                }
+
+                this->_codes[symbol] = code;
+                this->_sorted.push_back(static_cast<std::uint32_t>(symbol));
+                this->_count[length]++;
+
+                if(length <= HUFFMAN_LOOKUP_BITS)
+                {
+                    const std::size_t shift = HUFFMAN_LOOKUP_BITS - length;
+
+                    for(std::size_t i = 0; i < (std::size_t(1) << shift); i++)
+                    {
+                        this->_lookup[(code << shift) | i] = static_cast<std::uint32_t>(symbol << 8 | length);
+                    }
+                }
+
+                code++;
+            }
+
+            code <<= 1;
+        }
+    }
+
+    const std::vector<std::uint8_t>& lengths() const noexcept { return this->_lengths; }
+
+    void encode(HuffmanBitWriter& writer, const std::uint32_t symbol) const noexcept
+    {
+        writer.put(this->_codes[symbol], this->_lengths[symbol]);
+    }
+
+    std::uint32_t decode(HuffmanBitReader& reader) const noexcept
+    {
+        const std::uint32_t entry = this->_lookup[reader.peek(HUFFMAN_LOOKUP_BITS)];
+
+        if(entry != 0)
+        {
+            reader.skip(entry & 0xFF);
+            return entry >> 8;
+        }
+
+        const std::uint32_t bits = reader.peek(HUFFMAN_MAX_LENGTH);
+
+        for(std::size_t length = HUFFMAN_LOOKUP_BITS + 1; length <= HUFFMAN_MAX_LENGTH; length++)
+        {
+            const std::uint32_t code = bits >> (HUFFMAN_MAX_LENGTH - length);
+
+            if(code - this->_first[length] < this->_count[length])
+            {
+                reader.skip(length);
+                return this->_sorted[this->_offset[length] + code - this->_first[length]];
+            }
+        }
+
+        /* Not a code of this table, corrupted stream */
+        reader.skip(HUFFMAN_MAX_LENGTH);
+        return 0;
+    }
+};
@@ -4,56 +4,18 @@
 
 #include <vector>
 #include <string>
-#include <queue>
 #include <unordered_map>
-#include <stack>
 #include <iostream>
-#include <numeric>
+
+#include "huffman.hpp"
 
 class Huffman
 {
-private:
-    struct Node 
-    {
-        static constexpr char NO_SYMBOL = 0;
-        static constexpr std::size_t NO_NODE = std::numeric_limits<std::size_t>::max();
-
-        std::size_t _left;
-        std::size_t _right;
-
-        std::size_t _frequency;
-
-        char _symbol;
-
-        char _padding[7]; /* For 32 bytes size */
-
-        Node() : _left(NO_NODE),
-                 _right(NO_NODE),
-                 _frequency(0),
-                 _symbol(NO_SYMBOL)
-        {}
-
-        Node(char symbol) : _left(NO_NODE),
-                            _right(NO_NODE),
-                            _frequency(0),
-                            _symbol(symbol)
-        {}
-
-        Node(std::size_t left, std::size_t right, std::uint32_t frequency) : _left(left),
-                                                                             _right(right),
-                                                                             _frequency(frequency),
-                                                                             _symbol(NO_SYMBOL)
-        {}
-
-        bool is_leaf() const noexcept { return this->_left == NO_NODE && this->_right == NO_NODE; }
-    };
-
 public:
     static std::string encode(const std::string& str) noexcept
     {
-        std::vector<Node> nodes;
+        std::vector<HuffmanNode> nodes;
         std::unordered_map<char, std::string> codes;
-        std::size_t root = Node::NO_NODE;
 
         std::unordered_map<char, std::size_t> char_mapping;
 
@@ -61,50 +23,26 @@ public:
         {
             if(char_mapping.find(c) == char_mapping.end())            
             {
-                nodes.emplace_back(c);
+                nodes.emplace_back(static_cast<std::uint32_t>(c));
                 char_mapping[c] = nodes.size() - 1;
             }
 
             nodes[char_mapping[c]]._frequency++;
         }
 
-        auto comp = [&](const std::size_t lhs, const std::size_t rhs) { return nodes[lhs]._frequency > nodes[rhs]._frequency; };
-
-        std::vector<std::size_t> node_indices(nodes.size());
-        std::iota(node_indices.begin(), node_indices.end(), 0);
-
-        std::priority_queue<std::size_t, std::vector<std::size_t>, decltype(comp)> queue(node_indices.begin(), node_indices.end(), comp);
-
-        while(!queue.empty())
-        {
-            if(queue.size() == 1)
-            {
-                root = queue.top();
-                break;
-            }
-
-            std::size_t l = queue.top();
-            queue.pop();
-
-            std::size_t r = queue.top();
-            queue.pop();
-
-            nodes.emplace_back(l, r, nodes[l]._frequency + nodes[r]._frequency);
-
-            queue.push(nodes.size() - 1);
-        }
+        const std::size_t root = huffman_build_tree(nodes);
 
         auto traverse = [&](auto&& self, std::size_t node_index, std::string code) -> void {
-            if(node_index == Node::NO_NODE || node_index >= nodes.size())
+            if(node_index == HuffmanNode::NO_NODE || node_index >= nodes.size())
             {
                 return;
             }
 
-            const Node& node = nodes[node_index];
+            const HuffmanNode& node = nodes[node_index];
 
             if(node.is_leaf())
             {
-                codes[node._symbol] = std::move(code);
+                codes[static_cast<char>(node._symbol)] = std::move(code);
                 return;
             }
 
@@ -223,6 +223,465 @@ void runCompilationBenchmark(const std::vector<TestCase>& test_cases, int iterat
     }
 }
 
+/* Expands body{min,max} into body...body(body?)..., or body...body(body*) when max < 0, for comparison with the counter based bytecode */
+std::string unrollRepetition(const std::string& body, int min, int max) noexcept
+{
+    std::string unrolled;
+
+    for(int i = 0; i < (max < 0 ? min + 1 : max); ++i)
+    {
+        unrolled += body;
+
+        if(max < 0 && i == min)
+        {
+            unrolled += "*";
+        }
+        else if(i >= min)
+        {
+            unrolled += "?";
+        }
+    }
+
+    return unrolled;
+}
+
+/* Every string of up to max_length characters taken from alphabet */
+std::vector<std::string> generateAllStrings(const std::string& alphabet, std::size_t max_length) noexcept
+{
+    std::vector<std::string> result = { "" };
+
+    for(std::size_t begin = 0; result.back().size() < max_length; )
+    {
+        const std::size_t end = result.size();
+
+        for(std::size_t i = begin; i < end; ++i)
+        {
+            for(const char c : alphabet)
+            {
+                result.push_back(result[i] + c);
+            }
+        }
+
+        begin = end;
+    }
+
+    return result;
+}
+
+/*
+    The counted bytecode (REPEATINIT / REPEATLOOP) against the same pattern unrolled, both run on the bytecode vm,
+    and the NFA program against std::regex. Prints the patterns that disagree on any string.
+*/
+void runCountedRepetitionChecks() noexcept
+{
+    std::cout << "\n" << std::string(60, '=') << std::endl;
+    std::cout << "Counted repetition checks" << std::endl;
+    std::cout << std::string(60, '=') << std::endl;
+
+    struct Repetition
+    {
+        std::string prefix;
+        std::string body;
+        int min;
+        int max; /* < 0 for {min,} */
+        std::string suffix;
+    };
+
+    const std::vector<Repetition> repetitions = {
+        { "", "(a|b)", 3, 3, "" },
+        { "", "(ab|c)", 2, -1, "" },
+        { "", "(a|b)", 0, 3, "" },
+        { "", "(a|b)", 2, 2, "c" },
+        { "", "a", 2, 4, "b" },
+        { "", "[ab]", 1, 3, "c?" },
+        { "", "(a|b)", 0, 1, "(a|b)" },
+        { "", "((a|b){2})", 1, 2, "c" },
+    };
+
+    const std::vector<std::string> strings = generateAllStrings("abc", 7);
+
+    std::size_t failures = 0;
+
+    for(const auto& [prefix, body, min, max, suffix] : repetitions)
+    {
+        const std::string bounds = "{" + std::to_string(min) + (max == min ? "" : "," + (max < 0 ? "" : std::to_string(max))) + "}";
+        const std::string counted_pattern = prefix + body + bounds + suffix;
+        const std::string unrolled_pattern = prefix + unrollRepetition(body, min, max) + suffix;
+
+        const Regex counted_regex(counted_pattern, false);
+        const Regex unrolled_regex(unrolled_pattern, false);
+        const std::regex std_regex(counted_pattern);
+
+        std::size_t vm_mismatches = 0;
+        std::size_t std_mismatches = 0;
+
+        for(const auto& test_str : strings)
+        {
+            RegexVM counted_vm(counted_regex.bytecode(), test_str);
+            RegexVM unrolled_vm(unrolled_regex.bytecode(), test_str);
+
+            vm_mismatches += regex_exec(&counted_vm) != regex_exec(&unrolled_vm);
+
+            RegexCaptures captures;
+
+            std_mismatches += counted_regex.match(test_str, captures) !=
+                              std::regex_search(test_str, std_regex, std::regex_constants::match_continuous);
+        }
+
+        std::cout << std::left << std::setw(20) << counted_pattern << std::right
+                  << " counted vs unrolled bytecode: " << vm_mismatches << " mismatches,"
+                  << " NFA vs std::regex: " << std_mismatches << " mismatches" << std::endl;
+
+        failures += vm_mismatches + std_mismatches;
+    }
+
+    /*
+        Bodies that can match empty, the counted loop must stop instead of spinning up to the maximum.
+        Then bodies that can fail after consuming input: the bytecode vm does not give the input back,
+        so its counted and unrolled forms may stop at different places, only the NFA program is checked.
+    */
+    for(const char* pattern : { "(a*){2,}b", "(a?){3,5}b", "(a*|b){2,}c", "c(a|bc){1,3}a", "(a(b|c)){0,2}" })
+    {
+        const Regex regex(pattern, false);
+        const std::regex std_regex(pattern);
+
+        std::size_t std_mismatches = 0;
+
+        for(const auto& test_str : strings)
+        {
+            RegexCaptures captures;
+            RegexVM vm(regex.bytecode(), test_str);
+
+            regex_exec(&vm);
+
+            std_mismatches += regex.match(test_str, captures) !=
+                              std::regex_search(test_str, std_regex, std::regex_constants::match_continuous);
+        }
+
+        std::cout << std::left << std::setw(20) << pattern << std::right
+                  << " NFA vs std::regex:                            " << std_mismatches << " mismatches" << std::endl;
+
+        failures += std_mismatches;
+    }
+
+    /* Malformed or overflowing bounds are compile errors, not empty matches */
+    for(const char* pattern : { "a{9999999999}", "a{2,1}", "a{,}", "a{1,2,3}", "a{x}" })
+    {
+        const Regex regex(pattern, false);
+
+        failures += !regex.bytecode().empty();
+    }
+
+    /* Too large for the NFA program: only patterns the greedy vm runs exactly still compile */
+    for(const char* pattern : { "[ab]{0,40000}b", "(a|ab){1,40000}c" })
+    {
+        failures += Regex(pattern, false).valid();
+    }
+
+    const Regex large_greedy("[0-9]{1,40000}x", false);
+
+    failures += !large_greedy.valid() || !large_greedy.search("a123x") || large_greedy.search("a123");
+
+    std::cout << (failures == 0 ? "All counted repetition checks passed" : "Counted repetition checks FAILED") << std::endl;
+}
+
+void runCountedRepetitionBenchmark(const std::string& body, int min, int max, int iterations = 1000) noexcept
+{
+    const std::string counted_pattern = body + "{" + std::to_string(min) + "," + std::to_string(max) + "}";
+    const std::string unrolled_pattern = unrollRepetition(body, min, max);
+
+    const std::vector<std::string> test_strings = generateNumericStrings(100, min, max);
+
+    std::cout << "\n" << std::string(60, '=') << std::endl;
+    std::cout << "Counted repetition: " << counted_pattern << std::endl;
+    std::cout << std::string(60, '=') << std::endl;
+
+    BenchmarkTimer timer;
+
+    timer.start();
+    Regex counted_regex(counted_pattern, false);
+    double counted_compilation_time = timer.elapsed_ms();
+
+    timer.start();
+    Regex unrolled_regex(unrolled_pattern, false);
+    double unrolled_compilation_time = timer.elapsed_ms();
+
+    timer.start();
+
+    for(int i = 0; i < iterations; ++i) 
+    {
+        for(const auto& test_str : test_strings) 
+        {
+            counted_regex.match(test_str);
+        }
+    }
+
+    double counted_time = timer.elapsed_ms();
+
+    timer.start();
+
+    for(int i = 0; i < iterations; ++i) 
+    {
+        for(const auto& test_str : test_strings) 
+        {
+            unrolled_regex.match(test_str);
+        }
+    }
+
+    double unrolled_time = timer.elapsed_ms();
+
+    timer.start();
+
+    std::regex std_regex(counted_pattern);
+
+    for(int i = 0; i < iterations; ++i) 
+    {
+        for(const auto& test_str : test_strings) 
+        {
+            std::regex_match(test_str, std_regex);
+        }
+    }
+
+    double std_time = timer.elapsed_ms();
+
+    std::cout << std::fixed << std::setprecision(2);
+    std::cout << "Counted bytecode:  " << counted_regex.bytecode().size() << " bytes, compiled in " << counted_compilation_time << " ms" << std::endl;
+    std::cout << "Unrolled bytecode: " << unrolled_regex.bytecode().size() << " bytes, compiled in " << unrolled_compilation_time << " ms" << std::endl;
+    std::cout << "Custom Regex (counted):  " << counted_time << " ms" << std::endl;
+    std::cout << "Custom Regex (unrolled): " << unrolled_time << " ms" << std::endl;
+    std::cout << "std::regex:              " << std_time << " ms" << std::endl;
+}
+
+/* Escapes: classes, control characters and punctuation, anything else is a compile error */
+void runEscapeChecks() noexcept
+{
+    std::cout << "\n" << std::string(60, '=') << std::endl;
+    std::cout << "Escape checks" << std::endl;
+    std::cout << std::string(60, '=') << std::endl;
+
+    struct EscapeCase
+    {
+        std::string pattern;
+        std::string str;
+        bool expected;
+    };
+
+    const std::vector<EscapeCase> cases = {
+        { "\\w+", "www", true },
+        { "\\w+", "_a9", true },
+        { "\\w", "!", false },
+        { "\\W", "!", true },
+        { "\\s", "s", false },
+        { "\\s", " ", true },
+        { "\\S", " ", false },
+        { "\\D", "5", false },
+        { "\\D", "x", true },
+        { "a\\tb", "a\tb", true },
+        { "a\\.b", "axb", false },
+        { "a\\.b", "a.b", true },
+        { "[\\w.]+x", "a.bx", true },
+        { "[^\\s]", " ", false },
+    };
+
+    std::size_t failures = 0;
+
+    for(const auto& [pattern, str, expected] : cases)
+    {
+        const Regex regex(pattern, false);
+        RegexCaptures captures;
+
+        if(regex.match(str, captures) != expected)
+        {
+            std::cout << "Wrong result for " << pattern << " on \"" << str << "\"" << std::endl;
+            failures++;
+        }
+    }
+
+    for(const char* pattern : { "\\q", "\\1", "[\\q]", "a\\" })
+    {
+        failures += !Regex(pattern, false).bytecode().empty();
+    }
+
+    std::cout << (failures == 0 ? "All escape checks passed" : "Escape checks FAILED") << std::endl;
+}
+
+/*
+    match and search without captures run the bytecode vm when greedy matching is exact and the NFA engines otherwise,
+    with captures always the NFA engines: they must agree with each other and with std::regex
+*/
+void runEngineAgreementChecks() noexcept
+{
+    std::cout << "\n" << std::string(60, '=') << std::endl;
+    std::cout << "Engine agreement checks" << std::endl;
+    std::cout << std::string(60, '=') << std::endl;
+
+    const std::vector<std::string> patterns = {
+        "a*ab", "ab|cd", "x.*y", "(a|ab)(c|bcd)(d*)", "a+b", "[a-c]*d", "^ab", "cd$", "\\bab", "(ab)*c", "a?b?c", "(a|b){2,3}d",
+        "[ab]{1,3}c?d", "b*\\bc", "[^a]+a", "x{2}y*", "a*b{0,2}", "a*a", "[a-c]+[b-d]",
+        "[a-c]+\\B", "x[a-c]*\\B", "a.*", ".*(b)", ".*ab.*", "x.*(d)y?"
+    };
+
+    const std::vector<std::string> strings = generateAllStrings("abcdxy ", 5);
+
+    std::size_t failures = 0;
+
+    for(const auto& pattern : patterns)
+    {
+        const Regex regex(pattern, false);
+        const std::regex std_regex(pattern);
+
+        std::size_t match_mismatches = 0;
+        std::size_t search_mismatches = 0;
+
+        for(const auto& test_str : strings)
+        {
+            RegexCaptures captures;
+            std::smatch std_match;
+
+            const bool match = regex.match(test_str);
+            const bool search = regex.search(test_str);
+
+            /* captures[0] is the whole match, leading and trailing .* included */
+            match_mismatches += match != regex.match(test_str, captures) ||
+                                match != std::regex_search(test_str, std_match, std_regex, std::regex_constants::match_continuous) ||
+                                (match && captures[0] != std::string_view(test_str).substr(static_cast<std::size_t>(std_match.position(0)),
+                                                                                            static_cast<std::size_t>(std_match.length(0))));
+
+            search_mismatches += search != regex.search(test_str, captures) ||
+                                 search != std::regex_search(test_str, std_match, std_regex) ||
+                                 (search && captures[0] != std::string_view(test_str).substr(static_cast<std::size_t>(std_match.position(0)),
+                                                                                              static_cast<std::size_t>(std_match.length(0))));
+        }
+
+        std::cout << std::left << std::setw(20) << pattern << std::right
+                  << " match: " << match_mismatches << " mismatches, search: " << search_mismatches << " mismatches" << std::endl;
+
+        failures += match_mismatches + search_mismatches;
+    }
+
+    std::cout << (failures == 0 ? "All engine agreement checks passed" : "Engine agreement checks FAILED") << std::endl;
+}
+
+/* Unanchored search on long inputs, where anchors and .* stripping let the engine skip most of the input */
+void runSearchBenchmark(const std::string& pattern, const std::vector<std::string>& test_strings, int iterations = 10) noexcept
+{
+    std::cout << "\n" << std::string(60, '=') << std::endl;
+    std::cout << "Search: " << pattern << std::endl;
+    std::cout << std::string(60, '=') << std::endl;
+
+    BenchmarkTimer timer;
+
+    Regex custom_regex(pattern, false);
+    std::size_t custom_matches = 0;
+
+    timer.start();
+
+    for(int i = 0; i < iterations; ++i) 
+    {
+        for(const auto& test_str : test_strings) 
+        {
+            custom_matches += custom_regex.search(test_str);
+        }
+    }
+
+    double custom_time = timer.elapsed_ms();
+
+    std::regex std_regex(pattern);
+    std::size_t std_matches = 0;
+
+    timer.start();
+
+    for(int i = 0; i < iterations; ++i) 
+    {
+        for(const auto& test_str : test_strings) 
+        {
+            std_matches += std::regex_search(test_str, std_regex);
+        }
+    }
+
+    double std_time = timer.elapsed_ms();
+
+    std::cout << std::fixed << std::setprecision(2);
+    std::cout << "Custom Regex search: " << custom_time << " ms (" << custom_matches << " matches)" << std::endl;
+    std::cout << "std::regex_search:   " << std_time << " ms (" << std_matches << " matches)" << std::endl;
+}
+
+/* Short inputs with captures, where the bounded backtracker should beat the Pike VM */
+void runCapturesBenchmark(const std::string& pattern, const std::vector<std::string>& test_strings, int iterations = 1000) noexcept
+{
+    std::cout << "\n" << std::string(60, '=') << std::endl;
+    std::cout << "Captures: " << pattern << std::endl;
+    std::cout << std::string(60, '=') << std::endl;
+
+    BenchmarkTimer timer;
+
+    Regex custom_regex(pattern, false);
+    std::vector<std::size_t> slots(2 * (custom_regex.num_groups() + 1));
+    std::size_t backtrack_matches = 0;
+    std::size_t pikevm_matches = 0;
+    std::size_t dispatch_matches = 0;
+    std::size_t std_matches = 0;
+
+    timer.start();
+
+    for(int i = 0; i < iterations; ++i) 
+    {
+        for(const auto& test_str : test_strings) 
+        {
+            backtrack_matches += regex_backtrack(custom_regex.program(), test_str, true, slots);
+        }
+    }
+
+    double backtrack_time = timer.elapsed_ms();
+
+    timer.start();
+
+    for(int i = 0; i < iterations; ++i) 
+    {
+        for(const auto& test_str : test_strings) 
+        {
+            pikevm_matches += regex_pikevm(custom_regex.program(), test_str, true, slots);
+        }
+    }
+
+    double pikevm_time = timer.elapsed_ms();
+
+    RegexCaptures captures;
+
+    timer.start();
+
+    for(int i = 0; i < iterations; ++i) 
+    {
+        for(const auto& test_str : test_strings) 
+        {
+            dispatch_matches += custom_regex.match(test_str, captures);
+        }
+    }
+
+    double dispatch_time = timer.elapsed_ms();
+
+    std::regex std_regex(pattern);
+    std::smatch std_captures;
+
+    timer.start();
+
+    for(int i = 0; i < iterations; ++i) 
+    {
+        for(const auto& test_str : test_strings) 
+        {
+            std_matches += std::regex_search(test_str, std_captures, std_regex, std::regex_constants::match_continuous);
+        }
+    }
+
+    double std_time = timer.elapsed_ms();
+
+    std::cout << std::fixed << std::setprecision(2);
+    std::cout << "Bounded backtracker: " << backtrack_time << " ms (" << backtrack_matches << " matches)" << std::endl;
+    std::cout << "Pike VM:             " << pikevm_time << " ms (" << pikevm_matches << " matches)" << std::endl;
+    std::cout << "Dispatched:          " << dispatch_time << " ms (" << dispatch_matches << " matches)" << std::endl;
+    std::cout << "std::regex:          " << std_time << " ms (" << std_matches << " matches)" << std::endl;
+}
+
 int main(int argc, char** argv) noexcept 
 {
     std::cout << "Regex Performance Benchmark" << std::endl;
@@ -304,6 +763,27 @@ int main(int argc, char** argv) noexcept
     }
     
     runCompilationBenchmark(test_cases);
+
+    runEscapeChecks();
+    runCountedRepetitionChecks();
+    runEngineAgreementChecks();
+
+    runCountedRepetitionBenchmark("[0-9]", 4, 16);
+    runCountedRepetitionBenchmark("[0-9]", 1, 100);
+    /* The unrolled pattern runs on the NFA engines, a thousand optional steps make it orders of magnitude slower */
+    runCountedRepetitionBenchmark("[0-9]", 1, 1000, 2);
+
+    const std::vector<std::string> long_strings = generateMixedStrings(100, 1000, 2000);
+
+    runSearchBenchmark("^[0-9]+", long_strings);
+    runSearchBenchmark("[0-9][0-9][0-9]$", long_strings);
+    runSearchBenchmark("\\bzz[0-9]", long_strings);
+
+    /* std::regex is quadratic here, keep it short */
+    runSearchBenchmark(".*zz[0-9].*", long_strings, 1);
+
+    runCapturesBenchmark("([a-z]+)([0-9]+)", generateMixedStrings(100, 5, 25));
+    runCapturesBenchmark("(a|ab)(c|bcd)(d*)", { "abcd", "acd", "abcdddd", "abd", "ab" }, 10000);
     
     std::cout << "\n" << std::string(60, '=') << std::endl;
     std::cout << "BENCHMARK COMPLETE" << std::endl;
@@ -0,0 +1,353 @@
+/*
+    grep-like driver built on regex.hpp, made to scan multi-GB files:
+
+    - the file is memory-mapped, lines are never copied into a std::string
+    - the mapping is split into newline-aligned chunks, one per thread
+    - line boundaries are found 32 (AVX2) or 16 (SSE2) bytes at a time
+    - when the regex starts with a literal, we jump from one literal occurrence to the next
+      and only run the vm on the lines that contain it
+    - matched lines are collected per chunk and printed in file order
+
+    g++ grep.cpp -o grep -std=c++23 -O3 -march=native -pthread
+
+    Usage: grep [-c] [-s|--stats] <pattern> <file> [num_threads]
+
+    -c prints the number of matching lines instead of the lines, -s prints the scan time and throughput on stderr.
+    Like grep, exits with 0 when a line matched, 1 when none did and 2 on an invalid pattern or an unreadable file.
+*/
+
+#include <vector>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <chrono>
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <cerrno>
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+#include "regex.hpp"
+
+class MappedFile
+{
+    const char* _data;
+    std::size_t _size;
+    int _fd;
+
+    /* On errors, so that valid() is false */
+    void _close() noexcept
+    {
+        close(this->_fd);
+        this->_fd = -1;
+    }
+
+public:
+    MappedFile(const char* path) noexcept : _data(nullptr), _size(0), _fd(-1)
+    {
+        this->_fd = open(path, O_RDONLY);
+
+        if(this->_fd < 0)
+        {
+            std::format_to(STDERR, "Cannot open file: {}\n", path);
+            return;
+        }
+
+        struct stat st;
+
+        if(fstat(this->_fd, &st) != 0)
+        {
+            std::format_to(STDERR, "Cannot read the size of file: {}: {}\n", path, std::strerror(errno));
+            this->_close();
+            return;
+        }
+
+        /* The only valid file without a mapping */
+        if(st.st_size == 0)
+        {
+            return;
+        }
+
+        void* data = mmap(nullptr, static_cast<std::size_t>(st.st_size), PROT_READ, MAP_PRIVATE, this->_fd, 0);
+
+        if(data == MAP_FAILED)
+        {
+            std::format_to(STDERR, "Cannot map file: {}: {}\n", path, std::strerror(errno));
+            this->_close();
+            return;
+        }
+
+        /* We read the whole file once, front to back. The advice values are not flags, each needs its own call */
+        if(madvise(data, static_cast<std::size_t>(st.st_size), MADV_SEQUENTIAL) != 0)
+        {
+            std::format_to(STDERR, "madvise(MADV_SEQUENTIAL) failed on {}: {}\n", path, std::strerror(errno));
+        }
+
+        if(madvise(data, static_cast<std::size_t>(st.st_size), MADV_WILLNEED) != 0)
+        {
+            std::format_to(STDERR, "madvise(MADV_WILLNEED) failed on {}: {}\n", path, std::strerror(errno));
+        }
+
+        this->_data = static_cast<const char*>(data);
+        this->_size = static_cast<std::size_t>(st.st_size);
+    }
+
+    ~MappedFile() noexcept
+    {
+        if(this->_data != nullptr)
+        {
+            munmap(const_cast<char*>(this->_data), this->_size);
+        }
+
+        if(this->_fd >= 0)
+        {
+            close(this->_fd);
+        }
+    }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    MappedFile(MappedFile&&) = delete;
+    MappedFile& operator=(MappedFile&&) = delete;
+
+    /* False when the file could not be opened, sized or mapped, an empty file is valid */
+    bool valid() const noexcept { return this->_fd >= 0; }
+
+    const char* data() const noexcept { return this->_data; }
+    std::size_t size() const noexcept { return this->_size; }
+};
+
+/* Returns a pointer to the next '\n' in [begin, end), or end if there is none */
+inline const char* find_newline(const char* begin, const char* end) noexcept
+{
+#if defined(__AVX2__)
+    const __m256i newlines = _mm256_set1_epi8('\n');
+
+    while(end - begin >= 32)
+    {
+        const __m256i bytes = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(begin));
+        const std::uint32_t mask = static_cast<std::uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(bytes, newlines)));
+
+        if(mask != 0)
+        {
+            return begin + __builtin_ctz(mask);
+        }
+
+        begin += 32;
+    }
+#elif defined(__SSE2__)
+    const __m128i newlines = _mm_set1_epi8('\n');
+
+    while(end - begin >= 16)
+    {
+        const __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(begin));
+        const std::uint32_t mask = static_cast<std::uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(bytes, newlines)));
+
+        if(mask != 0)
+        {
+            return begin + __builtin_ctz(mask);
+        }
+
+        begin += 16;
+    }
+#endif
+
+    const void* nl = std::memchr(begin, '\n', static_cast<std::size_t>(end - begin));
+
+    return nl != nullptr ? static_cast<const char*>(nl) : end;
+}
+
+/* Returns the start of the line containing pos, without going before lower_bound */
+inline const char* find_line_start(const char* lower_bound, const char* pos) noexcept
+{
+    while(pos > lower_bound && pos[-1] != '\n')
+    {
+        pos--;
+    }
+
+    return pos;
+}
+
+void grep_chunk(const Regex& regex,
+                const char* begin,
+                const char* end,
+                std::vector<std::string_view>& matches) noexcept
+{
+    const std::string& prefix = regex.literal_prefix();
+
+    const char* line = begin;
+
+    if(!prefix.empty())
+    {
+        while(line < end)
+        {
+            const std::string_view remaining(line, static_cast<std::size_t>(end - line));
+            const std::size_t found = remaining.find(prefix);
+
+            if(found == std::string_view::npos)
+            {
+                break;
+            }
+
+            const char* line_start = find_line_start(line, line + found);
+            const char* line_end = find_newline(line + found, end);
+
+            const std::string_view candidate(line_start, static_cast<std::size_t>(line_end - line_start));
+
+            if(regex.search(candidate))
+            {
+                matches.push_back(candidate);
+            }
+
+            line = line_end + 1;
+        }
+
+        return;
+    }
+
+    while(line < end)
+    {
+        const char* line_end = find_newline(line, end);
+
+        const std::string_view candidate(line, static_cast<std::size_t>(line_end - line));
+
+        if(regex.search(candidate))
+        {
+            matches.push_back(candidate);
+        }
+
+        line = line_end + 1;
+    }
+}
+
+int main(int argc, char** argv) noexcept
+{
+    int arg = 1;
+    bool count_only = false;
+    bool print_stats = false;
+
+    for(; argc > arg; arg++)
+    {
+        if(std::strcmp(argv[arg], "-c") == 0)
+        {
+            count_only = true;
+        }
+        else if(std::strcmp(argv[arg], "-s") == 0 || std::strcmp(argv[arg], "--stats") == 0)
+        {
+            print_stats = true;
+        }
+        else
+        {
+            break;
+        }
+    }
+
+    if(argc - arg < 2)
+    {
+        std::format_to(STDERR, "Usage: {} [-c] [-s|--stats] <pattern> <file> [num_threads]\n", argv[0]);
+        return 2;
+    }
+
+    const Regex regex(argv[arg]);
+
+    if(!regex.valid())
+    {
+        return 2;
+    }
+
+    const MappedFile file(argv[arg + 1]);
+
+    if(!file.valid())
+    {
+        return 2;
+    }
+
+    std::size_t num_threads = argc - arg > 2 ? std::strtoul(argv[arg + 2], nullptr, 10) :
+                                               std::thread::hardware_concurrency();
+
+    /* Not worth spawning threads for chunks smaller than a few pages */
+    num_threads = std::clamp<std::size_t>(num_threads, 1, std::max<std::size_t>(1, file.size() / (1 << 16)));
+
+    const auto start = std::chrono::steady_clock::now();
+
+    const char* data = file.data();
+    const char* data_end = file.data() + file.size();
+
+    std::vector<const char*> boundaries(num_threads + 1, data_end);
+    boundaries[0] = data;
+
+    for(std::size_t i = 1; i < num_threads; i++)
+    {
+        const char* split = std::max(boundaries[i - 1], data + (file.size() / num_threads) * i);
+        const char* nl = find_newline(split, data_end);
+
+        boundaries[i] = nl < data_end ? nl + 1 : data_end;
+    }
+
+    std::vector<std::vector<std::string_view>> matches(num_threads);
+    std::vector<std::thread> workers;
+    workers.reserve(num_threads);
+
+    for(std::size_t i = 0; i < num_threads; i++)
+    {
+        workers.emplace_back(grep_chunk,
+                             std::cref(regex),
+                             boundaries[i],
+                             boundaries[i + 1],
+                             std::ref(matches[i]));
+    }
+
+    for(auto& worker : workers)
+    {
+        worker.join();
+    }
+
+    std::size_t num_matches = 0;
+
+    for(const auto& chunk_matches : matches)
+    {
+        num_matches += chunk_matches.size();
+
+        if(count_only)
+        {
+            continue;
+        }
+
+        for(const auto& line : chunk_matches)
+        {
+            std::fwrite(line.data(), 1, line.size(), stdout);
+            std::fputc('\n', stdout);
+        }
+    }
+
+    if(count_only)
+    {
+        std::format_to(STDOUT, "{}\n", num_matches);
+    }
+
+    std::fflush(stdout);
+
+    if(print_stats)
+    {
+        const double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        std::format_to(STDERR,
+                       "Scanned {} bytes in {}s ({} MB/s, {} threads, {} matches)\n",
+                       file.size(),
+                       elapsed,
+                       static_cast<double>(file.size()) / (elapsed * 1e6),
+                       num_threads,
+                       num_matches);
+    }
+
+    return num_matches > 0 ? 0 : 1;
+}
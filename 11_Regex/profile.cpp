@@ -0,0 +1,42 @@
+/*
+    Prints execution counters and a hot-instruction listing for a pattern run over a corpus, one input per line.
+
+    g++ profile.cpp -o profile -std=c++23 -O2 -march=native
+
+    Usage: profile <pattern> <corpus file>
+*/
+
+#define REGEX_PROFILE
+
+#include <fstream>
+
+#include "regex.hpp"
+
+int main(int argc, char** argv) noexcept
+{
+    if(argc < 3)
+    {
+        std::format_to(STDERR, "Usage: {} <pattern> <corpus file>\n", argv[0]);
+        return 1;
+    }
+
+    std::ifstream file(argv[2]);
+
+    if(!file)
+    {
+        std::format_to(STDERR, "Cannot open file: {}\n", argv[2]);
+        return 1;
+    }
+
+    std::vector<std::string> corpus;
+    std::string line;
+
+    while(std::getline(file, line))
+    {
+        corpus.push_back(std::move(line));
+    }
+
+    regex_profile(argv[1], corpus);
+
+    return 0;
+}
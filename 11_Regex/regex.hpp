@@ -1,12 +1,21 @@
 #include <vector>
 #include <string>
+#include <string_view>
 #include <iostream>
 #include <cstdint>
 #include <stack>
+#include <array>
 #include <format>
 #include <cctype>
 #include <tuple>
 #include <cassert>
+#include <cstring>
+#include <limits>
+#include <algorithm>
+
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
 
 static std::ostream_iterator<char> STDOUT(std::cout);
 static std::ostream_iterator<char> STDERR(std::cerr);
@@ -24,6 +33,7 @@ enum RegexOperatorType : std::uint16_t
     RegexOperatorType_ZeroOrMore,
     RegexOperatorType_OneOrMore,
     RegexOperatorType_ZeroOrOne,
+    RegexOperatorType_Repeat, /* {m}, {m,}, {m,n} */
 };
 
 const char* regex_operator_type_to_string(std::uint16_t op)
@@ -40,6 +50,8 @@ const char* regex_operator_type_to_string(std::uint16_t op)
             return "OneOrMore";
         case RegexOperatorType_ZeroOrOne:
             return "ZeroOrOne";
+        case RegexOperatorType_Repeat:
+            return "Repeat";
         default:
             return "Unknown Operator";
     }
@@ -67,6 +79,402 @@ const char* regex_character_type_to_string(std::uint16_t c)
     }
 }
 
+enum RegexAssertionType : std::uint16_t
+{
+    RegexAssertionType_Begin, /* ^ */
+    RegexAssertionType_End, /* $ */
+    RegexAssertionType_WordBoundary, /* \b */
+    RegexAssertionType_NotWordBoundary, /* \B */
+};
+
+const char* regex_assertion_type_to_string(std::uint16_t a)
+{
+    switch(a)
+    {
+        case RegexAssertionType_Begin:
+            return "Begin";
+        case RegexAssertionType_End:
+            return "End";
+        case RegexAssertionType_WordBoundary:
+            return "WordBoundary";
+        case RegexAssertionType_NotWordBoundary:
+            return "NotWordBoundary";
+        default:
+            return "Unknown Assertion";
+    }
+}
+
+inline bool is_word_char(const char c) noexcept
+{
+    return static_cast<unsigned char>(c - 'a') < 26 ||
+           static_cast<unsigned char>(c - 'A') < 26 ||
+           static_cast<unsigned char>(c - '0') < 10 ||
+           c == '_';
+}
+
+/* UTF-8 */
+
+/* 
+    Codepoint classes are compiled into byte-level automata (as RE2 and Rust regex do): 
+    a codepoint range is split into sequences of byte ranges that all have the same encoded length,
+    so the vm only ever compares raw bytes and never decodes the input.
+*/
+
+static constexpr char32_t UTF8_MAX_CODEPOINT = 0x10FFFF;
+static constexpr char32_t UTF8_MAX_ASCII = 0x7F;
+
+/* Returns the length of the sequence starting with this byte, 0 if it cannot start a sequence */
+inline std::uint32_t utf8_sequence_length(const unsigned char lead) noexcept
+{
+    if(lead < 0x80) return 1;
+    if(lead >= 0xC2 && lead <= 0xDF) return 2;
+    if(lead >= 0xE0 && lead <= 0xEF) return 3;
+    if(lead >= 0xF0 && lead <= 0xF4) return 4;
+    return 0;
+}
+
+inline char32_t utf8_decode(const char* data, const std::uint32_t len) noexcept
+{
+    static constexpr unsigned char lead_masks[5] = { 0x00, 0x7F, 0x1F, 0x0F, 0x07 };
+
+    char32_t cp = static_cast<unsigned char>(data[0]) & lead_masks[len];
+
+    for(std::uint32_t i = 1; i < len; i++)
+    {
+        cp = (cp << 6) | (static_cast<unsigned char>(data[i]) & 0x3F);
+    }
+
+    return cp;
+}
+
+inline std::uint32_t utf8_encode(const char32_t cp, std::uint8_t* out) noexcept
+{
+    if(cp <= 0x7F)
+    {
+        out[0] = static_cast<std::uint8_t>(cp);
+        return 1;
+    }
+
+    if(cp <= 0x7FF)
+    {
+        out[0] = static_cast<std::uint8_t>(0xC0 | (cp >> 6));
+        out[1] = static_cast<std::uint8_t>(0x80 | (cp & 0x3F));
+        return 2;
+    }
+
+    if(cp <= 0xFFFF)
+    {
+        out[0] = static_cast<std::uint8_t>(0xE0 | (cp >> 12));
+        out[1] = static_cast<std::uint8_t>(0x80 | ((cp >> 6) & 0x3F));
+        out[2] = static_cast<std::uint8_t>(0x80 | (cp & 0x3F));
+        return 3;
+    }
+
+    out[0] = static_cast<std::uint8_t>(0xF0 | (cp >> 18));
+    out[1] = static_cast<std::uint8_t>(0x80 | ((cp >> 12) & 0x3F));
+    out[2] = static_cast<std::uint8_t>(0x80 | ((cp >> 6) & 0x3F));
+    out[3] = static_cast<std::uint8_t>(0x80 | (cp & 0x3F));
+    return 4;
+}
+
+using CodepointRange = std::pair<char32_t, char32_t>;
+
+/* A sequence of byte ranges, matching len bytes */
+struct Utf8Sequence
+{
+    std::array<std::pair<std::uint8_t, std::uint8_t>, 4> ranges;
+    std::uint8_t len;
+};
+
+void utf8_split_range(const char32_t lo, const char32_t hi, std::vector<Utf8Sequence>& sequences) noexcept
+{
+    if(lo > hi)
+    {
+        return;
+    }
+
+    /* Surrogates cannot be encoded */
+    if(lo < 0xD800 && hi > 0xDFFF)
+    {
+        utf8_split_range(lo, 0xD7FF, sequences);
+        utf8_split_range(0xE000, hi, sequences);
+        return;
+    }
+
+    /* Split at encoded length changes */
+    for(const char32_t max_of_len : { 0x7F, 0x7FF, 0xFFFF })
+    {
+        if(lo <= max_of_len && hi > max_of_len)
+        {
+            utf8_split_range(lo, max_of_len, sequences);
+            utf8_split_range(max_of_len + 1, hi, sequences);
+            return;
+        }
+    }
+
+    /* Split until every byte position is an independent range */
+    for(std::uint32_t i = 1; i < 4; i++)
+    {
+        const char32_t mask = (static_cast<char32_t>(1) << (6 * i)) - 1;
+
+        if((lo & ~mask) != (hi & ~mask))
+        {
+            if((lo & mask) != 0)
+            {
+                utf8_split_range(lo, lo | mask, sequences);
+                utf8_split_range((lo | mask) + 1, hi, sequences);
+                return;
+            }
+
+            if((hi & mask) != mask)
+            {
+                utf8_split_range(lo, (hi & ~mask) - 1, sequences);
+                utf8_split_range(hi & ~mask, hi, sequences);
+                return;
+            }
+        }
+    }
+
+    std::uint8_t lo_bytes[4];
+    std::uint8_t hi_bytes[4];
+
+    Utf8Sequence sequence;
+    sequence.len = static_cast<std::uint8_t>(utf8_encode(lo, lo_bytes));
+    utf8_encode(hi, hi_bytes);
+
+    for(std::uint32_t i = 0; i < sequence.len; i++)
+    {
+        sequence.ranges[i] = std::make_pair(lo_bytes[i], hi_bytes[i]);
+    }
+
+    sequences.push_back(sequence);
+}
+
+/* Sorts and merges overlapping or adjacent ranges */
+std::vector<CodepointRange> normalize_ranges(std::vector<CodepointRange> ranges) noexcept
+{
+    std::sort(ranges.begin(), ranges.end());
+
+    std::vector<CodepointRange> merged;
+
+    for(const auto& range : ranges)
+    {
+        if(!merged.empty() && range.first <= merged.back().second + 1)
+        {
+            merged.back().second = std::max(merged.back().second, range.second);
+        }
+        else
+        {
+            merged.push_back(range);
+        }
+    }
+
+    return merged;
+}
+
+/* Complement of normalized ranges in [0, max_codepoint] */
+std::vector<CodepointRange> negate_ranges(const std::vector<CodepointRange>& ranges, const char32_t max_codepoint) noexcept
+{
+    std::vector<CodepointRange> negated;
+    char32_t next = 0;
+
+    for(const auto& [lo, hi] : ranges)
+    {
+        if(lo > max_codepoint)
+        {
+            break;
+        }
+
+        if(lo > next)
+        {
+            negated.emplace_back(next, lo - 1);
+        }
+
+        next = hi + 1;
+    }
+
+    if(next <= max_codepoint)
+    {
+        negated.emplace_back(next, max_codepoint);
+    }
+
+    return negated;
+}
+
+/* Inside of the character class of an escape like \d, nullptr if the escape is not a class */
+inline const char* regex_escape_class(const char c) noexcept
+{
+    switch(c)
+    {
+        case 'd':
+            return "0-9";
+        case 'D':
+            return "^0-9";
+        case 'w':
+            return "a-zA-Z0-9_";
+        case 'W':
+            return "^a-zA-Z0-9_";
+        case 's':
+            return " \t\n\r\f\v";
+        case 'S':
+            return "^ \t\n\r\f\v";
+        default:
+            return nullptr;
+    }
+}
+
+/* 
+    Byte matched by an escape that is not a class: a control character like \n, or an escaped ASCII
+    punctuation character, matched literally. nullptr for any other escape, which is an error
+*/
+inline const char* regex_escape_char(const char* c) noexcept
+{
+    switch(*c)
+    {
+        case 'n':
+            return "\n";
+        case 't':
+            return "\t";
+        case 'r':
+            return "\r";
+        case 'f':
+            return "\f";
+        case 'v':
+            return "\v";
+        default:
+            return std::ispunct(static_cast<unsigned char>(*c)) && static_cast<unsigned char>(*c) < 0x80 ? c : nullptr;
+    }
+}
+
+/* 
+    Parses the inside of a character class, e.g. "^a-zA-Z_\dé-ö"
+    Returns success, whether the class is negated and its normalized codepoint ranges
+*/
+std::tuple<bool, bool, std::vector<CodepointRange>> parse_character_class(std::string_view data) noexcept
+{
+    std::vector<CodepointRange> ranges;
+    bool negated = false;
+
+    std::size_t i = 0;
+
+    if(!data.empty() && data[0] == '^')
+    {
+        negated = true;
+        i++;
+    }
+
+    /* Reads one codepoint, returns false on invalid UTF-8 */
+    auto read_codepoint = [&](char32_t& cp) -> bool {
+        const std::uint32_t len = utf8_sequence_length(static_cast<unsigned char>(data[i]));
+
+        if(len == 0 || i + len > data.size())
+        {
+            return false;
+        }
+
+        cp = utf8_decode(data.data() + i, len);
+        i += len;
+
+        return true;
+    };
+
+    while(i < data.size())
+    {
+        char32_t lo;
+
+        if(data[i] == '\\' && i + 1 < data.size())
+        {
+            i++;
+
+            if(const char* escape_class = regex_escape_class(data[i]); escape_class != nullptr)
+            {
+                const auto [class_valid, class_negated, class_ranges] = parse_character_class(escape_class);
+                const std::vector<CodepointRange> added = class_negated ? negate_ranges(class_ranges, UTF8_MAX_CODEPOINT) : class_ranges;
+
+                ranges.insert(ranges.end(), added.begin(), added.end());
+                i++;
+                continue;
+            }
+
+            const char* escaped = regex_escape_char(data.data() + i);
+
+            if(escaped == nullptr)
+            {
+                return std::make_tuple(false, negated, ranges);
+            }
+
+            lo = static_cast<unsigned char>(*escaped);
+            i++;
+        }
+        else if(!read_codepoint(lo))
+        {
+            return std::make_tuple(false, negated, ranges);
+        }
+
+        char32_t hi = lo;
+
+        if(i + 1 < data.size() && data[i] == '-')
+        {
+            i++;
+
+            if(!read_codepoint(hi) || hi < lo)
+            {
+                return std::make_tuple(false, negated, ranges);
+            }
+        }
+
+        ranges.emplace_back(lo, hi);
+    }
+
+    const bool valid = !ranges.empty();
+
+    return std::make_tuple(valid, negated, normalize_ranges(std::move(ranges)));
+}
+
+/* Input analysis */
+
+/* Checks the high bit of every byte, 32 (AVX2) or 16 (SSE2) bytes at a time */
+inline bool is_ascii(std::string_view str) noexcept
+{
+    const char* data = str.data();
+    std::size_t i = 0;
+
+#if defined(__AVX2__)
+    __m256i acc = _mm256_setzero_si256();
+
+    for(; i + 32 <= str.size(); i += 32)
+    {
+        acc = _mm256_or_si256(acc, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i)));
+    }
+
+    if(_mm256_movemask_epi8(acc) != 0)
+    {
+        return false;
+    }
+#elif defined(__SSE2__)
+    __m128i acc = _mm_setzero_si128();
+
+    for(; i + 16 <= str.size(); i += 16)
+    {
+        acc = _mm_or_si128(acc, _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i)));
+    }
+
+    if(_mm_movemask_epi8(acc) != 0)
+    {
+        return false;
+    }
+#endif
+
+    unsigned char acc_tail = 0;
+
+    for(; i < str.size(); i++)
+    {
+        acc_tail |= static_cast<unsigned char>(data[i]);
+    }
+
+    return acc_tail < 0x80;
+}
+
 /* Lexing / Parsing */
 
 enum RegexTokenType : std::uint32_t
@@ -76,6 +484,7 @@ enum RegexTokenType : std::uint32_t
     RegexTokenType_Operator,
     RegexTokenType_GroupBegin,
     RegexTokenType_GroupEnd,
+    RegexTokenType_Assertion,
     RegexTokenType_Invalid,
 };
 
@@ -85,7 +494,7 @@ struct RegexToken
     const char* data;
     std::uint32_t data_len;
     std::uint16_t type;
-    std::uint16_t encoding; /* Either RegexOperatorType or RegexCharacterType */
+    std::uint16_t encoding; /* Either RegexOperatorType, RegexCharacterType or RegexAssertionType */
 
     RegexToken() : data(nullptr), data_len(0), type(RegexTokenType_Invalid), encoding(0) {}
 
@@ -175,6 +584,12 @@ struct RegexToken
                 break;
             }
 
+            case RegexTokenType_Assertion:
+            {
+                std::format_to(STDOUT, "ASSERT({})", regex_assertion_type_to_string(this->encoding));
+                break;
+            }
+
             case RegexTokenType_Invalid:
             {
                 std::format_to(STDOUT, "INVALID");
@@ -190,6 +605,61 @@ struct RegexToken
     }
 };
 
+static constexpr std::uint32_t REPEAT_INFINITE = std::numeric_limits<std::int32_t>::max();
+
+/* Parses the inside of a counted repetition: "m", "m,", "m,n" or ",n" */
+std::tuple<bool, std::uint32_t, std::uint32_t> parse_repeat_bounds(std::string_view bounds) noexcept
+{
+    std::uint32_t values[2] = { 0, REPEAT_INFINITE };
+    bool has_value[2] = { false, false };
+    std::size_t current = 0;
+
+    for(const char c : bounds)
+    {
+        if(c == ',')
+        {
+            if(current == 1)
+            {
+                return std::make_tuple(false, 0u, 0u);
+            }
+
+            current = 1;
+            values[1] = 0;
+        }
+        else if(c >= '0' && c <= '9')
+        {
+            const std::uint32_t digit = static_cast<std::uint32_t>(c - '0');
+
+            /* Checked before multiplying, values[current] * 10 could wrap around */
+            if(values[current] > (REPEAT_INFINITE - 1 - digit) / 10)
+            {
+                return std::make_tuple(false, 0u, 0u);
+            }
+
+            values[current] = values[current] * 10 + digit;
+            has_value[current] = true;
+        }
+        else
+        {
+            return std::make_tuple(false, 0u, 0u);
+        }
+    }
+
+    if(current == 0)
+    {
+        /* {m} */
+        return std::make_tuple(has_value[0], values[0], values[0]);
+    }
+
+    if(!has_value[1])
+    {
+        /* {m,} */
+        return std::make_tuple(has_value[0], values[0], REPEAT_INFINITE);
+    }
+
+    return std::make_tuple(values[0] <= values[1], values[0], values[1]);
+}
+
 std::tuple<bool, std::vector<RegexToken>> lex_regex(const std::string& regex) noexcept
 {
     std::vector<RegexToken> tokens;
@@ -199,7 +669,29 @@ std::tuple<bool, std::vector<RegexToken>> lex_regex(const std::string& regex) no
 
     while(i < regex.size())
     {
-        if(std::isalnum(regex[i]) || regex[i] == '_')
+        if(static_cast<unsigned char>(regex[i]) >= 0x80)
+        {
+            const std::uint32_t len = utf8_sequence_length(static_cast<unsigned char>(regex[i]));
+
+            if(len == 0 || i + len > regex.size())
+            {
+                std::format_to(STDERR, "Invalid UTF-8 in regular expression at byte {}\n", i);
+                return std::make_tuple(false, tokens);
+            }
+
+            if(need_concat)
+            {
+                tokens.emplace_back(nullptr, 0u, RegexTokenType_Operator, RegexOperatorType_Concatenate);
+            }
+
+            tokens.emplace_back(regex.data() + i, len, RegexTokenType_Character, RegexCharacterType_Single);
+            need_concat = true;
+
+            i += len;
+            continue;
+        }
+
+        if(std::isalnum(regex[i]) || regex[i] == '_' || regex[i] == '-')
         {
             if(need_concat)
             {
@@ -238,28 +730,113 @@ std::tuple<bool, std::vector<RegexToken>> lex_regex(const std::string& regex) no
                     break;
                 }
 
-                case '.':
+                case '{':
                 {
-                    if(need_concat)
+                    const char* start = regex.data() + ++i;
+
+                    while(i < regex.size() && regex[i] != '}')
                     {
-                        tokens.emplace_back(nullptr, 0u, RegexTokenType_Operator, RegexOperatorType_Concatenate);
+                        i++;
                     }
 
-                    tokens.emplace_back(regex.data() + i, 1u, RegexTokenType_Character, RegexCharacterType_Any);
-                    need_concat = true;
+                    if(i >= regex.size())
+                    {
+                        std::format_to(STDERR, "Unclosed counted repetition in regular expression\n");
+                        return std::make_tuple(false, tokens);
+                    }
+
+                    const std::uint32_t bounds_len = static_cast<std::uint32_t>((regex.data() + i) - start);
+
+                    if(!std::get<0>(parse_repeat_bounds(std::string_view(start, bounds_len))))
+                    {
+                        std::format_to(STDERR, "Invalid counted repetition in regular expression: {{{}}}\n", std::string_view(start, bounds_len));
+                        return std::make_tuple(false, tokens);
+                    }
 
+                    tokens.emplace_back(start, bounds_len, RegexTokenType_Operator, RegexOperatorType_Repeat);
                     break;
                 }
 
-                case '(':
+                case '\\':
                 {
+                    if(i + 1 >= regex.size())
+                    {
+                        std::format_to(STDERR, "Trailing backslash in regular expression\n");
+                        return std::make_tuple(false, tokens);
+                    }
+
                     if(need_concat)
                     {
                         tokens.emplace_back(nullptr, 0u, RegexTokenType_Operator, RegexOperatorType_Concatenate);
                     }
 
-                    tokens.emplace_back(regex.data() + i, 1u, RegexTokenType_GroupBegin);
-                    need_concat = false;
+                    i++;
+
+                    if(const char* escape_class = regex_escape_class(regex[i]); escape_class != nullptr)
+                    {
+                        /* The token points into the static class string */
+                        tokens.emplace_back(escape_class, static_cast<std::uint32_t>(std::strlen(escape_class)), RegexTokenType_CharacterRange);
+                    }
+                    else if(regex[i] == 'b' || regex[i] == 'B')
+                    {
+                        tokens.emplace_back(regex.data() + i,
+                                            1u,
+                                            RegexTokenType_Assertion,
+                                            regex[i] == 'b' ? RegexAssertionType_WordBoundary : RegexAssertionType_NotWordBoundary);
+                    }
+                    else if(const char* escaped = regex_escape_char(regex.data() + i); escaped != nullptr)
+                    {
+                        tokens.emplace_back(escaped, 1u, RegexTokenType_Character, RegexCharacterType_Single);
+                    }
+                    else
+                    {
+                        std::format_to(STDERR, "Unknown escape in regular expression: \\{}\n", regex[i]);
+                        return std::make_tuple(false, tokens);
+                    }
+
+                    need_concat = true;
+                    break;
+                }
+
+                case '^':
+                case '$':
+                {
+                    if(need_concat)
+                    {
+                        tokens.emplace_back(nullptr, 0u, RegexTokenType_Operator, RegexOperatorType_Concatenate);
+                    }
+
+                    tokens.emplace_back(regex.data() + i,
+                                        1u,
+                                        RegexTokenType_Assertion,
+                                        regex[i] == '^' ? RegexAssertionType_Begin : RegexAssertionType_End);
+                    need_concat = true;
+
+                    break;
+                }
+
+                case '.':
+                {
+                    if(need_concat)
+                    {
+                        tokens.emplace_back(nullptr, 0u, RegexTokenType_Operator, RegexOperatorType_Concatenate);
+                    }
+
+                    tokens.emplace_back(regex.data() + i, 1u, RegexTokenType_Character, RegexCharacterType_Any);
+                    need_concat = true;
+
+                    break;
+                }
+
+                case '(':
+                {
+                    if(need_concat)
+                    {
+                        tokens.emplace_back(nullptr, 0u, RegexTokenType_Operator, RegexOperatorType_Concatenate);
+                    }
+
+                    tokens.emplace_back(regex.data() + i, 1u, RegexTokenType_GroupBegin);
+                    need_concat = false;
 
                     break;
                 }
@@ -282,7 +859,8 @@ std::tuple<bool, std::vector<RegexToken>> lex_regex(const std::string& regex) no
 
                     while(i < regex.size() && regex[i] != ']')
                     {
-                        i++;
+                        /* Skip escaped characters, \] does not close the class */
+                        i += regex[i] == '\\' ? 2 : 1;
                     }
 
                     if(i >= regex.size())
@@ -291,7 +869,15 @@ std::tuple<bool, std::vector<RegexToken>> lex_regex(const std::string& regex) no
                         return std::make_tuple(false, tokens);
                     }
 
-                    tokens.emplace_back(start, (regex.data() + i) - start, RegexTokenType_CharacterRange);
+                    const std::uint32_t class_len = static_cast<std::uint32_t>((regex.data() + i) - start);
+
+                    if(!std::get<0>(parse_character_class(std::string_view(start, class_len))))
+                    {
+                        std::format_to(STDERR, "Invalid character class in regular expression: [{}]\n", std::string_view(start, class_len));
+                        return std::make_tuple(false, tokens);
+                    }
+
+                    tokens.emplace_back(start, class_len, RegexTokenType_CharacterRange);
                     need_concat = true;
                     break;
                 }
@@ -322,6 +908,7 @@ inline int get_operator_precedence(RegexOperatorType op) noexcept
         case RegexOperatorType_ZeroOrMore:
         case RegexOperatorType_OneOrMore:
         case RegexOperatorType_ZeroOrOne:
+        case RegexOperatorType_Repeat:
             return 3;
         default:
             return 0;
@@ -338,6 +925,7 @@ inline bool is_left_associative(RegexOperatorType op) noexcept
         case RegexOperatorType_ZeroOrMore:
         case RegexOperatorType_OneOrMore:
         case RegexOperatorType_ZeroOrOne:
+        case RegexOperatorType_Repeat:
             return false; /* These are postfix operators */
         default:
             return true;
@@ -351,6 +939,7 @@ std::tuple<bool, std::vector<RegexToken>> parse_regex(const std::vector<RegexTok
     std::stack<RegexToken> operators;
 
     std::uint32_t current_group_id = 1;
+    std::uint32_t previous_type = RegexTokenType_Invalid;
 
     for(const auto& token : tokens)
     {
@@ -358,6 +947,7 @@ std::tuple<bool, std::vector<RegexToken>> parse_regex(const std::vector<RegexTok
         {
             case RegexTokenType_Character:
             case RegexTokenType_CharacterRange:
+            case RegexTokenType_Assertion:
             {
                 output.push_back(token);
                 break;
@@ -421,10 +1011,17 @@ std::tuple<bool, std::vector<RegexToken>> parse_regex(const std::vector<RegexTok
                 RegexToken group_begin_token = operators.top();
                 operators.pop();
 
-                // RegexToken group_end_token = token;
-                // group_end_token.encoding = --current_group_id;
+                if(previous_type == RegexTokenType_GroupBegin)
+                {
+                    std::format_to(STDERR, "Empty group in regular expression\n");
+                    return std::make_tuple(false, output);
+                }
+
+                /* Acts as a postfix operator on the group content, only the NFA program uses it for captures */
+                RegexToken group_end_token = token;
+                group_end_token.encoding = group_begin_token.encoding;
 
-                // output.push_back(group_end_token);
+                output.push_back(group_end_token);
 
                 break;
             }
@@ -435,6 +1032,8 @@ std::tuple<bool, std::vector<RegexToken>> parse_regex(const std::vector<RegexTok
                 return std::make_tuple(false, output);
             }
         }
+
+        previous_type = token.type;
     }
 
     while(!operators.empty())
@@ -452,6 +1051,58 @@ std::tuple<bool, std::vector<RegexToken>> parse_regex(const std::vector<RegexTok
     return std::make_tuple(true, output);
 }
 
+/* 
+    Strips a leading and/or trailing .* from the (infix) tokens:
+    - a trailing .* never changes the result since matches are not required to consume the whole input
+    - a leading .* only asks for an unanchored search, which Regex does by itself way faster than
+      a greedy .* consuming the whole input
+    Returns whether the leading and trailing .* have been stripped
+*/
+std::tuple<bool, bool> regex_strip_dotstar(std::vector<RegexToken>& tokens) noexcept
+{
+    auto is_dotstar = [&](std::size_t i) -> bool {
+        return tokens[i].type == RegexTokenType_Character &&
+               tokens[i].encoding == RegexCharacterType_Any &&
+               tokens[i + 1].type == RegexTokenType_Operator &&
+               tokens[i + 1].encoding == RegexOperatorType_ZeroOrMore;
+    };
+
+    auto is_concat = [&](std::size_t i) -> bool {
+        return tokens[i].type == RegexTokenType_Operator && tokens[i].encoding == RegexOperatorType_Concatenate;
+    };
+
+    /* .* would only belong to the first or last branch of a top-level alternation */
+    std::size_t depth = 0;
+
+    for(const auto& token : tokens)
+    {
+        depth += token.type == RegexTokenType_GroupBegin ? 1 : 0;
+        depth -= token.type == RegexTokenType_GroupEnd ? 1 : 0;
+
+        if(depth == 0 && token.type == RegexTokenType_Operator && token.encoding == RegexOperatorType_Alternate)
+        {
+            return std::make_tuple(false, false);
+        }
+    }
+
+    bool stripped_leading = false;
+    bool stripped_trailing = false;
+
+    if(tokens.size() >= 4 && is_dotstar(0) && is_concat(2))
+    {
+        tokens.erase(tokens.begin(), tokens.begin() + 3);
+        stripped_leading = true;
+    }
+
+    if(tokens.size() >= 4 && is_concat(tokens.size() - 3) && is_dotstar(tokens.size() - 2))
+    {
+        tokens.erase(tokens.end() - 3, tokens.end());
+        stripped_trailing = true;
+    }
+
+    return std::make_tuple(stripped_leading, stripped_trailing);
+}
+
 void print_tokens(const std::vector<RegexToken>& tokens)
 {
     for(std::size_t i = 0; i < tokens.size(); ++i)
@@ -485,8 +1136,152 @@ enum RegexInstrOpCode : std::uint8_t
     RegexInstrOpCode_IncPosEq, /* string_pos += (status_flag ? 1 : 0) */
     RegexInstrOpCode_JumpPos,    /* Absolute jump in string position */
     RegexInstrOpCode_SetFlag, /* status_flag = static_cast<bool>(bytecode[pc + 1]) */
+    RegexInstrOpCode_RepeatInit, /* counters[bytecode[pc + 1]] = 0 */
+    RegexInstrOpCode_RepeatLoop, /* counter, min, max, jump: loops back while the body matches and counter < max */
+    RegexInstrOpCode_TestSequence, /* n, then n (lo, hi) byte ranges tested against the next n bytes */
+    RegexInstrOpCode_IncPosEqN, /* string_pos += (status_flag ? bytecode[pc + 1] : 0) */
+    RegexInstrOpCode_AssertBegin, /* status_flag = string_pos == 0 */
+    RegexInstrOpCode_AssertEnd, /* status_flag = string_pos == string_size */
+    RegexInstrOpCode_AssertWordBoundary,
+    RegexInstrOpCode_AssertNotWordBoundary,
+};
+
+const char* regex_instr_opcode_to_string(std::uint8_t op)
+{
+    switch(op)
+    {
+        case RegexInstrOpCode_TestSingle:
+            return "TestSingle";
+        case RegexInstrOpCode_TestRange:
+            return "TestRange";
+        case RegexInstrOpCode_TestNegatedRange:
+            return "TestNegatedRange";
+        case RegexInstrOpCode_TestAny:
+            return "TestAny";
+        case RegexInstrOpCode_TestDigit:
+            return "TestDigit";
+        case RegexInstrOpCode_TestLowerCase:
+            return "TestLowerCase";
+        case RegexInstrOpCode_TestUpperCase:
+            return "TestUpperCase";
+        case RegexInstrOpCode_JumpEq:
+            return "JumpEq";
+        case RegexInstrOpCode_JumpNeq:
+            return "JumpNeq";
+        case RegexInstrOpCode_Accept:
+            return "Accept";
+        case RegexInstrOpCode_Fail:
+            return "Fail";
+        case RegexInstrOpCode_GroupStart:
+            return "GroupStart";
+        case RegexInstrOpCode_GroupEnd:
+            return "GroupEnd";
+        case RegexInstrOpCode_IncPos:
+            return "IncPos";
+        case RegexInstrOpCode_DecPos:
+            return "DecPos";
+        case RegexInstrOpCode_IncPosEq:
+            return "IncPosEq";
+        case RegexInstrOpCode_JumpPos:
+            return "JumpPos";
+        case RegexInstrOpCode_SetFlag:
+            return "SetFlag";
+        case RegexInstrOpCode_RepeatInit:
+            return "RepeatInit";
+        case RegexInstrOpCode_RepeatLoop:
+            return "RepeatLoop";
+        case RegexInstrOpCode_TestSequence:
+            return "TestSequence";
+        case RegexInstrOpCode_IncPosEqN:
+            return "IncPosEqN";
+        case RegexInstrOpCode_AssertBegin:
+            return "AssertBegin";
+        case RegexInstrOpCode_AssertEnd:
+            return "AssertEnd";
+        case RegexInstrOpCode_AssertWordBoundary:
+            return "AssertWordBoundary";
+        case RegexInstrOpCode_AssertNotWordBoundary:
+            return "AssertNotWordBoundary";
+        default:
+            return "Unknown OpCode";
+    }
+}
+
+/* Counter registers available to counted repetitions, one per nesting level */
+static constexpr std::size_t REGEX_MAX_COUNTERS = 16;
+
+/* 
+    Profiling
+
+    Define REGEX_PROFILE before including this header to count what the engines do.
+    Without it REGEX_PROFILE_COUNT expands to nothing and no counter is compiled in.
+    Counters are thread_local, each grep worker gets its own.
+*/
+
+#if defined(REGEX_PROFILE)
+#include <unordered_map>
+
+struct RegexProfile
+{
+    std::array<std::uint64_t, 256> opcode_counts; /* Bytecode vm, by RegexInstrOpCode */
+    std::array<std::uint64_t, 8> inst_counts; /* Backtracker and Pike VM, by RegexInstKind */
+
+    /* Per instruction counts, keyed by the bytecode / program they belong to */
+    std::unordered_map<const void*, std::vector<std::uint64_t>> pc_counts;
+
+    std::uint64_t bytes_scanned; /* Input bytes read by test instructions */
+
+    std::uint64_t vm_runs; /* regex_exec calls, one per start position tried */
+    std::uint64_t backtrack_runs;
+    std::uint64_t backtrack_jobs;
+    std::uint64_t pikevm_runs;
+    std::uint64_t pikevm_steps; /* Input positions processed */
+    std::uint64_t pikevm_threads; /* Sum of the live threads at each step */
+    std::uint64_t pikevm_max_threads;
+
+    RegexProfile() noexcept { this->reset(); }
+
+    void reset() noexcept
+    {
+        this->opcode_counts.fill(0);
+        this->inst_counts.fill(0);
+        this->pc_counts.clear();
+        this->bytes_scanned = 0;
+        this->vm_runs = 0;
+        this->backtrack_runs = 0;
+        this->backtrack_jobs = 0;
+        this->pikevm_runs = 0;
+        this->pikevm_steps = 0;
+        this->pikevm_threads = 0;
+        this->pikevm_max_threads = 0;
+    }
+
+    std::uint64_t* counts_for(const void* code, const std::size_t size) noexcept
+    {
+        std::vector<std::uint64_t>& counts = this->pc_counts[code];
+
+        if(counts.size() < size)
+        {
+            counts.resize(size, 0);
+        }
+
+        return counts.data();
+    }
+
+    const std::uint64_t* find_counts(const void* code) const noexcept
+    {
+        const auto it = this->pc_counts.find(code);
+        return it != this->pc_counts.end() ? it->second.data() : nullptr;
+    }
 };
 
+inline thread_local RegexProfile regex_profile_counters;
+
+#define REGEX_PROFILE_COUNT(...) __VA_ARGS__
+#else
+#define REGEX_PROFILE_COUNT(...)
+#endif /* defined(REGEX_PROFILE) */
+
 enum RegexInstrOpType : std::uint32_t
 {
     RegexInstrOpType_TestOp,
@@ -524,6 +1319,57 @@ inline int decode_jump(const std::byte* bytecode) noexcept
            static_cast<int>(bytecode[3]) << 0;
 }
 
+inline std::size_t regex_instr_size(const std::byte* instr) noexcept
+{
+    switch(static_cast<std::uint8_t>(instr[0]))
+    {
+        case RegexInstrOpCode_TestSequence:
+            return 2 + 2 * static_cast<std::size_t>(instr[1]);
+
+        case RegexInstrOpCode_JumpEq:
+        case RegexInstrOpCode_JumpNeq:
+        case RegexInstrOpCode_JumpPos:
+            return 5;
+
+        case RegexInstrOpCode_TestSingle:
+        case RegexInstrOpCode_SetFlag:
+        case RegexInstrOpCode_GroupStart:
+        case RegexInstrOpCode_GroupEnd:
+        case RegexInstrOpCode_RepeatInit:
+        case RegexInstrOpCode_IncPosEqN:
+            return 2;
+
+        case RegexInstrOpCode_TestRange:
+        case RegexInstrOpCode_TestNegatedRange:
+            return 3;
+
+        case RegexInstrOpCode_RepeatLoop:
+            return 14;
+
+        default:
+            return 1;
+    }
+}
+
+/* Counters can be reused by sibling repetitions, only nested ones need a new register */
+inline std::size_t get_next_counter(const RegexByteCode& body) noexcept
+{
+    std::size_t next_counter = 0;
+    std::size_t i = 0;
+
+    while(i < body.size())
+    {
+        if(static_cast<std::uint8_t>(body[i]) == RegexInstrOpCode_RepeatInit)
+        {
+            next_counter = std::max(next_counter, static_cast<std::size_t>(body[i + 1]) + 1);
+        }
+
+        i += regex_instr_size(std::addressof(body[i]));
+    }
+
+    return next_counter;
+}
+
 inline std::size_t emit_jump(RegexByteCode& code, RegexInstrOpCode op) noexcept
 {
     code.push_back(BYTE(op));
@@ -572,9 +1418,87 @@ inline RegexByteCode get_range_instrs(char range_start, char range_end) noexcept
 }
 
 
+/* Tests one sequence of byte ranges and moves past it on success */
+inline RegexByteCode get_sequence_instrs(const Utf8Sequence& sequence) noexcept
+{
+    if(sequence.len == 1)
+    {
+        const auto [lo, hi] = sequence.ranges[0];
+
+        if(lo == hi)
+        {
+            return { BYTE(RegexInstrOpCode_TestSingle), BYTE(lo), BYTE(RegexInstrOpCode_IncPosEq) };
+        }
+
+        return get_range_instrs(static_cast<char>(lo), static_cast<char>(hi));
+    }
+
+    RegexByteCode code = { BYTE(RegexInstrOpCode_TestSequence), BYTE(sequence.len) };
+
+    for(std::uint32_t i = 0; i < sequence.len; i++)
+    {
+        code.push_back(BYTE(sequence.ranges[i].first));
+        code.push_back(BYTE(sequence.ranges[i].second));
+    }
+
+    code.push_back(BYTE(RegexInstrOpCode_IncPosEqN));
+    code.push_back(BYTE(sequence.len));
+
+    return code;
+}
+
+/* 
+    Alternation of the byte sequences matching the codepoint ranges, jumping to the end as soon as one matches.
+    When compiling for ASCII-only input, the ranges are clamped to ASCII and every sequence is a single byte test.
+*/
+RegexByteCode get_class_instrs(const std::vector<CodepointRange>& ranges, const bool utf8) noexcept
+{
+    std::vector<Utf8Sequence> sequences;
+
+    for(const auto& [lo, hi] : ranges)
+    {
+        if(utf8)
+        {
+            utf8_split_range(lo, hi, sequences);
+        }
+        else if(lo <= UTF8_MAX_ASCII)
+        {
+            utf8_split_range(lo, std::min(hi, UTF8_MAX_ASCII), sequences);
+        }
+    }
+
+    if(sequences.empty())
+    {
+        /* Nothing can match this class */
+        return { BYTE(RegexInstrOpCode_SetFlag), BYTE(0) };
+    }
+
+    RegexByteCode code;
+    std::vector<std::size_t> exit_jumps;
+
+    for(std::size_t i = 0; i < sequences.size(); i++)
+    {
+        const RegexByteCode instrs = get_sequence_instrs(sequences[i]);
+        code.insert(code.end(), instrs.begin(), instrs.end());
+
+        if((i + 1) < sequences.size())
+        {
+            exit_jumps.push_back(emit_jump(code, RegexInstrOpCode_JumpEq));
+        }
+    }
+
+    for(const std::size_t jump_pos : exit_jumps)
+    {
+        patch_jump(code, jump_pos, static_cast<int>(code.size() - (jump_pos + 4)));
+    }
+
+    return code;
+}
+
 using Fragment = std::pair<std::uint32_t, RegexByteCode>;
 
-std::tuple<bool, RegexByteCode> regex_emit(const std::vector<RegexToken>& tokens) noexcept
+/* utf8 = false compiles a program that is only valid on ASCII input, see Regex::match */
+std::tuple<bool, RegexByteCode> regex_emit(const std::vector<RegexToken>& tokens, const bool utf8 = true) noexcept
 {
     std::stack<Fragment> fragments;
 
@@ -589,28 +1513,65 @@ std::tuple<bool, RegexByteCode> regex_emit(const std::vector<RegexToken>& tokens
                 switch(token.encoding)
                 {
                     case RegexCharacterType_Single:
-                        frag.push_back(BYTE(RegexInstrOpCode_TestSingle));
-                        frag.push_back(BYTE(token.data[0]));
+                    {
+                        Utf8Sequence sequence;
+                        sequence.len = static_cast<std::uint8_t>(token.data_len);
+
+                        for(std::uint32_t i = 0; i < token.data_len; i++)
+                        {
+                            sequence.ranges[i] = std::make_pair(static_cast<std::uint8_t>(token.data[i]),
+                                                                static_cast<std::uint8_t>(token.data[i]));
+                        }
+
+                        frag = get_sequence_instrs(sequence);
                         break;
+                    }
 
                     case RegexCharacterType_Any:
-                        frag.push_back(BYTE(RegexInstrOpCode_TestAny));
+                    {
+                        if(utf8)
+                        {
+                            frag = get_class_instrs({ CodepointRange(0, UTF8_MAX_CODEPOINT) }, utf8);
+                        }
+                        else
+                        {
+                            frag.push_back(BYTE(RegexInstrOpCode_TestAny));
+                            frag.push_back(BYTE(RegexInstrOpCode_IncPosEq));
+                        }
+
                         break;
+                    }
                 }
-                
-                frag.push_back(BYTE(RegexInstrOpCode_IncPosEq));
 
                 fragments.push({ RegexInstrOpType_TestOp, std::move(frag) });
 
                 break;
             }
 
+            case RegexTokenType_Assertion:
+            {
+                /* Zero-width, assertions only set the status flag */
+                static constexpr RegexInstrOpCode assertion_instrs[] = {
+                    RegexInstrOpCode_AssertBegin,
+                    RegexInstrOpCode_AssertEnd,
+                    RegexInstrOpCode_AssertWordBoundary,
+                    RegexInstrOpCode_AssertNotWordBoundary,
+                };
+
+                fragments.push({ RegexInstrOpType_TestOp, { BYTE(assertion_instrs[token.encoding]) } });
+                break;
+            }
+
             case RegexTokenType_CharacterRange:
+            {
+                const auto [valid, negated, ranges] = parse_character_class(std::string_view(token.data, token.data_len));
+
                 fragments.push({ 
                     RegexInstrOpType_TestOp,
-                    get_range_instrs(token.data[0], token.data[2])
+                    get_class_instrs(negated ? negate_ranges(ranges, utf8 ? UTF8_MAX_CODEPOINT : UTF8_MAX_ASCII) : ranges, utf8)
                 });
                 break;
+            }
 
             case RegexTokenType_GroupBegin:
                 fragments.push({ 
@@ -623,13 +1584,7 @@ std::tuple<bool, RegexByteCode> regex_emit(const std::vector<RegexToken>& tokens
                 break;
 
             case RegexTokenType_GroupEnd:
-                fragments.push({
-                    RegexInstrOpType_GroupOp, 
-                    { 
-                        BYTE(RegexInstrOpCode_GroupEnd),
-                        BYTE(token.encoding & 0xFF)
-                    } 
-                });
+                /* Groups are only tracked by the NFA program, see regex_compile_program */
                 break;
 
             case RegexTokenType_Operator:
@@ -652,7 +1607,7 @@ std::tuple<bool, RegexByteCode> regex_emit(const std::vector<RegexToken>& tokens
 
                         frag.insert(frag.end(), rhs.begin(), rhs.end());
 
-                        const int offset = static_cast<int>(frag.size() - (jump_over_rhs_pos - 1));
+                        const int offset = static_cast<int>(frag.size() - (jump_over_rhs_pos + 4));
                         patch_jump(frag, jump_over_rhs_pos, offset);
 
                         fragments.push({ RegexInstrOpType_BinaryOp, std::move(frag) });
@@ -726,8 +1681,11 @@ std::tuple<bool, RegexByteCode> regex_emit(const std::vector<RegexToken>& tokens
                         const int offset_back = static_cast<int>(loop_start - frag.size());
                         const std::size_t loop_jump_pos = emit_jump(frag, RegexInstrOpCode_JumpEq);
                         patch_jump(frag, loop_jump_pos, offset_back);
-                        
-                        patch_jump(frag, exit_loop_jump_pos, static_cast<int>(frag.size() - (exit_loop_jump_pos-1)));
+
+                        /* The loop ends when the body fails, which is still a match of the whole + */
+                        patch_jump(frag, exit_loop_jump_pos, static_cast<int>(frag.size() - (exit_loop_jump_pos + 4)));
+                        frag.push_back(BYTE(RegexInstrOpCode_SetFlag));
+                        frag.push_back(BYTE(1));
                         
                         fragments.push({ RegexInstrOpType_UnaryOp, std::move(frag) });
 
@@ -749,6 +1707,69 @@ std::tuple<bool, RegexByteCode> regex_emit(const std::vector<RegexToken>& tokens
 
                         break;
                     }
+
+                    case RegexOperatorType_Repeat:
+                    {
+                        /* 
+                            Counted repetitions use a counter register instead of unrolling the body,
+                            so the program size does not depend on the bounds:
+
+                            REPEATINIT r
+                            loop: body
+                            REPEATLOOP r min max loop
+                        */
+                        RegexByteCode frag; 
+
+                        const auto [op_type, body] = std::move(fragments.top());
+                        fragments.pop();
+
+                        const auto [valid, min, max] = parse_repeat_bounds(std::string_view(token.data, token.data_len));
+
+                        if(!valid)
+                        {
+                            std::format_to(STDERR, "Invalid counted repetition: {{{}}}\n", std::string_view(token.data, token.data_len));
+                            return { false, RegexByteCode() };
+                        }
+
+                        if(max == 0)
+                        {
+                            frag.push_back(BYTE(RegexInstrOpCode_SetFlag));
+                            frag.push_back(BYTE(1));
+
+                            fragments.push({ RegexInstrOpType_UnaryOp, std::move(frag) });
+
+                            break;
+                        }
+
+                        const std::size_t counter = get_next_counter(body);
+
+                        if(counter >= REGEX_MAX_COUNTERS)
+                        {
+                            std::format_to(STDERR, "Too many nested counted repetitions (max {})\n", REGEX_MAX_COUNTERS);
+                            return { false, RegexByteCode() };
+                        }
+
+                        frag.push_back(BYTE(RegexInstrOpCode_RepeatInit));
+                        frag.push_back(BYTE(static_cast<std::uint8_t>(counter)));
+
+                        const std::size_t loop_start = frag.size();
+                        frag.insert(frag.end(), body.begin(), body.end());
+
+                        const int offset_back = static_cast<int>(loop_start - frag.size());
+
+                        frag.push_back(BYTE(RegexInstrOpCode_RepeatLoop));
+                        frag.push_back(BYTE(static_cast<std::uint8_t>(counter)));
+
+                        for(const int value : { static_cast<int>(min), static_cast<int>(max), offset_back })
+                        {
+                            const auto [b1, b2, b3, b4] = encode_jump(value);
+                            frag.insert(frag.end(), { b1, b2, b3, b4 });
+                        }
+
+                        fragments.push({ RegexInstrOpType_UnaryOp, std::move(frag) });
+
+                        break;
+                    }
                 }
 
                 break;
@@ -801,46 +1822,18 @@ std::tuple<bool, RegexByteCode> regex_emit(const std::vector<RegexToken>& tokens
                 break;
             }
 
-            case RegexInstrOpCode_GroupStart:
-            case RegexInstrOpCode_GroupEnd:
-            case RegexInstrOpCode_Accept:
-            case RegexInstrOpCode_Fail:
-            case RegexInstrOpCode_TestAny:
-            case RegexInstrOpCode_TestDigit:
-            case RegexInstrOpCode_TestLowerCase:
-            case RegexInstrOpCode_TestUpperCase:
-            case RegexInstrOpCode_IncPos:
-            case RegexInstrOpCode_DecPos:
-            case RegexInstrOpCode_IncPosEq:
-                i++;
+            default:
+                i += regex_instr_size(std::addressof(bytecode[i]));
                 break;
+        }
+    }
 
-            case RegexInstrOpCode_JumpPos:
-                i += 5;
-                break;
+    return make_tuple(true, bytecode);
+}
 
-            case RegexInstrOpCode_TestSingle:
-            case RegexInstrOpCode_SetFlag:
-                i += 2;
-                break;
-
-            case RegexInstrOpCode_TestRange:
-            case RegexInstrOpCode_TestNegatedRange:
-                i += 3;
-                break;
-
-            default:
-                i++;
-                break;
-        }
-    }
-
-    return make_tuple(true, bytecode);
-}
-
-std::tuple<bool, RegexByteCode> regex_opt(RegexByteCode& bytecode) noexcept
-{
-    std::size_t i = 0;
+std::tuple<bool, RegexByteCode> regex_opt(RegexByteCode& bytecode) noexcept
+{
+    std::size_t i = 0;
 
     while(i < bytecode.size())
     {
@@ -850,12 +1843,18 @@ std::tuple<bool, RegexByteCode> regex_opt(RegexByteCode& bytecode) noexcept
     return std::make_tuple(true, bytecode);
 }
 
-void regex_disasm(const RegexByteCode& bytecode) noexcept
+/* When counts is given (see RegexProfile), each instruction is prefixed with its offset and execution count */
+void regex_disasm(const RegexByteCode& bytecode, const std::uint64_t* counts = nullptr) noexcept
 {
     std::size_t i = 0;
 
     while(i < bytecode.size())
     {
+        if(counts != nullptr)
+        {
+            std::format_to(STDOUT, "{:>12} {:5} ", counts[i], i);
+        }
+
         switch(static_cast<std::uint8_t>(bytecode[i]))
         {
             case RegexInstrOpCode_TestSingle:
@@ -944,6 +1943,64 @@ void regex_disasm(const RegexByteCode& bytecode) noexcept
                                static_cast<std::uint8_t>(bytecode[i + 1]));
                 i += 2;
                 break;
+            case RegexInstrOpCode_TestSequence:
+            {
+                const std::size_t len = static_cast<std::size_t>(bytecode[i + 1]);
+
+                std::format_to(STDOUT, "TESTSEQ");
+
+                for(std::size_t j = 0; j < len; j++)
+                {
+                    std::format_to(STDOUT,
+                                   " {:02X}-{:02X}",
+                                   static_cast<std::uint8_t>(bytecode[i + 2 + 2 * j]),
+                                   static_cast<std::uint8_t>(bytecode[i + 3 + 2 * j]));
+                }
+
+                i += 2 + 2 * len;
+                break;
+            }
+            case RegexInstrOpCode_AssertBegin:
+                std::format_to(STDOUT, "ASSERTBEGIN");
+                i++;
+                break;
+            case RegexInstrOpCode_AssertEnd:
+                std::format_to(STDOUT, "ASSERTEND");
+                i++;
+                break;
+            case RegexInstrOpCode_AssertWordBoundary:
+                std::format_to(STDOUT, "ASSERTWORDBOUNDARY");
+                i++;
+                break;
+            case RegexInstrOpCode_AssertNotWordBoundary:
+                std::format_to(STDOUT, "ASSERTNOTWORDBOUNDARY");
+                i++;
+                break;
+            case RegexInstrOpCode_IncPosEqN:
+                std::format_to(STDOUT,
+                               "INCPOSEQN {}",
+                               static_cast<std::uint8_t>(bytecode[i + 1]));
+                i += 2;
+                break;
+            case RegexInstrOpCode_RepeatInit:
+                std::format_to(STDOUT,
+                               "REPEATINIT {}",
+                               static_cast<std::uint8_t>(bytecode[i + 1]));
+                i += 2;
+                break;
+            case RegexInstrOpCode_RepeatLoop:
+            {
+                const int max = decode_jump(std::addressof(bytecode[i + 6]));
+
+                std::format_to(STDOUT,
+                               "REPEATLOOP {} {} {} {}",
+                               static_cast<std::uint8_t>(bytecode[i + 1]),
+                               decode_jump(std::addressof(bytecode[i + 2])),
+                               max == static_cast<int>(REPEAT_INFINITE) ? std::string("inf") : std::to_string(max),
+                               decode_jump(std::addressof(bytecode[i + 10])));
+                i += 14;
+                break;
+            }
             default:
                 std::format_to(STDOUT, "UNKNOWN {}", static_cast<std::uint8_t>(bytecode[i]));
                 i++;
@@ -954,223 +2011,1746 @@ void regex_disasm(const RegexByteCode& bytecode) noexcept
     }
 }
 
-struct RegexVM
-{
-    const RegexByteCode& bytecode;
-
-    std::string string;
-    std::size_t sp; /* string position */
-    std::size_t pc; /* program counter */
-
-    bool status_flag;
-
-    RegexVM(const RegexByteCode& bytecode, const std::string& str) : bytecode(bytecode), 
-                                                                     string(str),
-                                                                     sp(0),
-                                                                     pc(0),
-                                                                     status_flag(false) {}
+/* Analysis */
 
-    RegexVM(const RegexVM&) = delete;
-    RegexVM& operator=(const RegexVM&) = delete;
-
-    RegexVM(RegexVM&&) = delete;
-    RegexVM& operator=(RegexVM&&) = delete;
+struct RegexInfo
+{
+    std::size_t min_length; /* Minimum number of bytes consumed by a match */
+    bool anchored_begin; /* Every match starts with ^ */
+    bool anchored_end; /* Every match ends with $ */
 };
 
-bool regex_exec(RegexVM* vm) noexcept
+RegexInfo regex_analyze(const std::vector<RegexToken>& postfix_tokens) noexcept
 {
-    while(vm->pc < vm->bytecode.size() && vm->sp <= vm->string.size())
+    std::stack<RegexInfo> infos;
+
+    for(const auto& token : postfix_tokens)
     {
-        switch(static_cast<std::uint8_t>(vm->bytecode[vm->pc]))
+        switch(token.type)
         {
-            case RegexInstrOpCode_TestSingle:
-                vm->status_flag = vm->string[vm->sp] == CHAR(vm->bytecode[vm->pc + 1]);
-                vm->pc += 2;
-                break;
-            case RegexInstrOpCode_TestRange:
-                vm->status_flag = vm->string[vm->sp] >= CHAR(vm->bytecode[vm->pc + 1]) &&
-                                  vm->string[vm->sp] <= CHAR(vm->bytecode[vm->pc + 2]);
-                vm->pc += 3;
-                break;
-            case RegexInstrOpCode_TestNegatedRange:
-                vm->status_flag = vm->string[vm->sp] < CHAR(vm->bytecode[vm->pc + 1]) &&
-                                  vm->string[vm->sp] > CHAR(vm->bytecode[vm->pc + 2]);
-                vm->pc += 3;
-                break;
-            case RegexInstrOpCode_TestAny:
-                vm->status_flag = true;
-                vm->pc += 1;
-                break;
-            case RegexInstrOpCode_TestDigit:
-                vm->status_flag = std::isdigit(static_cast<int>(vm->string[vm->sp]));
-                vm->pc += 1;
+            case RegexTokenType_Character:
+                infos.push({ token.encoding == RegexCharacterType_Single ? token.data_len : 1, false, false });
                 break;
-            case RegexInstrOpCode_TestLowerCase:
-                vm->status_flag = std::islower(static_cast<int>(vm->string[vm->sp]));
-                vm->pc += 1;
+
+            case RegexTokenType_CharacterRange:
+                infos.push({ 1, false, false });
                 break;
-            case RegexInstrOpCode_TestUpperCase:
-                vm->status_flag = std::isupper(static_cast<int>(vm->string[vm->sp]));
-                vm->pc += 1;
+
+            case RegexTokenType_Assertion:
+                infos.push({ 0, 
+                             token.encoding == RegexAssertionType_Begin,
+                             token.encoding == RegexAssertionType_End });
                 break;
-            case RegexInstrOpCode_JumpEq:
-                if(vm->status_flag)
-                {
-                    const int jmp = decode_jump(std::addressof(vm->bytecode[vm->pc + 1]));
 
-                    if(jmp > 0)
-                    {
-                        vm->pc += 5;
-                    }
-                    
-                    vm->pc += jmp;
-                }
-                else
+            case RegexTokenType_Operator:
+            {
+                if(infos.empty())
                 {
-                    vm->pc += 5;
+                    break;
                 }
 
-                break;
-            case RegexInstrOpCode_JumpNeq:
-                if(!vm->status_flag)
+                const RegexInfo rhs = infos.top();
+                infos.pop();
+
+                switch(token.encoding)
                 {
-                    const int jmp = decode_jump(std::addressof(vm->bytecode[vm->pc + 1]));
+                    case RegexOperatorType_Alternate:
+                    case RegexOperatorType_Concatenate:
+                    {
+                        if(infos.empty())
+                        {
+                            infos.push(rhs);
+                            break;
+                        }
+
+                        const RegexInfo lhs = infos.top();
+                        infos.pop();
+
+                        if(token.encoding == RegexOperatorType_Alternate)
+                        {
+                            infos.push({ std::min(lhs.min_length, rhs.min_length),
+                                         lhs.anchored_begin && rhs.anchored_begin,
+                                         lhs.anchored_end && rhs.anchored_end });
+                        }
+                        else
+                        {
+                            infos.push({ lhs.min_length + rhs.min_length, lhs.anchored_begin, rhs.anchored_end });
+                        }
 
-                    if(jmp > 0)
+                        break;
+                    }
+
+                    case RegexOperatorType_ZeroOrMore:
+                    case RegexOperatorType_ZeroOrOne:
+                        infos.push({ 0, false, false });
+                        break;
+
+                    case RegexOperatorType_OneOrMore:
+                        infos.push(rhs);
+                        break;
+
+                    case RegexOperatorType_Repeat:
                     {
-                        vm->pc += 5;
+                        const auto [valid, min, max] = parse_repeat_bounds(std::string_view(token.data, token.data_len));
+
+                        infos.push({ rhs.min_length * min, min > 0 && rhs.anchored_begin, min > 0 && rhs.anchored_end });
+                        break;
                     }
-                    
-                    vm->pc += jmp;
-                }
-                else
-                {
-                    vm->pc += 5;
                 }
+
                 break;
-            case RegexInstrOpCode_Accept:
-                return true;
-            case RegexInstrOpCode_Fail:
-                return false;
-            case RegexInstrOpCode_GroupStart:
-                vm->pc += 2;
-                break;
-            case RegexInstrOpCode_GroupEnd:
-                vm->pc += 2;
-                break;
-            case RegexInstrOpCode_IncPos:
-                vm->sp++;
-                vm->pc++;
-                break;
-            case RegexInstrOpCode_DecPos:
-                vm->sp--;
-                vm->pc++;
-                break;
-            case RegexInstrOpCode_IncPosEq:
-                vm->sp += static_cast<std::size_t>(vm->status_flag);
-                vm->pc++;
-                break;
-            case RegexInstrOpCode_JumpPos:
-                vm->sp += decode_jump(std::addressof(vm->bytecode[vm->pc + 1]));
-                vm->pc += 5;
-                break;
-            case RegexInstrOpCode_SetFlag:
-                vm->status_flag = static_cast<bool>(vm->bytecode[vm->pc + 1]);
-                vm->pc += 2;
-                break;
-            default:
-                std::format_to(STDERR,
-                               "Error: unknown instruction in regex vm: {} (pc {})",
-                               static_cast<std::uint8_t>(vm->bytecode[vm->pc]),
-                               vm->pc);
-                return false;
+            }
         }
     }
 
-    return false;
+    return infos.empty() ? RegexInfo{ 0, false, false } : infos.top();
 }
 
-class Regex
+/* 
+    Extracts the literal bytes every match has to start with, from the postfix tokens. Each subexpression gets
+    the prefix of all its matches and whether it matches nothing but that string: alternatives keep the prefix
+    they share, optional parts end it. Used to skip candidates with memchr/memcmp when searching.
+*/
+std::string regex_literal_prefix(const std::vector<RegexToken>& postfix_tokens) noexcept
 {
-    RegexByteCode _bytecode;
+    /* Prefix, and whether the subexpression only matches exactly it */
+    std::stack<std::pair<std::string, bool>> literals;
 
-    bool _compile(const std::string& regex, const bool debug) noexcept
+    for(const auto& token : postfix_tokens)
     {
-        this->_bytecode.clear();
-
-        if(debug)
+        switch(token.type)
         {
-            std::format_to(STDOUT, "Compiling Regex: {}\n", regex);
-        }
+            case RegexTokenType_Character:
+                if(token.encoding == RegexCharacterType_Single)
+                {
+                    literals.push({ std::string(token.data, token.data_len), true });
+                }
+                else
+                {
+                    literals.push({ std::string(), false });
+                }
 
-        auto [lex_success, tokens] = lex_regex(regex);
+                break;
 
-        if(!lex_success)
-        {
-            std::format_to(STDERR, "Failed to lex regex: {}\n", regex);
-            return false;
-        }
+            case RegexTokenType_CharacterRange:
+                literals.push({ std::string(), false });
+                break;
 
-        if(debug)
-        {
-            std::format_to(STDOUT, "Regex tokens (lex):\n");
-            print_tokens(tokens);
-        }
+            /* Zero-width, the prefix goes on after it */
+            case RegexTokenType_Assertion:
+                literals.push({ std::string(), true });
+                break;
 
-        auto [parse_success, postfix_tokens] = parse_regex(tokens);
+            case RegexTokenType_Operator:
+            {
+                if(literals.empty())
+                {
+                    break;
+                }
 
-        if(!parse_success)
-        {
-            std::format_to(STDERR, "Failed to parse regex: {}\n", regex);
-            return false;
-        }
+                const auto rhs = literals.top();
+                literals.pop();
 
-        if(debug)
-        {
-            std::format_to(STDOUT, "Regex tokens (parse):\n");
-            print_tokens(tokens);
-        }
+                switch(token.encoding)
+                {
+                    case RegexOperatorType_Alternate:
+                    case RegexOperatorType_Concatenate:
+                    {
+                        if(literals.empty())
+                        {
+                            literals.push(rhs);
+                            break;
+                        }
+
+                        const auto lhs = literals.top();
+                        literals.pop();
+
+                        if(token.encoding == RegexOperatorType_Alternate)
+                        {
+                            const std::size_t common = static_cast<std::size_t>(std::mismatch(lhs.first.begin(),
+                                                                                              lhs.first.end(),
+                                                                                              rhs.first.begin(),
+                                                                                              rhs.first.end()).first - lhs.first.begin());
+
+                            literals.push({ lhs.first.substr(0, common), lhs.second && rhs.second && lhs.first == rhs.first });
+                        }
+                        else
+                        {
+                            literals.push(lhs.second ? std::make_pair(lhs.first + rhs.first, rhs.second) : lhs);
+                        }
 
-        auto [emit_success, bytecode] = regex_emit(postfix_tokens);
+                        break;
+                    }
 
-        if(!emit_success)
-        {
-            std::format_to(STDERR, "Failed to emit bytecode for regex: {}\n", regex);
-            return false;
-        }
+                    case RegexOperatorType_ZeroOrMore:
+                    case RegexOperatorType_ZeroOrOne:
+                        literals.push({ std::string(), false });
+                        break;
 
-        this->_bytecode = std::move(bytecode);
+                    case RegexOperatorType_OneOrMore:
+                        literals.push({ rhs.first, false });
+                        break;
 
-        if(debug)
-        {
-            std::format_to(STDOUT, "Regex disasm:\n");
-            regex_disasm(this->_bytecode);
-        }
+                    case RegexOperatorType_Repeat:
+                    {
+                        const auto [valid, min, max] = parse_repeat_bounds(std::string_view(token.data, token.data_len));
+
+                        if(!valid || min == 0)
+                        {
+                            literals.push({ std::string(), false });
+                        }
+                        else if(min == 1 && max == 1)
+                        {
+                            literals.push(rhs);
+                        }
+                        else
+                        {
+                            literals.push({ rhs.first, false });
+                        }
 
-        return true;
-    }
+                        break;
+                    }
+                }
 
-public:
-    Regex(const std::string& regex, const bool debug_compilation = false)
+                break;
+            }
+
+            default:
+                break;
+        }
+    }
+
+    return literals.empty() ? std::string() : literals.top().first;
+}
+
+/*
+    Whether the greedy bytecode vm, which never gives back input, finds exactly the matches of the regex.
+    True for a plain sequence of characters, classes and assertions, where every quantifier applies to a single
+    character or class whose set is disjoint from every character that can come right after it, and that is
+    not followed by an assertion: a match can then never stop the loop early, e.g. [0-9]{1,8}, [a-z]*[0-9]+
+    or a?b?c, but not a*ab, x.*y or [a-c]+\B.
+*/
+bool regex_is_greedy_exact(const std::vector<RegexToken>& postfix_tokens) noexcept
+{
+    struct Item
+    {
+        std::vector<CodepointRange> ranges; /* Empty for assertions */
+        bool variable; /* Quantified with a choice of counts */
+        bool optional; /* Can be skipped to reach the next item */
+    };
+
+    std::stack<std::vector<Item>> sequences;
+
+    for(const auto& token : postfix_tokens)
+    {
+        switch(token.type)
+        {
+            case RegexTokenType_Character:
+            {
+                if(token.encoding == RegexCharacterType_Any)
+                {
+                    sequences.push({ Item{ { CodepointRange(0, UTF8_MAX_CODEPOINT) }, false, false } });
+                }
+                else
+                {
+                    const char32_t cp = utf8_decode(token.data, token.data_len);
+
+                    sequences.push({ Item{ { CodepointRange(cp, cp) }, false, false } });
+                }
+
+                break;
+            }
+
+            case RegexTokenType_CharacterRange:
+            {
+                const auto [valid, negated, ranges] = parse_character_class(std::string_view(token.data, token.data_len));
+
+                sequences.push({ Item{ negated ? negate_ranges(ranges, UTF8_MAX_CODEPOINT) : ranges, false, false } });
+                break;
+            }
+
+            case RegexTokenType_Assertion:
+                sequences.push({ Item{ {}, false, true } });
+                break;
+
+            case RegexTokenType_GroupBegin:
+            case RegexTokenType_GroupEnd:
+                break;
+
+            case RegexTokenType_Operator:
+            {
+                if(token.encoding == RegexOperatorType_Alternate || sequences.empty())
+                {
+                    return false;
+                }
+
+                if(token.encoding == RegexOperatorType_Concatenate)
+                {
+                    std::vector<Item> rhs = std::move(sequences.top());
+                    sequences.pop();
+
+                    if(sequences.empty())
+                    {
+                        return false;
+                    }
+
+                    sequences.top().insert(sequences.top().end(),
+                                           std::make_move_iterator(rhs.begin()),
+                                           std::make_move_iterator(rhs.end()));
+                    break;
+                }
+
+                std::vector<Item>& body = sequences.top();
+
+                /* Quantified groups and quantified quantifiers would need the vm to backtrack into them */
+                if(body.size() != 1 || body[0].ranges.empty() || body[0].variable)
+                {
+                    return false;
+                }
+
+                std::uint32_t min = token.encoding == RegexOperatorType_OneOrMore ? 1 : 0;
+                std::uint32_t max = REPEAT_INFINITE;
+
+                if(token.encoding == RegexOperatorType_ZeroOrOne)
+                {
+                    max = 1;
+                }
+                else if(token.encoding == RegexOperatorType_Repeat)
+                {
+                    const auto [valid, repeat_min, repeat_max] = parse_repeat_bounds(std::string_view(token.data, token.data_len));
+
+                    if(!valid)
+                    {
+                        return false;
+                    }
+
+                    min = repeat_min;
+                    max = repeat_max;
+                }
+
+                body[0].variable = min != max;
+                body[0].optional = min == 0;
+                break;
+            }
+
+            default:
+                return false;
+        }
+    }
+
+    if(sequences.size() > 1)
+    {
+        return false;
+    }
+
+    const std::vector<Item> items = sequences.empty() ? std::vector<Item>() : std::move(sequences.top());
+
+    for(std::size_t i = 0; i < items.size(); i++)
+    {
+        if(!items[i].variable)
+        {
+            continue;
+        }
+
+        /* Every character the rest can start with, up to and including the first item that cannot be skipped */
+        for(std::size_t j = i + 1; j < items.size(); j++)
+        {
+            /* An assertion can fail where the loop stopped and hold one character earlier, e.g. [a-c]+\B on "cc" */
+            if(items[j].ranges.empty())
+            {
+                return false;
+            }
+
+            for(const auto& [lo, hi] : items[i].ranges)
+            {
+                for(const auto& [next_lo, next_hi] : items[j].ranges)
+                {
+                    if(lo <= next_hi && next_lo <= hi)
+                    {
+                        return false;
+                    }
+                }
+            }
+
+            if(!items[j].optional)
+            {
+                break;
+            }
+        }
+    }
+
+    return true;
+}
+
+struct RegexVM
+{
+    const RegexByteCode& bytecode;
+
+    /* Not owning, the VM can run directly on memory-mapped data */
+    std::string_view string;
+    std::size_t sp; /* string position */
+    std::size_t pc; /* program counter */
+
+    bool status_flag;
+
+    std::array<std::uint32_t, REGEX_MAX_COUNTERS> counters;
+
+    /* String position at the start of the current iteration of each counted repetition */
+    std::array<std::size_t, REGEX_MAX_COUNTERS> repeat_starts;
+
+    RegexVM(const RegexByteCode& bytecode,
+            std::string_view str,
+            std::size_t start = 0) : bytecode(bytecode), 
+                                     string(str),
+                                     sp(start),
+                                     pc(0),
+                                     status_flag(false),
+                                     counters(),
+                                     repeat_starts() {}
+
+    RegexVM(const RegexVM&) = delete;
+    RegexVM& operator=(const RegexVM&) = delete;
+
+    RegexVM(RegexVM&&) = delete;
+    RegexVM& operator=(RegexVM&&) = delete;
+
+    /* Past the end we read a null character, like std::string does */
+    inline char current() const noexcept { return this->sp < this->string.size() ? this->string[this->sp] : '\0'; }
+};
+
+bool regex_exec(RegexVM* vm) noexcept
+{
+    REGEX_PROFILE_COUNT(
+        regex_profile_counters.vm_runs++;
+        std::uint64_t* pc_counts = regex_profile_counters.counts_for(vm->bytecode.data(), vm->bytecode.size());
+    )
+
+    while(vm->pc < vm->bytecode.size() && vm->sp <= vm->string.size())
+    {
+        REGEX_PROFILE_COUNT(
+            const std::uint8_t profiled_op = static_cast<std::uint8_t>(vm->bytecode[vm->pc]);
+
+            regex_profile_counters.opcode_counts[profiled_op]++;
+            pc_counts[vm->pc]++;
+
+            if(profiled_op <= RegexInstrOpCode_TestUpperCase)
+            {
+                regex_profile_counters.bytes_scanned++;
+            }
+            else if(profiled_op == RegexInstrOpCode_TestSequence)
+            {
+                regex_profile_counters.bytes_scanned += static_cast<std::uint64_t>(vm->bytecode[vm->pc + 1]);
+            }
+        )
+
+        switch(static_cast<std::uint8_t>(vm->bytecode[vm->pc]))
+        {
+            case RegexInstrOpCode_TestSingle:
+                vm->status_flag = vm->current() == CHAR(vm->bytecode[vm->pc + 1]);
+                vm->pc += 2;
+                break;
+            case RegexInstrOpCode_TestRange:
+                vm->status_flag = vm->sp < vm->string.size() &&
+                                  vm->current() >= CHAR(vm->bytecode[vm->pc + 1]) &&
+                                  vm->current() <= CHAR(vm->bytecode[vm->pc + 2]);
+                vm->pc += 3;
+                break;
+            case RegexInstrOpCode_TestNegatedRange:
+                vm->status_flag = vm->current() < CHAR(vm->bytecode[vm->pc + 1]) &&
+                                  vm->current() > CHAR(vm->bytecode[vm->pc + 2]);
+                vm->pc += 3;
+                break;
+            case RegexInstrOpCode_TestAny:
+                vm->status_flag = vm->sp < vm->string.size();
+                vm->pc += 1;
+                break;
+            /* Plain byte comparisons, the <cctype> functions depend on the locale */
+            case RegexInstrOpCode_TestDigit:
+                vm->status_flag = static_cast<unsigned char>(vm->current() - '0') < 10;
+                vm->pc += 1;
+                break;
+            case RegexInstrOpCode_TestLowerCase:
+                vm->status_flag = static_cast<unsigned char>(vm->current() - 'a') < 26;
+                vm->pc += 1;
+                break;
+            case RegexInstrOpCode_TestUpperCase:
+                vm->status_flag = static_cast<unsigned char>(vm->current() - 'A') < 26;
+                vm->pc += 1;
+                break;
+            case RegexInstrOpCode_TestSequence:
+            {
+                const std::size_t len = static_cast<std::size_t>(vm->bytecode[vm->pc + 1]);
+                const std::byte* ranges = std::addressof(vm->bytecode[vm->pc + 2]);
+
+                bool matches = (vm->sp + len) <= vm->string.size();
+
+                for(std::size_t i = 0; matches && i < len; i++)
+                {
+                    const std::byte b = static_cast<std::byte>(vm->string[vm->sp + i]);
+                    matches = b >= ranges[2 * i] && b <= ranges[2 * i + 1];
+                }
+
+                vm->status_flag = matches;
+                vm->pc += 2 + 2 * len;
+                break;
+            }
+            case RegexInstrOpCode_IncPosEqN:
+                vm->sp += vm->status_flag ? static_cast<std::size_t>(vm->bytecode[vm->pc + 1]) : 0;
+                vm->pc += 2;
+                break;
+            case RegexInstrOpCode_AssertBegin:
+                vm->status_flag = vm->sp == 0;
+                vm->pc++;
+                break;
+            case RegexInstrOpCode_AssertEnd:
+                vm->status_flag = vm->sp == vm->string.size();
+                vm->pc++;
+                break;
+            case RegexInstrOpCode_AssertWordBoundary:
+            case RegexInstrOpCode_AssertNotWordBoundary:
+            {
+                const bool word_before = vm->sp > 0 && is_word_char(vm->string[vm->sp - 1]);
+                const bool word_after = vm->sp < vm->string.size() && is_word_char(vm->string[vm->sp]);
+
+                vm->status_flag = (word_before != word_after) == 
+                                  (static_cast<std::uint8_t>(vm->bytecode[vm->pc]) == RegexInstrOpCode_AssertWordBoundary);
+                vm->pc++;
+                break;
+            }
+            case RegexInstrOpCode_JumpEq:
+                if(vm->status_flag)
+                {
+                    const int jmp = decode_jump(std::addressof(vm->bytecode[vm->pc + 1]));
+
+                    if(jmp > 0)
+                    {
+                        vm->pc += 5;
+                    }
+                    
+                    vm->pc += jmp;
+                }
+                else
+                {
+                    vm->pc += 5;
+                }
+
+                break;
+            case RegexInstrOpCode_JumpNeq:
+                if(!vm->status_flag)
+                {
+                    const int jmp = decode_jump(std::addressof(vm->bytecode[vm->pc + 1]));
+
+                    if(jmp > 0)
+                    {
+                        vm->pc += 5;
+                    }
+                    
+                    vm->pc += jmp;
+                }
+                else
+                {
+                    vm->pc += 5;
+                }
+                break;
+            case RegexInstrOpCode_Accept:
+                return true;
+            case RegexInstrOpCode_Fail:
+                return false;
+            case RegexInstrOpCode_GroupStart:
+                vm->pc += 2;
+                break;
+            case RegexInstrOpCode_GroupEnd:
+                vm->pc += 2;
+                break;
+            case RegexInstrOpCode_IncPos:
+                vm->sp++;
+                vm->pc++;
+                break;
+            case RegexInstrOpCode_DecPos:
+                vm->sp--;
+                vm->pc++;
+                break;
+            case RegexInstrOpCode_IncPosEq:
+                vm->sp += static_cast<std::size_t>(vm->status_flag);
+                vm->pc++;
+                break;
+            case RegexInstrOpCode_JumpPos:
+                vm->sp += decode_jump(std::addressof(vm->bytecode[vm->pc + 1]));
+                vm->pc += 5;
+                break;
+            case RegexInstrOpCode_SetFlag:
+                vm->status_flag = static_cast<bool>(vm->bytecode[vm->pc + 1]);
+                vm->pc += 2;
+                break;
+            case RegexInstrOpCode_RepeatInit:
+                vm->counters[static_cast<std::uint8_t>(vm->bytecode[vm->pc + 1])] = 0;
+                vm->repeat_starts[static_cast<std::uint8_t>(vm->bytecode[vm->pc + 1])] = vm->sp;
+                vm->pc += 2;
+                break;
+            case RegexInstrOpCode_RepeatLoop:
+            {
+                const std::uint8_t reg = static_cast<std::uint8_t>(vm->bytecode[vm->pc + 1]);
+                std::uint32_t& counter = vm->counters[reg];
+                const std::uint32_t min = static_cast<std::uint32_t>(decode_jump(std::addressof(vm->bytecode[vm->pc + 2])));
+                const std::uint32_t max = static_cast<std::uint32_t>(decode_jump(std::addressof(vm->bytecode[vm->pc + 6])));
+
+                if(vm->status_flag && vm->sp == vm->repeat_starts[reg])
+                {
+                    /* The body matched empty, so would every remaining iteration: the minimum is reached */
+                    vm->pc += 14;
+                }
+                else if(vm->status_flag && ++counter < max)
+                {
+                    vm->repeat_starts[reg] = vm->sp;
+                    vm->pc += decode_jump(std::addressof(vm->bytecode[vm->pc + 10]));
+                }
+                else
+                {
+                    vm->status_flag = counter >= min;
+                    vm->pc += 14;
+                }
+
+                break;
+            }
+            default:
+                std::format_to(STDERR,
+                               "Error: unknown instruction in regex vm: {} (pc {})",
+                               static_cast<std::uint8_t>(vm->bytecode[vm->pc]),
+                               vm->pc);
+                return false;
+        }
+    }
+
+    return false;
+}
+
+/* NFA program */
+
+/*
+    The bytecode vm is deterministic: loops consume as much as they can and never give it back,
+    and groups are not tracked. For captures, patterns are also compiled to a Thompson NFA with explicit 
+    choice points (https://swtch.com/~rsc/regexp/regexp2.html), executed by one of the engines below:
+
+    - a bounded backtracker (RE2's BitState), depth-first with a visited bitset of program size x input size
+      bits, so each (pc, sp) pair is explored at most once
+    - a Pike VM, running all the threads in lockstep, for inputs where the bitset would be too large
+*/
+
+enum RegexInstKind : std::uint8_t
+{
+    RegexInstKind_ByteRange, /* lo <= byte <= hi, then pc + 1 */
+    RegexInstKind_Split, /* x, then y with a lower priority */
+    RegexInstKind_Jump, /* x */
+    RegexInstKind_Save, /* slots[arg] = sp */
+    RegexInstKind_Assert, /* RegexAssertionType in arg */
+    RegexInstKind_Match,
+};
+
+const char* regex_inst_kind_to_string(std::uint8_t kind)
+{
+    switch(kind)
+    {
+        case RegexInstKind_ByteRange:
+            return "ByteRange";
+        case RegexInstKind_Split:
+            return "Split";
+        case RegexInstKind_Jump:
+            return "Jump";
+        case RegexInstKind_Save:
+            return "Save";
+        case RegexInstKind_Assert:
+            return "Assert";
+        case RegexInstKind_Match:
+            return "Match";
+        default:
+            return "Unknown Instruction";
+    }
+}
+
+struct RegexInst
+{
+    std::uint8_t kind;
+    std::uint8_t lo;
+    std::uint8_t hi;
+    std::uint8_t padding; /* For 16 bytes size */
+    std::uint32_t arg;
+    std::int32_t x; /* Relative to the instruction while compiling, absolute once compiled */
+    std::int32_t y;
+
+    RegexInst(const std::uint8_t kind,
+              const std::uint8_t lo = 0,
+              const std::uint8_t hi = 0,
+              const std::uint32_t arg = 0,
+              const std::int32_t x = 0,
+              const std::int32_t y = 0) : kind(kind),
+                                          lo(lo),
+                                          hi(hi),
+                                          padding(0),
+                                          arg(arg),
+                                          x(x),
+                                          y(y) {}
+};
+
+using RegexProgram = std::vector<RegexInst>;
+
+/* Whole match, then each group, viewing the matched string */
+using RegexCaptures = std::vector<std::string_view>;
+
+/* Counted repetitions are unrolled in the NFA program, this bounds the unrolling */
+static constexpr std::size_t REGEX_MAX_PROGRAM_SIZE = 1 << 16;
+
+static constexpr std::size_t REGEX_NO_POS = std::numeric_limits<std::size_t>::max();
+
+inline std::int32_t program_size(const RegexProgram& program) noexcept
+{
+    return static_cast<std::int32_t>(program.size());
+}
+
+inline void program_append(RegexProgram& program, const RegexProgram& other) noexcept
+{
+    program.insert(program.end(), other.begin(), other.end());
+}
+
+/* Alternation of the byte sequences matching the codepoint ranges */
+RegexProgram program_class(const std::vector<CodepointRange>& ranges) noexcept
+{
+    std::vector<Utf8Sequence> sequences;
+
+    for(const auto& [lo, hi] : ranges)
+    {
+        utf8_split_range(lo, hi, sequences);
+    }
+
+    RegexProgram program;
+    std::vector<std::size_t> exit_jumps;
+
+    for(std::size_t i = 0; i < sequences.size(); i++)
+    {
+        const bool last = (i + 1) == sequences.size();
+
+        if(!last)
+        {
+            program.emplace_back(RegexInstKind_Split, 0, 0, 0, 1, sequences[i].len + 2);
+        }
+
+        for(std::uint32_t j = 0; j < sequences[i].len; j++)
+        {
+            program.emplace_back(RegexInstKind_ByteRange, sequences[i].ranges[j].first, sequences[i].ranges[j].second);
+        }
+
+        if(!last)
+        {
+            exit_jumps.push_back(program.size());
+            program.emplace_back(RegexInstKind_Jump);
+        }
+    }
+
+    for(const std::size_t jump : exit_jumps)
+    {
+        program[jump].x = static_cast<std::int32_t>(program.size() - jump);
+    }
+
+    return program;
+}
+
+/* e* */
+RegexProgram program_star(const RegexProgram& body) noexcept
+{
+    RegexProgram program;
+    program.emplace_back(RegexInstKind_Split, 0, 0, 0, 1, program_size(body) + 2);
+    program_append(program, body);
+    program.emplace_back(RegexInstKind_Jump, 0, 0, 0, -(program_size(body) + 1));
+    return program;
+}
+
+/* e? */
+RegexProgram program_quest(const RegexProgram& body) noexcept
+{
+    RegexProgram program;
+    program.emplace_back(RegexInstKind_Split, 0, 0, 0, 1, program_size(body) + 1);
+    program_append(program, body);
+    return program;
+}
+
+/* Fails silently when the program would be larger than REGEX_MAX_PROGRAM_SIZE, the caller decides if that is an error */
+std::tuple<bool, RegexProgram> regex_compile_program(const std::vector<RegexToken>& tokens) noexcept
+{
+    std::stack<RegexProgram> fragments;
+
+    for(const auto& token : tokens)
+    {
+        switch(token.type)
+        {
+            case RegexTokenType_Character:
+            {
+                if(token.encoding == RegexCharacterType_Any)
+                {
+                    fragments.push(program_class({ CodepointRange(0, UTF8_MAX_CODEPOINT) }));
+                    break;
+                }
+
+                RegexProgram frag;
+
+                for(std::uint32_t i = 0; i < token.data_len; i++)
+                {
+                    const std::uint8_t c = static_cast<std::uint8_t>(token.data[i]);
+                    frag.emplace_back(RegexInstKind_ByteRange, c, c);
+                }
+
+                fragments.push(std::move(frag));
+                break;
+            }
+
+            case RegexTokenType_CharacterRange:
+            {
+                const auto [valid, negated, ranges] = parse_character_class(std::string_view(token.data, token.data_len));
+
+                fragments.push(program_class(negated ? negate_ranges(ranges, UTF8_MAX_CODEPOINT) : ranges));
+                break;
+            }
+
+            case RegexTokenType_Assertion:
+                fragments.push({ RegexInst(RegexInstKind_Assert, 0, 0, token.encoding) });
+                break;
+
+            case RegexTokenType_GroupEnd:
+            {
+                RegexProgram frag = { RegexInst(RegexInstKind_Save, 0, 0, 2 * token.encoding) };
+                program_append(frag, fragments.top());
+                frag.emplace_back(RegexInstKind_Save, 0, 0, 2 * token.encoding + 1);
+
+                fragments.pop();
+                fragments.push(std::move(frag));
+                break;
+            }
+
+            case RegexTokenType_Operator:
+            {
+                RegexProgram rhs = std::move(fragments.top());
+                fragments.pop();
+
+                RegexProgram frag;
+
+                switch(token.encoding)
+                {
+                    case RegexOperatorType_Alternate:
+                    {
+                        RegexProgram lhs = std::move(fragments.top());
+                        fragments.pop();
+
+                        frag.emplace_back(RegexInstKind_Split, 0, 0, 0, 1, program_size(lhs) + 2);
+                        program_append(frag, lhs);
+                        frag.emplace_back(RegexInstKind_Jump, 0, 0, 0, program_size(rhs) + 1);
+                        program_append(frag, rhs);
+                        break;
+                    }
+
+                    case RegexOperatorType_Concatenate:
+                    {
+                        frag = std::move(fragments.top());
+                        fragments.pop();
+
+                        program_append(frag, rhs);
+                        break;
+                    }
+
+                    case RegexOperatorType_ZeroOrMore:
+                        frag = program_star(rhs);
+                        break;
+
+                    case RegexOperatorType_OneOrMore:
+                        frag = rhs;
+                        frag.emplace_back(RegexInstKind_Split, 0, 0, 0, -program_size(rhs), 1);
+                        break;
+
+                    case RegexOperatorType_ZeroOrOne:
+                        frag = program_quest(rhs);
+                        break;
+
+                    case RegexOperatorType_Repeat:
+                    {
+                        /* 
+                            Counters cannot be used here: the backtracker memoizes (pc, sp) pairs, 
+                            which is only valid if the state does not depend on anything else 
+                        */
+                        const auto [valid, min, max] = parse_repeat_bounds(std::string_view(token.data, token.data_len));
+
+                        if(!valid)
+                        {
+                            std::format_to(STDERR, "Invalid counted repetition: {{{}}}\n", std::string_view(token.data, token.data_len));
+                            return std::make_tuple(false, RegexProgram());
+                        }
+
+                        const std::size_t copies = max == REPEAT_INFINITE ? min + 1 : max;
+
+                        if(copies * (rhs.size() + 1) > REGEX_MAX_PROGRAM_SIZE)
+                        {
+                            return std::make_tuple(false, RegexProgram());
+                        }
+
+                        for(std::uint32_t i = 0; i < min; i++)
+                        {
+                            program_append(frag, rhs);
+                        }
+
+                        if(max == REPEAT_INFINITE)
+                        {
+                            program_append(frag, program_star(rhs));
+                        }
+                        else
+                        {
+                            const RegexProgram optional = program_quest(rhs);
+
+                            for(std::uint32_t i = min; i < max; i++)
+                            {
+                                program_append(frag, optional);
+                            }
+                        }
+
+                        break;
+                    }
+                }
+
+                fragments.push(std::move(frag));
+                break;
+            }
+        }
+
+        if(!fragments.empty() && fragments.top().size() > REGEX_MAX_PROGRAM_SIZE)
+        {
+            return std::make_tuple(false, RegexProgram());
+        }
+    }
+
+    /* Slots 0 and 1 hold the whole match */
+    RegexProgram program = { RegexInst(RegexInstKind_Save, 0, 0, 0) };
+
+    if(!fragments.empty())
+    {
+        program_append(program, fragments.top());
+    }
+
+    program.emplace_back(RegexInstKind_Save, 0, 0, 1);
+    program.emplace_back(RegexInstKind_Match);
+
+    for(std::size_t i = 0; i < program.size(); i++)
+    {
+        program[i].x += static_cast<std::int32_t>(i);
+        program[i].y += static_cast<std::int32_t>(i);
+    }
+
+    return std::make_tuple(true, std::move(program));
+}
+
+void regex_program_disasm(const RegexProgram& program, const std::uint64_t* counts = nullptr) noexcept
+{
+    for(std::size_t i = 0; i < program.size(); i++)
+    {
+        const RegexInst& inst = program[i];
+
+        if(counts != nullptr)
+        {
+            std::format_to(STDOUT, "{:>12} ", counts[i]);
+        }
+
+        switch(inst.kind)
+        {
+            case RegexInstKind_ByteRange:
+                std::format_to(STDOUT, "{:4} BYTERANGE {:02X}-{:02X}\n", i, inst.lo, inst.hi);
+                break;
+            case RegexInstKind_Split:
+                std::format_to(STDOUT, "{:4} SPLIT {}, {}\n", i, inst.x, inst.y);
+                break;
+            case RegexInstKind_Jump:
+                std::format_to(STDOUT, "{:4} JUMP {}\n", i, inst.x);
+                break;
+            case RegexInstKind_Save:
+                std::format_to(STDOUT, "{:4} SAVE {}\n", i, inst.arg);
+                break;
+            case RegexInstKind_Assert:
+                std::format_to(STDOUT, "{:4} ASSERT {}\n", i, regex_assertion_type_to_string(inst.arg));
+                break;
+            case RegexInstKind_Match:
+                std::format_to(STDOUT, "{:4} MATCH\n", i);
+                break;
+        }
+    }
+}
+
+/* Explores (pc, sp), or restores a slot to the value in sp when restore_slot is set (backtracking over a SAVE) */
+struct RegexJob
+{
+    std::uint32_t pc;
+    std::uint32_t restore_slot;
+    std::size_t sp;
+};
+
+static constexpr std::uint32_t REGEX_NO_SLOT = std::numeric_limits<std::uint32_t>::max();
+
+inline bool check_assertion(const std::uint32_t assertion, std::string_view str, const std::size_t sp) noexcept
+{
+    switch(assertion)
+    {
+        case RegexAssertionType_Begin:
+            return sp == 0;
+        case RegexAssertionType_End:
+            return sp == str.size();
+        default:
+        {
+            const bool word_before = sp > 0 && is_word_char(str[sp - 1]);
+            const bool word_after = sp < str.size() && is_word_char(str[sp]);
+
+            return (word_before != word_after) == (assertion == RegexAssertionType_WordBoundary);
+        }
+    }
+}
+
+/* Bounded backtracker */
+
+/* Same limit as RE2, 32KB of visited bitset */
+static constexpr std::size_t REGEX_BITSTATE_MAX_BITS = 256 * 1024;
+
+inline bool regex_backtrack_fits(const RegexProgram& program, std::string_view str) noexcept
+{
+    return program.size() * (str.size() + 1) <= REGEX_BITSTATE_MAX_BITS;
+}
+
+/* 
+    Runs the program depth-first, from position 0 if anchored or from every position otherwise.
+    slots must be sized 2 * (number of groups + 1), they hold the leftmost-first match positions on success
+*/
+bool regex_backtrack(const RegexProgram& program,
+                     std::string_view str,
+                     const bool anchored,
+                     std::vector<std::size_t>& slots) noexcept
+{
+    const std::size_t num_positions = str.size() + 1;
+
+    std::vector<std::uint64_t> visited((program.size() * num_positions + 63) / 64, 0);
+    std::vector<RegexJob> jobs;
+
+    std::fill(slots.begin(), slots.end(), REGEX_NO_POS);
+
+    REGEX_PROFILE_COUNT(
+        regex_profile_counters.backtrack_runs++;
+        std::uint64_t* pc_counts = regex_profile_counters.counts_for(program.data(), program.size());
+    )
+
+    /* The visited bitset is shared by all start positions: a (pc, sp) pair that failed once fails again */
+    for(std::size_t start = 0; start < num_positions; start++)
+    {
+        jobs.push_back({ 0, REGEX_NO_SLOT, start });
+
+        while(!jobs.empty())
+        {
+            const RegexJob job = jobs.back();
+            jobs.pop_back();
+
+            REGEX_PROFILE_COUNT(regex_profile_counters.backtrack_jobs++;)
+
+            if(job.restore_slot != REGEX_NO_SLOT)
+            {
+                slots[job.restore_slot] = job.sp;
+                continue;
+            }
+
+            std::uint32_t pc = job.pc;
+            std::size_t sp = job.sp;
+
+            while(true)
+            {
+                const std::size_t bit = pc * num_positions + sp;
+
+                if(visited[bit / 64] & (std::uint64_t(1) << (bit % 64)))
+                {
+                    break;
+                }
+
+                visited[bit / 64] |= std::uint64_t(1) << (bit % 64);
+
+                const RegexInst& inst = program[pc];
+
+                REGEX_PROFILE_COUNT(
+                    regex_profile_counters.inst_counts[inst.kind]++;
+                    regex_profile_counters.bytes_scanned += inst.kind == RegexInstKind_ByteRange;
+                    pc_counts[pc]++;
+                )
+
+                if(inst.kind == RegexInstKind_ByteRange)
+                {
+                    if(sp >= str.size() ||
+                       static_cast<std::uint8_t>(str[sp]) < inst.lo ||
+                       static_cast<std::uint8_t>(str[sp]) > inst.hi)
+                    {
+                        break;
+                    }
+
+                    pc++;
+                    sp++;
+                }
+                else if(inst.kind == RegexInstKind_Split)
+                {
+                    jobs.push_back({ static_cast<std::uint32_t>(inst.y), REGEX_NO_SLOT, sp });
+                    pc = static_cast<std::uint32_t>(inst.x);
+                }
+                else if(inst.kind == RegexInstKind_Jump)
+                {
+                    pc = static_cast<std::uint32_t>(inst.x);
+                }
+                else if(inst.kind == RegexInstKind_Save)
+                {
+                    if(inst.arg < slots.size())
+                    {
+                        jobs.push_back({ 0, inst.arg, slots[inst.arg] });
+                        slots[inst.arg] = sp;
+                    }
+
+                    pc++;
+                }
+                else if(inst.kind == RegexInstKind_Assert)
+                {
+                    if(!check_assertion(inst.arg, str, sp))
+                    {
+                        break;
+                    }
+
+                    pc++;
+                }
+                else
+                {
+                    return true;
+                }
+            }
+        }
+
+        if(anchored)
+        {
+            break;
+        }
+    }
+
+    return false;
+}
+
+/* Pike VM */
+
+/* Sparse set of program counters, in priority order, with the slots of each thread */
+struct RegexThreadList
+{
+    std::vector<std::uint32_t> sparse;
+    std::vector<std::uint32_t> dense;
+    std::vector<std::size_t> slots;
+    std::size_t size;
+    std::size_t num_slots;
+
+    RegexThreadList(const std::size_t program_size, const std::size_t num_slots) : sparse(program_size),
+                                                                                   dense(program_size),
+                                                                                   slots(program_size * num_slots),
+                                                                                   size(0),
+                                                                                   num_slots(num_slots) {}
+
+    inline bool contains(const std::uint32_t pc) const noexcept
+    {
+        return this->sparse[pc] < this->size && this->dense[this->sparse[pc]] == pc;
+    }
+
+    inline std::size_t insert(const std::uint32_t pc) noexcept
+    {
+        this->sparse[pc] = static_cast<std::uint32_t>(this->size);
+        this->dense[this->size] = pc;
+        return this->size++;
+    }
+
+    inline std::size_t* thread_slots(const std::size_t index) noexcept
+    {
+        return this->slots.data() + index * this->num_slots;
+    }
+};
+
+/* Follows the empty transitions from pc, adding every reachable thread to the list in priority order */
+void pikevm_add_thread(const RegexProgram& program,
+                       std::string_view str,
+                       RegexThreadList& list,
+                       const std::uint32_t start_pc,
+                       const std::size_t sp,
+                       std::vector<std::size_t>& slots,
+                       std::vector<RegexJob>& jobs) noexcept
+{
+    jobs.push_back({ start_pc, REGEX_NO_SLOT, sp });
+
+    while(!jobs.empty())
+    {
+        const RegexJob job = jobs.back();
+        jobs.pop_back();
+
+        if(job.restore_slot != REGEX_NO_SLOT)
+        {
+            slots[job.restore_slot] = job.sp;
+            continue;
+        }
+
+        if(list.contains(job.pc))
+        {
+            continue;
+        }
+
+        const std::size_t index = list.insert(job.pc);
+        const RegexInst& inst = program[job.pc];
+
+        REGEX_PROFILE_COUNT(
+            regex_profile_counters.inst_counts[inst.kind]++;
+            regex_profile_counters.counts_for(program.data(), program.size())[job.pc]++;
+        )
+
+        switch(inst.kind)
+        {
+            case RegexInstKind_Jump:
+                jobs.push_back({ static_cast<std::uint32_t>(inst.x), REGEX_NO_SLOT, sp });
+                break;
+
+            case RegexInstKind_Split:
+                jobs.push_back({ static_cast<std::uint32_t>(inst.y), REGEX_NO_SLOT, sp });
+                jobs.push_back({ static_cast<std::uint32_t>(inst.x), REGEX_NO_SLOT, sp });
+                break;
+
+            case RegexInstKind_Save:
+                if(inst.arg < slots.size())
+                {
+                    jobs.push_back({ 0, inst.arg, slots[inst.arg] });
+                    slots[inst.arg] = sp;
+                }
+
+                jobs.push_back({ job.pc + 1, REGEX_NO_SLOT, sp });
+                break;
+
+            case RegexInstKind_Assert:
+                if(check_assertion(inst.arg, str, sp))
+                {
+                    jobs.push_back({ job.pc + 1, REGEX_NO_SLOT, sp });
+                }
+
+                break;
+
+            default:
+                std::copy(slots.begin(), slots.end(), list.thread_slots(index));
+                break;
+        }
+    }
+}
+
+/* Same interface as regex_backtrack, runs in O(program size x input size) time without the bitset */
+bool regex_pikevm(const RegexProgram& program,
+                  std::string_view str,
+                  const bool anchored,
+                  std::vector<std::size_t>& slots) noexcept
+{
+    const std::size_t num_slots = slots.size();
+
+    RegexThreadList current(program.size(), num_slots);
+    RegexThreadList next(program.size(), num_slots);
+
+    std::vector<std::size_t> thread_slots(num_slots);
+    std::vector<RegexJob> jobs;
+
+    std::fill(slots.begin(), slots.end(), REGEX_NO_POS);
+
+    bool matched = false;
+
+    REGEX_PROFILE_COUNT(regex_profile_counters.pikevm_runs++;)
+
+    for(std::size_t sp = 0; sp <= str.size(); sp++)
+    {
+        /* New threads have the lowest priority, leftmost matches win */
+        if(!matched && (!anchored || sp == 0))
+        {
+            std::fill(thread_slots.begin(), thread_slots.end(), REGEX_NO_POS);
+            pikevm_add_thread(program, str, current, 0, sp, thread_slots, jobs);
+        }
+
+        /* No thread left, nothing can reach MATCH anymore */
+        if(current.size == 0)
+        {
+            break;
+        }
+
+        REGEX_PROFILE_COUNT(
+            regex_profile_counters.pikevm_steps++;
+            regex_profile_counters.pikevm_threads += current.size;
+            regex_profile_counters.pikevm_max_threads = std::max<std::uint64_t>(regex_profile_counters.pikevm_max_threads,
+                                                                                current.size);
+            regex_profile_counters.bytes_scanned += sp < str.size();
+        )
+
+        next.size = 0;
+
+        for(std::size_t i = 0; i < current.size; i++)
+        {
+            const std::uint32_t pc = current.dense[i];
+            const RegexInst& inst = program[pc];
+
+            if(inst.kind == RegexInstKind_ByteRange)
+            {
+                if(sp < str.size() &&
+                   static_cast<std::uint8_t>(str[sp]) >= inst.lo &&
+                   static_cast<std::uint8_t>(str[sp]) <= inst.hi)
+                {
+                    std::copy(current.thread_slots(i), current.thread_slots(i) + num_slots, thread_slots.begin());
+                    pikevm_add_thread(program, str, next, pc + 1, sp + 1, thread_slots, jobs);
+                }
+            }
+            else if(inst.kind == RegexInstKind_Match)
+            {
+                std::copy(current.thread_slots(i), current.thread_slots(i) + num_slots, slots.begin());
+                matched = true;
+
+                /* Lower priority threads are cut */
+                break;
+            }
+        }
+
+        std::swap(current, next);
+    }
+
+    return matched;
+}
+
+class Regex
+{
+    RegexByteCode _bytecode;
+
+    /* Same program with classes restricted to ASCII, empty when it would be identical to _bytecode */
+    RegexByteCode _ascii_bytecode;
+
+    std::string _literal_prefix;
+
+    RegexInfo _info;
+
+    /* The pattern started with .*, match() has to search */
+    bool _unanchored;
+
+    /* The bytecode vm finds exactly the matches of the NFA engines, and faster, see regex_is_greedy_exact */
+    bool _greedy_exact;
+
+    /* For captures, empty if the pattern is too large for the NFA engines */
+    RegexProgram _program;
+    std::size_t _num_groups;
+
+    /* Picks the bounded backtracker for small inputs, the Pike VM otherwise */
+    bool _exec_program(std::string_view str, const bool anchored, std::vector<std::size_t>& slots) const noexcept
+    {
+        if(this->_program.empty() || str.size() < this->_info.min_length)
+        {
+            return false;
+        }
+
+        slots.assign(2 * (this->_num_groups + 1), REGEX_NO_POS);
+
+        return regex_backtrack_fits(this->_program, str) ? regex_backtrack(this->_program, str, anchored, slots) :
+                                                            regex_pikevm(this->_program, str, anchored, slots);
+    }
+
+    bool _exec_program(std::string_view str, const bool anchored, RegexCaptures& captures) const noexcept
+    {
+        std::vector<std::size_t> slots;
+
+        const bool matched = this->_exec_program(str, anchored, slots);
+
+        captures.assign(this->_num_groups + 1, std::string_view());
+
+        if(!matched)
+        {
+            return false;
+        }
+
+        for(std::size_t i = 0; i <= this->_num_groups; i++)
+        {
+            if(slots[2 * i] != REGEX_NO_POS && slots[2 * i + 1] != REGEX_NO_POS)
+            {
+                captures[i] = str.substr(slots[2 * i], slots[2 * i + 1] - slots[2 * i]);
+            }
+        }
+
+        return true;
+    }
+
+    inline bool _exec_at(const RegexByteCode& bytecode, std::string_view str, const std::size_t start) const noexcept
+    {
+        RegexVM vm(bytecode, str, start);
+
+        return regex_exec(&vm);
+    }
+
+    /* Inputs without any byte >= 0x80 can run the simpler ASCII program */
+    inline const RegexByteCode& _select_bytecode(std::string_view str) const noexcept
+    {
+        return (!this->_ascii_bytecode.empty() && is_ascii(str)) ? this->_ascii_bytecode : this->_bytecode;
+    }
+
+    bool _compile(const std::string& regex, const bool debug) noexcept
+    {
+        this->_bytecode.clear();
+        this->_ascii_bytecode.clear();
+        this->_info = RegexInfo{ 0, false, false };
+        this->_unanchored = false;
+        this->_greedy_exact = false;
+        this->_program.clear();
+        this->_num_groups = 0;
+
+        if(debug)
+        {
+            std::format_to(STDOUT, "Compiling Regex: {}\n", regex);
+        }
+
+        auto [lex_success, tokens] = lex_regex(regex);
+
+        if(!lex_success)
+        {
+            std::format_to(STDERR, "Failed to lex regex: {}\n", regex);
+            return false;
+        }
+
+        if(debug)
+        {
+            std::format_to(STDOUT, "Regex tokens (lex):\n");
+            print_tokens(tokens);
+        }
+
+        /* The NFA program keeps the .* so that captures[0] spans the whole match */
+        const auto [full_parse_success, full_postfix_tokens] = parse_regex(tokens);
+
+        this->_unanchored = std::get<0>(regex_strip_dotstar(tokens));
+
+        auto [parse_success, postfix_tokens] = parse_regex(tokens);
+
+        if(!parse_success)
+        {
+            std::format_to(STDERR, "Failed to parse regex: {}\n", regex);
+            return false;
+        }
+
+        if(debug)
+        {
+            std::format_to(STDOUT, "Regex tokens (parse):\n");
+            print_tokens(tokens);
+        }
+
+        auto [emit_success, bytecode] = regex_emit(postfix_tokens);
+
+        if(!emit_success)
+        {
+            std::format_to(STDERR, "Failed to emit bytecode for regex: {}\n", regex);
+            return false;
+        }
+
+        this->_bytecode = std::move(bytecode);
+        this->_literal_prefix = regex_literal_prefix(postfix_tokens);
+        this->_info = regex_analyze(postfix_tokens);
+        this->_greedy_exact = regex_is_greedy_exact(postfix_tokens);
+
+        auto [ascii_emit_success, ascii_bytecode] = regex_emit(postfix_tokens, false);
+
+        if(ascii_emit_success && ascii_bytecode != this->_bytecode)
+        {
+            this->_ascii_bytecode = std::move(ascii_bytecode);
+        }
+
+        auto [program_success, program] = regex_compile_program(full_postfix_tokens);
+
+        if(program_success && full_parse_success)
+        {
+            this->_program = std::move(program);
+
+            for(const auto& token : full_postfix_tokens)
+            {
+                if(token.type == RegexTokenType_GroupEnd)
+                {
+                    this->_num_groups = std::max(this->_num_groups, static_cast<std::size_t>(token.encoding));
+                }
+            }
+        }
+        else if(!this->_greedy_exact)
+        {
+            /* The bytecode vm alone would miss the matches that need to give back input */
+            std::format_to(STDERR, "Regex too large for the NFA program: {}\n", regex);
+            this->_bytecode.clear();
+            this->_ascii_bytecode.clear();
+            return false;
+        }
+
+        if(debug)
+        {
+            std::format_to(STDOUT, "Regex disasm:\n");
+            regex_disasm(this->_bytecode);
+
+            std::format_to(STDOUT, "Regex NFA program:\n");
+            regex_program_disasm(this->_program);
+
+            if(!this->_literal_prefix.empty())
+            {
+                std::format_to(STDOUT, "Regex literal prefix: {}\n", this->_literal_prefix);
+            }
+
+            std::format_to(STDOUT,
+                           "Regex info: min length {}, anchored begin {}, anchored end {}, unanchored {}\n",
+                           this->_info.min_length,
+                           this->_info.anchored_begin,
+                           this->_info.anchored_end,
+                           this->_unanchored);
+        }
+
+        return true;
+    }
+
+public:
+    Regex(const std::string& regex, const bool debug_compilation = false)
     {
         this->_compile(regex, debug_compilation);
     }
 
-    bool match(const std::string& str) const noexcept
+    /*
+        Whether the regex matches at the start of str. Runs on the NFA program, like the overloads with captures,
+        so both always agree, except for patterns where greedy matching is exact, which run on the faster bytecode
+        vm. Other patterns too large for the NFA program do not compile: the bytecode vm does not backtrack and
+        would miss the matches that need to give back input, e.g. a*ab on "aab".
+    */
+    bool match(std::string_view str) const noexcept
+    {
+        if(this->_bytecode.size() == 0 || str.size() < this->_info.min_length)
+        {
+            return false;
+        }
+
+        if(!this->_program.empty() && !this->_greedy_exact)
+        {
+            std::vector<std::size_t> slots;
+
+            return this->_exec_program(str, true, slots);
+        }
+
+        if(this->_unanchored && !this->_info.anchored_begin)
+        {
+            return this->search(str);
+        }
+
+        return this->_exec_at(this->_select_bytecode(str), str, 0);
+    }
+
+    /* Unanchored search, returns true if the regex matches starting at any position of str */
+    bool search(std::string_view str) const noexcept
     {
-        if(this->_bytecode.size() == 0)
+        if(this->_bytecode.size() == 0 || str.size() < this->_info.min_length)
+        {
+            return false;
+        }
+
+        if(!this->_program.empty() && !this->_greedy_exact)
+        {
+            /* Every match starts with the literal prefix, no need to run anything without it */
+            if(!this->_literal_prefix.empty() && str.find(this->_literal_prefix) == std::string_view::npos)
+            {
+                return false;
+            }
+
+            std::vector<std::size_t> slots;
+
+            return this->_exec_program(str, this->_info.anchored_begin, slots);
+        }
+
+        const RegexByteCode& bytecode = this->_select_bytecode(str);
+
+        /* ^ can only match at the first position, no need to scan */
+        if(this->_info.anchored_begin)
+        {
+            return this->_exec_at(bytecode, str, 0);
+        }
+
+        /* No match can start once less than min_length bytes remain */
+        const std::size_t last_start = str.size() - this->_info.min_length;
+
+        if(this->_literal_prefix.empty())
         {
+            for(std::size_t start = 0; start <= last_start; start++)
+            {
+                if(this->_exec_at(bytecode, str, start))
+                {
+                    return true;
+                }
+            }
+
             return false;
         }
 
-        RegexVM vm(this->_bytecode, str);
+        std::size_t start = str.find(this->_literal_prefix);
+
+        while(start != std::string_view::npos && start <= last_start)
+        {
+            if(this->_exec_at(bytecode, str, start))
+            {
+                return true;
+            }
+
+            start = str.find(this->_literal_prefix, start + 1);
+        }
+
+        return false;
+    }
 
-        bool res = regex_exec(&vm);
+    /* 
+        Same as match and search, filling captures with the whole match and each group (empty views for unmatched groups).
+        Always false for the greedy exact patterns too large for the NFA program, the bytecode vm does not track groups.
+    */
+    bool match(std::string_view str, RegexCaptures& captures) const noexcept
+    {
+        return this->_exec_program(str, true, captures);
+    }
 
-        return res;
+    bool search(std::string_view str, RegexCaptures& captures) const noexcept
+    {
+        return this->_exec_program(str, this->_info.anchored_begin, captures);
     }
+
+    bool anchored() const noexcept { return this->_info.anchored_begin; }
+
+    /* False when the pattern failed to compile, the reason was printed on stderr */
+    bool valid() const noexcept { return !this->_bytecode.empty(); }
+
+    std::size_t min_length() const noexcept { return this->_info.min_length; }
+
+    const std::string& literal_prefix() const noexcept { return this->_literal_prefix; }
+
+    const RegexByteCode& bytecode() const noexcept { return this->_bytecode; }
+
+    const RegexByteCode& ascii_bytecode() const noexcept { return this->_ascii_bytecode; }
+
+    const RegexProgram& program() const noexcept { return this->_program; }
+
+    std::size_t num_groups() const noexcept { return this->_num_groups; }
 };
 
+#if defined(REGEX_PROFILE)
+static constexpr std::size_t REGEX_PROFILE_HOT_INSTRUCTIONS = 10;
+
+/* Prints the offsets of the most executed instructions, hottest first */
+void regex_profile_print_hot(const std::uint64_t* counts, const std::size_t size) noexcept
+{
+    std::vector<std::size_t> pcs;
+
+    for(std::size_t pc = 0; pc < size; pc++)
+    {
+        if(counts[pc] > 0)
+        {
+            pcs.push_back(pc);
+        }
+    }
+
+    const std::size_t num_hot = std::min(pcs.size(), REGEX_PROFILE_HOT_INSTRUCTIONS);
+
+    std::partial_sort(pcs.begin(),
+                      pcs.begin() + num_hot,
+                      pcs.end(),
+                      [counts](const std::size_t a, const std::size_t b) { return counts[a] > counts[b] || (counts[a] == counts[b] && a < b); });
+
+    for(std::size_t i = 0; i < num_hot; i++)
+    {
+        std::format_to(STDOUT, "  {:5} {:>12}\n", pcs[i], counts[pcs[i]]);
+    }
+}
+
+void regex_profile_print_bytecode(const char* name, const RegexByteCode& bytecode) noexcept
+{
+    const std::uint64_t* counts = regex_profile_counters.find_counts(bytecode.data());
+
+    if(bytecode.empty() || counts == nullptr)
+    {
+        return;
+    }
+
+    std::format_to(STDOUT, "{} hot instructions (offset, count):\n", name);
+    regex_profile_print_hot(counts, bytecode.size());
+
+    std::format_to(STDOUT, "{} listing (count, offset, instruction):\n", name);
+    regex_disasm(bytecode, counts);
+}
+
+/* 
+    Runs search, then search with captures, on every line of the corpus and prints what the engines did.
+    Counters are reset first, the totals stay available in regex_profile_counters afterwards.
+*/
+void regex_profile(const std::string& pattern, const std::vector<std::string>& corpus) noexcept
+{
+    const Regex regex(pattern);
+
+    regex_profile_counters.reset();
+
+    std::size_t num_matches = 0;
+    std::size_t num_capture_matches = 0;
+    std::size_t corpus_size = 0;
+
+    RegexCaptures captures;
+
+    for(const auto& line : corpus)
+    {
+        num_matches += regex.search(line);
+        num_capture_matches += regex.search(line, captures);
+        corpus_size += line.size();
+    }
+
+    const RegexProfile& profile = regex_profile_counters;
+
+    std::format_to(STDOUT, "Profile of \"{}\" on {} lines, {} bytes\n", pattern, corpus.size(), corpus_size);
+    std::format_to(STDOUT, "  matches: {} (search), {} (search with captures)\n", num_matches, num_capture_matches);
+    std::format_to(STDOUT,
+                   "  bytes scanned: {} ({} per input byte)\n",
+                   profile.bytes_scanned,
+                   corpus_size > 0 ? static_cast<double>(profile.bytes_scanned) / static_cast<double>(corpus_size) : 0.0);
+    std::format_to(STDOUT, "  vm runs: {}\n", profile.vm_runs);
+    std::format_to(STDOUT, "  backtracker runs: {}, jobs: {}\n", profile.backtrack_runs, profile.backtrack_jobs);
+    std::format_to(STDOUT,
+                   "  pike vm runs: {}, steps: {}, threads per step: {} avg, {} max\n",
+                   profile.pikevm_runs,
+                   profile.pikevm_steps,
+                   profile.pikevm_steps > 0 ? static_cast<double>(profile.pikevm_threads) / static_cast<double>(profile.pikevm_steps) : 0.0,
+                   profile.pikevm_max_threads);
+
+    std::format_to(STDOUT, "Opcode counts:\n");
+
+    for(std::size_t op = 0; op < profile.opcode_counts.size(); op++)
+    {
+        if(profile.opcode_counts[op] > 0)
+        {
+            std::format_to(STDOUT,
+                           "  {:<24} {:>12}\n",
+                           regex_instr_opcode_to_string(static_cast<std::uint8_t>(op)),
+                           profile.opcode_counts[op]);
+        }
+    }
+
+    std::format_to(STDOUT, "NFA instruction counts:\n");
+
+    for(std::size_t kind = 0; kind < profile.inst_counts.size(); kind++)
+    {
+        if(profile.inst_counts[kind] > 0)
+        {
+            std::format_to(STDOUT, "  {:<24} {:>12}\n", regex_inst_kind_to_string(static_cast<std::uint8_t>(kind)), profile.inst_counts[kind]);
+        }
+    }
+
+    regex_profile_print_bytecode("Bytecode", regex.bytecode());
+    regex_profile_print_bytecode("ASCII bytecode", regex.ascii_bytecode());
+
+    const std::uint64_t* program_counts = profile.find_counts(regex.program().data());
+
+    if(program_counts != nullptr)
+    {
+        std::format_to(STDOUT, "NFA program hot instructions (pc, count):\n");
+        regex_profile_print_hot(program_counts, regex.program().size());
+
+        std::format_to(STDOUT, "NFA program listing (count, pc, instruction):\n");
+        regex_program_disasm(regex.program(), program_counts);
+    }
+}
+#endif /* defined(REGEX_PROFILE) */
+
 // int main(int argc, char** argv) 
 // {
 //     Regex regex1("[0-9]*", true);
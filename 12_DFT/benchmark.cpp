@@ -0,0 +1,1439 @@
+#include <iostream>
+#include <chrono>
+#include <vector>
+#include <complex>
+#include <random>
+#include <iomanip>
+#include <cmath>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <atomic>
+#include <span>
+#include <iterator>
+#include <limits>
+#include <fstream>
+#include <filesystem>
+
+#include "dft.hpp"
+#include "ntt.hpp"
+#include "fft_file.hpp"
+
+class BenchmarkTimer
+{
+private:
+    std::chrono::high_resolution_clock::time_point start_time;
+
+public:
+    void start() noexcept
+    {
+        this->start_time = std::chrono::high_resolution_clock::now();
+    }
+
+    double elapsed_ms() const noexcept
+    {
+        auto end_time = std::chrono::high_resolution_clock::now();
+        auto duration = std::chrono::duration_cast<std::chrono::microseconds>(end_time - this->start_time);
+        return duration.count() / 1000.0;
+    }
+};
+
+std::vector<std::complex<double>> generateSignal(const std::size_t N) noexcept
+{
+    std::mt19937 gen(42);
+    std::uniform_real_distribution<double> dist(-1.0, 1.0);
+
+    std::vector<std::complex<double>> signal(N);
+
+    for(auto& x : signal)
+    {
+        x = std::complex<double>(dist(gen), dist(gen));
+    }
+
+    return signal;
+}
+
+/* The O(N²) loop dft.cpp started with, one complex exponential per term */
+std::vector<std::complex<double>> dftExp(const std::vector<std::complex<double>>& input) noexcept
+{
+    using namespace std::complex_literals;
+
+    const std::size_t N = input.size();
+
+    std::vector<std::complex<double>> res(N);
+
+    for(std::size_t i = 0; i < N; i++)
+    {
+        std::complex<double> Xn = 0;
+
+        for(std::size_t j = 0; j < N; j++)
+        {
+            Xn += input[j] * exp(-1i *
+                                 2.0 *
+                                 M_PI *
+                                 static_cast<std::complex<double>>(j) *
+                                 static_cast<std::complex<double>>(i) /
+                                 static_cast<std::complex<double>>(N));
+        }
+
+        res[i] = Xn;
+    }
+
+    return res;
+}
+
+/* Largest error relative to the largest magnitude of the reference */
+double maxRelativeError(const std::vector<std::complex<double>>& res,
+                        const std::vector<std::complex<double>>& ref) noexcept
+{
+    double max_error = 0.0;
+    double max_ref = 0.0;
+
+    for(std::size_t i = 0; i < ref.size(); i++)
+    {
+        max_error = std::max(max_error, std::abs(res[i] - ref[i]));
+        max_ref = std::max(max_ref, std::abs(ref[i]));
+    }
+
+    return max_ref > 0.0 ? max_error / max_ref : max_error;
+}
+
+void runAccuracyCheck() noexcept
+{
+    std::cout << "\n=== Accuracy against the direct DFT ===" << std::endl;
+
+    const FFTAlgorithm algorithms[] = { FFTAlgorithm_Radix2, FFTAlgorithm_Radix4, FFTAlgorithm_SplitRadix };
+
+    for(std::size_t N = 1; N <= 4096; N *= 2)
+    {
+        const std::vector<std::complex<double>> signal = generateSignal(N);
+        const std::vector<std::complex<double>> ref = dft_direct(signal);
+
+        std::cout << "N = " << std::setw(5) << N;
+
+        for(const FFTAlgorithm algorithm : algorithms)
+        {
+            std::vector<std::complex<double>> res = signal;
+            fft(res, FFTDirection_Forward, algorithm);
+
+            const double forward_error = maxRelativeError(res, ref);
+
+            fft(res, FFTDirection_Backward, algorithm);
+
+            for(auto& x : res)
+            {
+                x /= static_cast<double>(N);
+            }
+
+            const double roundtrip_error = maxRelativeError(res, signal);
+
+            std::cout << "  " << fft_algorithm_to_string(algorithm)
+                      << " " << std::scientific << std::setprecision(1) << forward_error
+                      << "/" << roundtrip_error << std::defaultfloat;
+        }
+
+        std::cout << std::endl;
+    }
+}
+
+void runDirectBenchmark() noexcept
+{
+    std::cout << "\n=== Direct DFT vs FFT ===" << std::endl;
+
+    for(std::size_t N = 256; N <= 4096; N *= 4)
+    {
+        const std::vector<std::complex<double>> signal = generateSignal(N);
+
+        BenchmarkTimer timer;
+
+        timer.start();
+        const auto res_exp = dftExp(signal);
+        const double exp_time = timer.elapsed_ms();
+
+        timer.start();
+        const auto res_direct = dft_direct(signal);
+        const double direct_time = timer.elapsed_ms();
+
+        timer.start();
+        const auto res_fft = dft(signal);
+        const double fft_time = timer.elapsed_ms();
+
+        std::cout << "N = " << std::setw(5) << N
+                  << "  exp() loop: " << std::fixed << std::setprecision(3) << exp_time << " ms"
+                  << "  direct with table: " << direct_time << " ms"
+                  << "  dft() (fft): " << fft_time << " ms"
+                  << "  speedup: " << std::setprecision(0) << exp_time / std::max(fft_time, 1e-3) << "x"
+                  << std::defaultfloat << std::endl;
+    }
+}
+
+/* 5 N log2(N) is the conventional flop count for a complex FFT */
+void runFFTBenchmark() noexcept
+{
+    std::cout << "\n=== Power-of-two FFT algorithms ===" << std::endl;
+
+    const FFTAlgorithm algorithms[] = { FFTAlgorithm_Radix2, FFTAlgorithm_Radix4, FFTAlgorithm_SplitRadix };
+
+    for(std::size_t log2N = 6; log2N <= 22; log2N += 2)
+    {
+        const std::size_t N = std::size_t(1) << log2N;
+        const std::size_t iterations = std::max<std::size_t>(1, (std::size_t(1) << 24) / (N * log2N));
+
+        const std::vector<std::complex<double>> signal = generateSignal(N);
+
+        std::cout << "N = 2^" << std::setw(2) << log2N;
+
+        for(const FFTAlgorithm algorithm : algorithms)
+        {
+            std::vector<std::complex<double>> data = signal;
+
+            /* Builds the tables outside of the timed loop */
+            fft_engine<double>(N, algorithm);
+
+            BenchmarkTimer timer;
+            timer.start();
+
+            for(std::size_t i = 0; i < iterations; i++)
+            {
+                fft(data, FFTDirection_Forward, algorithm);
+            }
+
+            const double time = timer.elapsed_ms() / static_cast<double>(iterations);
+            const double gflops = 5.0 * static_cast<double>(N) * static_cast<double>(log2N) / (time * 1e6);
+
+            std::cout << "  " << fft_algorithm_to_string(algorithm)
+                      << " " << std::fixed << std::setprecision(3) << time << " ms ("
+                      << std::setprecision(2) << gflops << " GFLOPS)" << std::defaultfloat;
+        }
+
+        std::cout << std::endl;
+    }
+}
+
+const std::size_t ARBITRARY_SIZES[] = {
+    3, 5, 6, 7, 11, 12, 13, 15, 17, 31, 35, 49, 60, 97, 100, 121, 169, 210, 257, 360, 1000, 1009, 2310, 4093,
+};
+
+void runArbitrarySizeAccuracyCheck() noexcept
+{
+    std::cout << "\n=== Accuracy of arbitrary sizes against the direct DFT ===" << std::endl;
+
+    for(const std::size_t N : ARBITRARY_SIZES)
+    {
+        const std::vector<std::complex<double>> signal = generateSignal(N);
+        const std::vector<std::complex<double>> ref = dft_direct(signal);
+
+        std::cout << "N = " << std::setw(5) << N;
+
+        for(const FFTAlgorithm algorithm : { FFTAlgorithm_Auto, FFTAlgorithm_Rader, FFTAlgorithm_Bluestein })
+        {
+            const FFTEngine<double>& engine = fft_engine<double>(N, algorithm);
+
+            std::vector<std::complex<double>> res = signal;
+            fft(res, FFTDirection_Forward, algorithm);
+
+            const double forward_error = maxRelativeError(res, ref);
+
+            fft(res, FFTDirection_Backward, algorithm);
+
+            for(auto& x : res)
+            {
+                x /= static_cast<double>(N);
+            }
+
+            const double roundtrip_error = maxRelativeError(res, signal);
+
+            std::cout << "  " << std::setw(10) << fft_algorithm_to_string(engine.algorithm())
+                      << " " << std::scientific << std::setprecision(1) << forward_error
+                      << "/" << roundtrip_error << std::defaultfloat;
+        }
+
+        std::cout << std::endl;
+    }
+}
+
+/* Sizes around a million with very different factorizations */
+void runArbitrarySizeBenchmark() noexcept
+{
+    std::cout << "\n=== Arbitrary sizes ===" << std::endl;
+
+    const std::size_t sizes[] = {
+        1 << 20,         /* 2^20 */
+        1000000,         /* 2^6 5^6 */
+        3 * 5 * 7 * 9 * 11 * 13 * 17, /* small odd primes and 17 through a sub-transform */
+        1 << 16,
+        65537,           /* prime, 65536 = 2^16 so Rader */
+        1000003,         /* prime, 1000002 = 2 3 166667 so Bluestein */
+        2 * 500009,      /* 2 times a prime */
+    };
+
+    for(const std::size_t N : sizes)
+    {
+        const std::vector<std::complex<double>> signal = generateSignal(N);
+        const std::size_t log2N = log2_floor(N);
+        const std::size_t iterations = std::max<std::size_t>(1, (std::size_t(1) << 24) / (N * log2N));
+
+        for(const FFTAlgorithm algorithm : { FFTAlgorithm_Auto, FFTAlgorithm_Bluestein })
+        {
+            const FFTEngine<double>& engine = fft_engine<double>(N, algorithm);
+
+            std::vector<std::complex<double>> data = signal;
+
+            BenchmarkTimer timer;
+            timer.start();
+
+            for(std::size_t i = 0; i < iterations; i++)
+            {
+                fft(data, FFTDirection_Forward, algorithm);
+            }
+
+            const double time = timer.elapsed_ms() / static_cast<double>(iterations);
+
+            std::cout << "N = " << std::setw(8) << N
+                      << "  " << std::setw(10) << fft_algorithm_to_string(engine.algorithm())
+                      << " " << std::fixed << std::setprecision(3) << time << " ms"
+                      << std::defaultfloat << std::endl;
+        }
+    }
+}
+
+/* Estimated plans against measured ones, and wisdom going through a file */
+void runPlanBenchmark() noexcept
+{
+    std::cout << "\n=== Plans: estimate vs measure ===" << std::endl;
+
+    const std::size_t sizes[] = { 64, 1024, 4096, 1 << 16, 1000, 4093, 65537, 100000 };
+
+    fft_wisdom_forget();
+
+    std::vector<FFTAlgorithm> measured;
+
+    for(const std::size_t N : sizes)
+    {
+        const std::vector<std::complex<double>> signal = generateSignal(N);
+        const std::size_t iterations = std::max<std::size_t>(1, (std::size_t(1) << 22) / N);
+
+        BenchmarkTimer timer;
+
+        timer.start();
+        FFTPlan<double> estimate(N, FFTDirection_Forward, FFTPlanFlag_Estimate);
+        const double estimate_plan_time = timer.elapsed_ms();
+
+        timer.start();
+        FFTPlan<double> measure(N, FFTDirection_Forward, FFTPlanFlag_Measure);
+        const double measure_plan_time = timer.elapsed_ms();
+
+        measured.push_back(measure.algorithm());
+
+        std::vector<std::complex<double>> data = signal;
+
+        timer.start();
+
+        for(std::size_t i = 0; i < iterations; i++)
+        {
+            estimate.execute(data.data());
+        }
+
+        const double estimate_time = timer.elapsed_ms() / static_cast<double>(iterations);
+
+        data = signal;
+
+        timer.start();
+
+        for(std::size_t i = 0; i < iterations; i++)
+        {
+            measure.execute(data.data());
+        }
+
+        const double measure_time = timer.elapsed_ms() / static_cast<double>(iterations);
+
+        std::cout << "N = " << std::setw(6) << N
+                  << "  estimate: " << std::setw(10) << fft_algorithm_to_string(estimate.algorithm())
+                  << std::fixed << std::setprecision(4) << " " << estimate_time << " ms (planned in "
+                  << std::setprecision(2) << estimate_plan_time << " ms)"
+                  << "  measure: " << std::setw(10) << fft_algorithm_to_string(measure.algorithm())
+                  << std::setprecision(4) << " " << measure_time << " ms (planned in "
+                  << std::setprecision(2) << measure_plan_time << " ms)"
+                  << std::defaultfloat << std::endl;
+    }
+
+    const std::string wisdom_path = "fft_wisdom.txt";
+
+    fft_wisdom_save(wisdom_path);
+    fft_wisdom_forget();
+
+    const bool loaded = fft_wisdom_load(wisdom_path);
+
+    std::size_t matching = 0;
+
+    for(std::size_t i = 0; i < std::size(sizes); i++)
+    {
+        const FFTPlan<double> from_wisdom(sizes[i]);
+
+        matching += from_wisdom.algorithm() == measured[i];
+    }
+
+    std::cout << "Wisdom saved to " << wisdom_path << " and reloaded (" << (loaded ? "ok" : "failed") << "), "
+              << matching << "/" << std::size(sizes) << " plans rebuilt from it without measuring" << std::endl;
+
+    std::remove(wisdom_path.c_str());
+
+    /* Wisdom that disagrees with the heuristic: followed by default, ignored with FFTPlanFlag_ForgetWisdom */
+    const std::size_t N = 1024;
+    const FFTAlgorithm heuristic = fft_choose_algorithm(N);
+
+    for(const FFTAlgorithm candidate : fft_candidate_algorithms(N))
+    {
+        if(candidate == heuristic)
+        {
+            continue;
+        }
+
+        fft_wisdom_store<double>(N, candidate);
+
+        const bool followed = FFTPlan<double>(N).algorithm() == candidate;
+        const bool forgotten = FFTPlan<double>(N, FFTDirection_Forward, FFTPlanFlag_ForgetWisdom).algorithm() == heuristic;
+
+        std::cout << "Wisdom " << fft_algorithm_to_string(candidate) << " for N = " << N << ": "
+                  << (followed ? "followed" : "NOT followed") << " by default, "
+                  << (forgotten ? "ignored" : "NOT ignored") << " with ForgetWisdom" << std::endl;
+    }
+
+    fft_wisdom_forget();
+}
+
+template<typename T>
+void runSimdBenchmark(const char* precision) noexcept
+{
+    std::cout << "\n=== Split-format SIMD kernels, " << precision
+              << " (CPU supports " << fft_simd_to_string(fft_detect_simd()) << ") ===" << std::endl;
+
+    const FFTSimd simds[] = { FFTSimd_Scalar, FFTSimd_AVX2, FFTSimd_AVX512 };
+
+    for(std::size_t log2N = 6; log2N <= 22; log2N += 2)
+    {
+        const std::size_t N = std::size_t(1) << log2N;
+        const std::size_t iterations = std::max<std::size_t>(1, (std::size_t(1) << 24) / (N * log2N));
+        const double flops = 5.0 * static_cast<double>(N) * static_cast<double>(log2N);
+
+        const std::vector<std::complex<double>> signal = generateSignal(N);
+
+        std::vector<std::complex<T>> interleaved(N);
+
+        for(std::size_t i = 0; i < N; i++)
+        {
+            interleaved[i] = std::complex<T>(signal[i]);
+        }
+
+        /* Interleaved std::complex reference */
+        FFTPlan<T> plan(N);
+
+        std::vector<std::complex<T>> reference = interleaved;
+        plan.execute(reference.data());
+
+        BenchmarkTimer timer;
+
+        std::vector<std::complex<T>> data = interleaved;
+
+        timer.start();
+
+        for(std::size_t i = 0; i < iterations; i++)
+        {
+            plan.execute(data.data());
+        }
+
+        const double interleaved_time = timer.elapsed_ms() / static_cast<double>(iterations);
+
+        std::cout << "N = 2^" << std::setw(2) << log2N
+                  << "  interleaved " << std::fixed << std::setprecision(2) << flops / (interleaved_time * 1e6) << " GFLOPS";
+
+        for(const FFTSimd simd : simds)
+        {
+            FFTSplitEngine<T> engine(N, simd);
+
+            if(engine.simd() != simd)
+            {
+                continue;
+            }
+
+            std::vector<T> re(N);
+            std::vector<T> im(N);
+
+            for(std::size_t i = 0; i < N; i++)
+            {
+                re[i] = interleaved[i].real();
+                im[i] = interleaved[i].imag();
+            }
+
+            engine.template execute<FFTDirection_Forward>(re.data(), im.data());
+
+            double max_error = 0.0;
+            double max_ref = 0.0;
+
+            for(std::size_t i = 0; i < N; i++)
+            {
+                max_error = std::max(max_error, static_cast<double>(std::abs(std::complex<T>(re[i], im[i]) - reference[i])));
+                max_ref = std::max(max_ref, static_cast<double>(std::abs(reference[i])));
+            }
+
+            timer.start();
+
+            for(std::size_t i = 0; i < iterations; i++)
+            {
+                engine.template execute<FFTDirection_Forward>(re.data(), im.data());
+            }
+
+            const double time = timer.elapsed_ms() / static_cast<double>(iterations);
+
+            std::cout << "  " << fft_simd_to_string(simd) << " " << std::setprecision(2) << flops / (time * 1e6) << " GFLOPS"
+                      << " (err " << std::scientific << std::setprecision(0) << max_error / max_ref << std::fixed << ")";
+        }
+
+        std::cout << std::defaultfloat << std::endl;
+    }
+}
+
+/* r2c against a complex transform of the same real signal */
+void runRealBenchmark() noexcept
+{
+    std::cout << "\n=== Real-input FFT (r2c / c2r) ===" << std::endl;
+
+    const std::size_t sizes[] = { 1, 2, 3, 5, 8, 15, 64, 100, 1000, 1024, 1 << 12, 1 << 16, 1000000, 1 << 20 };
+
+    for(const std::size_t N : sizes)
+    {
+        const std::vector<std::complex<double>> signal = generateSignal(N);
+
+        std::vector<double> real(N);
+        std::vector<std::complex<double>> complex(N);
+
+        for(std::size_t i = 0; i < N; i++)
+        {
+            real[i] = signal[i].real();
+            complex[i] = std::complex<double>(signal[i].real(), 0.0);
+        }
+
+        FFTPlan<double> complex_plan(N);
+        FFTRealPlan<double> real_plan(N);
+
+        std::vector<std::complex<double>> reference = complex;
+        complex_plan.execute(reference.data());
+
+        std::vector<std::complex<double>> spectrum(real_plan.spectrum_size());
+        real_plan.forward(real.data(), spectrum.data());
+
+        std::vector<double> roundtrip(N);
+        real_plan.backward(spectrum.data(), roundtrip.data());
+
+        double forward_error = 0.0;
+        double roundtrip_error = 0.0;
+        double max_ref = 1e-300;
+
+        for(std::size_t k = 0; k < spectrum.size(); k++)
+        {
+            forward_error = std::max(forward_error, std::abs(spectrum[k] - reference[k]));
+            max_ref = std::max(max_ref, std::abs(reference[k]));
+        }
+
+        for(std::size_t i = 0; i < N; i++)
+        {
+            roundtrip_error = std::max(roundtrip_error, std::abs(roundtrip[i] / static_cast<double>(N) - real[i]));
+        }
+
+        const std::size_t iterations = std::max<std::size_t>(1, (std::size_t(1) << 22) / N);
+
+        BenchmarkTimer timer;
+
+        timer.start();
+
+        for(std::size_t i = 0; i < iterations; i++)
+        {
+            complex_plan.execute(complex.data());
+        }
+
+        const double complex_time = timer.elapsed_ms() / static_cast<double>(iterations);
+
+        timer.start();
+
+        for(std::size_t i = 0; i < iterations; i++)
+        {
+            real_plan.forward(real.data(), spectrum.data());
+        }
+
+        const double real_time = timer.elapsed_ms() / static_cast<double>(iterations);
+
+        std::cout << "N = " << std::setw(7) << N
+                  << "  error " << std::scientific << std::setprecision(1) << forward_error / max_ref
+                  << " roundtrip " << roundtrip_error
+                  << std::fixed << std::setprecision(4)
+                  << "  complex: " << complex_time << " ms  r2c: " << real_time << " ms"
+                  << "  speedup: " << std::setprecision(2) << complex_time / std::max(real_time, 1e-6) << "x"
+                  << std::defaultfloat << std::endl;
+    }
+}
+
+/* Direct multi-dimensional DFT of a row-major array, dims = { n0, n1, ... } */
+std::vector<std::complex<double>> dftDirectND(const std::vector<std::complex<double>>& input,
+                                              const std::vector<std::size_t>& dims) noexcept
+{
+    std::vector<std::complex<double>> res = input;
+
+    std::size_t inner = input.size();
+
+    /* One axis at a time, with direct 1D DFTs along it */
+    for(const std::size_t n : dims)
+    {
+        inner /= n;
+
+        const std::size_t outer = input.size() / (n * inner);
+
+        for(std::size_t o = 0; o < outer; o++)
+        {
+            for(std::size_t i = 0; i < inner; i++)
+            {
+                std::vector<std::complex<double>> line(n);
+
+                for(std::size_t k = 0; k < n; k++)
+                {
+                    line[k] = res[(o * n + k) * inner + i];
+                }
+
+                line = dft_direct(line);
+
+                for(std::size_t k = 0; k < n; k++)
+                {
+                    res[(o * n + k) * inner + i] = line[k];
+                }
+            }
+        }
+    }
+
+    return res;
+}
+
+void runMultiDimensionalBenchmark() noexcept
+{
+    std::cout << "\n=== Batched and multi-dimensional FFT ===" << std::endl;
+
+    {
+        /* 3 interleaved transforms of 10 points: stride 3, distance 1 */
+        const std::vector<std::complex<double>> signal = generateSignal(30);
+        std::vector<std::complex<double>> data = signal;
+
+        FFTBatchPlan<double> batch(10, 3, 3, 1);
+        batch.execute(data.data());
+
+        double error = 0.0;
+
+        for(std::size_t b = 0; b < 3; b++)
+        {
+            std::vector<std::complex<double>> line(10);
+
+            for(std::size_t i = 0; i < 10; i++)
+            {
+                line[i] = signal[b + 3 * i];
+            }
+
+            const std::vector<std::complex<double>> ref = dft_direct(line);
+
+            for(std::size_t i = 0; i < 10; i++)
+            {
+                error = std::max(error, std::abs(data[b + 3 * i] - ref[i]));
+            }
+        }
+
+        std::cout << "Strided batch 3 x 10 error: " << std::scientific << std::setprecision(1) << error << std::defaultfloat << std::endl;
+    }
+
+    {
+        const std::vector<std::complex<double>> signal = generateSignal(12 * 10);
+        std::vector<std::complex<double>> data = signal;
+
+        FFTPlan2D<double> plan(12, 10);
+        plan.execute(data.data());
+
+        const std::vector<std::complex<double>> ref = dftDirectND(signal, { 12, 10 });
+
+        std::cout << "2D 12 x 10 error: " << std::scientific << std::setprecision(1)
+                  << maxRelativeError(data, ref) << std::defaultfloat << std::endl;
+    }
+
+    {
+        const std::vector<std::complex<double>> signal = generateSignal(4 * 6 * 5);
+        std::vector<std::complex<double>> data = signal;
+
+        FFTPlan3D<double> plan(4, 6, 5);
+        plan.execute(data.data());
+
+        const std::vector<std::complex<double>> ref = dftDirectND(signal, { 4, 6, 5 });
+
+        std::cout << "3D 4 x 6 x 5 error: " << std::scientific << std::setprecision(1)
+                  << maxRelativeError(data, ref) << std::defaultfloat << std::endl;
+    }
+
+    {
+        /* Two callers sharing a pool, each with a nested parallel_for, plus two 2D plans on the shared pool */
+        FFTThreadPool pool(4);
+
+        std::atomic<std::size_t> wrong_sums = 0;
+
+        const auto caller = [&] {
+            for(std::size_t run = 0; run < 200; run++)
+            {
+                std::vector<std::size_t> sums(16, 0);
+
+                /* The nested loop runs inline, on the thread of the outer call */
+                pool.parallel_for(16, [&](const std::size_t i, const std::size_t outer) {
+                    pool.parallel_for(8, [&](const std::size_t j, const std::size_t inner) {
+                        sums[i] += inner == outer ? j : 100;
+                    });
+                });
+
+                for(const std::size_t sum : sums)
+                {
+                    wrong_sums += sum != 28;
+                }
+            }
+        };
+
+        const std::vector<std::complex<double>> signal = generateSignal(64 * 64);
+        std::vector<std::complex<double>> ref = signal;
+        FFTPlan2D<double>(64, 64).execute(ref.data());
+
+        std::atomic<std::size_t> wrong_transforms = 0;
+
+        const auto transform = [&] {
+            FFTPlan2D<double> plan(64, 64);
+
+            for(std::size_t run = 0; run < 50; run++)
+            {
+                std::vector<std::complex<double>> data = signal;
+                plan.execute(data.data());
+                wrong_transforms += maxRelativeError(data, ref) > 1e-12;
+            }
+        };
+
+        std::thread a(caller);
+        std::thread b(caller);
+        std::thread c(transform);
+        std::thread d(transform);
+
+        a.join();
+        b.join();
+        c.join();
+        d.join();
+
+        std::cout << "Concurrent and nested parallel_for: " << wrong_sums << " wrong sums, "
+                  << wrong_transforms << " wrong 2D transforms" << std::endl;
+    }
+
+    const std::size_t max_threads = std::max(1u, std::thread::hardware_concurrency());
+
+    std::cout << "Scaling up to " << max_threads << " threads (hardware concurrency)" << std::endl;
+
+    for(std::size_t num_threads = 1; ; num_threads = std::min(2 * num_threads, max_threads))
+    {
+        FFTThreadPool pool(num_threads);
+
+        std::vector<std::complex<double>> frames = generateSignal(1000 * 4096);
+        std::vector<std::complex<double>> image = generateSignal(1024 * 1024);
+        std::vector<std::complex<double>> volume = generateSignal(128 * 128 * 128);
+
+        FFTBatchPlan<double> batch(4096, 1000, 1, 4096, FFTDirection_Forward, FFTPlanFlag_Estimate, pool);
+        FFTPlan2D<double> plan2d(1024, 1024, FFTDirection_Forward, FFTPlanFlag_Estimate, pool);
+        FFTPlan3D<double> plan3d(128, 128, 128, FFTDirection_Forward, FFTPlanFlag_Estimate, pool);
+
+        BenchmarkTimer timer;
+
+        timer.start();
+        batch.execute(frames.data());
+        const double batch_time = timer.elapsed_ms();
+
+        timer.start();
+        plan2d.execute(image.data());
+        const double time2d = timer.elapsed_ms();
+
+        timer.start();
+        plan3d.execute(volume.data());
+        const double time3d = timer.elapsed_ms();
+
+        std::cout << std::setw(3) << num_threads << " threads"
+                  << std::fixed << std::setprecision(2)
+                  << "  1000 x 4096 batch: " << batch_time << " ms"
+                  << "  1024 x 1024: " << time2d << " ms"
+                  << "  128^3: " << time3d << " ms"
+                  << std::defaultfloat << std::endl;
+
+        if(num_threads == max_threads)
+        {
+            break;
+        }
+    }
+}
+
+void runStftBenchmark() noexcept
+{
+    std::cout << "\n=== Streaming STFT / ISTFT ===" << std::endl;
+
+    const std::size_t sample_rate = 192000;
+
+    struct StftConfig
+    {
+        std::size_t frame_size;
+        std::size_t hop;
+        FFTWindow window;
+    };
+
+    const StftConfig configs[] = {
+        { 256, 64, FFTWindow_Hann },
+        { 1024, 256, FFTWindow_Hann },
+        { 1024, 512, FFTWindow_Hamming },
+        { 2048, 512, FFTWindow_Blackman },
+        { 4096, 1024, FFTWindow_Hann },
+    };
+
+    /* 10 seconds of one channel */
+    const std::vector<std::complex<double>> noise = generateSignal(10 * sample_rate);
+
+    std::vector<float> signal(noise.size());
+
+    for(std::size_t i = 0; i < signal.size(); i++)
+    {
+        signal[i] = static_cast<float>(noise[i].real());
+    }
+
+    /* Pushed in blocks of irregular sizes, like an audio callback would */
+    const std::size_t block_sizes[] = { 480, 1, 999, 64, 2048, 333 };
+
+    for(const StftConfig& config : configs)
+    {
+        const std::size_t delay = config.frame_size - config.hop;
+
+        STFT<float> stft(config.frame_size, config.hop, config.window);
+        ISTFT<float> istft(config.frame_size, config.hop, config.window);
+
+        std::vector<float> output;
+        output.reserve(signal.size() + config.frame_size);
+
+        std::size_t frames = 0;
+        std::size_t offset = 0;
+
+        for(std::size_t b = 0; offset < signal.size(); b++)
+        {
+            const std::size_t count = std::min(block_sizes[b % std::size(block_sizes)], signal.size() - offset);
+
+            stft.push(std::span<const float>(signal.data() + offset, count), [&](const std::vector<std::complex<float>>& spectrum) {
+                istft.push(spectrum, [&](const float* samples, const std::size_t n) {
+                    output.insert(output.end(), samples, samples + n);
+                });
+            });
+
+            offset += count;
+        }
+
+        double error = 0.0;
+
+        for(std::size_t i = delay; i < output.size(); i++)
+        {
+            error = std::max(error, std::abs(static_cast<double>(output[i]) - static_cast<double>(signal[i - delay])));
+        }
+
+        BenchmarkTimer timer;
+
+        timer.start();
+
+        for(std::size_t i = 0; i < signal.size(); i += 512)
+        {
+            const std::size_t count = std::min<std::size_t>(512, signal.size() - i);
+
+            stft.push(std::span<const float>(signal.data() + i, count), STFTOutput_Power, [&](const std::vector<float>& power) {
+                frames += power.empty() ? 0 : 1;
+            });
+        }
+
+        const double stft_time = timer.elapsed_ms();
+
+        std::vector<std::complex<float>> spectrum(stft.bins(), std::complex<float>(1.0f, 0.0f));
+
+        timer.start();
+
+        for(std::size_t f = 0; f < frames; f++)
+        {
+            istft.push(spectrum, [&](const float* samples, const std::size_t n) { output.assign(samples, samples + n); });
+        }
+
+        const double istft_time = timer.elapsed_ms();
+
+        /* Number of 192 kHz channels one core keeps up with */
+        const double seconds = static_cast<double>(signal.size()) / static_cast<double>(sample_rate);
+
+        std::cout << "N=" << std::setw(4) << config.frame_size
+                  << " hop=" << std::setw(4) << config.hop
+                  << " " << std::setw(8) << std::left << fft_window_to_string(config.window) << std::right
+                  << " roundtrip error: " << std::scientific << std::setprecision(1) << error
+                  << std::fixed << std::setprecision(2)
+                  << "  STFT: " << std::setw(7) << stft_time << " ms (" << std::setw(6) << seconds * 1000.0 / stft_time << " ch)"
+                  << "  ISTFT: " << std::setw(7) << istft_time << " ms (" << std::setw(6) << seconds * 1000.0 / istft_time << " ch)"
+                  << std::defaultfloat << std::endl;
+    }
+}
+
+/* The O(N * K) convolution sum */
+std::vector<double> convolveDirect(const std::vector<double>& x, const std::vector<double>& h) noexcept
+{
+    std::vector<double> res(x.size() + h.size() - 1, 0.0);
+
+    for(std::size_t i = 0; i < x.size(); i++)
+    {
+        for(std::size_t k = 0; k < h.size(); k++)
+        {
+            res[i + k] += x[i] * h[k];
+        }
+    }
+
+    return res;
+}
+
+void runConvolutionBenchmark() noexcept
+{
+    std::cout << "\n=== FFT convolution / correlation / FIR ===" << std::endl;
+
+    const auto realSignal = [](const std::size_t N, const std::size_t offset) {
+        const std::vector<std::complex<double>> noise = generateSignal(N + offset);
+        std::vector<double> res(N);
+
+        for(std::size_t i = 0; i < N; i++)
+        {
+            res[i] = noise[i + offset].real();
+        }
+
+        return res;
+    };
+
+    const std::pair<std::size_t, std::size_t> shapes[] = { { 1, 1 }, { 5, 3 }, { 3, 5 }, { 100, 1 }, { 1000, 96 }, { 1000, 97 }, { 5000, 700 }, { 777, 2000 } };
+
+    for(const auto& [N, K] : shapes)
+    {
+        const std::vector<double> x = realSignal(N, 0);
+        const std::vector<double> h = realSignal(K, N);
+
+        const std::vector<double> ref = convolveDirect(x, h);
+        const std::vector<double> ref_corr = convolveDirect(x, std::vector<double>(h.rbegin(), h.rend()));
+
+        double error = 0.0;
+
+        for(const FIRMethod method : { FIRMethod_Direct, FIRMethod_OverlapSave })
+        {
+            const std::vector<double> res = convolve(x, h, method);
+            const std::vector<double> corr = correlate(x, h, method);
+
+            if(res.size() != ref.size() || corr.size() != ref_corr.size())
+            {
+                error = std::numeric_limits<double>::infinity();
+                break;
+            }
+
+            for(std::size_t i = 0; i < ref.size(); i++)
+            {
+                error = std::max(error, std::abs(res[i] - ref[i]));
+                error = std::max(error, std::abs(corr[i] - ref_corr[i]));
+            }
+        }
+
+        /* Streaming, pushed in blocks of irregular sizes, the output is the first N samples of the convolution */
+        FIRFilter<double> filter(h);
+        std::vector<double> streamed;
+
+        const std::size_t block_sizes[] = { 7, 1, 300, 64, 4097 };
+
+        for(std::size_t b = 0, offset = 0; offset < N; b++)
+        {
+            const std::size_t count = std::min(block_sizes[b % std::size(block_sizes)], N - offset);
+
+            filter.push(x.data() + offset, count, [&](const double* samples, const std::size_t n) {
+                streamed.insert(streamed.end(), samples, samples + n);
+            });
+
+            offset += count;
+        }
+
+        filter.flush([&](const double* samples, const std::size_t n) { streamed.insert(streamed.end(), samples, samples + n); });
+
+        for(std::size_t i = 0; i < N; i++)
+        {
+            error = std::max(error, i < streamed.size() ? std::abs(streamed[i] - ref[i]) : std::numeric_limits<double>::infinity());
+        }
+
+        std::cout << "N=" << std::setw(5) << N << " K=" << std::setw(5) << K
+                  << " max error: " << std::scientific << std::setprecision(1) << error << std::defaultfloat << std::endl;
+    }
+
+    /* Crossover, samples per second filtered by each path */
+    const std::size_t N = 1 << 18;
+    const std::size_t taps[] = { 4, 8, 16, 24, 32, 48, 64, 96, 128, 256, 1024, 4096, 16384, 65536 };
+
+    const std::vector<double> noise = realSignal(N, 0);
+    const std::vector<float> x(noise.begin(), noise.end());
+
+    std::cout << "Filtering " << N << " float samples" << std::endl;
+
+    for(const std::size_t K : taps)
+    {
+        const std::vector<float> h(x.begin(), x.begin() + K);
+
+        double times[2] = { 0.0, 0.0 };
+
+        for(const FIRMethod method : { FIRMethod_Direct, FIRMethod_OverlapSave })
+        {
+            /* Direct path with the largest kernels would take minutes */
+            if(method == FIRMethod_Direct && K > 4096)
+            {
+                continue;
+            }
+
+            FIRFilter<float> filter(h, method);
+            float last = 0.0f;
+
+            const auto keep = [&](const float* samples, const std::size_t n) { last = samples[n - 1]; };
+
+            /* Best of 3 */
+            for(std::size_t run = 0; run < 3; run++)
+            {
+                BenchmarkTimer timer;
+
+                timer.start();
+
+                filter.push(x.data(), x.size(), keep);
+                filter.flush(keep);
+
+                const double time = timer.elapsed_ms();
+
+                times[method] = run == 0 ? time : std::min(times[method], time);
+            }
+
+            (void)last;
+        }
+
+        std::cout << "K=" << std::setw(5) << K << std::fixed << std::setprecision(2);
+
+        if(times[FIRMethod_Direct] > 0.0)
+        {
+            std::cout << "  direct: " << std::setw(8) << times[FIRMethod_Direct] << " ms";
+        }
+        else
+        {
+            std::cout << "  direct: " << std::setw(8) << "-" << "   ";
+        }
+
+        std::cout << "  overlap-save: " << std::setw(7) << times[FIRMethod_OverlapSave] << " ms"
+                  << "  (auto: " << fir_method_to_string(FIRFilter<float>(h).method()) << ")"
+                  << std::defaultfloat << std::endl;
+    }
+}
+
+void runGoertzelBenchmark() noexcept
+{
+    std::cout << "\n=== Goertzel / sliding DFT ===" << std::endl;
+
+    /* Accuracy, real and complex input, against the direct sum */
+    for(const std::size_t N : { 1, 7, 205, 1000, 4096 })
+    {
+        const std::vector<std::complex<double>> signal = generateSignal(N);
+
+        std::vector<double> real(N);
+
+        for(std::size_t i = 0; i < N; i++)
+        {
+            real[i] = signal[i].real();
+        }
+
+        std::vector<std::size_t> bins;
+
+        for(std::size_t k = 0; k < N + 3; k += std::max<std::size_t>(1, N / 9))
+        {
+            bins.push_back(k);
+        }
+
+        const std::vector<std::complex<double>> ref = dft_direct(signal);
+        const std::vector<std::complex<double>> ref_real = dft_direct(real);
+
+        const std::vector<std::complex<double>> res = dft_bins(signal, bins);
+        const std::vector<std::complex<double>> res_real = dft_bins(real, bins);
+
+        double error = 0.0;
+
+        for(std::size_t i = 0; i < bins.size(); i++)
+        {
+            error = std::max(error, std::abs(res[i] - ref[bins[i] % N]) / std::sqrt(static_cast<double>(N)));
+            error = std::max(error, std::abs(res_real[i] - ref_real[bins[i] % N]) / std::sqrt(static_cast<double>(N)));
+        }
+
+        std::cout << "N=" << std::setw(5) << N << " " << std::setw(2) << bins.size() << " bins, error: "
+                  << std::scientific << std::setprecision(1) << error << std::defaultfloat << std::endl;
+    }
+
+    /* Cost against a full real FFT, per transform */
+    for(const std::size_t N : { 205, 1024, 4096, 1 << 16 })
+    {
+        const std::vector<std::complex<double>> signal = generateSignal(N);
+
+        std::vector<double> real(N);
+
+        for(std::size_t i = 0; i < N; i++)
+        {
+            real[i] = signal[i].real();
+        }
+
+        FFTRealPlan<double> plan(N);
+        std::vector<std::complex<double>> spectrum(plan.spectrum_size());
+
+        const std::size_t iterations = std::max<std::size_t>(1, (std::size_t(1) << 22) / N);
+
+        BenchmarkTimer timer;
+
+        timer.start();
+
+        for(std::size_t i = 0; i < iterations; i++)
+        {
+            plan.forward(real.data(), spectrum.data());
+        }
+
+        const double fft_time = timer.elapsed_ms() / static_cast<double>(iterations);
+
+        std::cout << "N=" << std::setw(5) << N << std::fixed << std::setprecision(4) << "  real FFT: " << fft_time * 1000.0 << " us  Goertzel:";
+
+        for(const std::size_t count : { 1, 2, 4, 8, 16, 32 })
+        {
+            std::vector<std::size_t> bins(count);
+            std::vector<std::complex<double>> values(count);
+
+            for(std::size_t i = 0; i < count; i++)
+            {
+                bins[i] = (i * 37 + 3) % (N / 2 + 1);
+            }
+
+            timer.start();
+
+            for(std::size_t i = 0; i < iterations; i++)
+            {
+                goertzel_bins(real.data(), N, bins.data(), count, values.data());
+            }
+
+            const double time = timer.elapsed_ms() / static_cast<double>(iterations);
+
+            std::cout << "  " << count << ": " << time * 1000.0 << " us";
+        }
+
+        std::cout << std::defaultfloat << std::endl;
+    }
+
+    /* Sliding DFT, the 8 DTMF frequencies at 8 kHz with the classic 205-point window */
+    {
+        const std::size_t N = 205;
+        const std::vector<std::size_t> bins = { 18, 20, 22, 24, 31, 34, 38, 42 };
+        const std::size_t num_samples = 4000000;
+
+        const std::vector<std::complex<double>> noise = generateSignal(num_samples);
+
+        std::vector<double> signal(num_samples);
+
+        for(std::size_t i = 0; i < num_samples; i++)
+        {
+            signal[i] = noise[i].real();
+        }
+
+        SlidingDFT<double> sliding(N, bins);
+
+        BenchmarkTimer timer;
+
+        timer.start();
+
+        sliding.push(std::span<const double>(signal.data(), signal.size()));
+
+        const double time = timer.elapsed_ms();
+
+        const std::vector<double> window(signal.end() - N, signal.end());
+        const std::vector<std::complex<double>> ref = dft_bins(window, bins);
+
+        double error = 0.0;
+
+        for(std::size_t i = 0; i < bins.size(); i++)
+        {
+            error = std::max(error, std::abs(sliding.values()[i] - ref[i]));
+        }
+
+        std::cout << "Sliding DFT N=205, 8 bins, " << num_samples << " samples: " << std::fixed << std::setprecision(2)
+                  << time * 1e6 / static_cast<double>(num_samples) << " ns/sample, error after the last sample: "
+                  << std::scientific << std::setprecision(1) << error << std::defaultfloat << std::endl;
+    }
+}
+
+void runNttBenchmark() noexcept
+{
+    std::cout << "\n=== NTT / modular polynomial products ===" << std::endl;
+
+    std::mt19937_64 gen(42);
+
+    /* 998244353 = 119 * 2^23 + 1 takes one NTT, the others the three primes and the CRT */
+    const std::uint32_t moduli[] = { 998244353, 1000000007, 4294967291, 2 };
+    const std::pair<std::size_t, std::size_t> shapes[] = { { 1, 1 }, { 33, 33 }, { 100, 3000 }, { 4097, 5000 } };
+
+    for(const std::uint32_t modulus : moduli)
+    {
+        std::size_t mismatches = 0;
+
+        for(const auto& [n, m] : shapes)
+        {
+            std::vector<std::uint64_t> a(n);
+            std::vector<std::uint64_t> b(m);
+
+            for(auto& x : a)
+            {
+                x = gen();
+            }
+
+            for(auto& x : b)
+            {
+                x = gen();
+            }
+
+            const std::vector<std::uint32_t> res = ntt_convolve(a, b, modulus);
+            const std::vector<std::uint32_t> ref = ntt_convolve_direct(a, b, modulus);
+
+            for(std::size_t i = 0; i < ref.size(); i++)
+            {
+                mismatches += i >= res.size() || res[i] != ref[i];
+            }
+        }
+
+        std::cout << "mod " << std::setw(10) << modulus << ": " << mismatches << " mismatches against the direct product" << std::endl;
+    }
+
+    /* Modulus 0 and three-prime products longer than NTT_MAX_SIZE are rejected, the data are never read */
+    struct Zeros
+    {
+        std::size_t n;
+
+        std::size_t size() const noexcept { return this->n; }
+        std::uint64_t operator[](const std::size_t) const noexcept { return 0; }
+    };
+
+    const bool rejected = ntt_convolve(Zeros{ 100 }, Zeros{ 100 }, 0).empty() &&
+                          ntt_convolve(Zeros{ NTT_MAX_SIZE / 2 + 1 }, Zeros{ NTT_MAX_SIZE / 2 + 1 }, 1000000007).empty();
+
+    std::cout << "Invalid modulus and oversized products " << (rejected ? "rejected" : "NOT rejected") << std::endl;
+
+    /* Forward + inverse, every SIMD level gives the same residues */
+    for(const std::size_t N : { 1 << 10, 1 << 16, 1 << 20, 1 << 22 })
+    {
+        std::vector<std::uint32_t> input(N);
+
+        for(auto& x : input)
+        {
+            x = static_cast<std::uint32_t>(gen() % NTT_PRIMES[0]);
+        }
+
+        std::vector<std::uint32_t> reference;
+
+        std::cout << "N = 2^" << std::setw(2) << log2_floor(N) << " per transform" << std::fixed << std::setprecision(1);
+
+        for(const FFTSimd simd : { FFTSimd_Scalar, FFTSimd_AVX2, FFTSimd_AVX512 })
+        {
+            if(simd > fft_detect_simd())
+            {
+                continue;
+            }
+
+            NTTPlan plan(N, NTT_PRIMES[0], simd);
+            std::vector<std::uint32_t> data(input);
+
+            const std::size_t runs = std::max<std::size_t>(1, (1 << 22) / N);
+
+            BenchmarkTimer timer;
+            timer.start();
+
+            for(std::size_t run = 0; run < runs; run++)
+            {
+                plan.forward(data.data());
+                plan.inverse(data.data());
+            }
+
+            const double time = 1000.0 * timer.elapsed_ms() / static_cast<double>(2 * runs);
+
+            plan.forward(data.data());
+
+            if(reference.empty())
+            {
+                reference = data;
+            }
+
+            std::cout << "  " << fft_simd_to_string(simd) << ": " << std::setw(9) << time << " us"
+                      << (data == reference ? "" : " (differs)");
+        }
+
+        std::cout << std::defaultfloat << std::endl;
+    }
+
+    /* Products of two polynomials of n terms modulo 1e9 + 7 */
+    for(const std::size_t n : { 16, 32, 64, 256, 1000, 10000, 100000, 1000000 })
+    {
+        std::vector<std::uint32_t> a(n);
+        std::vector<std::uint32_t> b(n);
+
+        for(std::size_t i = 0; i < n; i++)
+        {
+            a[i] = static_cast<std::uint32_t>(gen() % 1000000007);
+            b[i] = static_cast<std::uint32_t>(gen() % 1000000007);
+        }
+
+        /* Plans built out of the timing */
+        (void)ntt_convolve(a, b, 1000000007);
+
+        BenchmarkTimer timer;
+
+        timer.start();
+        const std::vector<std::uint32_t> res = ntt_convolve(a, b, 1000000007);
+        const double ntt_time = timer.elapsed_ms();
+
+        std::cout << "n = " << std::setw(7) << n << std::fixed << std::setprecision(3)
+                  << "  NTT + CRT: " << std::setw(9) << ntt_time << " ms";
+
+        if(n <= 10000)
+        {
+            timer.start();
+            const std::vector<std::uint32_t> ref = ntt_convolve_direct(a, b, 1000000007);
+            const double direct_time = timer.elapsed_ms();
+
+            std::cout << "  direct: " << std::setw(9) << direct_time << " ms" << (res == ref ? "" : " (differs)");
+        }
+
+        std::cout << std::defaultfloat << std::endl;
+    }
+}
+
+void runFourStepBenchmark() noexcept
+{
+    std::cout << "\n=== Four-step FFT / out-of-core FFT ===" << std::endl;
+
+    /* Powers of two, a mixed radix, a prime that runs one FFTPlan, and a small panel that splits the passes */
+    const std::pair<std::size_t, std::size_t> cases[] = { { 1 << 12, FFT_FOUR_STEP_PANEL_BYTES },
+                                                          { 1 << 13, FFT_FOUR_STEP_PANEL_BYTES },
+                                                          { 3 * 5 * 7 * 64, FFT_FOUR_STEP_PANEL_BYTES },
+                                                          { 10007, FFT_FOUR_STEP_PANEL_BYTES },
+                                                          { 1 << 16, 16 << 10 } };
+
+    for(const auto& [N, panel_bytes] : cases)
+    {
+        const std::vector<std::complex<double>> signal = generateSignal(N);
+
+        std::vector<std::complex<double>> ref = signal;
+        FFTPlan<double>(N).execute(ref.data());
+
+        FFTFourStepPlan<double> forward(N, FFTDirection_Forward, FFTPlanFlag_Estimate, fft_thread_pool(), panel_bytes);
+        FFTFourStepPlan<double> backward(N, FFTDirection_Backward, FFTPlanFlag_Estimate, fft_thread_pool(), panel_bytes);
+
+        std::vector<std::complex<double>> res(N);
+        std::vector<std::complex<double>> back(N);
+
+        forward.execute(signal.data(), res.data());
+        backward.execute(res.data(), back.data());
+
+        for(auto& x : back)
+        {
+            x /= static_cast<double>(N);
+        }
+
+        std::cout << "N = " << std::setw(6) << N << " = " << std::setw(3) << forward.factors().first << " x " << std::setw(5) << forward.factors().second
+                  << "  error against FFTPlan: " << std::scientific << std::setprecision(1) << maxRelativeError(res, ref)
+                  << "  roundtrip: " << maxRelativeError(back, signal) << std::defaultfloat << std::endl;
+    }
+
+    /* Out of cache: both transform the same input, out-of-place for the four-step plan. In memory FFTPlan wins or ties */
+    for(std::size_t N = 1 << 16; N <= (1 << 25); N *= 2)
+    {
+        const std::vector<std::complex<double>> signal = generateSignal(N);
+
+        FFTPlan<double> plan(N);
+        FFTFourStepPlan<double> four_step(N);
+
+        std::vector<std::complex<double>> data = signal;
+        std::vector<std::complex<double>> res(N);
+
+        BenchmarkTimer timer;
+
+        timer.start();
+        plan.execute(data.data());
+        const double plan_time = timer.elapsed_ms();
+
+        timer.start();
+        four_step.execute(signal.data(), res.data());
+        const double four_step_time = timer.elapsed_ms();
+
+        const double flops = 5.0 * static_cast<double>(N) * static_cast<double>(log2_floor(N));
+
+        std::cout << "N = 2^" << std::setw(2) << log2_floor(N) << std::fixed << std::setprecision(2)
+                  << "  FFTPlan: " << std::setw(8) << plan_time << " ms (" << std::setw(5) << flops / (plan_time * 1e6) << " GFlops)"
+                  << "  four-step: " << std::setw(8) << four_step_time << " ms (" << std::setw(5) << flops / (four_step_time * 1e6) << " GFlops)"
+                  << std::defaultfloat << std::endl;
+
+        if(maxRelativeError(res, data) > 1e-9)
+        {
+            std::cout << "  four-step result differs" << std::endl;
+        }
+    }
+
+    /* Through files, with a budget far smaller than the data */
+    {
+        constexpr std::size_t N = 1 << 22;
+        constexpr std::size_t budget = 8 << 20;
+
+        const std::string in_path = (std::filesystem::temp_directory_path() / "fft_file_input.bin").string();
+        const std::string out_path = (std::filesystem::temp_directory_path() / "fft_file_output.bin").string();
+
+        const std::vector<std::complex<double>> signal = generateSignal(N);
+
+        std::ofstream(in_path, std::ios::binary).write(reinterpret_cast<const char*>(signal.data()), N * sizeof(std::complex<double>));
+
+        BenchmarkTimer timer;
+
+        timer.start();
+        const bool ok = fft_file<double>(in_path, out_path, FFTDirection_Forward, budget);
+        const double file_time = timer.elapsed_ms();
+
+        std::vector<std::complex<double>> res(N);
+        std::ifstream(out_path, std::ios::binary).read(reinterpret_cast<char*>(res.data()), N * sizeof(std::complex<double>));
+
+        std::vector<std::complex<double>> ref = signal;
+        FFTPlan<double>(N).execute(ref.data());
+
+        std::cout << "File of 2^22 points (64 MB), 8 MB budget: " << std::fixed << std::setprecision(2) << file_time << " ms"
+                  << std::defaultfloat << "  error: " << std::scientific << std::setprecision(1)
+                  << (ok ? maxRelativeError(res, ref) : 1.0) << std::defaultfloat << std::endl;
+
+        std::filesystem::remove(in_path);
+        std::filesystem::remove(out_path);
+    }
+}
+
+int main(int argc, char** argv) noexcept
+{
+    std::cout << "DFT / FFT Benchmark" << std::endl;
+
+    runAccuracyCheck();
+    runDirectBenchmark();
+    runFFTBenchmark();
+    runArbitrarySizeAccuracyCheck();
+    runArbitrarySizeBenchmark();
+    runPlanBenchmark();
+    runRealBenchmark();
+    runMultiDimensionalBenchmark();
+    runStftBenchmark();
+    runConvolutionBenchmark();
+    runGoertzelBenchmark();
+    runNttBenchmark();
+    runFourStepBenchmark();
+    runSimdBenchmark<double>("double");
+    runSimdBenchmark<float>("float");
+
+    return 0;
+}
@@ -0,0 +1,3390 @@
+#pragma once
+
+#define _USE_MATH_DEFINES
+
+#include <complex>
+#include <vector>
+#include <cmath>
+#include <cstdint>
+#include <cstddef>
+#include <utility>
+#include <unordered_map>
+#include <algorithm>
+#include <memory>
+#include <map>
+#include <mutex>
+#include <string>
+#include <fstream>
+#include <sstream>
+#include <iostream>
+#include <chrono>
+#include <limits>
+#include <cstring>
+#include <thread>
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <span>
+#include <type_traits>
+
+/*
+    https://en.wikipedia.org/wiki/Cooley%E2%80%93Tukey_FFT_algorithm
+    https://en.wikipedia.org/wiki/Split-radix_FFT_algorithm
+    https://en.wikipedia.org/wiki/Rader%27s_FFT_algorithm
+    https://en.wikipedia.org/wiki/Chirp_Z-transform#Bluestein's_algorithm
+
+    Conventions, same as FFTW:
+    - forward transform is X[k] = sum x[n] * exp(-2πi * n * k / N)
+    - backward transform uses exp(+2πi * n * k / N) and is not normalized, backward(forward(x)) = N * x
+*/
+
+enum FFTDirection : std::uint8_t
+{
+    FFTDirection_Forward,
+    FFTDirection_Backward,
+};
+
+enum FFTAlgorithm : std::uint8_t
+{
+    FFTAlgorithm_Radix2,
+    FFTAlgorithm_Radix4, /* radix-2^2 stages, plus one radix-2 stage when log2(N) is odd */
+    FFTAlgorithm_SplitRadix,
+    FFTAlgorithm_MixedRadix, /* Stockham stages of radix 2, 3, 4, 5, 7, 11, 13, larger primes through a sub-transform */
+    FFTAlgorithm_Rader, /* prime N, cyclic convolution of length N - 1 */
+    FFTAlgorithm_Bluestein, /* any N, chirp-z convolution of power-of-two length */
+    FFTAlgorithm_Auto, /* let the planner decide */
+};
+
+const char* fft_algorithm_to_string(std::uint8_t algorithm)
+{
+    switch(algorithm)
+    {
+        case FFTAlgorithm_Radix2:
+            return "Radix2";
+        case FFTAlgorithm_Radix4:
+            return "Radix4";
+        case FFTAlgorithm_SplitRadix:
+            return "SplitRadix";
+        case FFTAlgorithm_MixedRadix:
+            return "MixedRadix";
+        case FFTAlgorithm_Rader:
+            return "Rader";
+        case FFTAlgorithm_Bluestein:
+            return "Bluestein";
+        case FFTAlgorithm_Auto:
+            return "Auto";
+        default:
+            return "Unknown Algorithm";
+    }
+}
+
+inline constexpr bool is_power_of_two(const std::size_t n) noexcept
+{
+    return n != 0 && (n & (n - 1)) == 0;
+}
+
+inline constexpr std::size_t log2_floor(std::size_t n) noexcept
+{
+    std::size_t res = 0;
+
+    while(n >>= 1)
+    {
+        res++;
+    }
+
+    return res;
+}
+
+/* Prime factors of n in increasing order, with multiplicity */
+inline std::vector<std::size_t> prime_factors(std::size_t n) noexcept
+{
+    std::vector<std::size_t> factors;
+
+    for(std::size_t p = 2; p * p <= n; p++)
+    {
+        while(n % p == 0)
+        {
+            factors.push_back(p);
+            n /= p;
+        }
+    }
+
+    if(n > 1)
+    {
+        factors.push_back(n);
+    }
+
+    return factors;
+}
+
+inline bool is_prime(const std::size_t n) noexcept
+{
+    return n >= 2 && prime_factors(n).size() == 1;
+}
+
+inline std::uint64_t pow_mod(std::uint64_t base, std::uint64_t exp, const std::uint64_t mod) noexcept
+{
+    std::uint64_t res = 1;
+
+    base %= mod;
+
+    while(exp > 0)
+    {
+        if(exp & 1)
+        {
+            res = static_cast<std::uint64_t>((static_cast<unsigned __int128>(res) * base) % mod);
+        }
+
+        base = static_cast<std::uint64_t>((static_cast<unsigned __int128>(base) * base) % mod);
+        exp >>= 1;
+    }
+
+    return res;
+}
+
+/* Smallest generator of the multiplicative group modulo the prime p */
+inline std::size_t primitive_root(const std::size_t p) noexcept
+{
+    if(p == 2)
+    {
+        return 1;
+    }
+
+    std::vector<std::size_t> factors = prime_factors(p - 1);
+    factors.erase(std::unique(factors.begin(), factors.end()), factors.end());
+
+    for(std::size_t g = 2; g < p; g++)
+    {
+        bool generator = true;
+
+        for(const std::size_t q : factors)
+        {
+            if(pow_mod(g, (p - 1) / q, p) == 1)
+            {
+                generator = false;
+                break;
+            }
+        }
+
+        if(generator)
+        {
+            return g;
+        }
+    }
+
+    return 0;
+}
+
+/*
+    std::complex operator* checks for NaN/inf (__muldc3) unless compiled with -ffast-math,
+    which costs a call per multiplication and blocks vectorization
+*/
+template<typename T>
+inline std::complex<T> cmul(const std::complex<T>& a, const std::complex<T>& b) noexcept
+{
+    return std::complex<T>(a.real() * b.real() - a.imag() * b.imag(),
+                           a.real() * b.imag() + a.imag() * b.real());
+}
+
+/* Multiplies by -i (forward) or +i (backward) */
+template<FFTDirection direction, typename T>
+inline std::complex<T> mul_minus_i(const std::complex<T>& a) noexcept
+{
+    if constexpr(direction == FFTDirection_Forward)
+    {
+        return std::complex<T>(a.imag(), -a.real());
+    }
+    else
+    {
+        return std::complex<T>(-a.imag(), a.real());
+    }
+}
+
+/* Forward twiddles are stored, backward ones are their conjugates */
+template<FFTDirection direction, typename T>
+inline std::complex<T> twiddle(const std::complex<T>& w) noexcept
+{
+    if constexpr(direction == FFTDirection_Forward)
+    {
+        return w;
+    }
+    else
+    {
+        return std::conj(w);
+    }
+}
+
+/* exp(-2πi * k / N), computed in long double so large tables stay accurate to the last bit */
+template<typename T>
+inline std::complex<T> root_of_unity(const std::size_t k, const std::size_t N) noexcept
+{
+    const long double angle = -2.0L * static_cast<long double>(M_PI) * static_cast<long double>(k) / static_cast<long double>(N);
+
+    return std::complex<T>(static_cast<T>(std::cos(angle)), static_cast<T>(std::sin(angle)));
+}
+
+/* Precomputed tables for a power-of-two size, built once and reused by every transform of that size */
+template<typename T>
+struct FFTTables
+{
+    std::size_t N;
+    std::size_t log2N;
+
+    /* bitrev[i] = i with its log2N bits reversed */
+    std::vector<std::uint32_t> bitrev;
+
+    /* exp(-2πi * k / N), k < N, used with a stride by the radix-2 and split-radix kernels */
+    std::vector<std::complex<T>> twiddles;
+
+    /* Radix-4 stages of size 4h, in order: (w^k, w^2k, w^3k) with w = exp(-2πi / 4h), for k < h, contiguous */
+    std::vector<std::complex<T>> radix4_twiddles;
+
+    FFTTables() noexcept : N(0), log2N(0) {}
+
+    explicit FFTTables(const std::size_t N) : N(N), log2N(log2_floor(N)), bitrev(N), twiddles(N)
+    {
+        for(std::size_t i = 0; i < N; i++)
+        {
+            std::uint32_t r = 0;
+
+            for(std::size_t b = 0; b < this->log2N; b++)
+            {
+                r |= static_cast<std::uint32_t>((i >> b) & 1) << (this->log2N - 1 - b);
+            }
+
+            this->bitrev[i] = r;
+            this->twiddles[i] = root_of_unity<T>(i, N);
+        }
+
+        for(std::size_t h = (this->log2N % 2 == 1) ? 2 : 1; 4 * h <= N; h *= 4)
+        {
+            const std::size_t stride = N / (4 * h);
+
+            for(std::size_t k = 0; k < h; k++)
+            {
+                this->radix4_twiddles.push_back(this->twiddles[k * stride]);
+                this->radix4_twiddles.push_back(this->twiddles[2 * k * stride]);
+                this->radix4_twiddles.push_back(this->twiddles[3 * k * stride]);
+            }
+        }
+    }
+};
+
+template<typename T>
+void bit_reverse_permute(std::complex<T>* data, const FFTTables<T>& tables) noexcept
+{
+    for(std::size_t i = 0; i < tables.N; i++)
+    {
+        const std::size_t j = tables.bitrev[i];
+
+        /* Each pair is swapped once */
+        if(i < j)
+        {
+            std::swap(data[i], data[j]);
+        }
+    }
+}
+
+/* Iterative decimation in time, in-place, expects bit-reversed input */
+template<FFTDirection direction, typename T>
+void fft_radix2_stages(std::complex<T>* data, const FFTTables<T>& tables) noexcept
+{
+    const std::size_t N = tables.N;
+
+    for(std::size_t h = 1; h < N; h *= 2)
+    {
+        const std::size_t stride = N / (2 * h);
+
+        for(std::size_t b = 0; b < N; b += 2 * h)
+        {
+            for(std::size_t k = 0; k < h; k++)
+            {
+                const std::complex<T> a = data[b + k];
+                const std::complex<T> c = cmul(data[b + k + h], twiddle<direction>(tables.twiddles[k * stride]));
+
+                data[b + k] = a + c;
+                data[b + k + h] = a - c;
+            }
+        }
+    }
+}
+
+/*
+    Two radix-2 stages (half sizes h and 2h) fused into one pass over blocks of 4h, expects bit-reversed input.
+    With w = exp(-2πi / 4h):
+
+        t0 = x0 + w^2k x1    t2 = w^k x2 + w^3k x3
+        t1 = x0 - w^2k x1    t3 = w^k x2 - w^3k x3
+
+        X0 = t0 + t2         X1 = t1 - i t3
+        X2 = t0 - t2         X3 = t1 + i t3
+
+    3 complex multiplications per 4 points instead of 4, and half the passes over memory.
+*/
+template<FFTDirection direction, typename T>
+void fft_radix4_stages(std::complex<T>* data, const FFTTables<T>& tables) noexcept
+{
+    const std::size_t N = tables.N;
+
+    std::size_t h = 1;
+
+    /* Odd number of stages, the first one is a plain radix-2 stage with twiddle 1 */
+    if(tables.log2N % 2 == 1)
+    {
+        for(std::size_t b = 0; b < N; b += 2)
+        {
+            const std::complex<T> a = data[b];
+            const std::complex<T> c = data[b + 1];
+
+            data[b] = a + c;
+            data[b + 1] = a - c;
+        }
+
+        h = 2;
+    }
+
+    const std::complex<T>* w = tables.radix4_twiddles.data();
+
+    for(; 4 * h <= N; h *= 4)
+    {
+        for(std::size_t b = 0; b < N; b += 4 * h)
+        {
+            std::complex<T>* x = data + b;
+
+            for(std::size_t k = 0; k < h; k++)
+            {
+                const std::complex<T> w1 = twiddle<direction>(w[3 * k]);
+                const std::complex<T> w2 = twiddle<direction>(w[3 * k + 1]);
+                const std::complex<T> w3 = twiddle<direction>(w[3 * k + 2]);
+
+                const std::complex<T> x0 = x[k];
+                const std::complex<T> x1 = cmul(x[k + h], w2);
+                const std::complex<T> x2 = cmul(x[k + 2 * h], w1);
+                const std::complex<T> x3 = cmul(x[k + 3 * h], w3);
+
+                const std::complex<T> t0 = x0 + x1;
+                const std::complex<T> t1 = x0 - x1;
+                const std::complex<T> t2 = x2 + x3;
+                const std::complex<T> t3 = mul_minus_i<direction>(x2 - x3);
+
+                x[k] = t0 + t2;
+                x[k + h] = t1 + t3;
+                x[k + 2 * h] = t0 - t2;
+                x[k + 3 * h] = t1 - t3;
+            }
+        }
+
+        w += 3 * h;
+    }
+}
+
+/*
+    Recursive split-radix decimation in time, out-of-place: out[0..n) = FFT of in[0], in[stride], ..., in[(n - 1) * stride].
+    One half-size transform of the even samples and two quarter-size transforms of the odd ones:
+
+        X[k]          = U[k] + (w^k Z[k] + w^3k Z'[k])
+        X[k + n/2]    = U[k] - (w^k Z[k] + w^3k Z'[k])
+        X[k + n/4]    = U[k + n/4] - i (w^k Z[k] - w^3k Z'[k])
+        X[k + 3n/4]   = U[k + n/4] + i (w^k Z[k] - w^3k Z'[k])
+
+    Lowest operation count of the power-of-two algorithms, but the recursion walks memory less regularly.
+*/
+template<FFTDirection direction, typename T>
+void fft_split_radix_rec(const std::complex<T>* in,
+                         std::complex<T>* out,
+                         const std::size_t n,
+                         const std::size_t stride,
+                         const FFTTables<T>& tables) noexcept
+{
+    if(n == 1)
+    {
+        out[0] = in[0];
+        return;
+    }
+
+    if(n == 2)
+    {
+        out[0] = in[0] + in[stride];
+        out[1] = in[0] - in[stride];
+        return;
+    }
+
+    const std::size_t n2 = n / 2;
+    const std::size_t n4 = n / 4;
+
+    /* U in out[0..n/2), Z in out[n/2..3n/4), Z' in out[3n/4..n) */
+    fft_split_radix_rec<direction>(in, out, n2, 2 * stride, tables);
+    fft_split_radix_rec<direction>(in + stride, out + n2, n4, 4 * stride, tables);
+    fft_split_radix_rec<direction>(in + 3 * stride, out + n2 + n4, n4, 4 * stride, tables);
+
+    /* w = exp(-2πi / n) = tables.twiddles[N / n] */
+    const std::size_t tw_stride = tables.N / n;
+
+    for(std::size_t k = 0; k < n4; k++)
+    {
+        const std::complex<T> z = cmul(out[n2 + k], twiddle<direction>(tables.twiddles[k * tw_stride]));
+        const std::complex<T> zp = cmul(out[n2 + n4 + k], twiddle<direction>(tables.twiddles[3 * k * tw_stride]));
+
+        const std::complex<T> sum = z + zp;
+        const std::complex<T> diff = mul_minus_i<direction>(z - zp);
+
+        const std::complex<T> u0 = out[k];
+        const std::complex<T> u1 = out[k + n4];
+
+        out[k] = u0 + sum;
+        out[k + n2] = u0 - sum;
+        out[k + n4] = u1 + diff;
+        out[k + n2 + n4] = u1 - diff;
+    }
+}
+
+/* In-place transform of a power-of-two sized buffer, scratch must hold N elements for the split-radix algorithm */
+template<FFTDirection direction, typename T>
+void fft_pow2(std::complex<T>* data,
+              const FFTTables<T>& tables,
+              const FFTAlgorithm algorithm,
+              std::complex<T>* scratch) noexcept
+{
+    if(tables.N <= 1)
+    {
+        return;
+    }
+
+    switch(algorithm)
+    {
+        case FFTAlgorithm_Radix2:
+            bit_reverse_permute(data, tables);
+            fft_radix2_stages<direction>(data, tables);
+            break;
+
+        case FFTAlgorithm_Radix4:
+            bit_reverse_permute(data, tables);
+            fft_radix4_stages<direction>(data, tables);
+            break;
+
+        case FFTAlgorithm_SplitRadix:
+            std::copy(data, data + tables.N, scratch);
+            fft_split_radix_rec<direction>(scratch, data, tables.N, 1, tables);
+            break;
+
+        default:
+            break;
+    }
+}
+
+/* Default power-of-two algorithm, the fastest one in benchmark.cpp on AVX2 hardware */
+static constexpr FFTAlgorithm FFT_DEFAULT_ALGORITHM = FFTAlgorithm_Radix4;
+
+/* Odd prime radices up to this one get a dedicated butterfly, larger prime factors go through a sub-transform */
+static constexpr std::size_t FFT_MAX_BUTTERFLY_RADIX = 13;
+
+template<typename T>
+class FFTEngine;
+
+/*
+    One Stockham decimation in frequency pass over s interleaved sequences of length n = p * m.
+    With x[t] the input of one sequence, t = q + m * j and w = exp(-2πi / n):
+
+        y_r[q] = w^(q r) * sum_j x[q + m j] * exp(-2πi j r / p)
+
+    each y_r is then a transform of length m, stored so that the next pass sees s * p sequences.
+    No bit-reversal is needed, the output of the last pass is in natural order.
+*/
+template<typename T>
+struct FFTStage
+{
+    std::size_t radix;
+    std::size_t n;
+    std::size_t m;
+    std::size_t s;
+
+    /* exp(-2πi q r / n), (radix - 1) per q, for q < m and 1 <= r < radix */
+    std::vector<std::complex<T>> twiddles;
+
+    /* cos / sin(2π j r / radix) for 1 <= j, r <= (radix - 1) / 2, odd radices only */
+    std::vector<T> cos_table;
+    std::vector<T> sin_table;
+
+    /* Transform of length radix, for prime radices above FFT_MAX_BUTTERFLY_RADIX */
+    std::unique_ptr<FFTEngine<T>> sub;
+};
+
+/* Length-P DFT of a[0..P) into b[0..P), P = 0 means the radix is only known at runtime */
+template<FFTDirection direction, std::size_t P, typename T>
+inline void fft_butterfly(const std::complex<T>* a,
+                          std::complex<T>* b,
+                          const FFTStage<T>& stage) noexcept
+{
+    if constexpr(P == 2)
+    {
+        b[0] = a[0] + a[1];
+        b[1] = a[0] - a[1];
+    }
+    else if constexpr(P == 4)
+    {
+        const std::complex<T> t0 = a[0] + a[2];
+        const std::complex<T> t1 = a[0] - a[2];
+        const std::complex<T> t2 = a[1] + a[3];
+        const std::complex<T> t3 = mul_minus_i<direction>(a[1] - a[3]);
+
+        b[0] = t0 + t2;
+        b[1] = t1 + t3;
+        b[2] = t0 - t2;
+        b[3] = t1 - t3;
+    }
+    else
+    {
+        /*
+            Odd radix, the inputs are paired with their mirror so only half of the products are needed:
+
+                b[r]     = a0 + sum_j cos(2π j r / p) (a[j] + a[p - j]) - i sin(2π j r / p) (a[j] - a[p - j])
+                b[p - r] = same with +i
+        */
+        const std::size_t p = P != 0 ? P : stage.radix;
+        const std::size_t half = (p - 1) / 2;
+
+        std::complex<T> sums[FFT_MAX_BUTTERFLY_RADIX / 2];
+        std::complex<T> diffs[FFT_MAX_BUTTERFLY_RADIX / 2];
+
+        std::complex<T> b0 = a[0];
+
+        for(std::size_t j = 0; j < half; j++)
+        {
+            sums[j] = a[j + 1] + a[p - 1 - j];
+            diffs[j] = a[j + 1] - a[p - 1 - j];
+            b0 += sums[j];
+        }
+
+        b[0] = b0;
+
+        for(std::size_t r = 0; r < half; r++)
+        {
+            const T* c = stage.cos_table.data() + r * half;
+            const T* s = stage.sin_table.data() + r * half;
+
+            std::complex<T> re = a[0];
+            std::complex<T> im = 0;
+
+            for(std::size_t j = 0; j < half; j++)
+            {
+                re += c[j] * sums[j];
+                im += s[j] * diffs[j];
+            }
+
+            im = mul_minus_i<direction>(im);
+
+            b[r + 1] = re + im;
+            b[p - 1 - r] = re - im;
+        }
+    }
+}
+
+template<FFTDirection direction, std::size_t P, typename T>
+void fft_stage(const FFTStage<T>& stage, const std::complex<T>* x, std::complex<T>* y) noexcept
+{
+    const std::size_t p = P != 0 ? P : stage.radix;
+    const std::size_t m = stage.m;
+    const std::size_t s = stage.s;
+
+    std::complex<T> a[P != 0 ? P : FFT_MAX_BUTTERFLY_RADIX];
+    std::complex<T> b[P != 0 ? P : FFT_MAX_BUTTERFLY_RADIX];
+
+    for(std::size_t q = 0; q < m; q++)
+    {
+        const std::complex<T>* w = stage.twiddles.data() + q * (p - 1);
+
+        for(std::size_t k = 0; k < s; k++)
+        {
+            for(std::size_t j = 0; j < p; j++)
+            {
+                a[j] = x[k + s * (q + m * j)];
+            }
+
+            fft_butterfly<direction, P>(a, b, stage);
+
+            y[k + s * p * q] = b[0];
+
+            for(std::size_t r = 1; r < p; r++)
+            {
+                y[k + s * (r + p * q)] = cmul(b[r], twiddle<direction>(w[r - 1]));
+            }
+        }
+    }
+}
+
+/* Same pass for a large prime radix, each butterfly is a full sub-transform */
+template<FFTDirection direction, typename T>
+void fft_stage_sub(const FFTStage<T>& stage,
+                   const std::complex<T>* x,
+                   std::complex<T>* y,
+                   std::complex<T>* scratch) noexcept
+{
+    const std::size_t p = stage.radix;
+    const std::size_t m = stage.m;
+    const std::size_t s = stage.s;
+
+    std::complex<T>* a = scratch;
+
+    for(std::size_t q = 0; q < m; q++)
+    {
+        const std::complex<T>* w = stage.twiddles.data() + q * (p - 1);
+
+        for(std::size_t k = 0; k < s; k++)
+        {
+            for(std::size_t j = 0; j < p; j++)
+            {
+                a[j] = x[k + s * (q + m * j)];
+            }
+
+            stage.sub->template execute<direction>(a, scratch + p);
+
+            y[k + s * p * q] = a[0];
+
+            for(std::size_t r = 1; r < p; r++)
+            {
+                y[k + s * (r + p * q)] = cmul(a[r], twiddle<direction>(w[r - 1]));
+            }
+        }
+    }
+}
+
+/* Radices of the mixed-radix passes: 4s first, then the prime factors in increasing order */
+inline std::vector<std::size_t> fft_factorize(std::size_t N) noexcept
+{
+    std::vector<std::size_t> factors;
+
+    while(N % 4 == 0)
+    {
+        factors.push_back(4);
+        N /= 4;
+    }
+
+    const std::vector<std::size_t> primes = prime_factors(N);
+    factors.insert(factors.end(), primes.begin(), primes.end());
+
+    return factors;
+}
+
+/* Picks the algorithm for a size, the planner used when FFTAlgorithm_Auto is asked for */
+inline FFTAlgorithm fft_choose_algorithm(const std::size_t N) noexcept
+{
+    if(is_power_of_two(N))
+    {
+        return FFT_DEFAULT_ALGORITHM;
+    }
+
+    if(N <= FFT_MAX_BUTTERFLY_RADIX || !is_prime(N))
+    {
+        return FFTAlgorithm_MixedRadix;
+    }
+
+    /* Rader's convolution is cheap when N - 1 factors into small radices, otherwise pad to a power of two */
+    const std::vector<std::size_t> factors = prime_factors(N - 1);
+
+    return factors.back() <= FFT_MAX_BUTTERFLY_RADIX ? FFTAlgorithm_Rader : FFTAlgorithm_Bluestein;
+}
+
+/*
+    Wisdom: the algorithm FFTPlanFlag_Measure found fastest for each (precision, size), used by every
+    later FFTAlgorithm_Auto engine of that size, sub-transforms included.
+    It can be saved to and loaded from a text file, one "f<bits> <N> <algorithm>" entry per line.
+*/
+struct FFTWisdom
+{
+    std::map<std::pair<std::size_t, std::size_t>, FFTAlgorithm> entries;
+    std::mutex mutex;
+};
+
+inline FFTWisdom& fft_wisdom() noexcept
+{
+    static FFTWisdom wisdom;
+    return wisdom;
+}
+
+template<typename T>
+inline FFTAlgorithm fft_wisdom_lookup(const std::size_t N) noexcept
+{
+    FFTWisdom& wisdom = fft_wisdom();
+    std::lock_guard<std::mutex> lock(wisdom.mutex);
+
+    const auto it = wisdom.entries.find({ sizeof(T) * 8, N });
+
+    return it != wisdom.entries.end() ? it->second : FFTAlgorithm_Auto;
+}
+
+template<typename T>
+inline void fft_wisdom_store(const std::size_t N, const FFTAlgorithm algorithm) noexcept
+{
+    FFTWisdom& wisdom = fft_wisdom();
+    std::lock_guard<std::mutex> lock(wisdom.mutex);
+
+    wisdom.entries[{ sizeof(T) * 8, N }] = algorithm;
+}
+
+inline void fft_wisdom_forget() noexcept
+{
+    FFTWisdom& wisdom = fft_wisdom();
+    std::lock_guard<std::mutex> lock(wisdom.mutex);
+
+    wisdom.entries.clear();
+}
+
+inline bool fft_wisdom_save(const std::string& path) noexcept
+{
+    std::ofstream file(path);
+
+    if(!file)
+    {
+        std::cerr << "Cannot open wisdom file for writing: " << path << "\n";
+        return false;
+    }
+
+    FFTWisdom& wisdom = fft_wisdom();
+    std::lock_guard<std::mutex> lock(wisdom.mutex);
+
+    file << "# fft wisdom v1\n";
+
+    for(const auto& [key, algorithm] : wisdom.entries)
+    {
+        file << 'f' << key.first << ' ' << key.second << ' ' << fft_algorithm_to_string(algorithm) << '\n';
+    }
+
+    return static_cast<bool>(file);
+}
+
+/* Entries of the file are merged into the current wisdom, malformed lines are reported and skipped */
+inline bool fft_wisdom_load(const std::string& path) noexcept
+{
+    std::ifstream file(path);
+
+    if(!file)
+    {
+        std::cerr << "Cannot open wisdom file: " << path << "\n";
+        return false;
+    }
+
+    FFTWisdom& wisdom = fft_wisdom();
+    std::lock_guard<std::mutex> lock(wisdom.mutex);
+
+    std::string line;
+    std::size_t line_number = 0;
+    bool valid = true;
+
+    while(std::getline(file, line))
+    {
+        line_number++;
+
+        if(line.empty() || line[0] == '#')
+        {
+            continue;
+        }
+
+        std::istringstream stream(line);
+
+        char prefix = 0;
+        std::size_t bits = 0;
+        std::size_t N = 0;
+        std::string name;
+
+        stream >> prefix >> bits >> N >> name;
+
+        std::uint8_t algorithm = 0;
+
+        while(algorithm < FFTAlgorithm_Auto && name != fft_algorithm_to_string(algorithm))
+        {
+            algorithm++;
+        }
+
+        if(!stream || prefix != 'f' || N == 0 || algorithm == FFTAlgorithm_Auto)
+        {
+            std::cerr << "Invalid wisdom entry at " << path << ":" << line_number << ": " << line << "\n";
+            valid = false;
+            continue;
+        }
+
+        wisdom.entries[{ bits, N }] = static_cast<FFTAlgorithm>(algorithm);
+    }
+
+    return valid;
+}
+
+/*
+    Transform of any length N, in O(N log N):
+    - powers of two: radix-2, radix-4 or split-radix, in-place
+    - composite sizes: Stockham mixed-radix passes
+    - primes: Rader or Bluestein, through a child transform
+
+    execute() is const and takes a caller-provided scratch of scratch_size() elements,
+    so one engine can be shared by several threads.
+*/
+template<typename T>
+class FFTEngine
+{
+    std::size_t _N;
+    FFTAlgorithm _algorithm;
+
+    /* Power-of-two algorithms, and the convolution length of Bluestein */
+    FFTTables<T> _tables;
+
+    /* Mixed radix */
+    std::vector<FFTStage<T>> _stages;
+
+    /* Rader: input gathered in g^q order, output scattered in g^-q order */
+    std::vector<std::size_t> _perm_in;
+    std::vector<std::size_t> _perm_out;
+
+    /* Rader and Bluestein: transform of the convolution kernel, already divided by its length */
+    std::vector<std::complex<T>> _kernel;
+
+    /* Bluestein: exp(-πi n² / N) */
+    std::vector<std::complex<T>> _chirp;
+
+    /* Rader: transform of length N - 1 */
+    std::unique_ptr<FFTEngine<T>> _child;
+
+    std::size_t _scratch_size;
+
+    void _init_mixed_radix()
+    {
+        std::size_t n = this->_N;
+        std::size_t s = 1;
+
+        std::size_t sub_scratch = 0;
+
+        for(const std::size_t p : fft_factorize(this->_N))
+        {
+            FFTStage<T> stage;
+            stage.radix = p;
+            stage.n = n;
+            stage.m = n / p;
+            stage.s = s;
+
+            stage.twiddles.reserve(stage.m * (p - 1));
+
+            for(std::size_t q = 0; q < stage.m; q++)
+            {
+                for(std::size_t r = 1; r < p; r++)
+                {
+                    stage.twiddles.push_back(root_of_unity<T>(q * r, n));
+                }
+            }
+
+            if(p > FFT_MAX_BUTTERFLY_RADIX)
+            {
+                stage.sub = std::make_unique<FFTEngine<T>>(p);
+                sub_scratch = std::max(sub_scratch, p + stage.sub->scratch_size());
+            }
+            else if(p % 2 == 1)
+            {
+                const std::size_t half = (p - 1) / 2;
+
+                for(std::size_t r = 1; r <= half; r++)
+                {
+                    for(std::size_t j = 1; j <= half; j++)
+                    {
+                        const std::complex<T> w = root_of_unity<T>((j * r) % p, p);
+
+                        stage.cos_table.push_back(w.real());
+                        stage.sin_table.push_back(-w.imag());
+                    }
+                }
+            }
+
+            this->_stages.push_back(std::move(stage));
+
+            n /= p;
+            s *= p;
+        }
+
+        /* Ping-pong buffer, then the scratch of the sub-transforms */
+        this->_scratch_size = this->_N + sub_scratch;
+    }
+
+    /*
+        With g a generator modulo the prime N, for k != 0:
+
+            X[g^-p] = x[0] + sum_q x[g^q] exp(-2πi g^(q - p) / N)
+
+        which is a cyclic convolution of length N - 1, done with two transforms of that length
+    */
+    void _init_rader()
+    {
+        const std::size_t L = this->_N - 1;
+        const std::size_t g = primitive_root(this->_N);
+        const std::size_t g_inv = pow_mod(g, this->_N - 2, this->_N);
+
+        this->_perm_in.resize(L);
+        this->_perm_out.resize(L);
+
+        std::size_t gq = 1;
+        std::size_t gq_inv = 1;
+
+        for(std::size_t q = 0; q < L; q++)
+        {
+            this->_perm_in[q] = gq;
+            this->_perm_out[q] = gq_inv;
+
+            gq = (gq * g) % this->_N;
+            gq_inv = (gq_inv * g_inv) % this->_N;
+        }
+
+        this->_child = std::make_unique<FFTEngine<T>>(L);
+
+        std::vector<std::complex<T>> scratch(this->_child->scratch_size());
+
+        this->_kernel.resize(L);
+
+        for(std::size_t q = 0; q < L; q++)
+        {
+            this->_kernel[q] = root_of_unity<T>(this->_perm_out[q], this->_N) / static_cast<T>(L);
+        }
+
+        this->_child->template execute<FFTDirection_Forward>(this->_kernel.data(), scratch.data());
+
+        this->_scratch_size = L + this->_child->scratch_size();
+    }
+
+    /*
+        n k = (n² + k² - (k - n)²) / 2, so with c[n] = exp(-πi n² / N):
+
+            X[k] = c[k] * sum_n (x[n] c[n]) conj(c[k - n])
+
+        a linear convolution, zero-padded to a power of two M >= 2N - 1
+    */
+    void _init_bluestein()
+    {
+        const std::size_t N = this->_N;
+
+        std::size_t M = 1;
+
+        while(M < 2 * N - 1)
+        {
+            M *= 2;
+        }
+
+        this->_tables = FFTTables<T>(M);
+
+        this->_chirp.resize(N);
+
+        for(std::size_t n = 0; n < N; n++)
+        {
+            /* n² mod 2N keeps the angle small, and exact */
+            this->_chirp[n] = root_of_unity<T>(static_cast<std::size_t>((static_cast<unsigned __int128>(n) * n) % (2 * N)), 2 * N);
+        }
+
+        this->_kernel.assign(M, std::complex<T>(0));
+
+        for(std::size_t n = 0; n < N; n++)
+        {
+            this->_kernel[n] = std::conj(this->_chirp[n]) / static_cast<T>(M);
+
+            if(n > 0)
+            {
+                this->_kernel[M - n] = this->_kernel[n];
+            }
+        }
+
+        fft_pow2<FFTDirection_Forward>(this->_kernel.data(), this->_tables, FFTAlgorithm_Radix4, static_cast<std::complex<T>*>(nullptr));
+
+        this->_scratch_size = M;
+    }
+
+    void _execute_rader(std::complex<T>* data, std::complex<T>* scratch) const noexcept
+    {
+        const std::size_t L = this->_N - 1;
+
+        std::complex<T>* a = scratch;
+
+        const std::complex<T> x0 = data[0];
+        std::complex<T> sum = x0;
+
+        for(std::size_t q = 0; q < L; q++)
+        {
+            a[q] = data[this->_perm_in[q]];
+            sum += a[q];
+        }
+
+        this->_child->template execute<FFTDirection_Forward>(a, scratch + L);
+
+        for(std::size_t q = 0; q < L; q++)
+        {
+            a[q] = cmul(a[q], this->_kernel[q]);
+        }
+
+        this->_child->template execute<FFTDirection_Backward>(a, scratch + L);
+
+        data[0] = sum;
+
+        for(std::size_t q = 0; q < L; q++)
+        {
+            data[this->_perm_out[q]] = x0 + a[q];
+        }
+    }
+
+    void _execute_bluestein(std::complex<T>* data, std::complex<T>* scratch) const noexcept
+    {
+        const std::size_t N = this->_N;
+        const std::size_t M = this->_tables.N;
+
+        std::complex<T>* a = scratch;
+
+        for(std::size_t n = 0; n < N; n++)
+        {
+            a[n] = cmul(data[n], this->_chirp[n]);
+        }
+
+        std::fill(a + N, a + M, std::complex<T>(0));
+
+        fft_pow2<FFTDirection_Forward>(a, this->_tables, FFTAlgorithm_Radix4, static_cast<std::complex<T>*>(nullptr));
+
+        for(std::size_t n = 0; n < M; n++)
+        {
+            a[n] = cmul(a[n], this->_kernel[n]);
+        }
+
+        fft_pow2<FFTDirection_Backward>(a, this->_tables, FFTAlgorithm_Radix4, static_cast<std::complex<T>*>(nullptr));
+
+        for(std::size_t k = 0; k < N; k++)
+        {
+            data[k] = cmul(a[k], this->_chirp[k]);
+        }
+    }
+
+    template<FFTDirection direction>
+    void _execute_mixed_radix(std::complex<T>* data, std::complex<T>* scratch) const noexcept
+    {
+        std::complex<T>* src = data;
+        std::complex<T>* dst = scratch;
+        std::complex<T>* sub_scratch = scratch + this->_N;
+
+        for(const FFTStage<T>& stage : this->_stages)
+        {
+            switch(stage.radix)
+            {
+                case 2:
+                    fft_stage<direction, 2>(stage, src, dst);
+                    break;
+                case 3:
+                    fft_stage<direction, 3>(stage, src, dst);
+                    break;
+                case 4:
+                    fft_stage<direction, 4>(stage, src, dst);
+                    break;
+                case 5:
+                    fft_stage<direction, 5>(stage, src, dst);
+                    break;
+                case 7:
+                    fft_stage<direction, 7>(stage, src, dst);
+                    break;
+                default:
+                    if(stage.sub != nullptr)
+                    {
+                        fft_stage_sub<direction>(stage, src, dst, sub_scratch);
+                    }
+                    else
+                    {
+                        fft_stage<direction, 0>(stage, src, dst);
+                    }
+
+                    break;
+            }
+
+            std::swap(src, dst);
+        }
+
+        if(src != data)
+        {
+            std::copy(src, src + this->_N, data);
+        }
+    }
+
+public:
+    explicit FFTEngine(const std::size_t N, const FFTAlgorithm algorithm = FFTAlgorithm_Auto) : _N(N),
+                                                                                                _algorithm(algorithm),
+                                                                                                _scratch_size(0)
+    {
+        if(this->_algorithm == FFTAlgorithm_Auto)
+        {
+            this->_algorithm = fft_wisdom_lookup<T>(N);
+        }
+
+        if(this->_algorithm == FFTAlgorithm_Auto)
+        {
+            this->_algorithm = fft_choose_algorithm(N);
+        }
+
+        /* Forced algorithms that cannot handle this size fall back to the planner's choice */
+        if((this->_algorithm <= FFTAlgorithm_SplitRadix && !is_power_of_two(N)) ||
+           (this->_algorithm == FFTAlgorithm_Rader && !is_prime(N)))
+        {
+            this->_algorithm = fft_choose_algorithm(N);
+        }
+
+        if(N <= 1)
+        {
+            return;
+        }
+
+        switch(this->_algorithm)
+        {
+            case FFTAlgorithm_Radix2:
+            case FFTAlgorithm_Radix4:
+                this->_tables = FFTTables<T>(N);
+                break;
+            case FFTAlgorithm_SplitRadix:
+                this->_tables = FFTTables<T>(N);
+                this->_scratch_size = N;
+                break;
+            case FFTAlgorithm_MixedRadix:
+                this->_init_mixed_radix();
+                break;
+            case FFTAlgorithm_Rader:
+                this->_init_rader();
+                break;
+            case FFTAlgorithm_Bluestein:
+                this->_init_bluestein();
+                break;
+            default:
+                break;
+        }
+    }
+
+    std::size_t size() const noexcept { return this->_N; }
+
+    FFTAlgorithm algorithm() const noexcept { return this->_algorithm; }
+
+    /* Number of elements execute() needs in its scratch buffer */
+    std::size_t scratch_size() const noexcept { return this->_scratch_size; }
+
+    /* In-place transform of data[0..N) */
+    template<FFTDirection direction>
+    void execute(std::complex<T>* data, std::complex<T>* scratch) const noexcept
+    {
+        if(this->_N <= 1)
+        {
+            return;
+        }
+
+        switch(this->_algorithm)
+        {
+            case FFTAlgorithm_Radix2:
+            case FFTAlgorithm_Radix4:
+            case FFTAlgorithm_SplitRadix:
+                fft_pow2<direction>(data, this->_tables, this->_algorithm, scratch);
+                break;
+
+            case FFTAlgorithm_MixedRadix:
+                this->_execute_mixed_radix<direction>(data, scratch);
+                break;
+
+            /* The convolution tables are built for the forward transform, backward(x) = conj(forward(conj(x))) */
+            case FFTAlgorithm_Rader:
+            case FFTAlgorithm_Bluestein:
+                if constexpr(direction == FFTDirection_Backward)
+                {
+                    for(std::size_t i = 0; i < this->_N; i++)
+                    {
+                        data[i] = std::conj(data[i]);
+                    }
+                }
+
+                if(this->_algorithm == FFTAlgorithm_Rader)
+                {
+                    this->_execute_rader(data, scratch);
+                }
+                else
+                {
+                    this->_execute_bluestein(data, scratch);
+                }
+
+                if constexpr(direction == FFTDirection_Backward)
+                {
+                    for(std::size_t i = 0; i < this->_N; i++)
+                    {
+                        data[i] = std::conj(data[i]);
+                    }
+                }
+
+                break;
+
+            default:
+                break;
+        }
+    }
+
+    void execute(std::complex<T>* data, std::complex<T>* scratch, const FFTDirection direction) const noexcept
+    {
+        if(direction == FFTDirection_Forward)
+        {
+            this->execute<FFTDirection_Forward>(data, scratch);
+        }
+        else
+        {
+            this->execute<FFTDirection_Backward>(data, scratch);
+        }
+    }
+};
+
+/* Engines are cached per thread, per size and per algorithm, Auto engines follow the wisdom present when they are first built */
+template<typename T>
+const FFTEngine<T>& fft_engine(const std::size_t N, const FFTAlgorithm algorithm = FFTAlgorithm_Auto)
+{
+    static thread_local std::unordered_map<std::size_t, std::unique_ptr<FFTEngine<T>>> cache;
+
+    const std::size_t key = N * (FFTAlgorithm_Auto + 1) + algorithm;
+
+    auto it = cache.find(key);
+
+    if(it == cache.end())
+    {
+        it = cache.emplace(key, std::make_unique<FFTEngine<T>>(N, algorithm)).first;
+    }
+
+    return *it->second;
+}
+
+/* In-place FFT of any size */
+template<typename T>
+void fft(std::vector<std::complex<T>>& data,
+         const FFTDirection direction = FFTDirection_Forward,
+         const FFTAlgorithm algorithm = FFTAlgorithm_Auto) noexcept
+{
+    const FFTEngine<T>& engine = fft_engine<T>(data.size(), algorithm);
+
+    static thread_local std::vector<std::complex<T>> scratch;
+
+    if(scratch.size() < engine.scratch_size())
+    {
+        scratch.resize(engine.scratch_size());
+    }
+
+    engine.execute(data.data(), scratch.data(), direction);
+}
+
+enum FFTPlanFlag : std::uint32_t
+{
+    FFTPlanFlag_Estimate = 0, /* wisdom if there is some, the planner's heuristic otherwise */
+    FFTPlanFlag_Measure = 1 << 0, /* time every candidate algorithm and keep the fastest, the result goes to wisdom */
+    FFTPlanFlag_ForgetWisdom = 1 << 1, /* ignore existing wisdom: the heuristic alone, or measuring again with Measure */
+};
+
+/* Algorithms that can transform N points, the candidates of FFTPlanFlag_Measure */
+inline std::vector<FFTAlgorithm> fft_candidate_algorithms(const std::size_t N) noexcept
+{
+    if(is_power_of_two(N))
+    {
+        return { FFTAlgorithm_Radix2, FFTAlgorithm_Radix4, FFTAlgorithm_SplitRadix, FFTAlgorithm_MixedRadix };
+    }
+
+    if(is_prime(N))
+    {
+        std::vector<FFTAlgorithm> candidates = { FFTAlgorithm_Rader, FFTAlgorithm_Bluestein };
+
+        if(N <= FFT_MAX_BUTTERFLY_RADIX)
+        {
+            candidates.push_back(FFTAlgorithm_MixedRadix);
+        }
+
+        return candidates;
+    }
+
+    return { FFTAlgorithm_MixedRadix, FFTAlgorithm_Bluestein };
+}
+
+/* Minimum time spent timing each candidate, and minimum number of runs */
+static constexpr double FFT_MEASURE_MIN_SECONDS = 0.01;
+static constexpr std::size_t FFT_MEASURE_MIN_RUNS = 3;
+
+/* Best time of one transform, in seconds */
+template<typename T>
+double fft_measure(const FFTEngine<T>& engine) noexcept
+{
+    const std::size_t N = engine.size();
+
+    std::vector<std::complex<T>> data(N);
+    std::vector<std::complex<T>> scratch(engine.scratch_size());
+
+    for(std::size_t i = 0; i < N; i++)
+    {
+        data[i] = std::complex<T>(static_cast<T>(std::sin(0.1 * static_cast<double>(i))),
+                                  static_cast<T>(std::cos(0.37 * static_cast<double>(i))));
+    }
+
+    /* Warm-up, brings the tables into the cache */
+    engine.template execute<FFTDirection_Forward>(data.data(), scratch.data());
+
+    double best = std::numeric_limits<double>::max();
+    double total = 0.0;
+    std::size_t runs = 0;
+
+    while(runs < FFT_MEASURE_MIN_RUNS || total < FFT_MEASURE_MIN_SECONDS)
+    {
+        const auto start = std::chrono::steady_clock::now();
+
+        engine.template execute<FFTDirection_Forward>(data.data(), scratch.data());
+
+        const double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        best = std::min(best, elapsed);
+        total += elapsed;
+        runs++;
+    }
+
+    return best;
+}
+
+/*
+    A transform of fixed size and direction, in the spirit of FFTW plans: all the trigonometry, permutations
+    and scratch memory are set up once, execute() only does arithmetic and never allocates.
+    execute() uses the plan's scratch so a plan must not be executed from two threads at once,
+    engine() can be shared instead, with one scratch buffer per thread.
+*/
+template<typename T>
+class FFTPlan
+{
+    std::unique_ptr<FFTEngine<T>> _engine;
+    FFTDirection _direction;
+    std::vector<std::complex<T>> _scratch;
+
+public:
+    FFTPlan(const std::size_t N,
+            const FFTDirection direction = FFTDirection_Forward,
+            const std::uint32_t flags = FFTPlanFlag_Estimate) : _direction(direction)
+    {
+        FFTAlgorithm algorithm = (flags & FFTPlanFlag_ForgetWisdom) ? FFTAlgorithm_Auto : fft_wisdom_lookup<T>(N);
+
+        if((flags & FFTPlanFlag_Measure) && algorithm == FFTAlgorithm_Auto && N > 1)
+        {
+            double best = std::numeric_limits<double>::max();
+
+            for(const FFTAlgorithm candidate : fft_candidate_algorithms(N))
+            {
+                auto engine = std::make_unique<FFTEngine<T>>(N, candidate);
+
+                /* The engine may have fallen back to another algorithm, it was measured under that name */
+                if(engine->algorithm() != candidate)
+                {
+                    continue;
+                }
+
+                const double time = fft_measure(*engine);
+
+                if(time < best)
+                {
+                    best = time;
+                    this->_engine = std::move(engine);
+                }
+            }
+
+            fft_wisdom_store<T>(N, this->_engine->algorithm());
+        }
+        else
+        {
+            /* FFTEngine looks the wisdom up for FFTAlgorithm_Auto, which would undo FFTPlanFlag_ForgetWisdom */
+            if(algorithm == FFTAlgorithm_Auto)
+            {
+                algorithm = fft_choose_algorithm(N);
+            }
+
+            this->_engine = std::make_unique<FFTEngine<T>>(N, algorithm);
+        }
+
+        this->_scratch.resize(this->_engine->scratch_size());
+    }
+
+    std::size_t size() const noexcept { return this->_engine->size(); }
+
+    FFTDirection direction() const noexcept { return this->_direction; }
+
+    FFTAlgorithm algorithm() const noexcept { return this->_engine->algorithm(); }
+
+    const FFTEngine<T>& engine() const noexcept { return *this->_engine; }
+
+    /* In-place, data holds size() elements */
+    void execute(std::complex<T>* data) noexcept
+    {
+        this->_engine->execute(data, this->_scratch.data(), this->_direction);
+    }
+
+    /* Out-of-place, in and out hold size() elements and may be the same buffer */
+    void execute(const std::complex<T>* in, std::complex<T>* out) noexcept
+    {
+        if(in != out)
+        {
+            std::copy(in, in + this->size(), out);
+        }
+
+        this->execute(out);
+    }
+};
+
+/*
+    Real-input transforms. The spectrum of N reals is Hermitian, X[N - k] = conj(X[k]), so only
+    the N/2 + 1 first bins are stored, and the work is done by a complex FFT of half the size:
+
+        z[n] = x[2n] + i x[2n + 1],    Z = FFT_{N/2}(z)
+
+        E[k] = (Z[k] + conj(Z[N/2 - k])) / 2        (transform of the even samples)
+        O[k] = (Z[k] - conj(Z[N/2 - k])) / 2i       (transform of the odd samples)
+
+        X[k] = E[k] + exp(-2πi k / N) O[k],  0 <= k <= N/2
+
+    backward() undoes these steps and, like the complex backward transform, is not normalized:
+    backward(forward(x)) = N * x. Odd sizes run a full-size complex transform instead.
+*/
+template<typename T>
+class FFTRealPlan
+{
+    std::size_t _N;
+
+    /* Half size for even N, full size otherwise */
+    std::unique_ptr<FFTEngine<T>> _engine;
+
+    /* exp(-2πi k / N), 0 <= k <= N/2 */
+    std::vector<std::complex<T>> _twiddles;
+
+    /* Packed input, then the scratch of the engine */
+    std::vector<std::complex<T>> _work;
+
+public:
+    explicit FFTRealPlan(const std::size_t N) : _N(N)
+    {
+        const std::size_t M = N % 2 == 0 ? N / 2 : N;
+
+        this->_engine = std::make_unique<FFTEngine<T>>(M);
+
+        if(N % 2 == 0)
+        {
+            this->_twiddles.resize(M + 1);
+
+            for(std::size_t k = 0; k <= M; k++)
+            {
+                this->_twiddles[k] = root_of_unity<T>(k, N);
+            }
+        }
+
+        this->_work.resize(M + this->_engine->scratch_size());
+    }
+
+    std::size_t size() const noexcept { return this->_N; }
+
+    /* Number of complex bins produced by forward() and consumed by backward() */
+    std::size_t spectrum_size() const noexcept { return this->_N / 2 + 1; }
+
+    /* in holds size() reals, out receives spectrum_size() bins */
+    void forward(const T* in, std::complex<T>* out) noexcept
+    {
+        const std::size_t N = this->_N;
+
+        if(N == 0)
+        {
+            return;
+        }
+
+        std::complex<T>* z = this->_work.data();
+
+        if(N % 2 == 1)
+        {
+            for(std::size_t n = 0; n < N; n++)
+            {
+                z[n] = std::complex<T>(in[n], 0);
+            }
+
+            this->_engine->template execute<FFTDirection_Forward>(z, z + N);
+
+            std::copy(z, z + this->spectrum_size(), out);
+
+            return;
+        }
+
+        const std::size_t M = N / 2;
+
+        for(std::size_t n = 0; n < M; n++)
+        {
+            z[n] = std::complex<T>(in[2 * n], in[2 * n + 1]);
+        }
+
+        this->_engine->template execute<FFTDirection_Forward>(z, z + M);
+
+        /* Z[0] holds the sums of the even and odd samples */
+        out[0] = std::complex<T>(z[0].real() + z[0].imag(), 0);
+        out[M] = std::complex<T>(z[0].real() - z[0].imag(), 0);
+
+        for(std::size_t k = 1; k < M; k++)
+        {
+            const std::complex<T> zk = z[k];
+            const std::complex<T> zc = std::conj(z[M - k]);
+
+            const std::complex<T> even = static_cast<T>(0.5) * (zk + zc);
+            const std::complex<T> odd = static_cast<T>(0.5) * mul_minus_i<FFTDirection_Forward>(zk - zc);
+
+            out[k] = even + cmul(this->_twiddles[k], odd);
+        }
+    }
+
+    /* in holds spectrum_size() bins, out receives size() reals, the imaginary parts of bins 0 and N/2 are ignored */
+    void backward(const std::complex<T>* in, T* out) noexcept
+    {
+        const std::size_t N = this->_N;
+
+        if(N == 0)
+        {
+            return;
+        }
+
+        std::complex<T>* z = this->_work.data();
+
+        if(N % 2 == 1)
+        {
+            z[0] = std::complex<T>(in[0].real(), 0);
+
+            for(std::size_t k = 1; k < this->spectrum_size(); k++)
+            {
+                z[k] = in[k];
+                z[N - k] = std::conj(in[k]);
+            }
+
+            this->_engine->template execute<FFTDirection_Backward>(z, z + N);
+
+            for(std::size_t n = 0; n < N; n++)
+            {
+                out[n] = z[n].real();
+            }
+
+            return;
+        }
+
+        const std::size_t M = N / 2;
+
+        /* Z[k] = 2 E[k] + 2i O[k], the factor 2 makes the half-size backward transform scale by N */
+        z[0] = std::complex<T>(in[0].real() + in[M].real(), in[0].real() - in[M].real());
+
+        for(std::size_t k = 1; k < M; k++)
+        {
+            const std::complex<T> xk = in[k];
+            const std::complex<T> xc = std::conj(in[M - k]);
+
+            const std::complex<T> even = xk + xc;
+            const std::complex<T> odd = cmul(xk - xc, std::conj(this->_twiddles[k]));
+
+            z[k] = even + mul_minus_i<FFTDirection_Backward>(odd);
+        }
+
+        this->_engine->template execute<FFTDirection_Backward>(z, z + M);
+
+        for(std::size_t n = 0; n < M; n++)
+        {
+            out[2 * n] = z[n].real();
+            out[2 * n + 1] = z[n].imag();
+        }
+    }
+};
+
+/*
+    SIMD kernels on split-format complex data: real parts in one array, imaginary parts in another.
+
+    Interleaved std::complex needs shuffles to multiply two vectors of complex numbers, split arrays only need
+    vertical multiplies and FMAs, so a 256-bit register holds 4 doubles / 8 floats of the same kind.
+
+    The kernels are written once with GCC vector extensions and instantiated for each instruction set inside
+    functions carrying a target attribute, so the default build (no -march) still gets AVX2 / AVX-512 code,
+    picked at runtime from what the CPU supports.
+*/
+
+enum FFTSimd : std::uint8_t
+{
+    FFTSimd_Scalar,
+    FFTSimd_AVX2, /* AVX2 + FMA, 256-bit */
+    FFTSimd_AVX512, /* AVX-512F, 512-bit */
+};
+
+const char* fft_simd_to_string(std::uint8_t simd)
+{
+    switch(simd)
+    {
+        case FFTSimd_Scalar:
+            return "Scalar";
+        case FFTSimd_AVX2:
+            return "AVX2";
+        case FFTSimd_AVX512:
+            return "AVX512";
+        default:
+            return "Unknown Simd";
+    }
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+#define FFT_HAS_X86_SIMD 1
+#else
+#define FFT_HAS_X86_SIMD 0
+#endif
+
+/* Widest instruction set the CPU running us supports */
+inline FFTSimd fft_detect_simd() noexcept
+{
+#if FFT_HAS_X86_SIMD
+    __builtin_cpu_init();
+
+    if(__builtin_cpu_supports("avx512f"))
+    {
+        return FFTSimd_AVX512;
+    }
+
+    if(__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma"))
+    {
+        return FFTSimd_AVX2;
+    }
+#endif
+
+    return FFTSimd_Scalar;
+}
+
+/* GCC vector types, the vector_size attribute cannot depend on a template parameter */
+template<typename T, std::size_t Bytes>
+struct FFTVector;
+
+template<> struct FFTVector<float, 32> { typedef float type __attribute__((vector_size(32))); };
+template<> struct FFTVector<double, 32> { typedef double type __attribute__((vector_size(32))); };
+template<> struct FFTVector<float, 64> { typedef float type __attribute__((vector_size(64))); };
+template<> struct FFTVector<double, 64> { typedef double type __attribute__((vector_size(64))); };
+
+/* Twiddles of the radix-4 stages, per stage: w^k, w^2k, w^3k real and imaginary parts, each h long */
+template<typename T>
+struct FFTSplitTables
+{
+    std::size_t N;
+    std::size_t log2N;
+    std::vector<std::uint32_t> bitrev;
+    std::vector<T> twiddles;
+
+    FFTSplitTables() noexcept : N(0), log2N(0) {}
+
+    explicit FFTSplitTables(const std::size_t N) : N(N), log2N(log2_floor(N)), bitrev(N)
+    {
+        for(std::size_t i = 0; i < N; i++)
+        {
+            std::uint32_t r = 0;
+
+            for(std::size_t b = 0; b < this->log2N; b++)
+            {
+                r |= static_cast<std::uint32_t>((i >> b) & 1) << (this->log2N - 1 - b);
+            }
+
+            this->bitrev[i] = r;
+        }
+
+        for(std::size_t h = (this->log2N % 2 == 1) ? 2 : 1; 4 * h <= N; h *= 4)
+        {
+            for(std::size_t power = 1; power <= 3; power++)
+            {
+                for(std::size_t k = 0; k < h; k++)
+                {
+                    this->twiddles.push_back(root_of_unity<T>(power * k, 4 * h).real());
+                }
+
+                for(std::size_t k = 0; k < h; k++)
+                {
+                    this->twiddles.push_back(root_of_unity<T>(power * k, 4 * h).imag());
+                }
+            }
+        }
+    }
+};
+
+/* Vectors go through references, returning one by value from a function without the target attribute changes the ABI */
+template<typename V, typename T>
+[[gnu::always_inline]] inline void fft_load(V& v, const T* p) noexcept
+{
+    std::memcpy(&v, p, sizeof(V));
+}
+
+template<typename V, typename T>
+[[gnu::always_inline]] inline void fft_store(T* p, const V& v) noexcept
+{
+    std::memcpy(p, &v, sizeof(V));
+}
+
+/* One radix-2^2 pass (see fft_radix4_stages) over split data, V is T itself or a vector of T, h must be a multiple of its width */
+template<typename V, FFTDirection direction, typename T>
+[[gnu::always_inline]] inline void fft_split_radix4_pass(T* __restrict re,
+                                                         T* __restrict im,
+                                                         const T* __restrict w,
+                                                         const std::size_t N,
+                                                         const std::size_t h) noexcept
+{
+    constexpr std::size_t W = sizeof(V) / sizeof(T);
+
+    for(std::size_t b = 0; b < N; b += 4 * h)
+    {
+        T* r = re + b;
+        T* i = im + b;
+
+        for(std::size_t k = 0; k < h; k += W)
+        {
+            V w1r, w1i, w2r, w2i, w3r, w3i;
+
+            fft_load(w1r, w + k);
+            fft_load(w1i, w + h + k);
+            fft_load(w2r, w + 2 * h + k);
+            fft_load(w2i, w + 3 * h + k);
+            fft_load(w3r, w + 4 * h + k);
+            fft_load(w3i, w + 5 * h + k);
+
+            if constexpr(direction == FFTDirection_Backward)
+            {
+                w1i = -w1i;
+                w2i = -w2i;
+                w3i = -w3i;
+            }
+
+            V a0r, a0i, a1r, a1i, a2r, a2i, a3r, a3i;
+
+            fft_load(a0r, r + k);
+            fft_load(a0i, i + k);
+            fft_load(a1r, r + h + k);
+            fft_load(a1i, i + h + k);
+            fft_load(a2r, r + 2 * h + k);
+            fft_load(a2i, i + 2 * h + k);
+            fft_load(a3r, r + 3 * h + k);
+            fft_load(a3i, i + 3 * h + k);
+
+            const V x1r = a1r * w2r - a1i * w2i;
+            const V x1i = a1r * w2i + a1i * w2r;
+            const V x2r = a2r * w1r - a2i * w1i;
+            const V x2i = a2r * w1i + a2i * w1r;
+            const V x3r = a3r * w3r - a3i * w3i;
+            const V x3i = a3r * w3i + a3i * w3r;
+
+            const V t0r = a0r + x1r;
+            const V t0i = a0i + x1i;
+            const V t1r = a0r - x1r;
+            const V t1i = a0i - x1i;
+            const V t2r = x2r + x3r;
+            const V t2i = x2i + x3i;
+
+            /* t3 = -i (x2 - x3) forward, +i backward */
+            V t3r;
+            V t3i;
+
+            if constexpr(direction == FFTDirection_Forward)
+            {
+                t3r = x2i - x3i;
+                t3i = x3r - x2r;
+            }
+            else
+            {
+                t3r = x3i - x2i;
+                t3i = x2r - x3r;
+            }
+
+            fft_store(r + k, t0r + t2r);
+            fft_store(i + k, t0i + t2i);
+            fft_store(r + h + k, t1r + t3r);
+            fft_store(i + h + k, t1i + t3i);
+            fft_store(r + 2 * h + k, t0r - t2r);
+            fft_store(i + 2 * h + k, t0i - t2i);
+            fft_store(r + 3 * h + k, t1r - t3r);
+            fft_store(i + 3 * h + k, t1i - t3i);
+        }
+    }
+}
+
+/* Bit-reversal then every stage, passes narrower than V run on scalars */
+template<typename V, FFTDirection direction, typename T>
+[[gnu::always_inline]] inline void fft_split_impl(T* re, T* im, const FFTSplitTables<T>& tables) noexcept
+{
+    constexpr std::size_t W = sizeof(V) / sizeof(T);
+
+    const std::size_t N = tables.N;
+
+    for(std::size_t k = 0; k < N; k++)
+    {
+        const std::size_t j = tables.bitrev[k];
+
+        if(k < j)
+        {
+            std::swap(re[k], re[j]);
+            std::swap(im[k], im[j]);
+        }
+    }
+
+    std::size_t h = 1;
+
+    if(tables.log2N % 2 == 1)
+    {
+        for(std::size_t b = 0; b < N; b += 2)
+        {
+            const T ar = re[b];
+            const T ai = im[b];
+
+            re[b] = ar + re[b + 1];
+            im[b] = ai + im[b + 1];
+            re[b + 1] = ar - re[b + 1];
+            im[b + 1] = ai - im[b + 1];
+        }
+
+        h = 2;
+    }
+
+    const T* w = tables.twiddles.data();
+
+    for(; 4 * h <= N; h *= 4)
+    {
+        if(h >= W)
+        {
+            fft_split_radix4_pass<V, direction>(re, im, w, N, h);
+        }
+        else
+        {
+            fft_split_radix4_pass<T, direction>(re, im, w, N, h);
+        }
+
+        w += 6 * h;
+    }
+}
+
+template<FFTDirection direction, typename T>
+void fft_split_scalar(T* re, T* im, const FFTSplitTables<T>& tables) noexcept
+{
+    fft_split_impl<T, direction>(re, im, tables);
+}
+
+#if FFT_HAS_X86_SIMD
+template<FFTDirection direction, typename T>
+__attribute__((target("avx2,fma"))) void fft_split_avx2(T* re, T* im, const FFTSplitTables<T>& tables) noexcept
+{
+    fft_split_impl<typename FFTVector<T, 32>::type, direction>(re, im, tables);
+}
+
+template<FFTDirection direction, typename T>
+__attribute__((target("avx512f"))) void fft_split_avx512(T* re, T* im, const FFTSplitTables<T>& tables) noexcept
+{
+    fft_split_impl<typename FFTVector<T, 64>::type, direction>(re, im, tables);
+}
+#endif /* FFT_HAS_X86_SIMD */
+
+/*
+    FFT of split-format data, re[0..N) and im[0..N), in-place.
+    Powers of two run the SIMD kernels, other sizes go through an FFTEngine on an interleaved copy.
+*/
+template<typename T>
+class FFTSplitEngine
+{
+    std::size_t _N;
+    FFTSimd _simd;
+    FFTSplitTables<T> _tables;
+
+    /* Other sizes */
+    std::unique_ptr<FFTEngine<T>> _engine;
+    std::vector<std::complex<T>> _work;
+
+    template<FFTDirection direction>
+    void _execute_pow2(T* re, T* im) const noexcept
+    {
+        switch(this->_simd)
+        {
+#if FFT_HAS_X86_SIMD
+            case FFTSimd_AVX512:
+                fft_split_avx512<direction>(re, im, this->_tables);
+                break;
+            case FFTSimd_AVX2:
+                fft_split_avx2<direction>(re, im, this->_tables);
+                break;
+#endif
+            default:
+                fft_split_scalar<direction>(re, im, this->_tables);
+                break;
+        }
+    }
+
+public:
+    explicit FFTSplitEngine(const std::size_t N, const FFTSimd simd = fft_detect_simd()) : _N(N),
+                                                                                          _simd(std::min(simd, fft_detect_simd()))
+    {
+        if(is_power_of_two(N))
+        {
+            this->_tables = FFTSplitTables<T>(N);
+        }
+        else
+        {
+            this->_engine = std::make_unique<FFTEngine<T>>(N);
+            this->_work.resize(N + this->_engine->scratch_size());
+        }
+    }
+
+    std::size_t size() const noexcept { return this->_N; }
+
+    /* Instruction set actually used, never more than the CPU supports */
+    FFTSimd simd() const noexcept { return this->_simd; }
+
+    template<FFTDirection direction>
+    void execute(T* re, T* im) noexcept
+    {
+        if(this->_N <= 1)
+        {
+            return;
+        }
+
+        if(this->_engine == nullptr)
+        {
+            this->_execute_pow2<direction>(re, im);
+            return;
+        }
+
+        std::complex<T>* data = this->_work.data();
+
+        for(std::size_t i = 0; i < this->_N; i++)
+        {
+            data[i] = std::complex<T>(re[i], im[i]);
+        }
+
+        this->_engine->template execute<direction>(data, data + this->_N);
+
+        for(std::size_t i = 0; i < this->_N; i++)
+        {
+            re[i] = data[i].real();
+            im[i] = data[i].imag();
+        }
+    }
+
+    void execute(T* re, T* im, const FFTDirection direction) noexcept
+    {
+        if(direction == FFTDirection_Forward)
+        {
+            this->execute<FFTDirection_Forward>(re, im);
+        }
+        else
+        {
+            this->execute<FFTDirection_Backward>(re, im);
+        }
+    }
+};
+
+/*
+    Small persistent thread pool for the batched and multi-dimensional transforms.
+    parallel_for(count, fn) calls fn(index, thread) for every index < count, the calling thread takes part
+    as thread 0, and returns once every call is done. thread < size() so callers can keep per-thread buffers.
+    Callers on other threads take turns, one job runs at a time. A parallel_for from inside a job of the same
+    pool runs inline on the thread of that job, with its index, since the other threads may all be busy.
+*/
+class FFTThreadPool
+{
+    std::vector<std::thread> _workers;
+
+    /* Held by the caller for the whole job */
+    std::mutex _caller;
+
+    std::mutex _mutex;
+    std::condition_variable _start;
+    std::condition_variable _done;
+
+    std::function<void(std::size_t, std::size_t)> _job;
+    std::size_t _count;
+    std::atomic<std::size_t> _next;
+    std::size_t _generation;
+    std::size_t _active;
+    bool _stop;
+
+    /* Pool whose job the current thread is running, and its index there */
+    static inline thread_local const FFTThreadPool* _current_pool = nullptr;
+    static inline thread_local std::size_t _current_thread = 0;
+
+    void _run(const std::size_t thread) noexcept
+    {
+        while(true)
+        {
+            const std::size_t index = this->_next.fetch_add(1, std::memory_order_relaxed);
+
+            if(index >= this->_count)
+            {
+                break;
+            }
+
+            this->_job(index, thread);
+        }
+    }
+
+    void _worker(const std::size_t thread) noexcept
+    {
+        this->_current_pool = this;
+        this->_current_thread = thread;
+
+        std::size_t generation = 0;
+
+        while(true)
+        {
+            {
+                std::unique_lock<std::mutex> lock(this->_mutex);
+                this->_start.wait(lock, [&] { return this->_stop || this->_generation != generation; });
+
+                if(this->_stop)
+                {
+                    return;
+                }
+
+                generation = this->_generation;
+            }
+
+            this->_run(thread);
+
+            {
+                std::lock_guard<std::mutex> lock(this->_mutex);
+
+                if(--this->_active == 0)
+                {
+                    this->_done.notify_one();
+                }
+            }
+        }
+    }
+
+public:
+    explicit FFTThreadPool(const std::size_t num_threads = std::max(1u, std::thread::hardware_concurrency())) : _count(0),
+                                                                                                                _next(0),
+                                                                                                                _generation(0),
+                                                                                                                _active(0),
+                                                                                                                _stop(false)
+    {
+        for(std::size_t i = 1; i < num_threads; i++)
+        {
+            this->_workers.emplace_back(&FFTThreadPool::_worker, this, i);
+        }
+    }
+
+    ~FFTThreadPool() noexcept
+    {
+        {
+            std::lock_guard<std::mutex> lock(this->_mutex);
+            this->_stop = true;
+        }
+
+        this->_start.notify_all();
+
+        for(auto& worker : this->_workers)
+        {
+            worker.join();
+        }
+    }
+
+    FFTThreadPool(const FFTThreadPool&) = delete;
+    FFTThreadPool& operator=(const FFTThreadPool&) = delete;
+
+    /* Number of threads, the caller included */
+    std::size_t size() const noexcept { return this->_workers.size() + 1; }
+
+    template<typename F>
+    void parallel_for(const std::size_t count, F&& fn) noexcept
+    {
+        if(count == 0)
+        {
+            return;
+        }
+
+        const bool nested = this->_current_pool == this;
+
+        if(nested || this->_workers.empty() || count == 1)
+        {
+            const std::size_t thread = nested ? this->_current_thread : 0;
+
+            for(std::size_t i = 0; i < count; i++)
+            {
+                fn(i, thread);
+            }
+
+            return;
+        }
+
+        std::lock_guard<std::mutex> caller(this->_caller);
+
+        /* The caller may be running a job of another pool */
+        const FFTThreadPool* const outer_pool = this->_current_pool;
+        const std::size_t outer_thread = this->_current_thread;
+
+        this->_current_pool = this;
+        this->_current_thread = 0;
+
+        {
+            std::lock_guard<std::mutex> lock(this->_mutex);
+
+            this->_job = std::ref(fn);
+            this->_count = count;
+            this->_next.store(0, std::memory_order_relaxed);
+            this->_active = this->_workers.size();
+            this->_generation++;
+        }
+
+        this->_start.notify_all();
+
+        this->_run(0);
+
+        {
+            std::unique_lock<std::mutex> lock(this->_mutex);
+            this->_done.wait(lock, [&] { return this->_active == 0; });
+        }
+
+        this->_current_pool = outer_pool;
+        this->_current_thread = outer_thread;
+    }
+};
+
+/* Pool shared by the plans that are not given one, one thread per core */
+inline FFTThreadPool& fft_thread_pool() noexcept
+{
+    static FFTThreadPool pool;
+    return pool;
+}
+
+/*
+    howmany transforms of size N, like FFTW's advanced interface: element i of transform b is
+    data[b * dist + i * stride]. Transforms are spread over the threads of the pool, strided ones are
+    gathered into a per-thread buffer first. Every buffer is allocated by the constructor.
+*/
+template<typename T>
+class FFTBatchPlan
+{
+    FFTPlan<T> _plan;
+    std::size_t _howmany;
+    std::size_t _stride;
+    std::size_t _dist;
+    FFTThreadPool* _pool;
+
+    /* Per thread: N elements for the gathered transform, then the engine's scratch */
+    std::vector<std::complex<T>> _buffers;
+    std::size_t _buffer_size;
+
+public:
+    FFTBatchPlan(const std::size_t N,
+                 const std::size_t howmany,
+                 const std::size_t stride = 1,
+                 const std::size_t dist = 0,
+                 const FFTDirection direction = FFTDirection_Forward,
+                 const std::uint32_t flags = FFTPlanFlag_Estimate,
+                 FFTThreadPool& pool = fft_thread_pool()) : _plan(N, direction, flags),
+                                                            _howmany(howmany),
+                                                            _stride(stride),
+                                                            _dist(dist != 0 ? dist : N * stride),
+                                                            _pool(&pool)
+    {
+        this->_buffer_size = N + this->_plan.engine().scratch_size();
+        this->_buffers.resize(this->_buffer_size * pool.size());
+    }
+
+    std::size_t size() const noexcept { return this->_plan.size(); }
+
+    std::size_t howmany() const noexcept { return this->_howmany; }
+
+    FFTDirection direction() const noexcept { return this->_plan.direction(); }
+
+    void execute(std::complex<T>* data) noexcept
+    {
+        const FFTEngine<T>& engine = this->_plan.engine();
+        const FFTDirection direction = this->_plan.direction();
+        const std::size_t N = this->size();
+
+        this->_pool->parallel_for(this->_howmany, [&](const std::size_t b, const std::size_t thread) {
+            std::complex<T>* buffer = this->_buffers.data() + thread * this->_buffer_size;
+            std::complex<T>* x = data + b * this->_dist;
+
+            if(this->_stride == 1)
+            {
+                engine.execute(x, buffer + N, direction);
+                return;
+            }
+
+            for(std::size_t i = 0; i < N; i++)
+            {
+                buffer[i] = x[i * this->_stride];
+            }
+
+            engine.execute(buffer, buffer + N, direction);
+
+            for(std::size_t i = 0; i < N; i++)
+            {
+                x[i * this->_stride] = buffer[i];
+            }
+        });
+    }
+};
+
+/* Tiles of the blocked transpose, 16 x 16 complex doubles is 4KB per tile, smaller elements get wider tiles of as many lines */
+static constexpr std::size_t FFT_TRANSPOSE_TILE = 16;
+
+/*
+    out (cols x rows) = transpose of in (rows x cols), one band of tiles per task.
+    Rows of in are in_stride elements apart, rows of out out_stride apart, 0 when packed.
+*/
+template<typename E>
+void fft_transpose(const E* in,
+                   E* out,
+                   const std::size_t rows,
+                   const std::size_t cols,
+                   FFTThreadPool& pool,
+                   const std::size_t in_stride = 0,
+                   const std::size_t out_stride = 0) noexcept
+{
+    constexpr std::size_t tile_size = FFT_TRANSPOSE_TILE * std::max<std::size_t>(1, sizeof(std::complex<double>) / sizeof(E));
+
+    const std::size_t bands = (rows + tile_size - 1) / tile_size;
+    const std::size_t ld_in = in_stride != 0 ? in_stride : cols;
+    const std::size_t ld_out = out_stride != 0 ? out_stride : rows;
+
+    pool.parallel_for(bands, [&](const std::size_t band, const std::size_t) {
+        const std::size_t r0 = band * tile_size;
+        const std::size_t r1 = std::min(rows, r0 + tile_size);
+
+        /*
+            Through a local tile, so every line of out is written in one go: with power of two
+            strides the lines of a tile share a cache set and would evict each other between rows
+        */
+        E tile[tile_size * tile_size];
+
+        for(std::size_t c0 = 0; c0 < cols; c0 += tile_size)
+        {
+            const std::size_t c1 = std::min(cols, c0 + tile_size);
+
+            for(std::size_t r = r0; r < r1; r++)
+            {
+                for(std::size_t c = c0; c < c1; c++)
+                {
+                    tile[(c - c0) * tile_size + (r - r0)] = in[r * ld_in + c];
+                }
+            }
+
+            for(std::size_t c = c0; c < c1; c++)
+            {
+                std::copy(tile + (c - c0) * tile_size, tile + (c - c0) * tile_size + (r1 - r0), out + c * ld_out + r0);
+            }
+        }
+    });
+}
+
+/*
+    Transforms along the first axis of a rows x cols row-major matrix: transpose, contiguous row
+    transforms, transpose back. Strided column transforms would touch one element per cache line.
+*/
+template<typename T>
+class FFTColumnPlan
+{
+    std::size_t _rows;
+    std::size_t _cols;
+    FFTBatchPlan<T> _batch;
+    std::vector<std::complex<T>> _work;
+    FFTThreadPool* _pool;
+
+public:
+    FFTColumnPlan(const std::size_t rows,
+                  const std::size_t cols,
+                  const FFTDirection direction,
+                  const std::uint32_t flags,
+                  FFTThreadPool& pool) : _rows(rows),
+                                         _cols(cols),
+                                         _batch(rows, cols, 1, rows, direction, flags, pool),
+                                         _work(rows * cols),
+                                         _pool(&pool) {}
+
+    void execute(std::complex<T>* data) noexcept
+    {
+        fft_transpose(data, this->_work.data(), this->_rows, this->_cols, *this->_pool);
+        this->_batch.execute(this->_work.data());
+        fft_transpose(this->_work.data(), data, this->_cols, this->_rows, *this->_pool);
+    }
+};
+
+/* 2D transform of a rows x cols row-major array, rows first, then columns */
+template<typename T>
+class FFTPlan2D
+{
+    FFTBatchPlan<T> _rows;
+    FFTColumnPlan<T> _cols;
+
+public:
+    FFTPlan2D(const std::size_t rows,
+              const std::size_t cols,
+              const FFTDirection direction = FFTDirection_Forward,
+              const std::uint32_t flags = FFTPlanFlag_Estimate,
+              FFTThreadPool& pool = fft_thread_pool()) : _rows(cols, rows, 1, cols, direction, flags, pool),
+                                                         _cols(rows, cols, direction, flags, pool) {}
+
+    void execute(std::complex<T>* data) noexcept
+    {
+        this->_rows.execute(data);
+        this->_cols.execute(data);
+    }
+};
+
+/*
+    3D transform of an n0 x n1 x n2 row-major array: the last axis as n0 * n1 contiguous rows,
+    the middle axis as the columns of each n1 x n2 slab, the first axis as the columns of n0 x (n1 * n2)
+*/
+template<typename T>
+class FFTPlan3D
+{
+    std::size_t _n0;
+    std::size_t _n1;
+    std::size_t _n2;
+    FFTBatchPlan<T> _axis2;
+    FFTColumnPlan<T> _axis1;
+    FFTColumnPlan<T> _axis0;
+
+public:
+    FFTPlan3D(const std::size_t n0,
+              const std::size_t n1,
+              const std::size_t n2,
+              const FFTDirection direction = FFTDirection_Forward,
+              const std::uint32_t flags = FFTPlanFlag_Estimate,
+              FFTThreadPool& pool = fft_thread_pool()) : _n0(n0),
+                                                         _n1(n1),
+                                                         _n2(n2),
+                                                         _axis2(n2, n0 * n1, 1, n2, direction, flags, pool),
+                                                         _axis1(n1, n2, direction, flags, pool),
+                                                         _axis0(n0, n1 * n2, direction, flags, pool) {}
+
+    void execute(std::complex<T>* data) noexcept
+    {
+        this->_axis2.execute(data);
+
+        for(std::size_t i = 0; i < this->_n0; i++)
+        {
+            this->_axis1.execute(data + i * this->_n1 * this->_n2);
+        }
+
+        this->_axis0.execute(data);
+    }
+};
+
+/* Bytes of a panel of sub-transforms in the four-step passes, so they are transposed in, transformed and written back from L2 */
+static constexpr std::size_t FFT_FOUR_STEP_PANEL_BYTES = std::size_t(1) << 20;
+
+/*
+    Bailey's four-step FFT for transforms much larger than the caches, N = N1 * N2 with N1 <= N2 close to sqrt(N):
+
+        X[k2 + N2 k1] = sum_n1 W_N1^(n1 k1) W_N^(n1 k2) sum_n2 W_N2^(n2 k2) x[n1 + N1 n2]
+
+    Pass 1: the input seen as N2 rows of N1 is transposed into out (N1 rows of N2), a panel of rows at a time,
+            each row gets its N2-point FFT and the twiddles W_N^(n1 k2).
+    Pass 2: the N2 columns of out get their N1-point FFTs, a panel of columns is transposed into a buffer,
+            transformed and transposed back. out ends in natural order.
+
+    Every sub-transform works on contiguous data that fits in cache, and each pass reads and writes the data
+    once with blocked transposes. That is what fft_file needs, with the data on disk. In memory this plan is
+    slower than FFTPlan: measured on one core up to 2^25 points, it takes about twice as long below 2^21 and
+    is at best even above, the transposes cost more than the cache misses FFTPlan's kernels leave. Use FFTPlan
+    for arrays that fit in memory.
+    The panels hold panel_bytes, the out-of-core driver makes them as large as its memory budget.
+    Sizes without a factor (primes) run one FFTPlan.
+*/
+template<typename T>
+class FFTFourStepPlan
+{
+    std::size_t _N;
+    std::size_t _N1;
+    std::size_t _N2;
+    FFTDirection _direction;
+    FFTThreadPool* _pool;
+
+    std::unique_ptr<FFTPlan<T>> _plan1;
+    std::unique_ptr<FFTPlan<T>> _plan2;
+
+    /* W_N^m = high[m >> shift] * low[m & (2^shift - 1)], two tables of about sqrt(N) roots */
+    std::vector<std::complex<T>> _twiddles_low;
+    std::vector<std::complex<T>> _twiddles_high;
+    std::size_t _twiddle_shift;
+
+    /* Rows of N2 per panel of pass 1, columns per panel of pass 2 */
+    std::size_t _panel1;
+    std::size_t _panel2;
+
+    /* Pass 2 panel, then the engine scratch of every thread */
+    std::vector<std::complex<T>> _buffer;
+    std::size_t _scratch_size;
+
+    /* Row n1 of pass 1 times W_N^(n1 k2), the exponent n1 * k2 mod N is carried along the row */
+    void _twiddle_row(std::complex<T>* row, const std::size_t n1) const noexcept
+    {
+        const std::size_t mask = (std::size_t(1) << this->_twiddle_shift) - 1;
+
+        std::size_t m = 0;
+
+        for(std::size_t k2 = 0; k2 < this->_N2; k2++)
+        {
+            std::complex<T> w = cmul(this->_twiddles_high[m >> this->_twiddle_shift], this->_twiddles_low[m & mask]);
+
+            if(this->_direction == FFTDirection_Backward)
+            {
+                w = std::conj(w);
+            }
+
+            row[k2] = cmul(row[k2], w);
+
+            m += n1;
+            m = m >= this->_N ? m - this->_N : m;
+        }
+    }
+
+public:
+    FFTFourStepPlan(const std::size_t N,
+                    const FFTDirection direction = FFTDirection_Forward,
+                    const std::uint32_t flags = FFTPlanFlag_Estimate,
+                    FFTThreadPool& pool = fft_thread_pool(),
+                    const std::size_t panel_bytes = FFT_FOUR_STEP_PANEL_BYTES) : _N(N),
+                                                                                 _N1(1),
+                                                                                 _N2(N),
+                                                                                 _direction(direction),
+                                                                                 _pool(&pool),
+                                                                                 _twiddle_shift(0),
+                                                                                 _panel1(0),
+                                                                                 _panel2(0),
+                                                                                 _scratch_size(0)
+    {
+        /* Largest factor up to sqrt(N) */
+        for(std::size_t f = 2; f * f <= N; f++)
+        {
+            if(N % f == 0)
+            {
+                this->_N1 = f;
+            }
+        }
+
+        this->_N2 = N / this->_N1;
+
+        this->_plan2 = std::make_unique<FFTPlan<T>>(this->_N2, direction, flags);
+        this->_scratch_size = this->_plan2->engine().scratch_size();
+
+        if(this->_N1 > 1)
+        {
+            this->_plan1 = std::make_unique<FFTPlan<T>>(this->_N1, direction, flags);
+            this->_scratch_size = std::max(this->_scratch_size, this->_plan1->engine().scratch_size());
+
+            this->_twiddle_shift = (log2_floor(N - 1) + 2) / 2;
+
+            const std::size_t low = std::size_t(1) << this->_twiddle_shift;
+
+            for(std::size_t m = 0; m < low; m++)
+            {
+                this->_twiddles_low.push_back(root_of_unity<T>(m, N));
+            }
+
+            for(std::size_t m = 0; m < N; m += low)
+            {
+                this->_twiddles_high.push_back(root_of_unity<T>(m, N));
+            }
+
+            /* At least a cache line of every row for the transposes, and a row per thread */
+            const std::size_t min_panel = std::max<std::size_t>(std::max<std::size_t>(1, 64 / sizeof(std::complex<T>)), pool.size());
+            const std::size_t elements = panel_bytes / sizeof(std::complex<T>);
+
+            this->_panel1 = std::min(this->_N1, std::max(min_panel, elements / this->_N2));
+            this->_panel2 = std::min(this->_N2, std::max(min_panel, elements / this->_N1));
+        }
+
+        this->_buffer.resize(this->_panel2 * this->_N1 + this->_scratch_size * pool.size());
+    }
+
+    std::size_t size() const noexcept { return this->_N; }
+
+    FFTDirection direction() const noexcept { return this->_direction; }
+
+    /* Factors of the decomposition, N1 = 1 when N has none */
+    std::pair<std::size_t, std::size_t> factors() const noexcept { return { this->_N1, this->_N2 }; }
+
+    /* Out-of-place, in is left untouched, in and out must not overlap */
+    void execute(const std::complex<T>* in, std::complex<T>* out) noexcept
+    {
+        const std::size_t N1 = this->_N1;
+        const std::size_t N2 = this->_N2;
+
+        std::complex<T>* panel = this->_buffer.data();
+        std::complex<T>* scratch = panel + this->_panel2 * N1;
+
+        if(N1 == 1)
+        {
+            std::copy(in, in + this->_N, out);
+            this->_plan2->engine().execute(out, scratch, this->_direction);
+            return;
+        }
+
+        const FFTEngine<T>& engine1 = this->_plan1->engine();
+        const FFTEngine<T>& engine2 = this->_plan2->engine();
+
+        for(std::size_t a = 0; a < N1; a += this->_panel1)
+        {
+            const std::size_t rows = std::min(this->_panel1, N1 - a);
+
+            fft_transpose(in + a, out + a * N2, N2, rows, *this->_pool, N1, N2);
+
+            this->_pool->parallel_for(rows, [&](const std::size_t r, const std::size_t thread) {
+                std::complex<T>* row = out + (a + r) * N2;
+
+                engine2.execute(row, scratch + thread * this->_scratch_size, this->_direction);
+                this->_twiddle_row(row, a + r);
+            });
+        }
+
+        for(std::size_t b = 0; b < N2; b += this->_panel2)
+        {
+            const std::size_t cols = std::min(this->_panel2, N2 - b);
+
+            fft_transpose(out + b, panel, N1, cols, *this->_pool, N2, N1);
+
+            this->_pool->parallel_for(cols, [&](const std::size_t c, const std::size_t thread) {
+                engine1.execute(panel + c * N1, scratch + thread * this->_scratch_size, this->_direction);
+            });
+
+            fft_transpose(panel, out + b, cols, N1, *this->_pool, N1, N2);
+        }
+    }
+};
+
+/*
+    Streaming short-time Fourier transform
+
+    Every hop samples, the last frame_size samples are windowed and go through a real FFT. Samples are pushed
+    in blocks of any size, frames are handed to a callback as soon as they are complete. Every buffer is
+    allocated by the constructor, nothing is allocated while streaming.
+*/
+
+enum FFTWindow : std::uint8_t
+{
+    FFTWindow_Rectangular,
+    FFTWindow_Hann,
+    FFTWindow_Hamming,
+    FFTWindow_Blackman,
+};
+
+const char* fft_window_to_string(std::uint8_t window)
+{
+    switch(window)
+    {
+        case FFTWindow_Rectangular:
+            return "Rectangular";
+        case FFTWindow_Hann:
+            return "Hann";
+        case FFTWindow_Hamming:
+            return "Hamming";
+        case FFTWindow_Blackman:
+            return "Blackman";
+        default:
+            return "Unknown Window";
+    }
+}
+
+/* Periodic windows (period N, not N - 1), the ones whose shifted copies add up to a constant */
+template<typename T>
+std::vector<T> fft_window(const FFTWindow window, const std::size_t N) noexcept
+{
+    std::vector<T> w(N, static_cast<T>(1));
+
+    for(std::size_t n = 0; n < N; n++)
+    {
+        const double x = 2.0 * M_PI * static_cast<double>(n) / static_cast<double>(N);
+
+        switch(window)
+        {
+            case FFTWindow_Hann:
+                w[n] = static_cast<T>(0.5 - 0.5 * std::cos(x));
+                break;
+            case FFTWindow_Hamming:
+                w[n] = static_cast<T>(0.54 - 0.46 * std::cos(x));
+                break;
+            case FFTWindow_Blackman:
+                w[n] = static_cast<T>(0.42 - 0.5 * std::cos(x) + 0.08 * std::cos(2.0 * x));
+                break;
+            default:
+                break;
+        }
+    }
+
+    return w;
+}
+
+enum STFTOutput : std::uint8_t
+{
+    STFTOutput_Complex,
+    STFTOutput_Magnitude,
+    STFTOutput_Power,
+};
+
+/*
+    The stream starts with frame_size - hop zeros, so that every sample is covered by as many frames
+    as in steady state, and ISTFT gives back the input delayed by frame_size - hop samples
+*/
+template<typename T>
+class STFT
+{
+    std::size_t _frame_size;
+    std::size_t _hop;
+
+    std::vector<T> _window;
+    FFTRealPlan<T> _plan;
+
+    /* Last samples of the stream, a frame is taken once it holds frame_size of them */
+    std::vector<T> _history;
+    std::size_t _filled;
+
+    std::vector<T> _frame;
+    std::vector<std::complex<T>> _spectrum;
+    std::vector<T> _values;
+
+    template<typename F>
+    void _emit(F&& on_frame) noexcept
+    {
+        const std::size_t N = this->_frame_size;
+
+        for(std::size_t n = 0; n < N; n++)
+        {
+            this->_frame[n] = this->_history[n] * this->_window[n];
+        }
+
+        this->_plan.forward(this->_frame.data(), this->_spectrum.data());
+
+        on_frame(static_cast<const std::vector<std::complex<T>>&>(this->_spectrum));
+
+        /* Keep the overlap for the next frame */
+        std::memmove(this->_history.data(), this->_history.data() + this->_hop, (N - this->_hop) * sizeof(T));
+        this->_filled = N - this->_hop;
+    }
+
+public:
+    STFT(const std::size_t frame_size,
+         const std::size_t hop,
+         const FFTWindow window = FFTWindow_Hann) : _frame_size(frame_size),
+                                                    _hop(std::clamp<std::size_t>(hop, 1, frame_size)),
+                                                    _window(fft_window<T>(window, frame_size)),
+                                                    _plan(frame_size),
+                                                    _history(frame_size),
+                                                    _frame(frame_size),
+                                                    _spectrum(frame_size / 2 + 1),
+                                                    _values(frame_size / 2 + 1)
+    {
+        this->reset();
+    }
+
+    std::size_t frame_size() const noexcept { return this->_frame_size; }
+
+    std::size_t hop() const noexcept { return this->_hop; }
+
+    /* Number of bins of each frame */
+    std::size_t bins() const noexcept { return this->_spectrum.size(); }
+
+    const std::vector<T>& window() const noexcept { return this->_window; }
+
+    /* Forgets the stream, the next sample pushed is the first one */
+    void reset() noexcept
+    {
+        std::fill(this->_history.begin(), this->_history.end(), static_cast<T>(0));
+        this->_filled = this->_frame_size - this->_hop;
+    }
+
+    /* on_frame(const std::vector<std::complex<T>>& spectrum) is called once per complete frame */
+    template<typename F>
+    void push(const T* samples, std::size_t count, F&& on_frame) noexcept
+    {
+        while(count > 0)
+        {
+            const std::size_t n = std::min(count, this->_frame_size - this->_filled);
+
+            std::memcpy(this->_history.data() + this->_filled, samples, n * sizeof(T));
+            this->_filled += n;
+            samples += n;
+            count -= n;
+
+            if(this->_filled == this->_frame_size)
+            {
+                this->_emit(on_frame);
+            }
+        }
+    }
+
+    template<typename F>
+    void push(std::span<const T> samples, F&& on_frame) noexcept
+    {
+        this->push(samples.data(), samples.size(), on_frame);
+    }
+
+    /* Spectrogram frames: on_frame(const std::vector<T>& values) gets |X[k]| or |X[k]|² */
+    template<typename F>
+    void push(std::span<const T> samples, const STFTOutput output, F&& on_frame) noexcept
+    {
+        this->push(samples.data(), samples.size(), [&](const std::vector<std::complex<T>>& spectrum) {
+            T* values = this->_values.data();
+
+            for(std::size_t k = 0; k < spectrum.size(); k++)
+            {
+                values[k] = spectrum[k].real() * spectrum[k].real() + spectrum[k].imag() * spectrum[k].imag();
+            }
+
+            if(output == STFTOutput_Magnitude)
+            {
+                for(std::size_t k = 0; k < spectrum.size(); k++)
+                {
+                    values[k] = std::sqrt(values[k]);
+                }
+            }
+
+            on_frame(static_cast<const std::vector<T>&>(this->_values));
+        });
+    }
+};
+
+/*
+    Inverse STFT by weighted overlap-add: every frame goes through the backward real FFT, is multiplied
+    by the window again and added to the output, which is divided by the sum of the squared windows
+    overlapping each sample. hop output samples are complete after each frame.
+*/
+template<typename T>
+class ISTFT
+{
+    std::size_t _frame_size;
+    std::size_t _hop;
+
+    std::vector<T> _window;
+    FFTRealPlan<T> _plan;
+
+    /* 1 / (N * sum of the squared windows) at each of the hop positions, N undoes the backward transform */
+    std::vector<T> _norm;
+
+    std::vector<T> _frame;
+    std::vector<T> _accumulator;
+
+public:
+    ISTFT(const std::size_t frame_size,
+          const std::size_t hop,
+          const FFTWindow window = FFTWindow_Hann) : _frame_size(frame_size),
+                                                     _hop(std::clamp<std::size_t>(hop, 1, frame_size)),
+                                                     _window(fft_window<T>(window, frame_size)),
+                                                     _plan(frame_size),
+                                                     _norm(_hop, static_cast<T>(0)),
+                                                     _frame(frame_size),
+                                                     _accumulator(frame_size, static_cast<T>(0))
+    {
+        for(std::size_t n = 0; n < frame_size; n++)
+        {
+            this->_norm[n % this->_hop] += this->_window[n] * this->_window[n];
+        }
+
+        for(T& norm : this->_norm)
+        {
+            norm = norm > static_cast<T>(0) ? static_cast<T>(1) / (norm * static_cast<T>(frame_size)) : static_cast<T>(0);
+        }
+    }
+
+    std::size_t frame_size() const noexcept { return this->_frame_size; }
+
+    std::size_t hop() const noexcept { return this->_hop; }
+
+    void reset() noexcept
+    {
+        std::fill(this->_accumulator.begin(), this->_accumulator.end(), static_cast<T>(0));
+    }
+
+    /* spectrum holds frame_size / 2 + 1 bins, on_samples(const T* samples, std::size_t hop) gets the completed samples */
+    template<typename F>
+    void push(std::span<const std::complex<T>> spectrum, F&& on_samples) noexcept
+    {
+        const std::size_t N = this->_frame_size;
+        const std::size_t hop = this->_hop;
+
+        this->_plan.backward(spectrum.data(), this->_frame.data());
+
+        T* acc = this->_accumulator.data();
+
+        for(std::size_t n = 0; n < N; n++)
+        {
+            acc[n] += this->_frame[n] * this->_window[n];
+        }
+
+        for(std::size_t n = 0; n < hop; n++)
+        {
+            acc[n] *= this->_norm[n];
+        }
+
+        on_samples(static_cast<const T*>(acc), hop);
+
+        std::memmove(acc, acc + hop, (N - hop) * sizeof(T));
+        std::fill(acc + N - hop, acc + N, static_cast<T>(0));
+    }
+};
+
+/*
+    FIR filtering, convolution and correlation
+
+    Short kernels use the direct sum, long ones overlap-save: each block of L = M + K - 1 samples (the K - 1
+    last samples of the previous block, then M new ones) goes through a real FFT of size L, is multiplied
+    by the spectrum of the kernel and transformed back, the M last outputs are the filtered samples,
+    the K - 1 first ones are wrapped around and discarded.
+*/
+
+enum FIRMethod : std::uint8_t
+{
+    FIRMethod_Direct,
+    FIRMethod_OverlapSave,
+    FIRMethod_Auto, /* direct up to FIR_DIRECT_MAX_TAPS taps */
+};
+
+const char* fir_method_to_string(std::uint8_t method)
+{
+    switch(method)
+    {
+        case FIRMethod_Direct:
+            return "Direct";
+        case FIRMethod_OverlapSave:
+            return "OverlapSave";
+        case FIRMethod_Auto:
+            return "Auto";
+        default:
+            return "Unknown Method";
+    }
+}
+
+/* Crossover measured by the benchmark (-O3 -march=native, AVX2), past about 100 taps the direct sum loses */
+static constexpr std::size_t FIR_DIRECT_MAX_TAPS = 96;
+
+/* New samples per block of the direct path */
+static constexpr std::size_t FIR_DIRECT_BLOCK = 4096;
+
+/* Smallest overlap-save FFT, below it the per-block overhead dominates */
+static constexpr std::size_t FIR_MIN_FFT_SIZE = 1 << 10;
+
+/* Power-of-two FFT size that minimizes the cost of a transform per output sample, L log2(L) / (L - K + 1) */
+inline std::size_t fir_fft_size(const std::size_t K) noexcept
+{
+    std::size_t best = FIR_MIN_FFT_SIZE;
+    double best_cost = std::numeric_limits<double>::max();
+
+    for(std::size_t L = FIR_MIN_FFT_SIZE; L <= std::max(K, FIR_MIN_FFT_SIZE) * 64; L *= 2)
+    {
+        if(L < 2 * K)
+        {
+            continue;
+        }
+
+        const double cost = static_cast<double>(L) * static_cast<double>(log2_floor(L)) / static_cast<double>(L - K + 1);
+
+        if(cost < best_cost)
+        {
+            best = L;
+            best_cost = cost;
+        }
+    }
+
+    return best;
+}
+
+/*
+    Streaming causal FIR filter, y[n] = sum h[k] x[n - k]. Samples are pushed in blocks of any size,
+    filtered samples come out through a callback once a whole block is in, flush() forces out the pending ones.
+    Every buffer is allocated by the constructor.
+*/
+template<typename T>
+class FIRFilter
+{
+    std::size_t _taps;
+    FIRMethod _method;
+
+    /* New samples per block */
+    std::size_t _block;
+
+    /* History of K - 1 samples, then the block */
+    std::vector<T> _buffer;
+    std::size_t _filled;
+
+    std::vector<T> _output;
+
+    /* Direct path, the kernel reversed, output i is the dot product with the K samples from buffer + i */
+    std::vector<T> _reversed;
+
+    /* Overlap-save path, the spectrum of the zero-padded kernel, scaled by 1 / L */
+    std::unique_ptr<FFTRealPlan<T>> _plan;
+    std::vector<std::complex<T>> _kernel;
+    std::vector<std::complex<T>> _spectrum;
+    std::vector<T> _time;
+
+    /* Computes the count first outputs of the block, hands them out and slides the history */
+    template<typename F>
+    void _process(const std::size_t count, F&& on_block) noexcept
+    {
+        const std::size_t K = this->_taps;
+        T* buffer = this->_buffer.data();
+        T* output = this->_output.data();
+
+        if(this->_method == FIRMethod_Direct)
+        {
+            const T* h = this->_reversed.data();
+
+            std::fill(output, output + count, static_cast<T>(0));
+
+            /* One tap at a time over the whole block, the inner loop vectorizes without reordering sums */
+            for(std::size_t k = 0; k < K; k++)
+            {
+                const T hk = h[k];
+                const T* x = buffer + k;
+
+                for(std::size_t i = 0; i < count; i++)
+                {
+                    output[i] += hk * x[i];
+                }
+            }
+        }
+        else
+        {
+            /* Stale samples past the count new ones only reach outputs we do not hand out */
+            this->_plan->forward(buffer, this->_spectrum.data());
+
+            for(std::size_t k = 0; k < this->_spectrum.size(); k++)
+            {
+                this->_spectrum[k] = cmul(this->_spectrum[k], this->_kernel[k]);
+            }
+
+            this->_plan->backward(this->_spectrum.data(), this->_time.data());
+
+            std::memcpy(output, this->_time.data() + K - 1, count * sizeof(T));
+        }
+
+        std::memmove(buffer, buffer + count, (K - 1) * sizeof(T));
+        this->_filled = 0;
+
+        on_block(static_cast<const T*>(output), count);
+    }
+
+public:
+    explicit FIRFilter(const std::vector<T>& taps, const FIRMethod method = FIRMethod_Auto) : _taps(std::max<std::size_t>(taps.size(), 1)),
+                                                                                              _method(method),
+                                                                                              _filled(0)
+    {
+        const std::size_t K = this->_taps;
+
+        if(this->_method == FIRMethod_Auto)
+        {
+            this->_method = K <= FIR_DIRECT_MAX_TAPS ? FIRMethod_Direct : FIRMethod_OverlapSave;
+        }
+
+        std::vector<T> h(K, static_cast<T>(0));
+        std::copy(taps.begin(), taps.end(), h.begin());
+
+        if(this->_method == FIRMethod_Direct)
+        {
+            this->_block = FIR_DIRECT_BLOCK;
+            this->_reversed.assign(h.rbegin(), h.rend());
+            this->_buffer.resize(this->_block + K - 1);
+        }
+        else
+        {
+            const std::size_t L = fir_fft_size(K);
+
+            this->_block = L - K + 1;
+            this->_plan = std::make_unique<FFTRealPlan<T>>(L);
+            this->_kernel.resize(this->_plan->spectrum_size());
+            this->_spectrum.resize(this->_plan->spectrum_size());
+            this->_time.resize(L);
+            this->_buffer.resize(L);
+
+            h.resize(L, static_cast<T>(0));
+            this->_plan->forward(h.data(), this->_kernel.data());
+
+            for(auto& x : this->_kernel)
+            {
+                x /= static_cast<T>(L);
+            }
+        }
+
+        this->_output.resize(this->_block);
+        this->reset();
+    }
+
+    std::size_t taps() const noexcept { return this->_taps; }
+
+    FIRMethod method() const noexcept { return this->_method; }
+
+    /* Number of filtered samples handed out at once, except by flush() */
+    std::size_t block_size() const noexcept { return this->_block; }
+
+    /* Forgets the signal, as if only zeros had been pushed so far */
+    void reset() noexcept
+    {
+        std::fill(this->_buffer.begin(), this->_buffer.end(), static_cast<T>(0));
+        this->_filled = 0;
+    }
+
+    /* on_block(const T* samples, std::size_t count) gets the filtered samples in order, count <= block_size() */
+    template<typename F>
+    void push(const T* samples, std::size_t count, F&& on_block) noexcept
+    {
+        T* block = this->_buffer.data() + this->_taps - 1;
+
+        while(count > 0)
+        {
+            const std::size_t n = std::min(count, this->_block - this->_filled);
+
+            std::memcpy(block + this->_filled, samples, n * sizeof(T));
+            this->_filled += n;
+            samples += n;
+            count -= n;
+
+            if(this->_filled == this->_block)
+            {
+                this->_process(this->_block, on_block);
+            }
+        }
+    }
+
+    template<typename F>
+    void push(std::span<const T> samples, F&& on_block) noexcept
+    {
+        this->push(samples.data(), samples.size(), on_block);
+    }
+
+    /* Hands out the filtered samples of an incomplete block, the stream can go on afterwards */
+    template<typename F>
+    void flush(F&& on_block) noexcept
+    {
+        if(this->_filled > 0)
+        {
+            this->_process(this->_filled, on_block);
+        }
+    }
+};
+
+/* Full linear convolution, x.size() + h.size() - 1 samples */
+template<typename T>
+std::vector<T> convolve(const std::vector<T>& x, const std::vector<T>& h, const FIRMethod method = FIRMethod_Auto) noexcept
+{
+    if(x.empty() || h.empty())
+    {
+        return {};
+    }
+
+    /* The shorter one is the kernel */
+    const std::vector<T>& signal = x.size() >= h.size() ? x : h;
+    const std::vector<T>& kernel = x.size() >= h.size() ? h : x;
+
+    std::vector<T> res;
+    res.reserve(x.size() + h.size() - 1);
+
+    const auto append = [&](const T* samples, const std::size_t count) { res.insert(res.end(), samples, samples + count); };
+
+    FIRFilter<T> filter(kernel, method);
+    filter.push(signal.data(), signal.size(), append);
+
+    /* The tail, where the kernel slides out of the signal */
+    const std::vector<T> zeros(std::min(kernel.size() - 1, filter.block_size()), static_cast<T>(0));
+
+    for(std::size_t remaining = kernel.size() - 1; remaining > 0; remaining -= std::min(remaining, zeros.size()))
+    {
+        filter.push(zeros.data(), std::min(remaining, zeros.size()), append);
+    }
+
+    filter.flush(append);
+
+    return res;
+}
+
+/*
+    Full cross-correlation, like numpy.correlate(x, h, "full"): res[j] = sum x[n + j - (K - 1)] h[n],
+    res[K - 1] is the zero lag
+*/
+template<typename T>
+std::vector<T> correlate(const std::vector<T>& x, const std::vector<T>& h, const FIRMethod method = FIRMethod_Auto) noexcept
+{
+    return convolve(x, std::vector<T>(h.rbegin(), h.rend()), method);
+}
+
+/*
+    Single bins, for tone detection
+
+    https://en.wikipedia.org/wiki/Goertzel_algorithm
+
+    Bin k of N samples with the real two-term recurrence s[n] = x[n] + 2cos(w) s[n - 1] - s[n - 2], w = 2πk / N,
+    then X[k] = cos(w) s[N - 1] - s[N - 2] + i sin(w) s[N - 1]. One multiply and two adds per sample for
+    real input, no complex exponential in the loop. The recurrence is latency bound, so up to GOERTZEL_GROUP bins
+    cost about as much as one, for a handful of bins that is cheaper than a full real FFT (see the benchmark).
+    Rounding errors grow with N, faster for bins near 0 and N / 2, which is fine for detection windows.
+*/
+
+template<typename T>
+struct fft_is_complex : std::false_type {};
+
+template<typename T>
+struct fft_is_complex<std::complex<T>> : std::true_type {};
+
+/* Recurrences run side by side, G independent chains hide the latency of each one */
+static constexpr std::size_t GOERTZEL_GROUP = 8;
+
+/* out[i] = X[bins[i] mod N] of the N samples of x, T is real or complex */
+template<typename T>
+void goertzel_bins(const T* x,
+                   const std::size_t N,
+                   const std::size_t* bins,
+                   const std::size_t count,
+                   std::complex<double>* out) noexcept
+{
+    typedef std::conditional_t<fft_is_complex<T>::value, std::complex<double>, double> S;
+
+    if(N == 0)
+    {
+        std::fill(out, out + count, std::complex<double>(0.0, 0.0));
+        return;
+    }
+
+    for(std::size_t b0 = 0; b0 < count; b0 += GOERTZEL_GROUP)
+    {
+        const std::size_t group = std::min(GOERTZEL_GROUP, count - b0);
+
+        /* Unused chains run with coefficient 0 so that the inner loop has a fixed trip count */
+        double cosines[GOERTZEL_GROUP] = {};
+        double sines[GOERTZEL_GROUP] = {};
+        double coefficients[GOERTZEL_GROUP] = {};
+
+        for(std::size_t j = 0; j < group; j++)
+        {
+            const std::complex<double> w = root_of_unity<double>(bins[b0 + j] % N, N);
+
+            cosines[j] = w.real();
+            sines[j] = -w.imag();
+            coefficients[j] = 2.0 * w.real();
+        }
+
+        S s1[GOERTZEL_GROUP] = {};
+        S s2[GOERTZEL_GROUP] = {};
+
+        for(std::size_t n = 0; n < N; n++)
+        {
+            const S xn = static_cast<S>(x[n]);
+
+            for(std::size_t j = 0; j < GOERTZEL_GROUP; j++)
+            {
+                const S s0 = xn + coefficients[j] * s1[j] - s2[j];
+                s2[j] = s1[j];
+                s1[j] = s0;
+            }
+        }
+
+        for(std::size_t j = 0; j < group; j++)
+        {
+            out[b0 + j] = cosines[j] * s1[j] - s2[j] + std::complex<double>(0.0, sines[j]) * s1[j];
+        }
+    }
+}
+
+/* Selected bins of the forward DFT of a container of real or complex values, O(N) per bin */
+template<typename Iterable>
+std::vector<std::complex<double>> dft_bins(const Iterable& input, const std::vector<std::size_t>& bins) noexcept
+{
+    typedef std::conditional_t<fft_is_complex<std::decay_t<decltype(input[0])>>::value, std::complex<double>, double> S;
+
+    const std::size_t N = input.size();
+
+    std::vector<S> samples(N);
+
+    for(std::size_t i = 0; i < N; i++)
+    {
+        samples[i] = static_cast<S>(input[i]);
+    }
+
+    std::vector<std::complex<double>> res(bins.size());
+    goertzel_bins(samples.data(), N, bins.data(), bins.size(), res.data());
+
+    return res;
+}
+
+/* Sliding DFTs are recomputed from scratch every N * SLIDING_DFT_RESYNC samples */
+static constexpr std::size_t SLIDING_DFT_RESYNC = 64;
+
+/*
+    Selected bins of the DFT of the last N samples, updated in O(1) per sample and per bin:
+    X'[k] = exp(2πik / N) (X[k] - x[n - N] + x[n]). The rounding errors of the update accumulate,
+    so the bins are periodically recomputed with Goertzel from the history, which costs O(1 / SLIDING_DFT_RESYNC)
+    per sample. Before N samples were pushed, the window is padded with zeros in front.
+*/
+template<typename T>
+class SlidingDFT
+{
+    std::size_t _N;
+    std::vector<std::size_t> _bins;
+
+    /* exp(2πik / N) */
+    std::vector<std::complex<T>> _twiddles;
+    std::vector<std::complex<T>> _values;
+
+    /* Last N samples, _position is the oldest one */
+    std::vector<T> _history;
+    std::size_t _position;
+    std::size_t _since_resync;
+
+    /* The window in order and the recomputed bins, for the resync */
+    std::vector<T> _window;
+    std::vector<std::complex<double>> _exact;
+
+    void _resync() noexcept
+    {
+        const std::size_t N = this->_N;
+
+        std::copy(this->_history.begin() + this->_position, this->_history.end(), this->_window.begin());
+        std::copy(this->_history.begin(), this->_history.begin() + this->_position, this->_window.begin() + (N - this->_position));
+
+        goertzel_bins(this->_window.data(), N, this->_bins.data(), this->_bins.size(), this->_exact.data());
+
+        for(std::size_t i = 0; i < this->_bins.size(); i++)
+        {
+            this->_values[i] = static_cast<std::complex<T>>(this->_exact[i]);
+        }
+
+        this->_since_resync = 0;
+    }
+
+public:
+    SlidingDFT(const std::size_t N, const std::vector<std::size_t>& bins) : _N(std::max<std::size_t>(N, 1)),
+                                                                         _bins(bins),
+                                                                         _twiddles(bins.size()),
+                                                                         _values(bins.size()),
+                                                                         _history(_N),
+                                                                         _window(_N),
+                                                                         _exact(bins.size())
+    {
+        for(std::size_t i = 0; i < bins.size(); i++)
+        {
+            this->_bins[i] %= this->_N;
+            this->_twiddles[i] = std::conj(root_of_unity<T>(this->_bins[i], this->_N));
+        }
+
+        this->reset();
+    }
+
+    std::size_t size() const noexcept { return this->_N; }
+
+    const std::vector<std::size_t>& bins() const noexcept { return this->_bins; }
+
+    /* values()[i] is bin bins()[i] of the window */
+    const std::vector<std::complex<T>>& values() const noexcept { return this->_values; }
+
+    void reset() noexcept
+    {
+        std::fill(this->_history.begin(), this->_history.end(), static_cast<T>(0));
+        std::fill(this->_values.begin(), this->_values.end(), std::complex<T>(0, 0));
+        this->_position = 0;
+        this->_since_resync = 0;
+    }
+
+    void push(const T sample) noexcept
+    {
+        const T delta = sample - this->_history[this->_position];
+
+        this->_history[this->_position] = sample;
+        this->_position = this->_position + 1 == this->_N ? 0 : this->_position + 1;
+
+        for(std::size_t i = 0; i < this->_values.size(); i++)
+        {
+            this->_values[i] = cmul(this->_twiddles[i], this->_values[i] + delta);
+        }
+
+        if(++this->_since_resync == this->_N * SLIDING_DFT_RESYNC)
+        {
+            this->_resync();
+        }
+    }
+
+    /* Same as pushing the samples one by one, the bins only hold the state after the last one */
+    void push(std::span<const T> samples) noexcept
+    {
+        for(const T sample : samples)
+        {
+            this->push(sample);
+        }
+    }
+};
+
+/* The textbook O(N²) sum, kept as the reference the fast transforms are checked against */
+template<typename Iterable>
+std::vector<std::complex<double>> dft_direct(const Iterable& input) noexcept
+{
+    const std::size_t N = input.size();
+
+    std::vector<std::complex<double>> res(N);
+
+    /* exp(-2πi * j * i / N) only depends on (j * i) mod N */
+    std::vector<std::complex<double>> roots(N);
+
+    for(std::size_t k = 0; k < N; k++)
+    {
+        roots[k] = root_of_unity<double>(k, N);
+    }
+
+    for(std::size_t i = 0; i < N; i++)
+    {
+        std::complex<double> Xn = 0;
+        std::size_t k = 0;
+
+        for(std::size_t j = 0; j < N; j++)
+        {
+            Xn += cmul(static_cast<std::complex<double>>(input[j]), roots[k]);
+
+            k += i;
+
+            if(k >= N)
+            {
+                k -= N;
+            }
+        }
+
+        res[i] = Xn;
+    }
+
+    return res;
+}
+
+/* Forward DFT of any container of real or complex values, in O(N log N) */
+template<typename Iterable>
+std::vector<std::complex<double>> dft(const Iterable& input) noexcept
+{
+    const std::size_t N = input.size();
+
+    std::vector<std::complex<double>> res(N);
+
+    for(std::size_t i = 0; i < N; i++)
+    {
+        res[i] = static_cast<std::complex<double>>(input[i]);
+    }
+
+    fft(res, FFTDirection_Forward);
+
+    return res;
+}
+
+/* Forward DFT of N real values, the N/2 + 1 first bins, the others are their conjugates */
+template<typename Iterable>
+std::vector<std::complex<double>> rfft(const Iterable& input)
+{
+    const std::size_t N = input.size();
+
+    std::vector<double> samples(N);
+
+    for(std::size_t i = 0; i < N; i++)
+    {
+        samples[i] = static_cast<double>(input[i]);
+    }
+
+    FFTRealPlan<double> plan(N);
+
+    std::vector<std::complex<double>> res(plan.spectrum_size());
+    plan.forward(samples.data(), res.data());
+
+    return res;
+}
+
+/* Inverse of rfft, normalized: irfft(rfft(x), x.size()) = x */
+inline std::vector<double> irfft(const std::vector<std::complex<double>>& spectrum, const std::size_t N)
+{
+    FFTRealPlan<double> plan(N);
+
+    std::vector<std::complex<double>> bins(plan.spectrum_size(), std::complex<double>(0));
+    std::copy(spectrum.begin(), spectrum.begin() + std::min(spectrum.size(), bins.size()), bins.begin());
+
+    std::vector<double> res(N);
+    plan.backward(bins.data(), res.data());
+
+    for(auto& x : res)
+    {
+        x /= static_cast<double>(N);
+    }
+
+    return res;
+}
@@ -0,0 +1,156 @@
+#pragma once
+
+#include <complex>
+#include <cstddef>
+#include <string>
+#include <iostream>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "dft.hpp"
+
+/*
+    Out-of-core FFT of a file of std::complex<T>, too large to be held in memory next to its transform
+
+    Both files are mapped and FFTFourStepPlan runs on the mappings, with panels as large as the memory budget:
+    pass 1 reads the input once, a strip of columns at a time, and writes every row of the output once,
+    pass 2 reads and writes the output once, a strip of columns at a time. The kernel pages in and writes back
+    in strips, the resident set stays around the budget plus the twiddles.
+    The strips are budget / sqrt(N) elements wide, a budget under sqrt(N) pages reads pages several times.
+*/
+
+/* Read-only or read-write mapping of a whole file, unmapped and closed on destruction */
+class FFTMappedFile
+{
+    void* _data;
+    std::size_t _size;
+    int _fd;
+
+public:
+    /* size == 0 maps an existing file read-only, otherwise the file is created or resized to size bytes */
+    FFTMappedFile(const std::string& path, const std::size_t size = 0) noexcept : _data(nullptr), _size(0), _fd(-1)
+    {
+        const bool writable = size != 0;
+
+        this->_fd = writable ? open(path.c_str(), O_RDWR | O_CREAT, 0644) : open(path.c_str(), O_RDONLY);
+
+        if(this->_fd < 0)
+        {
+            std::cerr << "Cannot open file: " << path << "\n";
+            return;
+        }
+
+        if(writable)
+        {
+            if(ftruncate(this->_fd, static_cast<off_t>(size)) != 0)
+            {
+                std::cerr << "Cannot resize file: " << path << "\n";
+                return;
+            }
+
+            this->_size = size;
+        }
+        else
+        {
+            struct stat st;
+
+            if(fstat(this->_fd, &st) != 0 || st.st_size == 0)
+            {
+                std::cerr << "Cannot read the size of file: " << path << "\n";
+                return;
+            }
+
+            this->_size = static_cast<std::size_t>(st.st_size);
+        }
+
+        void* data = mmap(nullptr, this->_size, writable ? PROT_READ | PROT_WRITE : PROT_READ, MAP_SHARED, this->_fd, 0);
+
+        if(data == MAP_FAILED)
+        {
+            std::cerr << "Cannot map file: " << path << "\n";
+            this->_size = 0;
+            return;
+        }
+
+        this->_data = data;
+    }
+
+    ~FFTMappedFile() noexcept
+    {
+        if(this->_data != nullptr)
+        {
+            munmap(this->_data, this->_size);
+        }
+
+        if(this->_fd >= 0)
+        {
+            close(this->_fd);
+        }
+    }
+
+    FFTMappedFile(const FFTMappedFile&) = delete;
+    FFTMappedFile& operator=(const FFTMappedFile&) = delete;
+
+    FFTMappedFile(FFTMappedFile&&) = delete;
+    FFTMappedFile& operator=(FFTMappedFile&&) = delete;
+
+    bool valid() const noexcept { return this->_data != nullptr; }
+
+    void* data() const noexcept { return this->_data; }
+    std::size_t size() const noexcept { return this->_size; }
+
+    /* Writes the dirty pages back, so the output is on disk when this returns true */
+    bool sync() const noexcept { return msync(this->_data, this->_size, MS_SYNC) == 0; }
+};
+
+/* Budget of the out-of-core transform for its strips, on top of the page cache of the mappings */
+static constexpr std::size_t FFT_FILE_MEMORY_BUDGET = std::size_t(256) << 20;
+
+/*
+    Transforms in_path, a raw array of std::complex<T> in native byte order, into out_path, created or overwritten.
+    Returns false with a message on std::cerr when a file cannot be opened, mapped or written.
+*/
+template<typename T>
+bool fft_file(const std::string& in_path,
+              const std::string& out_path,
+              const FFTDirection direction = FFTDirection_Forward,
+              const std::size_t memory_budget = FFT_FILE_MEMORY_BUDGET,
+              FFTThreadPool& pool = fft_thread_pool()) noexcept
+{
+    const FFTMappedFile input(in_path);
+
+    if(!input.valid())
+    {
+        return false;
+    }
+
+    if(input.size() % sizeof(std::complex<T>) != 0)
+    {
+        std::cerr << "File size is not a multiple of the element size: " << in_path << "\n";
+        return false;
+    }
+
+    const std::size_t N = input.size() / sizeof(std::complex<T>);
+
+    const FFTMappedFile output(out_path, input.size());
+
+    if(!output.valid())
+    {
+        return false;
+    }
+
+    FFTFourStepPlan<T> plan(N, direction, FFTPlanFlag_Estimate, pool, memory_budget);
+
+    plan.execute(static_cast<const std::complex<T>*>(input.data()), static_cast<std::complex<T>*>(output.data()));
+
+    if(!output.sync())
+    {
+        std::cerr << "Cannot write file: " << out_path << "\n";
+        return false;
+    }
+
+    return true;
+}
@@ -0,0 +1,54 @@
+#include <cstdint>
+#include <iostream>
+#include <vector>
+
+#include "ntt.hpp"
+
+/* Coefficients of (1 + x + x^2)^n mod 1e9 + 7 by repeated squaring, each product an NTT convolution */
+std::vector<std::uint32_t> trinomial_power(std::size_t n, const std::uint32_t modulus)
+{
+    std::vector<std::uint32_t> res = { 1 };
+    std::vector<std::uint32_t> base = { 1, 1, 1 };
+
+    while(n > 0)
+    {
+        if(n & 1)
+        {
+            res = ntt_convolve(res, base, modulus);
+        }
+
+        n >>= 1;
+
+        if(n > 0)
+        {
+            base = ntt_convolve(base, base, modulus);
+        }
+    }
+
+    return res;
+}
+
+int main(int argc, char** argv) noexcept
+{
+    constexpr std::uint32_t MOD = 1e9 + 7;
+
+    const std::vector<std::uint32_t> small = trinomial_power(4, MOD);
+
+    std::cout << "(1 + x + x^2)^4: ";
+
+    for(std::size_t i = 0; i < small.size(); i++)
+    {
+        std::cout << small[i] << ((i < (small.size() - 1)) ? ", " : "");
+    }
+
+    std::cout << "\n";
+
+    /* Central trinomial coefficient, the number of ways to come back to 0 after n steps of -1, 0 or +1 */
+    constexpr std::size_t N = 1000000;
+
+    const std::vector<std::uint32_t> large = trinomial_power(N, MOD);
+
+    std::cout << "Central coefficient of (1 + x + x^2)^" << N << " mod " << MOD << ": " << large[N] << "\n";
+
+    return 0;
+}
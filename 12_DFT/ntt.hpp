@@ -0,0 +1,773 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <memory>
+#include <unordered_map>
+#include <algorithm>
+#include <bit>
+
+#include "dft.hpp"
+
+#if FFT_HAS_X86_SIMD
+#include <immintrin.h>
+#endif
+
+/*
+    Number-theoretic transform: the DFT over the integers modulo a prime p, exact, with no rounding
+
+    https://en.wikipedia.org/wiki/Discrete_Fourier_transform_over_a_ring#Number-theoretic_transform
+    https://en.wikipedia.org/wiki/Montgomery_modular_multiplication
+    https://en.wikipedia.org/wiki/Chinese_remainder_theorem
+
+    A power-of-two N needs an N-th root of unity mod p, there is one when N divides p - 1: g^((p - 1) / N)
+    with g a primitive root. Primes c * 2^k + 1 have them for every N <= 2^k.
+
+    Products go through Montgomery multiplication with R = 2^32: a * b * R^-1 mod p with two 32 x 32 -> 64-bit
+    multiplications and a shift, no division. Roots are kept as w * R so that data can stay as plain residues.
+
+    The forward transform is decimation in frequency, natural order in, bit-reversed order out, the inverse is
+    decimation in time, bit-reversed in, natural out: a convolution never has to reorder anything.
+*/
+
+/* Primes below 2^31 for the three-prime convolutions, their product is about 1.7e27 */
+static constexpr std::uint32_t NTT_PRIMES[3] = {
+    2013265921, /* 15 * 2^27 + 1 */
+    1811939329, /* 27 * 2^26 + 1 */
+    469762049,  /* 7 * 2^26 + 1 */
+};
+
+/* Largest transform all three primes support, so longest three-prime convolution */
+static constexpr std::size_t NTT_MAX_SIZE = std::size_t(1) << 26;
+
+/* Transforms are done a whole level at a time over the array down to blocks of this many values, then block by block */
+static constexpr std::size_t NTT_BLOCK = std::size_t(1) << 13;
+
+/* Below this many terms in the shorter factor the direct product is faster */
+static constexpr std::size_t NTT_DIRECT_MAX_SIZE = 32;
+
+/* Montgomery arithmetic modulo an odd mod < 2^31, values in [0, mod) */
+struct NTTMontgomery
+{
+    std::uint32_t mod;
+    std::uint32_t inv; /* -mod^-1 mod 2^32 */
+    std::uint32_t r2; /* 2^64 mod mod */
+
+    NTTMontgomery() noexcept : mod(0), inv(0), r2(0) {}
+
+    explicit NTTMontgomery(const std::uint32_t mod) noexcept : mod(mod)
+    {
+        /* Newton's iteration, each step doubles the correct low bits */
+        std::uint32_t x = mod;
+
+        for(std::size_t i = 0; i < 5; i++)
+        {
+            x *= 2 - mod * x;
+        }
+
+        this->inv = -x;
+
+        const std::uint64_t r = (std::uint64_t(1) << 32) % mod;
+        this->r2 = static_cast<std::uint32_t>(r * r % mod);
+    }
+
+    /* x * 2^-32 mod mod, x < mod * 2^32 */
+    std::uint32_t reduce(const std::uint64_t x) const noexcept
+    {
+        const std::uint32_t m = static_cast<std::uint32_t>(x) * this->inv;
+        const std::uint32_t t = static_cast<std::uint32_t>((x + static_cast<std::uint64_t>(m) * this->mod) >> 32);
+
+        return t >= this->mod ? t - this->mod : t;
+    }
+
+    std::uint32_t mul(const std::uint32_t a, const std::uint32_t b) const noexcept
+    {
+        return this->reduce(static_cast<std::uint64_t>(a) * b);
+    }
+
+    /* x * 2^32 mod mod, the Montgomery form of x */
+    std::uint32_t to(const std::uint32_t x) const noexcept
+    {
+        return this->mul(x % this->mod, this->r2);
+    }
+
+    std::uint32_t from(const std::uint32_t x) const noexcept
+    {
+        return this->reduce(x);
+    }
+};
+
+/* GCC vector types of uint32 lanes */
+template<std::size_t Bytes>
+struct NTTVector;
+
+template<> struct NTTVector<32> { typedef std::uint32_t type __attribute__((vector_size(32))); };
+template<> struct NTTVector<64> { typedef std::uint32_t type __attribute__((vector_size(64))); };
+
+/*
+    Modular add, sub and Montgomery mul on uint32 or vectors of them, operands in [0, mod) and mod < 2^31.
+    min(x, x - mod) keeps x when x < mod, the subtraction wraps around.
+*/
+template<typename V>
+[[gnu::always_inline]] inline void ntt_add(const V& a, const V& b, const V& mod, V& out) noexcept
+{
+    const V s = a + b;
+    const V t = s - mod;
+    out = t < s ? t : s;
+}
+
+template<typename V>
+[[gnu::always_inline]] inline void ntt_sub(const V& a, const V& b, const V& mod, V& out) noexcept
+{
+    const V d = a - b;
+    const V t = d + mod;
+    out = t < d ? t : d;
+}
+
+[[gnu::always_inline]] inline void ntt_mul(const std::uint32_t& a,
+                                           const std::uint32_t& b,
+                                           const std::uint32_t& mod,
+                                           const std::uint32_t& inv,
+                                           std::uint32_t& out) noexcept
+{
+    const std::uint64_t x = static_cast<std::uint64_t>(a) * b;
+    const std::uint32_t m = static_cast<std::uint32_t>(x) * inv;
+    const std::uint32_t t = static_cast<std::uint32_t>((x + static_cast<std::uint64_t>(m) * mod) >> 32);
+
+    out = t >= mod ? t - mod : t;
+}
+
+#if FFT_HAS_X86_SIMD
+/*
+    vpmuludq multiplies the even 32-bit lanes into 64-bit ones: even and odd lanes are reduced separately,
+    the results are the high halves of the sums, put back together with a blend.
+*/
+__attribute__((target("avx2"))) inline void ntt_mul(const NTTVector<32>::type& a,
+                                                                           const NTTVector<32>::type& b,
+                                                                           const NTTVector<32>::type& mod,
+                                                                           const NTTVector<32>::type& inv,
+                                                                           NTTVector<32>::type& out) noexcept
+{
+    typedef NTTVector<32>::type V;
+
+    const __m256i x = (__m256i)a;
+    const __m256i y = (__m256i)b;
+    const __m256i p = (__m256i)mod;
+    const __m256i n = (__m256i)inv;
+
+    const __m256i even = _mm256_mul_epu32(x, y);
+    const __m256i odd = _mm256_mul_epu32(_mm256_srli_epi64(x, 32), _mm256_srli_epi64(y, 32));
+
+    const __m256i even_sum = _mm256_add_epi64(even, _mm256_mul_epu32(_mm256_mul_epu32(even, n), p));
+    const __m256i odd_sum = _mm256_add_epi64(odd, _mm256_mul_epu32(_mm256_mul_epu32(odd, n), p));
+
+    const V t = (V)_mm256_blend_epi32(_mm256_srli_epi64(even_sum, 32), odd_sum, 0xAA);
+    const V r = t - mod;
+
+    out = r < t ? r : t;
+}
+
+__attribute__((target("avx512f"))) inline void ntt_mul(const NTTVector<64>::type& a,
+                                                                              const NTTVector<64>::type& b,
+                                                                              const NTTVector<64>::type& mod,
+                                                                              const NTTVector<64>::type& inv,
+                                                                              NTTVector<64>::type& out) noexcept
+{
+    typedef NTTVector<64>::type V;
+
+    const __m512i x = (__m512i)a;
+    const __m512i y = (__m512i)b;
+    const __m512i p = (__m512i)mod;
+    const __m512i n = (__m512i)inv;
+
+    /* The zero-masked forms with a full mask, the plain ones start from _mm512_undefined_epi32() that GCC 12 warns about */
+    const __mmask8 all = 0xFF;
+
+    const __m512i even = _mm512_maskz_mul_epu32(all, x, y);
+    const __m512i odd = _mm512_maskz_mul_epu32(all, _mm512_maskz_srli_epi64(all, x, 32), _mm512_maskz_srli_epi64(all, y, 32));
+
+    const __m512i even_sum = _mm512_add_epi64(even, _mm512_maskz_mul_epu32(all, _mm512_maskz_mul_epu32(all, even, n), p));
+    const __m512i odd_sum = _mm512_add_epi64(odd, _mm512_maskz_mul_epu32(all, _mm512_maskz_mul_epu32(all, odd, n), p));
+
+    const V t = (V)_mm512_mask_blend_epi32(0xAAAA, _mm512_maskz_srli_epi64(all, even_sum, 32), odd_sum);
+    const V r = t - mod;
+
+    out = r < t ? r : t;
+}
+#endif /* FFT_HAS_X86_SIMD */
+
+/*
+    One radix-2 pass over n values, butterflies len apart, roots[j] = w^j * R with w a 2len-th root of unity.
+    Forward, decimation in frequency: (u, v) -> (u + v, (u - v) * w^j).
+    Inverse, decimation in time: (u, v) -> (u + v * w^j, u - v * w^j).
+*/
+template<typename V, bool forward>
+[[gnu::always_inline]] inline void ntt_pass(std::uint32_t* a,
+                                            const std::uint32_t* roots,
+                                            const std::size_t n,
+                                            const std::size_t len,
+                                            const NTTMontgomery& montgomery) noexcept
+{
+    constexpr std::size_t W = sizeof(V) / sizeof(std::uint32_t);
+
+    const V mod = V{} + montgomery.mod;
+    const V inv = V{} + montgomery.inv;
+
+    for(std::size_t s = 0; s < n; s += 2 * len)
+    {
+        for(std::size_t j = 0; j < len; j += W)
+        {
+            V u, v, w;
+
+            fft_load(u, a + s + j);
+            fft_load(v, a + s + j + len);
+            fft_load(w, roots + j);
+
+            V x, y;
+
+            if constexpr(forward)
+            {
+                V d;
+
+                ntt_add(u, v, mod, x);
+                ntt_sub(u, v, mod, d);
+                ntt_mul(d, w, mod, inv, y);
+            }
+            else
+            {
+                V t;
+
+                ntt_mul(v, w, mod, inv, t);
+                ntt_add(u, t, mod, x);
+                ntt_sub(u, t, mod, y);
+            }
+
+            fft_store(a + s + j, x);
+            fft_store(a + s + j + len, y);
+        }
+    }
+}
+
+/*
+    Masks of the passes with butterflies len < W apart, over the 2W values of two vectors a and b:
+    u and v gather the two inputs of every butterfly, lo and hi put the outputs x and y back in place.
+*/
+template<typename V, std::size_t len, typename I>
+struct NTTShuffle;
+
+template<typename V, std::size_t len, std::size_t... k>
+struct NTTShuffle<V, len, std::index_sequence<k...>>
+{
+    static constexpr std::size_t W = sizeof...(k);
+
+    static constexpr V u = { static_cast<std::uint32_t>(k / len * 2 * len + k % len)... };
+    static constexpr V v = { static_cast<std::uint32_t>(k / len * 2 * len + k % len + len)... };
+    static constexpr V lo = { static_cast<std::uint32_t>(((k & len) ? W : 0) + k / (2 * len) * len + k % len)... };
+    static constexpr V hi = { static_cast<std::uint32_t>((((k + W) & len) ? W : 0) + (k + W) / (2 * len) * len + (k + W) % len)... };
+};
+
+/* ntt_pass for len < W on n >= 2W values, the butterflies are shuffled into whole vectors */
+template<typename V, bool forward, std::size_t len>
+[[gnu::always_inline]] inline void ntt_pass_narrow(std::uint32_t* a,
+                                                   const std::uint32_t* roots,
+                                                   const std::size_t n,
+                                                   const NTTMontgomery& montgomery) noexcept
+{
+    constexpr std::size_t W = sizeof(V) / sizeof(std::uint32_t);
+
+    typedef NTTShuffle<V, len, std::make_index_sequence<W>> M;
+
+    const V mod = V{} + montgomery.mod;
+    const V inv = V{} + montgomery.inv;
+
+    std::uint32_t lanes[W];
+
+    for(std::size_t k = 0; k < W; k++)
+    {
+        lanes[k] = roots[k % len];
+    }
+
+    V w;
+    fft_load(w, lanes);
+
+    for(std::size_t s = 0; s < n; s += 2 * W)
+    {
+        V a0, a1;
+
+        fft_load(a0, a + s);
+        fft_load(a1, a + s + W);
+
+        const V u = __builtin_shuffle(a0, a1, M::u);
+        const V v = __builtin_shuffle(a0, a1, M::v);
+
+        V x, y;
+
+        if constexpr(forward)
+        {
+            V d;
+
+            ntt_add(u, v, mod, x);
+            ntt_sub(u, v, mod, d);
+            ntt_mul(d, w, mod, inv, y);
+        }
+        else
+        {
+            V t;
+
+            ntt_mul(v, w, mod, inv, t);
+            ntt_add(u, t, mod, x);
+            ntt_sub(u, t, mod, y);
+        }
+
+        a0 = __builtin_shuffle(x, y, M::lo);
+        a1 = __builtin_shuffle(x, y, M::hi);
+
+        fft_store(a + s, a0);
+        fft_store(a + s + W, a1);
+    }
+}
+
+/* One level, W lanes of butterflies at a time, only transforms shorter than two vectors run on scalars */
+template<typename V, bool forward>
+[[gnu::always_inline]] inline void ntt_level(std::uint32_t* a,
+                                             const std::uint32_t* roots,
+                                             const std::size_t n,
+                                             const std::size_t len,
+                                             const NTTMontgomery& montgomery) noexcept
+{
+    constexpr std::size_t W = sizeof(V) / sizeof(std::uint32_t);
+
+    if constexpr(W > 1)
+    {
+        if(len >= W)
+        {
+            ntt_pass<V, forward>(a, roots + len, n, len, montgomery);
+            return;
+        }
+
+        if(n >= 2 * W)
+        {
+            switch(len)
+            {
+                case 1:
+                    ntt_pass_narrow<V, forward, 1>(a, roots + len, n, montgomery);
+                    return;
+                case 2:
+                    ntt_pass_narrow<V, forward, 2>(a, roots + len, n, montgomery);
+                    return;
+                case 4:
+                    ntt_pass_narrow<V, forward, 4>(a, roots + len, n, montgomery);
+                    return;
+                default:
+                    ntt_pass_narrow<V, forward, 8>(a, roots + len, n, montgomery);
+                    return;
+            }
+        }
+    }
+
+    ntt_pass<std::uint32_t, forward>(a, roots + len, n, len, montgomery);
+}
+
+/*
+    Every level of the transform of N values. The levels with butterflies further apart than NTT_BLOCK sweep the
+    whole array, after them (before them for the inverse) the blocks are independent and done one by one in cache.
+*/
+template<typename V, bool forward>
+[[gnu::always_inline]] inline void ntt_impl(std::uint32_t* a,
+                                            const std::uint32_t* roots,
+                                            const std::size_t N,
+                                            const NTTMontgomery& montgomery) noexcept
+{
+    const std::size_t block = std::min(N, NTT_BLOCK);
+
+    if constexpr(forward)
+    {
+        for(std::size_t len = N / 2; len >= block; len /= 2)
+        {
+            ntt_level<V, true>(a, roots, N, len, montgomery);
+        }
+
+        for(std::size_t b = 0; b < N; b += block)
+        {
+            for(std::size_t len = block / 2; len >= 1; len /= 2)
+            {
+                ntt_level<V, true>(a + b, roots, block, len, montgomery);
+            }
+        }
+    }
+    else
+    {
+        for(std::size_t b = 0; b < N; b += block)
+        {
+            for(std::size_t len = 1; len < block; len *= 2)
+            {
+                ntt_level<V, false>(a + b, roots, block, len, montgomery);
+            }
+        }
+
+        for(std::size_t len = block; len < N; len *= 2)
+        {
+            ntt_level<V, false>(a, roots, N, len, montgomery);
+        }
+    }
+}
+
+/* Pointwise a * b * scale * R^-2 */
+template<typename V>
+[[gnu::always_inline]] inline void ntt_pointwise_impl(const std::uint32_t* a,
+                                                      const std::uint32_t* b,
+                                                      std::uint32_t* out,
+                                                      const std::size_t N,
+                                                      const std::uint32_t scale,
+                                                      const NTTMontgomery& montgomery) noexcept
+{
+    constexpr std::size_t W = sizeof(V) / sizeof(std::uint32_t);
+
+    const V mod = V{} + montgomery.mod;
+    const V inv = V{} + montgomery.inv;
+    const V s = V{} + scale;
+
+    for(std::size_t i = 0; i < N; i += W)
+    {
+        V x, y, p;
+
+        fft_load(x, a + i);
+        fft_load(y, b + i);
+
+        ntt_mul(x, y, mod, inv, p);
+        ntt_mul(p, s, mod, inv, x);
+
+        fft_store(out + i, x);
+    }
+}
+
+template<bool forward>
+void ntt_scalar(std::uint32_t* a, const std::uint32_t* roots, const std::size_t N, const NTTMontgomery& montgomery) noexcept
+{
+    ntt_impl<std::uint32_t, forward>(a, roots, N, montgomery);
+}
+
+inline void ntt_pointwise_scalar(const std::uint32_t* a,
+                                 const std::uint32_t* b,
+                                 std::uint32_t* out,
+                                 const std::size_t N,
+                                 const std::uint32_t scale,
+                                 const NTTMontgomery& montgomery) noexcept
+{
+    ntt_pointwise_impl<std::uint32_t>(a, b, out, N, scale, montgomery);
+}
+
+#if FFT_HAS_X86_SIMD
+template<bool forward>
+__attribute__((target("avx2"))) void ntt_avx2(std::uint32_t* a, const std::uint32_t* roots, const std::size_t N, const NTTMontgomery& montgomery) noexcept
+{
+    ntt_impl<NTTVector<32>::type, forward>(a, roots, N, montgomery);
+}
+
+template<bool forward>
+__attribute__((target("avx512f"))) void ntt_avx512(std::uint32_t* a, const std::uint32_t* roots, const std::size_t N, const NTTMontgomery& montgomery) noexcept
+{
+    ntt_impl<NTTVector<64>::type, forward>(a, roots, N, montgomery);
+}
+
+__attribute__((target("avx2"))) inline void ntt_pointwise_avx2(const std::uint32_t* a,
+                                                               const std::uint32_t* b,
+                                                               std::uint32_t* out,
+                                                               const std::size_t N,
+                                                               const std::uint32_t scale,
+                                                               const NTTMontgomery& montgomery) noexcept
+{
+    ntt_pointwise_impl<NTTVector<32>::type>(a, b, out, N, scale, montgomery);
+}
+
+__attribute__((target("avx512f"))) inline void ntt_pointwise_avx512(const std::uint32_t* a,
+                                                                    const std::uint32_t* b,
+                                                                    std::uint32_t* out,
+                                                                    const std::size_t N,
+                                                                    const std::uint32_t scale,
+                                                                    const NTTMontgomery& montgomery) noexcept
+{
+    ntt_pointwise_impl<NTTVector<64>::type>(a, b, out, N, scale, montgomery);
+}
+#endif /* FFT_HAS_X86_SIMD */
+
+/*
+    NTT of size N, a power of two, modulo the prime mod < 2^31 with N dividing mod - 1. Data are residues
+    in [0, mod). inverse(forward(x)) = N * x like the FFTs, multiply() divides by N.
+*/
+class NTTPlan
+{
+    std::size_t _N;
+    FFTSimd _simd;
+    NTTMontgomery _montgomery;
+
+    /* Roots of the level with butterflies len apart at [len, 2len), Montgomery form */
+    std::vector<std::uint32_t> _roots;
+    std::vector<std::uint32_t> _inverse_roots;
+
+    /* R^2 / N mod p: one Montgomery product with it undoes the R^-1 of the pointwise one and divides by N */
+    std::uint32_t _scale;
+
+    template<bool forward>
+    void _execute(std::uint32_t* data) const noexcept
+    {
+        const std::uint32_t* roots = forward ? this->_roots.data() : this->_inverse_roots.data();
+
+        switch(this->_simd)
+        {
+#if FFT_HAS_X86_SIMD
+            case FFTSimd_AVX512:
+                ntt_avx512<forward>(data, roots, this->_N, this->_montgomery);
+                break;
+            case FFTSimd_AVX2:
+                ntt_avx2<forward>(data, roots, this->_N, this->_montgomery);
+                break;
+#endif
+            default:
+                ntt_scalar<forward>(data, roots, this->_N, this->_montgomery);
+                break;
+        }
+    }
+
+public:
+    NTTPlan(const std::size_t N, const std::uint32_t mod, const FFTSimd simd = fft_detect_simd()) : _N(N),
+                                                                                                  _simd(std::min(simd, fft_detect_simd())),
+                                                                                                  _montgomery(mod),
+                                                                                                  _roots(std::max<std::size_t>(N, 1)),
+                                                                                                  _inverse_roots(std::max<std::size_t>(N, 1))
+    {
+        const std::uint64_t g = primitive_root(mod);
+
+        for(std::size_t len = 1; len < N; len *= 2)
+        {
+            const std::uint64_t w = pow_mod(g, (mod - 1) / (2 * len), mod);
+            const std::uint64_t w_inverse = pow_mod(w, mod - 2, mod);
+
+            std::uint64_t x = 1;
+            std::uint64_t y = 1;
+
+            for(std::size_t j = 0; j < len; j++)
+            {
+                this->_roots[len + j] = this->_montgomery.to(static_cast<std::uint32_t>(x));
+                this->_inverse_roots[len + j] = this->_montgomery.to(static_cast<std::uint32_t>(y));
+
+                x = x * w % mod;
+                y = y * w_inverse % mod;
+            }
+        }
+
+        const std::uint32_t N_inverse = static_cast<std::uint32_t>(pow_mod(N % mod, mod - 2, mod));
+        this->_scale = this->_montgomery.to(this->_montgomery.to(N_inverse));
+    }
+
+    std::size_t size() const noexcept { return this->_N; }
+
+    std::uint32_t modulus() const noexcept { return this->_montgomery.mod; }
+
+    /* Instruction set actually used, never more than the CPU supports */
+    FFTSimd simd() const noexcept { return this->_simd; }
+
+    /* In-place, natural order in, bit-reversed order out */
+    void forward(std::uint32_t* data) const noexcept
+    {
+        this->_execute<true>(data);
+    }
+
+    /* In-place, bit-reversed order in, natural order out, not normalized */
+    void inverse(std::uint32_t* data) const noexcept
+    {
+        this->_execute<false>(data);
+    }
+
+    /* out = a * b / N, pointwise, for the transforms of two sequences: inverse(out) is their cyclic convolution */
+    void multiply(const std::uint32_t* a, const std::uint32_t* b, std::uint32_t* out) const noexcept
+    {
+        switch(this->_N < 16 ? FFTSimd_Scalar : this->_simd)
+        {
+#if FFT_HAS_X86_SIMD
+            case FFTSimd_AVX512:
+                ntt_pointwise_avx512(a, b, out, this->_N, this->_scale, this->_montgomery);
+                break;
+            case FFTSimd_AVX2:
+                ntt_pointwise_avx2(a, b, out, this->_N, this->_scale, this->_montgomery);
+                break;
+#endif
+            default:
+                ntt_pointwise_scalar(a, b, out, this->_N, this->_scale, this->_montgomery);
+                break;
+        }
+    }
+};
+
+/* Plans are cached per thread, per size and per prime */
+inline NTTPlan& ntt_plan(const std::size_t N, const std::uint32_t mod)
+{
+    static thread_local std::unordered_map<std::uint64_t, std::unique_ptr<NTTPlan>> cache;
+
+    const std::uint64_t key = (static_cast<std::uint64_t>(mod) << 6) | log2_floor(N);
+
+    auto it = cache.find(key);
+
+    if(it == cache.end())
+    {
+        it = cache.emplace(key, std::make_unique<NTTPlan>(N, mod)).first;
+    }
+
+    return *it->second;
+}
+
+/* The textbook O(n * m) product, kept as the reference the transforms are checked against */
+template<typename Iterable>
+std::vector<std::uint32_t> ntt_convolve_direct(const Iterable& a, const Iterable& b, const std::uint32_t modulus)
+{
+    if(a.size() == 0 || b.size() == 0)
+    {
+        return {};
+    }
+
+    std::vector<std::uint64_t> sums(a.size() + b.size() - 1, 0);
+
+    for(std::size_t i = 0; i < a.size(); i++)
+    {
+        const std::uint64_t x = static_cast<std::uint64_t>(a[i]) % modulus;
+
+        for(std::size_t j = 0; j < b.size(); j++)
+        {
+            sums[i + j] = (sums[i + j] + x * (static_cast<std::uint64_t>(b[j]) % modulus)) % modulus;
+        }
+    }
+
+    return std::vector<std::uint32_t>(sums.begin(), sums.end());
+}
+
+/* Zero-padded transform of the residues of data modulo plan.modulus() */
+template<typename Iterable>
+void ntt_transform_padded(const Iterable& data, std::vector<std::uint32_t>& out, const NTTPlan& plan)
+{
+    out.assign(plan.size(), 0);
+
+    for(std::size_t i = 0; i < data.size(); i++)
+    {
+        out[i] = static_cast<std::uint32_t>(static_cast<std::uint64_t>(data[i]) % plan.modulus());
+    }
+
+    plan.forward(out.data());
+}
+
+/* Linear convolution modulo the prime of plan, whose size holds a.size() + b.size() - 1 terms */
+template<typename Iterable>
+std::vector<std::uint32_t> ntt_convolve_prime(const Iterable& a, const Iterable& b, const NTTPlan& plan)
+{
+    std::vector<std::uint32_t> x;
+    std::vector<std::uint32_t> y;
+
+    ntt_transform_padded(a, x, plan);
+    ntt_transform_padded(b, y, plan);
+
+    plan.multiply(x.data(), y.data(), x.data());
+    plan.inverse(x.data());
+
+    x.resize(a.size() + b.size() - 1);
+
+    return x;
+}
+
+/*
+    Product of the polynomials a and b modulo any modulus < 2^32, in O(n log n).
+    When modulus is itself a prime with a root of unity of the size needed, one NTT does it. Otherwise the exact
+    integer product is computed modulo the three NTT_PRIMES: its terms are below n * modulus^2 < 2^90, less than
+    the product of the primes for n <= NTT_MAX_SIZE, and rebuilt modulo modulus with Garner's form of the CRT.
+    Returns an empty vector with a message on std::cerr for modulus 0, and for products that need the three
+    primes and more than NTT_MAX_SIZE terms.
+*/
+template<typename Iterable>
+std::vector<std::uint32_t> ntt_convolve(const Iterable& a, const Iterable& b, const std::uint32_t modulus)
+{
+    if(modulus == 0)
+    {
+        std::cerr << "ntt_convolve: the modulus must be at least 1\n";
+        return {};
+    }
+
+    if(a.size() == 0 || b.size() == 0)
+    {
+        return {};
+    }
+
+    if(std::min(a.size(), b.size()) <= NTT_DIRECT_MAX_SIZE)
+    {
+        return ntt_convolve_direct(a, b, modulus);
+    }
+
+    const std::size_t length = a.size() + b.size() - 1;
+    const std::size_t N = std::bit_ceil(length);
+
+    if(modulus < (std::uint32_t(1) << 31) && (modulus - 1) % N == 0 && is_prime(modulus))
+    {
+        return ntt_convolve_prime(a, b, ntt_plan(N, modulus));
+    }
+
+    /* The primes have no root of unity of a larger order, and the CRT bound on the terms would not hold */
+    if(N > NTT_MAX_SIZE)
+    {
+        std::cerr << "ntt_convolve: " << length << " terms need a transform of size " << N
+                  << ", more than NTT_MAX_SIZE = " << NTT_MAX_SIZE << "\n";
+        return {};
+    }
+
+    /* The bound on the terms holds for residues modulo modulus */
+    std::vector<std::uint32_t> x(a.size());
+    std::vector<std::uint32_t> y(b.size());
+
+    for(std::size_t i = 0; i < a.size(); i++)
+    {
+        x[i] = static_cast<std::uint32_t>(static_cast<std::uint64_t>(a[i]) % modulus);
+    }
+
+    for(std::size_t i = 0; i < b.size(); i++)
+    {
+        y[i] = static_cast<std::uint32_t>(static_cast<std::uint64_t>(b[i]) % modulus);
+    }
+
+    const std::uint64_t p0 = NTT_PRIMES[0];
+    const std::uint64_t p1 = NTT_PRIMES[1];
+    const std::uint64_t p2 = NTT_PRIMES[2];
+
+    const std::vector<std::uint32_t> r0 = ntt_convolve_prime(x, y, ntt_plan(N, NTT_PRIMES[0]));
+    const std::vector<std::uint32_t> r1 = ntt_convolve_prime(x, y, ntt_plan(N, NTT_PRIMES[1]));
+    const std::vector<std::uint32_t> r2 = ntt_convolve_prime(x, y, ntt_plan(N, NTT_PRIMES[2]));
+
+    /* x = x0 + x1 * p0 + x2 * p0 * p1 with xi < pi, the constants in Montgomery form give plain residues */
+    const NTTMontgomery m1(NTT_PRIMES[1]);
+    const NTTMontgomery m2(NTT_PRIMES[2]);
+
+    const std::uint32_t p0_inverse_mod_p1 = m1.to(static_cast<std::uint32_t>(pow_mod(p0, p1 - 2, p1)));
+    const std::uint32_t p0p1_inverse_mod_p2 = m2.to(static_cast<std::uint32_t>(pow_mod(p0 * p1 % p2, p2 - 2, p2)));
+    const std::uint32_t p0_mod_p2 = m2.to(static_cast<std::uint32_t>(p0 % p2));
+    const std::uint32_t one_mod_p2 = m2.to(1);
+
+    const std::uint64_t p0_mod_m = p0 % modulus;
+    const std::uint64_t p0p1_mod_m = p0 * p1 % modulus;
+
+    std::vector<std::uint32_t> res(length);
+
+    for(std::size_t i = 0; i < length; i++)
+    {
+        const std::uint32_t x0 = r0[i];
+        const std::uint32_t x0_mod_p1 = x0 >= p1 ? x0 - static_cast<std::uint32_t>(p1) : x0;
+        const std::uint32_t x1 = m1.mul(r1[i] >= x0_mod_p1 ? r1[i] - x0_mod_p1 : r1[i] + static_cast<std::uint32_t>(p1) - x0_mod_p1, p0_inverse_mod_p1);
+
+        /* x0 + x1 * p0 mod p2, x0 * R * R^-1 reduces x0 < 2^31 */
+        std::uint32_t x01 = m2.mul(x1, p0_mod_p2) + m2.mul(x0, one_mod_p2);
+        x01 = x01 >= p2 ? x01 - static_cast<std::uint32_t>(p2) : x01;
+
+        const std::uint32_t x2 = m2.mul(r2[i] >= x01 ? r2[i] - x01 : r2[i] + static_cast<std::uint32_t>(p2) - x01, p0p1_inverse_mod_p2);
+
+        const std::uint64_t low = (x0 + x1 * p0_mod_m) % modulus;
+        res[i] = static_cast<std::uint32_t>((low + x2 * p0p1_mod_m) % modulus);
+    }
+
+    return res;
+}
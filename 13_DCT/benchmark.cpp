@@ -0,0 +1,879 @@
+#include <iostream>
+#include <chrono>
+#include <vector>
+#include <random>
+#include <iomanip>
+#include <cmath>
+#include <algorithm>
+#include <cstdlib>
+#include <new>
+#include <cstdint>
+
+#include "dct.hpp"
+
+/* Every allocation goes through here, to check that plans do not allocate once built, noinline or GCC flags the free() of a new-ed pointer */
+static std::size_t allocation_count = 0;
+
+[[gnu::noinline]] void* operator new(std::size_t size)
+{
+    allocation_count++;
+
+    void* ptr = std::malloc(size == 0 ? 1 : size);
+
+    if(ptr == nullptr)
+    {
+        throw std::bad_alloc();
+    }
+
+    return ptr;
+}
+
+[[gnu::noinline]] void operator delete(void* ptr) noexcept
+{
+    std::free(ptr);
+}
+
+[[gnu::noinline]] void operator delete(void* ptr, std::size_t) noexcept
+{
+    std::free(ptr);
+}
+
+class BenchmarkTimer
+{
+private:
+    std::chrono::high_resolution_clock::time_point start_time;
+
+public:
+    void start() noexcept
+    {
+        this->start_time = std::chrono::high_resolution_clock::now();
+    }
+
+    double elapsed_ms() const noexcept
+    {
+        auto end_time = std::chrono::high_resolution_clock::now();
+        auto duration = std::chrono::duration_cast<std::chrono::microseconds>(end_time - this->start_time);
+        return duration.count() / 1000.0;
+    }
+};
+
+std::vector<double> generateSignal(const std::size_t N) noexcept
+{
+    std::mt19937 gen(42);
+    std::uniform_real_distribution<double> dist(-1.0, 1.0);
+
+    std::vector<double> signal(N);
+
+    for(auto& x : signal)
+    {
+        x = dist(gen);
+    }
+
+    return signal;
+}
+
+/* Orthonormal DCT-IV by its O(N²) definition */
+std::vector<double> dct4Direct(const std::vector<double>& data) noexcept
+{
+    const std::size_t N = data.size();
+    const double scale = std::sqrt(2.0 / static_cast<double>(N));
+
+    std::vector<double> res(N, 0.0);
+
+    for(std::size_t k = 0; k < N; k++)
+    {
+        double sum = 0.0;
+
+        for(std::size_t n = 0; n < N; n++)
+        {
+            sum += data[n] * std::cos((M_PI / static_cast<double>(N)) * (static_cast<double>(n) + 0.5) * (static_cast<double>(k) + 0.5));
+        }
+
+        res[k] = sum * scale;
+    }
+
+    return res;
+}
+
+double maxError(const std::vector<double>& res, const std::vector<double>& ref) noexcept
+{
+    double max_error = 0.0;
+
+    for(std::size_t i = 0; i < ref.size(); i++)
+    {
+        max_error = std::max(max_error, std::abs(res[i] - ref[i]));
+    }
+
+    return max_error;
+}
+
+void runAccuracyCheck() noexcept
+{
+    std::cout << "\n=== Accuracy against the direct sums ===" << std::endl;
+
+    const std::size_t sizes[] = { 1, 2, 3, 5, 8, 15, 16, 100, 127, 1000, 1024, 4096 };
+
+    for(const std::size_t N : sizes)
+    {
+        const std::vector<double> signal = generateSignal(N);
+
+        const std::vector<double> dct2 = dct(signal);
+        const std::vector<double> dct3 = idct(dct2);
+        const std::vector<double> dct4 = dct(signal, DCTType_IV);
+        const std::vector<double> dct44 = dct(dct4, DCTType_IV);
+
+        std::cout << "N = " << std::setw(4) << N << std::scientific << std::setprecision(1)
+                  << "  DCT-II: " << maxError(dct2, dct_direct(signal))
+                  << "  DCT-III(DCT-II): " << maxError(dct3, signal)
+                  << "  DCT-IV: " << maxError(dct4, dct4Direct(signal))
+                  << "  DCT-IV(DCT-IV): " << maxError(dct44, signal)
+                  << std::defaultfloat << std::endl;
+    }
+}
+
+void runSpeedBenchmark() noexcept
+{
+    std::cout << "\n=== Direct O(N²) vs fast O(N log N) ===" << std::endl;
+
+    const std::size_t sizes[] = { 8, 64, 256, 1024, 4096, 8192, 1 << 16, 1 << 20 };
+
+    for(const std::size_t N : sizes)
+    {
+        const std::vector<double> signal = generateSignal(N);
+        std::vector<double> out(N);
+
+        BenchmarkTimer timer;
+
+        std::cout << "N = " << std::setw(7) << N << std::fixed << std::setprecision(4);
+
+        double direct_time = 0.0;
+
+        /* Past 8192 points the direct sum takes seconds */
+        if(N <= 8192)
+        {
+            const std::size_t iterations = std::max<std::size_t>(1, (std::size_t(1) << 20) / (N * N));
+
+            timer.start();
+
+            for(std::size_t i = 0; i < iterations; i++)
+            {
+                out = dct_direct(signal);
+            }
+
+            direct_time = timer.elapsed_ms() / static_cast<double>(iterations);
+
+            std::cout << "  direct: " << std::setw(10) << direct_time << " ms";
+        }
+        else
+        {
+            std::cout << "  direct: " << std::setw(10) << "-" << "   ";
+        }
+
+        const std::size_t iterations = std::max<std::size_t>(1, (std::size_t(1) << 22) / N);
+
+        for(const DCTType type : { DCTType_II, DCTType_III, DCTType_IV })
+        {
+            DCTPlan<double> plan(N, type);
+
+            timer.start();
+
+            for(std::size_t i = 0; i < iterations; i++)
+            {
+                plan.execute(signal.data(), out.data());
+            }
+
+            const double time = timer.elapsed_ms() / static_cast<double>(iterations);
+
+            std::cout << "  " << dct_type_to_string(type) << ": " << std::setw(8) << time << " ms";
+
+            if(type == DCTType_II && direct_time > 0.0)
+            {
+                std::cout << " (x" << std::setprecision(0) << direct_time / time << std::setprecision(4) << ")";
+            }
+        }
+
+        std::cout << std::defaultfloat << std::endl;
+    }
+}
+
+template<typename T>
+void runPlanBenchmark(const char* precision) noexcept
+{
+    std::cout << "\n=== DCTPlan<" << precision << ">, repeated transforms ===" << std::endl;
+
+    const std::size_t sizes[] = { 8, 16, 32, 64, 1024, 1 << 16 };
+
+    for(const std::size_t N : sizes)
+    {
+        const std::vector<double> signal = generateSignal(N);
+        const std::vector<T> input(signal.begin(), signal.end());
+        std::vector<T> output(N);
+
+        DCTPlan<T> plan(N);
+
+        plan.execute(input.data(), output.data());
+
+        /* The direct sum is too slow past a few thousand points, the double plan is the reference there */
+        double error = 0.0;
+        const std::vector<double> ref = N <= 4096 ? dct_direct(signal) : dct(signal);
+
+        for(std::size_t k = 0; k < N; k++)
+        {
+            error = std::max(error, std::abs(static_cast<double>(output[k]) - ref[k]));
+        }
+
+        const std::size_t iterations = std::max<std::size_t>(1, (std::size_t(1) << 24) / N);
+
+        BenchmarkTimer timer;
+
+        const std::size_t allocations = allocation_count;
+
+        timer.start();
+
+        for(std::size_t i = 0; i < iterations; i++)
+        {
+            plan.execute(input.data(), output.data());
+        }
+
+        const double plan_time = timer.elapsed_ms() * 1e6 / static_cast<double>(iterations);
+
+        const std::size_t plan_allocations = allocation_count - allocations;
+
+        /* dct() returns a new vector each time, its plan is cached */
+        timer.start();
+
+        for(std::size_t i = 0; i < iterations; i++)
+        {
+            output[0] += static_cast<T>(dct(input)[0]);
+        }
+
+        const double dct_time = timer.elapsed_ms() * 1e6 / static_cast<double>(iterations);
+
+        std::cout << "N = " << std::setw(5) << N << std::fixed << std::setprecision(1)
+                  << "  execute: " << std::setw(9) << plan_time << " ns (" << plan_allocations << " allocations)"
+                  << "  dct(): " << std::setw(9) << dct_time << " ns"
+                  << "  error: " << std::scientific << std::setprecision(1) << error
+                  << std::defaultfloat << std::endl;
+    }
+}
+
+/* Orthonormal 2D DCT of one N x N block with the generic plans, rows then columns, N <= 32 */
+template<typename T>
+void dctBlockGeneric(DCTPlan<T>& plan, const std::size_t N, const T* in, T* out) noexcept
+{
+    T rows[32 * 32];
+
+    for(std::size_t r = 0; r < N; r++)
+    {
+        plan.execute(in + r * N, rows + r * N);
+    }
+
+    for(std::size_t c = 0; c < N; c++)
+    {
+        T column[32];
+
+        for(std::size_t r = 0; r < N; r++)
+        {
+            column[r] = rows[r * N + c];
+        }
+
+        plan.execute(column, column);
+
+        for(std::size_t r = 0; r < N; r++)
+        {
+            out[r * N + c] = column[r];
+        }
+    }
+}
+
+void runBlockBenchmark() noexcept
+{
+    std::cout << "\n=== 8x8 block DCT (AAN float / Loeffler fixed point) ===" << std::endl;
+
+    const std::size_t num_blocks = 1000;
+
+    std::mt19937 gen(42);
+    std::uniform_int_distribution<int> dist(-128, 127);
+
+    std::vector<double> samples(num_blocks * 64);
+
+    for(auto& x : samples)
+    {
+        x = static_cast<double>(dist(gen));
+    }
+
+    std::vector<double> ref(num_blocks * 64);
+    DCTPlan<double> plan(8);
+
+    for(std::size_t b = 0; b < num_blocks; b++)
+    {
+        dctBlockGeneric(plan, 8, samples.data() + b * 64, ref.data() + b * 64);
+    }
+
+    const std::vector<float> input_float(samples.begin(), samples.end());
+    const std::vector<std::int16_t> input_fixed(samples.begin(), samples.end());
+
+    /* Outputs of the scalar path: fixed point must match them exactly, float within rounding (FMA contraction) */
+    std::vector<float> scalar_float;
+    std::vector<std::int16_t> scalar_fixed;
+
+    for(const FFTSimd simd : { FFTSimd_Scalar, FFTSimd_AVX2, FFTSimd_AVX512 })
+    {
+        if(simd > fft_detect_simd())
+        {
+            continue;
+        }
+
+        std::vector<float> coefficients_float(num_blocks * 64);
+        std::vector<float> roundtrip_float(num_blocks * 64);
+        std::vector<std::int16_t> coefficients_fixed(num_blocks * 64);
+        std::vector<std::int16_t> roundtrip_fixed(num_blocks * 64);
+
+        dct8x8_forward(input_float.data(), coefficients_float.data(), num_blocks, simd);
+        dct8x8_inverse(coefficients_float.data(), roundtrip_float.data(), num_blocks, simd);
+        dct8x8_forward(input_fixed.data(), coefficients_fixed.data(), num_blocks, simd);
+        dct8x8_inverse(coefficients_fixed.data(), roundtrip_fixed.data(), num_blocks, simd);
+
+        double float_error = 0.0;
+        double float_roundtrip = 0.0;
+        double fixed_error = 0.0;
+        int fixed_roundtrip = 0;
+
+        if(simd == FFTSimd_Scalar)
+        {
+            scalar_float = coefficients_float;
+            scalar_fixed = coefficients_fixed;
+        }
+
+        double float_vs_scalar = 0.0;
+        std::size_t fixed_vs_scalar = 0;
+
+        for(std::size_t i = 0; i < samples.size(); i++)
+        {
+            float_error = std::max(float_error, std::abs(static_cast<double>(coefficients_float[i]) - ref[i]));
+            float_roundtrip = std::max(float_roundtrip, std::abs(static_cast<double>(roundtrip_float[i]) - samples[i]));
+            fixed_error = std::max(fixed_error, std::abs(static_cast<double>(coefficients_fixed[i]) - ref[i]));
+            fixed_roundtrip = std::max(fixed_roundtrip, std::abs(static_cast<int>(roundtrip_fixed[i]) - static_cast<int>(input_fixed[i])));
+            float_vs_scalar = std::max(float_vs_scalar, std::abs(static_cast<double>(coefficients_float[i]) - scalar_float[i]));
+            fixed_vs_scalar += coefficients_fixed[i] != scalar_fixed[i];
+        }
+
+        std::cout << std::setw(6) << fft_simd_to_string(simd) << std::scientific << std::setprecision(1)
+                  << "  float: error " << float_error << ", roundtrip " << float_roundtrip << std::defaultfloat
+                  << "  fixed: error " << std::setprecision(2) << fixed_error << ", roundtrip " << fixed_roundtrip
+                  << "  vs scalar: float " << std::scientific << std::setprecision(1) << float_vs_scalar << std::defaultfloat
+                  << ", fixed " << fixed_vs_scalar << " mismatches"
+                  << (float_vs_scalar < 1e-3 && fixed_vs_scalar == 0 ? "" : "  FAILED") << std::endl;
+    }
+
+    /* A 4096 x 4096 gradient with noise */
+    const std::size_t width = 4096;
+    const std::size_t height = 4096;
+    const double megapixels = static_cast<double>(width * height) / 1e6;
+
+    std::vector<std::uint8_t> image(width * height);
+
+    for(std::size_t y = 0; y < height; y++)
+    {
+        for(std::size_t x = 0; x < width; x++)
+        {
+            image[y * width + x] = static_cast<std::uint8_t>(std::clamp(static_cast<int>((x + y) / 32) + dist(gen) / 8, 0, 255));
+        }
+    }
+
+    std::vector<std::uint8_t> decoded(width * height);
+    std::vector<float> blocks_float(dct8x8_image_blocks(width, height) * 64);
+    std::vector<std::int16_t> blocks_fixed(dct8x8_image_blocks(width, height) * 64);
+
+    BenchmarkTimer timer;
+
+    {
+        /* Generic 8-point plans on rows then columns, one block at a time */
+        DCTPlan<float> generic(8);
+
+        timer.start();
+
+        for(std::size_t b = 0; b < blocks_float.size() / 64; b++)
+        {
+            dctBlockGeneric(generic, 8, blocks_float.data() + b * 64, blocks_float.data() + b * 64);
+        }
+
+        const double time = timer.elapsed_ms();
+
+        std::cout << "Generic DCTPlan<float>(8) rows + columns: " << std::fixed << std::setprecision(1)
+                  << megapixels * 1000.0 / time << " MP/s" << std::defaultfloat << std::endl;
+    }
+
+    std::cout << "Image " << width << " x " << height << ", " << fft_thread_pool().size() << " threads" << std::endl;
+
+    for(const FFTSimd simd : { FFTSimd_Scalar, FFTSimd_AVX2, FFTSimd_AVX512 })
+    {
+        if(simd > fft_detect_simd())
+        {
+            continue;
+        }
+
+        timer.start();
+        dct8x8_image_forward(image.data(), width, height, width, blocks_float.data(), fft_thread_pool(), simd);
+        const double float_forward = timer.elapsed_ms();
+
+        timer.start();
+        dct8x8_image_inverse(blocks_float.data(), decoded.data(), width, height, width, fft_thread_pool(), simd);
+        const double float_inverse = timer.elapsed_ms();
+
+        int float_error = 0;
+
+        for(std::size_t i = 0; i < image.size(); i++)
+        {
+            float_error = std::max(float_error, std::abs(static_cast<int>(decoded[i]) - static_cast<int>(image[i])));
+        }
+
+        timer.start();
+        dct8x8_image_forward(image.data(), width, height, width, blocks_fixed.data(), fft_thread_pool(), simd);
+        const double fixed_forward = timer.elapsed_ms();
+
+        timer.start();
+        dct8x8_image_inverse(blocks_fixed.data(), decoded.data(), width, height, width, fft_thread_pool(), simd);
+        const double fixed_inverse = timer.elapsed_ms();
+
+        int fixed_error = 0;
+
+        for(std::size_t i = 0; i < image.size(); i++)
+        {
+            fixed_error = std::max(fixed_error, std::abs(static_cast<int>(decoded[i]) - static_cast<int>(image[i])));
+        }
+
+        std::cout << std::setw(6) << fft_simd_to_string(simd) << std::fixed << std::setprecision(1)
+                  << "  float: " << std::setw(7) << megapixels * 1000.0 / float_forward << " / "
+                  << std::setw(7) << megapixels * 1000.0 / float_inverse << " MP/s (max error " << float_error << ")"
+                  << "  fixed: " << std::setw(7) << megapixels * 1000.0 / fixed_forward << " / "
+                  << std::setw(7) << megapixels * 1000.0 / fixed_inverse << " MP/s (max error " << fixed_error << ")"
+                  << std::defaultfloat << std::endl;
+    }
+}
+
+/* Separable 2D DCT-II by the direct sums, rows then columns */
+std::vector<double> dct2dDirect(const std::vector<double>& data, const std::size_t rows, const std::size_t cols) noexcept
+{
+    std::vector<double> res(rows * cols);
+
+    for(std::size_t r = 0; r < rows; r++)
+    {
+        const std::vector<double> row(data.begin() + r * cols, data.begin() + (r + 1) * cols);
+        const std::vector<double> transformed = dct_direct(row);
+
+        std::copy(transformed.begin(), transformed.end(), res.begin() + r * cols);
+    }
+
+    for(std::size_t c = 0; c < cols; c++)
+    {
+        std::vector<double> column(rows);
+
+        for(std::size_t r = 0; r < rows; r++)
+        {
+            column[r] = res[r * cols + c];
+        }
+
+        const std::vector<double> transformed = dct_direct(column);
+
+        for(std::size_t r = 0; r < rows; r++)
+        {
+            res[r * cols + c] = transformed[r];
+        }
+    }
+
+    return res;
+}
+
+template<typename T>
+void runImageBenchmark(const char* precision) noexcept
+{
+    std::cout << "\n=== 2D / 3D DCT<" << precision << ">, " << fft_thread_pool().size() << " threads ===" << std::endl;
+
+    {
+        const std::size_t rows = 24;
+        const std::size_t cols = 40;
+        const std::size_t stride = 48;
+
+        const std::vector<double> signal = generateSignal(rows * cols);
+        const std::vector<double> ref = dct2dDirect(signal, rows, cols);
+
+        /* The same image in a window of a wider one */
+        std::vector<T> image(rows * stride, T(0));
+
+        for(std::size_t r = 0; r < rows; r++)
+        {
+            std::copy(signal.begin() + r * cols, signal.begin() + (r + 1) * cols, image.begin() + r * stride);
+        }
+
+        DCTPlan2D<T>(rows, cols, DCTType_II, stride).execute(image.data());
+
+        double error = 0.0;
+
+        for(std::size_t r = 0; r < rows; r++)
+        {
+            for(std::size_t c = 0; c < cols; c++)
+            {
+                error = std::max(error, std::abs(static_cast<double>(image[r * stride + c]) - ref[r * cols + c]));
+            }
+        }
+
+        std::cout << rows << " x " << cols << " (row stride " << stride << ") against the direct sums: "
+                  << std::scientific << std::setprecision(1) << error << std::defaultfloat << std::endl;
+    }
+
+    const std::size_t N = 4096;
+
+    const std::vector<double> signal = generateSignal(N * N);
+    const std::vector<T> input(signal.begin(), signal.end());
+    std::vector<T> image(input);
+
+    BenchmarkTimer timer;
+
+    timer.start();
+
+    DCTPlan2D<T> forward(N, N);
+    DCTPlan2D<T> inverse(N, N, DCTType_III);
+
+    const double plan_time = timer.elapsed_ms();
+
+    timer.start();
+    forward.execute(image.data());
+    const double forward_time = timer.elapsed_ms();
+
+    timer.start();
+    inverse.execute(image.data());
+    const double inverse_time = timer.elapsed_ms();
+
+    double error = 0.0;
+
+    for(std::size_t i = 0; i < N * N; i++)
+    {
+        error = std::max(error, std::abs(static_cast<double>(image[i] - input[i])));
+    }
+
+    /* The columns transformed in place, one element per cache line */
+    DCTBatchPlan<T> rows(N, N, 1, N);
+    DCTBatchPlan<T> columns(N, N, N, 1);
+
+    timer.start();
+    rows.execute(image.data());
+    columns.execute(image.data());
+    const double strided_time = timer.elapsed_ms();
+
+    std::cout << N << " x " << N << std::fixed << std::setprecision(1)
+              << "  plans: " << plan_time << " ms"
+              << "  forward: " << forward_time << " ms"
+              << "  inverse: " << inverse_time << " ms"
+              << "  strided columns: " << strided_time << " ms"
+              << "  roundtrip: " << std::scientific << error
+              << std::defaultfloat << std::endl;
+
+    const std::size_t M = 256;
+
+    const std::vector<double> volume_signal = generateSignal(M * M * M);
+    std::vector<T> volume(volume_signal.begin(), volume_signal.end());
+
+    DCTPlan3D<T> forward3(M, M, M);
+    DCTPlan3D<T> inverse3(M, M, M, DCTType_III);
+
+    timer.start();
+    forward3.execute(volume.data());
+    const double forward3_time = timer.elapsed_ms();
+
+    inverse3.execute(volume.data());
+
+    error = 0.0;
+
+    for(std::size_t i = 0; i < M * M * M; i++)
+    {
+        error = std::max(error, std::abs(static_cast<double>(volume[i]) - volume_signal[i]));
+    }
+
+    std::cout << M << " x " << M << " x " << M << std::fixed << std::setprecision(1)
+              << "  forward: " << forward3_time << " ms"
+              << "  roundtrip: " << std::scientific << error
+              << std::defaultfloat << std::endl;
+}
+
+/* Orthonormal MDCT of 2N windowed samples by its O(N²) definition */
+std::vector<double> mdctDirect(const std::vector<double>& frame, const std::vector<double>& window) noexcept
+{
+    const std::size_t N = frame.size() / 2;
+    const double scale = std::sqrt(2.0 / static_cast<double>(N));
+
+    std::vector<double> res(N, 0.0);
+
+    for(std::size_t k = 0; k < N; k++)
+    {
+        double sum = 0.0;
+
+        for(std::size_t n = 0; n < 2 * N; n++)
+        {
+            sum += window[n] * frame[n] * std::cos((M_PI / static_cast<double>(N)) * (static_cast<double>(n) + 0.5 + static_cast<double>(N) / 2.0) * (static_cast<double>(k) + 0.5));
+        }
+
+        res[k] = sum * scale;
+    }
+
+    return res;
+}
+
+void runMdctBenchmark() noexcept
+{
+    std::cout << "\n=== MDCT / IMDCT ===" << std::endl;
+
+    for(const MDCTWindow window : { MDCTWindow_Sine, MDCTWindow_KBD })
+    {
+        for(const std::size_t N : { 64, 256, 1024 })
+        {
+            const std::vector<double> frame = generateSignal(2 * N);
+
+            MDCTPlan<double> plan(N, window);
+
+            std::vector<double> coefficients(N);
+            plan.forward(frame.data(), coefficients.data());
+
+            /* Streaming round trip, the output is the input N samples later */
+            const std::vector<double> signal = generateSignal(50 * N);
+            std::vector<double> output;
+
+            MDCT<double> mdct(N, window);
+            IMDCT<double> imdct(N, window);
+
+            mdct.push(signal.data(), signal.size(), [&](const std::vector<double>& frame_coefficients) {
+                imdct.push(std::span<const double>(frame_coefficients), [&](const double* samples, const std::size_t count) {
+                    output.insert(output.end(), samples, samples + count);
+                });
+            });
+
+            double error = 0.0;
+
+            for(std::size_t i = N; i < output.size(); i++)
+            {
+                error = std::max(error, std::abs(output[i] - signal[i - N]));
+            }
+
+            std::cout << std::setw(4) << mdct_window_to_string(window) << " N = " << std::setw(4) << N
+                      << std::scientific << std::setprecision(1)
+                      << "  against the direct sum: " << maxError(coefficients, mdctDirect(frame, plan.window()))
+                      << "  TDAC roundtrip: " << error
+                      << std::defaultfloat << std::endl;
+        }
+    }
+
+    /* Audio at 48kHz in float, each channel with its own MDCT and IMDCT */
+    const double sample_rate = 48000.0;
+    const std::size_t num_channels = 64;
+    const std::size_t seconds = 2;
+
+    std::cout << num_channels << " channels, " << seconds << " s at " << static_cast<int>(sample_rate / 1000.0) << " kHz, float, analysis + synthesis" << std::endl;
+
+    for(const std::size_t N : { 128, 256, 512, 1024, 2048 })
+    {
+        const std::size_t length = static_cast<std::size_t>(sample_rate) * seconds;
+
+        const std::vector<double> samples = generateSignal(length);
+        const std::vector<float> input(samples.begin(), samples.end());
+
+        std::vector<MDCT<float>> analysis;
+        std::vector<IMDCT<float>> synthesis;
+
+        for(std::size_t c = 0; c < num_channels; c++)
+        {
+            analysis.emplace_back(N, MDCTWindow_KBD);
+            synthesis.emplace_back(N, MDCTWindow_KBD);
+        }
+
+        BenchmarkTimer timer;
+
+        const std::size_t allocations = allocation_count;
+
+        timer.start();
+
+        /* One block of N samples per channel at a time, like an audio callback */
+        for(std::size_t offset = 0; offset + N <= length; offset += N)
+        {
+            for(std::size_t c = 0; c < num_channels; c++)
+            {
+                analysis[c].push(input.data() + offset, N, [&](const std::vector<float>& coefficients) {
+                    synthesis[c].push(std::span<const float>(coefficients), [](const float*, const std::size_t) {});
+                });
+            }
+        }
+
+        const double elapsed = timer.elapsed_ms();
+
+        const std::size_t stream_allocations = allocation_count - allocations;
+
+        /* Audio processed per ms of computation: the channels one core keeps up with in real time */
+        const double realtime_ms = 1000.0 * static_cast<double>(seconds) * static_cast<double>(num_channels);
+
+        std::cout << "N = " << std::setw(4) << N << std::fixed << std::setprecision(1)
+                  << "  " << std::setw(7) << elapsed << " ms"
+                  << "  " << std::setw(6) << 1e6 * elapsed / (static_cast<double>(num_channels) * static_cast<double>(length / N)) << " ns/frame"
+                  << "  " << std::setw(7) << realtime_ms / elapsed << " channels per core"
+                  << " (" << stream_allocations << " allocations)"
+                  << std::defaultfloat << std::endl;
+    }
+}
+
+void runIntegerBenchmark() noexcept
+{
+    std::cout << "\n=== HEVC integer DCT ===" << std::endl;
+
+    std::mt19937 gen(42);
+    std::uniform_int_distribution<int> dist(-255, 255);
+
+    /* 8-bit video residuals: the outputs are N / 128 times the orthonormal DCT */
+    for(const std::size_t N : { 4, 8, 16, 32 })
+    {
+        const std::size_t num_blocks = 100;
+
+        std::vector<std::int16_t> input(num_blocks * N * N);
+
+        for(auto& x : input)
+        {
+            x = static_cast<std::int16_t>(dist(gen));
+        }
+
+        std::vector<std::int16_t> reference(input.size());
+        std::vector<std::int16_t> coefficients(input.size());
+        std::vector<std::int16_t> roundtrip(input.size());
+
+        dct_int_forward(input.data(), reference.data(), N, num_blocks, 8, FFTSimd_Scalar);
+
+        double error = 0.0;
+        double squared_error = 0.0;
+        double squared_norm = 0.0;
+
+        for(std::size_t b = 0; b < num_blocks; b++)
+        {
+            const std::vector<double> block(input.begin() + b * N * N, input.begin() + (b + 1) * N * N);
+            const std::vector<double> exact = dct_2d(block, N, N);
+
+            for(std::size_t i = 0; i < N * N; i++)
+            {
+                const double scaled = exact[i] * 128.0 / static_cast<double>(N);
+                const double difference = static_cast<double>(reference[b * N * N + i]) - scaled;
+
+                error = std::max(error, std::abs(difference));
+                squared_error += difference * difference;
+                squared_norm += scaled * scaled;
+            }
+        }
+
+        /* Every SIMD level has to give the same integers */
+        std::size_t mismatches = 0;
+        int roundtrip_error = 0;
+
+        for(const FFTSimd simd : { FFTSimd_Scalar, FFTSimd_AVX2, FFTSimd_AVX512 })
+        {
+            if(simd > fft_detect_simd())
+            {
+                continue;
+            }
+
+            dct_int_forward(input.data(), coefficients.data(), N, num_blocks, 8, simd);
+            dct_int_inverse(coefficients.data(), roundtrip.data(), N, num_blocks, 8, simd);
+
+            for(std::size_t i = 0; i < input.size(); i++)
+            {
+                mismatches += coefficients[i] != reference[i];
+                roundtrip_error = std::max(roundtrip_error, std::abs(static_cast<int>(roundtrip[i]) - static_cast<int>(input[i])));
+            }
+        }
+
+        std::cout << "N = " << std::setw(2) << N << std::fixed << std::setprecision(2)
+                  << "  against the double DCT: max " << error
+                  << ", relative RMS " << std::scientific << std::setprecision(1) << std::sqrt(squared_error / squared_norm)
+                  << std::defaultfloat << "  roundtrip: " << roundtrip_error
+                  << "  SIMD mismatches: " << mismatches << std::endl;
+    }
+
+    /* The blocks of a 1920 x 1088 frame, one block size at a time */
+    const double megapixels = 1920.0 * 1088.0 / 1e6;
+
+    std::cout << "1920 x 1088 frame, forward / inverse, one thread" << std::endl;
+
+    BenchmarkTimer timer;
+
+    for(const std::size_t N : { 4, 8, 16, 32 })
+    {
+        const std::size_t num_blocks = 1920 * 1088 / (N * N);
+
+        std::vector<std::int16_t> input(num_blocks * N * N);
+
+        for(auto& x : input)
+        {
+            x = static_cast<std::int16_t>(dist(gen));
+        }
+
+        std::vector<std::int16_t> coefficients(input.size());
+        std::vector<std::int16_t> output(input.size());
+
+        /* Float reference: the generic N-point plan on rows then columns */
+        std::vector<float> blocks_float(input.begin(), input.end());
+        DCTPlan<float> generic(N);
+
+        timer.start();
+
+        for(std::size_t b = 0; b < num_blocks; b++)
+        {
+            dctBlockGeneric(generic, N, blocks_float.data() + b * N * N, blocks_float.data() + b * N * N);
+        }
+
+        const double generic_time = timer.elapsed_ms();
+
+        std::cout << "N = " << std::setw(2) << N << std::fixed << std::setprecision(1)
+                  << "  DCTPlan<float>(" << N << ") rows + columns: " << megapixels * 1000.0 / generic_time << " MP/s";
+
+        if(N == 8)
+        {
+            timer.start();
+            dct8x8_forward(blocks_float.data(), blocks_float.data(), num_blocks);
+            std::cout << ", dct8x8_forward float: " << megapixels * 1000.0 / timer.elapsed_ms() << " MP/s";
+        }
+
+        std::cout << std::defaultfloat << std::endl;
+
+        for(const FFTSimd simd : { FFTSimd_Scalar, FFTSimd_AVX2, FFTSimd_AVX512 })
+        {
+            if(simd > fft_detect_simd())
+            {
+                continue;
+            }
+
+            timer.start();
+            dct_int_forward(input.data(), coefficients.data(), N, num_blocks, 8, simd);
+            const double forward = timer.elapsed_ms();
+
+            timer.start();
+            dct_int_inverse(coefficients.data(), output.data(), N, num_blocks, 8, simd);
+            const double inverse = timer.elapsed_ms();
+
+            std::cout << "       " << std::setw(6) << fft_simd_to_string(simd) << std::fixed << std::setprecision(1)
+                      << "  " << std::setw(7) << megapixels * 1000.0 / forward << " / "
+                      << std::setw(7) << megapixels * 1000.0 / inverse << " MP/s"
+                      << "  " << std::setw(7) << 1e6 * forward / static_cast<double>(num_blocks) << " ns/block"
+                      << std::defaultfloat << std::endl;
+        }
+    }
+}
+
+int main(int argc, char** argv) noexcept
+{
+    std::cout << "DCT Benchmark" << std::endl;
+
+    runAccuracyCheck();
+    runSpeedBenchmark();
+    runPlanBenchmark<double>("double");
+    runPlanBenchmark<float>("float");
+    runBlockBenchmark();
+    runImageBenchmark<float>("float");
+    runImageBenchmark<double>("double");
+    runMdctBenchmark();
+    runIntegerBenchmark();
+
+    return 0;
+}
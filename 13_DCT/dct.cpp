@@ -1,41 +1,10 @@
-#define _USE_MATH_DEFINES
-
 #include <vector>
 #include <array>
 #include <cmath>
 #include <iostream>
 #include <ranges>
 
-/*
-    Simple implementation of DCT-II (most commonly used form):
-    https://en.wikipedia.org/wiki/Discrete_cosine_transform#DCT-II
-
-    Xk = sum(x[n] * cos((pi / N) * (n + 0.5) * k)) for n ∈ [0 .. N - 1] and k ∈ [0 .. N - 1]
-
-*/
-
-template<typename Iterable>
-std::vector<double> dct(const Iterable& data) noexcept
-{
-    const std::size_t N = data.size();
-    const double scale = std::sqrt(2.0 / static_cast<double>(N));
-
-    std::vector<double> res(N, 0.0);
-
-    for(std::size_t k = 0; k < N; k++)
-    {
-        double sum = 0.0;
-
-        for(std::size_t n = 0; n < N; n++)
-        {
-            sum += data[n] * std::cos((M_PI / static_cast<double>(N)) * (static_cast<double>(n) + 0.5) * static_cast<double>(k));
-        }
-
-        res[k]= sum * scale * ((k == 0) ? (1.0 / std::sqrt(2.0)) : 1.0);
-    }
-
-    return res;
-}
+#include "dct.hpp"
 
 int main(int argc, char** argv) noexcept
 {
@@ -61,5 +30,54 @@ int main(int argc, char** argv) noexcept
 
     std::cout << "\n";
 
+    std::vector<double> idct_res = idct(dct_res);
+
+    std::cout << "IDCT: ";
+
+    for(const auto [i, x] : std::ranges::enumerate_view(idct_res))
+    {
+        std::cout << x << (i == (idct_res.size() - 1) ? "" : ",");
+    }
+
+    std::cout << "\n";
+
+    std::vector<double> dct4_res = dct(points, DCTType_IV);
+
+    std::cout << "DCT-IV: ";
+
+    for(const auto [i, x] : std::ranges::enumerate_view(dct4_res))
+    {
+        std::cout << x << (i == (dct4_res.size() - 1) ? "" : ",");
+    }
+
+    std::cout << "\n";
+
+    /* The same points as a 2 x 4 image */
+    std::vector<double> dct2d_res = dct_2d(points, 2, 4);
+
+    std::cout << "2D DCT (2 x 4): ";
+
+    for(const auto [i, x] : std::ranges::enumerate_view(dct2d_res))
+    {
+        std::cout << x << (i == (dct2d_res.size() - 1) ? "" : ",");
+    }
+
+    std::cout << "\n";
+
+    /* The points as one frame of 2N = 8 samples, N = 4 coefficients */
+    MDCTPlan<double> mdct(points.size() / 2);
+
+    std::vector<double> mdct_res(mdct.size());
+    mdct.forward(points.data(), mdct_res.data());
+
+    std::cout << "MDCT (sine window): ";
+
+    for(const auto [i, x] : std::ranges::enumerate_view(mdct_res))
+    {
+        std::cout << x << (i == (mdct_res.size() - 1) ? "" : ",");
+    }
+
+    std::cout << "\n";
+
     return 0;
 }
@@ -0,0 +1,2155 @@
+#pragma once
+
+#define _USE_MATH_DEFINES
+
+#include <vector>
+#include <array>
+#include <complex>
+#include <cmath>
+#include <cstdint>
+#include <cstddef>
+#include <memory>
+#include <unordered_map>
+#include <algorithm>
+#include <cstring>
+#include <type_traits>
+#include <span>
+#include <bit>
+#include <cassert>
+
+#include "../12_DFT/dft.hpp"
+
+/*
+    https://en.wikipedia.org/wiki/Discrete_cosine_transform
+    J. Makhoul, "A fast cosine transform in one and two dimensions", 1980
+
+    Orthonormal scaling, same as scipy's norm="ortho":
+    - DCT-II: X[k] = sqrt(2 / N) * c[k] * sum(x[n] * cos((pi / N) * (n + 0.5) * k)), c[0] = 1 / sqrt(2), c[k] = 1 otherwise
+    - DCT-III: the inverse of DCT-II
+    - DCT-IV: X[k] = sqrt(2 / N) * sum(x[n] * cos((pi / N) * (n + 0.5) * (k + 0.5))), its own inverse
+
+    Each transform is one FFT of N real values (so a complex FFT of N / 2 points for even N), with twiddles
+    before or after it, in O(N log N) instead of the O(N²) of the sums above.
+
+    A DCTPlan computes its twiddles, or its basis for small sizes, once: execute() only reads them and
+    works in buffers allocated by the constructor, it never allocates.
+*/
+
+enum DCTType : std::uint8_t
+{
+    DCTType_II,
+    DCTType_III,
+    DCTType_IV,
+};
+
+const char* dct_type_to_string(std::uint8_t type)
+{
+    switch(type)
+    {
+        case DCTType_II:
+            return "DCT-II";
+        case DCTType_III:
+            return "DCT-III";
+        case DCTType_IV:
+            return "DCT-IV";
+        default:
+            return "Unknown DCT";
+    }
+}
+
+/* Up to this size the plan multiplies by the precomputed basis, cheaper than the FFT and its twiddles (see the benchmark) */
+static constexpr std::size_t DCT_MATRIX_MAX_SIZE = 16;
+
+/*
+    DCT-II (Makhoul): v = x[0], x[2], x[4], ..., x[5], x[3], x[1], then X[k] = Re(exp(-iπk / 2N) * V[k]) with V the DFT of v.
+    DCT-III runs it backwards: V[k] = exp(iπk / 2N) * (X[k] - i * X[N - k]), an inverse real FFT, then v is put back in order.
+    DCT-IV, even N: z[n] = (x[2n] + i * x[N - 1 - 2n]) * exp(-iπ(n + 1/4) / N), Z the DFT of z over N / 2 points,
+    y[k] = Z[k] * exp(-iπk / N), X[2k] = Re(y[k]) and X[N - 1 - 2k] = -Im(y[k]).
+    DCT-IV, odd N: X[k] = Re(exp(-iπ(2k + 1) / 4N) * Z[k]), Z the DFT over 2N points of x[n] * exp(-iπn / 2N) padded with zeros.
+*/
+template<typename T>
+class DCTPlan
+{
+    std::size_t _N;
+    DCTType _type;
+
+    /* DCT-II and DCT-III */
+    std::unique_ptr<FFTRealPlan<T>> _real;
+    std::vector<T> _reordered;
+    std::vector<std::complex<T>> _spectrum;
+
+    /* DCT-IV, then the scratch of the engine in _work */
+    std::unique_ptr<FFTEngine<T>> _engine;
+    std::vector<std::complex<T>> _work;
+
+    /* Twiddles with the orthonormal scaling folded in */
+    std::vector<std::complex<T>> _pre;
+    std::vector<std::complex<T>> _post;
+
+    /* Small sizes, out[k] = sum(_basis[n * N + k] * in[n]), column by column so that the loop over k vectorizes */
+    std::vector<T> _basis;
+
+    void _matrix(const T* in, T* out) noexcept
+    {
+        const std::size_t N = this->_N;
+
+        /* Copied first, in and out can be the same array */
+        T* x = this->_reordered.data();
+        std::copy(in, in + N, x);
+
+        for(std::size_t k = 0; k < N; k++)
+        {
+            out[k] = this->_basis[k] * x[0];
+        }
+
+        for(std::size_t n = 1; n < N; n++)
+        {
+            const T* column = this->_basis.data() + n * N;
+            const T xn = x[n];
+
+            for(std::size_t k = 0; k < N; k++)
+            {
+                out[k] += column[k] * xn;
+            }
+        }
+    }
+
+    void _dct2(const T* in, T* out) noexcept
+    {
+        const std::size_t N = this->_N;
+        const std::size_t half = N / 2;
+
+        T* v = this->_reordered.data();
+
+        for(std::size_t n = 0; 2 * n < N; n++)
+        {
+            v[n] = in[2 * n];
+        }
+
+        for(std::size_t n = 0; 2 * n + 1 < N; n++)
+        {
+            v[N - 1 - n] = in[2 * n + 1];
+        }
+
+        this->_real->forward(v, this->_spectrum.data());
+
+        const std::complex<T>* V = this->_spectrum.data();
+        const std::complex<T>* w = this->_post.data();
+
+        /* The second half of V is the conjugate of the first one */
+        for(std::size_t k = 0; k <= half; k++)
+        {
+            out[k] = w[k].real() * V[k].real() - w[k].imag() * V[k].imag();
+        }
+
+        for(std::size_t k = half + 1; k < N; k++)
+        {
+            out[k] = w[k].real() * V[N - k].real() + w[k].imag() * V[N - k].imag();
+        }
+    }
+
+    void _dct3(const T* in, T* out) noexcept
+    {
+        const std::size_t N = this->_N;
+        const std::size_t half = N / 2;
+
+        std::complex<T>* V = this->_spectrum.data();
+        const std::complex<T>* w = this->_pre.data();
+
+        V[0] = w[0] * in[0];
+
+        for(std::size_t k = 1; k <= half; k++)
+        {
+            V[k] = cmul(w[k], std::complex<T>(in[k], -in[N - k]));
+        }
+
+        T* v = this->_reordered.data();
+
+        this->_real->backward(V, v);
+
+        for(std::size_t n = 0; 2 * n < N; n++)
+        {
+            out[2 * n] = v[n];
+        }
+
+        for(std::size_t n = 0; 2 * n + 1 < N; n++)
+        {
+            out[2 * n + 1] = v[N - 1 - n];
+        }
+    }
+
+    void _dct4(const T* in, T* out) noexcept
+    {
+        const std::size_t N = this->_N;
+
+        std::complex<T>* z = this->_work.data();
+        const std::complex<T>* pre = this->_pre.data();
+        const std::complex<T>* post = this->_post.data();
+
+        if(N % 2 == 0)
+        {
+            const std::size_t M = N / 2;
+
+            for(std::size_t n = 0; n < M; n++)
+            {
+                z[n] = cmul(std::complex<T>(in[2 * n], in[N - 1 - 2 * n]), pre[n]);
+            }
+
+            this->_engine->template execute<FFTDirection_Forward>(z, z + M);
+
+            for(std::size_t k = 0; k < M; k++)
+            {
+                const std::complex<T> y = cmul(z[k], post[k]);
+
+                out[2 * k] = y.real();
+                out[N - 1 - 2 * k] = -y.imag();
+            }
+
+            return;
+        }
+
+        for(std::size_t n = 0; n < N; n++)
+        {
+            z[n] = in[n] * pre[n];
+        }
+
+        std::fill(z + N, z + 2 * N, std::complex<T>(0, 0));
+
+        this->_engine->template execute<FFTDirection_Forward>(z, z + 2 * N);
+
+        for(std::size_t k = 0; k < N; k++)
+        {
+            out[k] = post[k].real() * z[k].real() - post[k].imag() * z[k].imag();
+        }
+    }
+
+    /* exp(i * pi * num / den) */
+    static std::complex<T> _phase(const long double num, const long double den) noexcept
+    {
+        const long double angle = static_cast<long double>(M_PI) * num / den;
+
+        return std::complex<T>(static_cast<T>(std::cos(angle)), static_cast<T>(std::sin(angle)));
+    }
+
+public:
+    DCTPlan(const std::size_t N, const DCTType type = DCTType_II) : _N(N), _type(type)
+    {
+        if(N == 0)
+        {
+            return;
+        }
+
+        const long double L = static_cast<long double>(N);
+        const T scale = static_cast<T>(std::sqrt(2.0L / L));
+        const T scale0 = static_cast<T>(std::sqrt(1.0L / L));
+
+        if(N <= DCT_MATRIX_MAX_SIZE)
+        {
+            this->_reordered.resize(N);
+            this->_basis.resize(N * N);
+
+            for(std::size_t k = 0; k < N; k++)
+            {
+                const long double c = std::sqrt((k == 0 ? 1.0L : 2.0L) / L);
+
+                for(std::size_t n = 0; n < N; n++)
+                {
+                    const long double n_half = static_cast<long double>(n) + 0.5L;
+                    const long double k_half = static_cast<long double>(k) + 0.5L;
+
+                    /* DCT-III is the transpose of DCT-II */
+                    switch(type)
+                    {
+                        case DCTType_II:
+                            this->_basis[n * N + k] = static_cast<T>(c * std::cos(M_PI * n_half * static_cast<long double>(k) / L));
+                            break;
+                        case DCTType_III:
+                            this->_basis[k * N + n] = static_cast<T>(c * std::cos(M_PI * n_half * static_cast<long double>(k) / L));
+                            break;
+                        default:
+                            this->_basis[n * N + k] = static_cast<T>(std::sqrt(2.0L / L) * std::cos(M_PI * n_half * k_half / L));
+                            break;
+                    }
+                }
+            }
+
+            return;
+        }
+
+        if(type == DCTType_II || type == DCTType_III)
+        {
+            this->_real = std::make_unique<FFTRealPlan<T>>(N);
+            this->_reordered.resize(N);
+            this->_spectrum.resize(this->_real->spectrum_size());
+        }
+
+        switch(type)
+        {
+            case DCTType_II:
+                this->_post.resize(N);
+
+                for(std::size_t k = 0; k < N; k++)
+                {
+                    this->_post[k] = (k == 0 ? scale0 : scale) * _phase(-static_cast<long double>(k), 2.0L * L);
+                }
+
+                break;
+
+            case DCTType_III:
+                /* The backward real FFT scales by N */
+                this->_pre.resize(N / 2 + 1);
+
+                for(std::size_t k = 0; k <= N / 2; k++)
+                {
+                    this->_pre[k] = _phase(static_cast<long double>(k), 2.0L * L) / ((k == 0 ? scale0 : scale) * static_cast<T>(N));
+                }
+
+                break;
+
+            case DCTType_IV:
+                if(N % 2 == 0)
+                {
+                    const std::size_t M = N / 2;
+
+                    this->_engine = std::make_unique<FFTEngine<T>>(M);
+                    this->_work.resize(M + this->_engine->scratch_size());
+                    this->_pre.resize(M);
+                    this->_post.resize(M);
+
+                    for(std::size_t n = 0; n < M; n++)
+                    {
+                        this->_pre[n] = _phase(-(static_cast<long double>(n) + 0.25L), L);
+                        this->_post[n] = scale * _phase(-static_cast<long double>(n), L);
+                    }
+                }
+                else
+                {
+                    this->_engine = std::make_unique<FFTEngine<T>>(2 * N);
+                    this->_work.resize(2 * N + this->_engine->scratch_size());
+                    this->_pre.resize(N);
+                    this->_post.resize(N);
+
+                    for(std::size_t n = 0; n < N; n++)
+                    {
+                        this->_pre[n] = _phase(-static_cast<long double>(n), 2.0L * L);
+                        this->_post[n] = scale * _phase(-(2.0L * static_cast<long double>(n) + 1.0L), 4.0L * L);
+                    }
+                }
+
+                break;
+
+            default:
+                break;
+        }
+    }
+
+    std::size_t size() const noexcept { return this->_N; }
+
+    DCTType type() const noexcept { return this->_type; }
+
+    /* in and out hold size() values, they can be the same array */
+    void execute(const T* in, T* out) noexcept
+    {
+        if(this->_N == 0)
+        {
+            return;
+        }
+
+        if(!this->_basis.empty())
+        {
+            this->_matrix(in, out);
+            return;
+        }
+
+        switch(this->_type)
+        {
+            case DCTType_II:
+                this->_dct2(in, out);
+                break;
+            case DCTType_III:
+                this->_dct3(in, out);
+                break;
+            case DCTType_IV:
+                this->_dct4(in, out);
+                break;
+            default:
+                break;
+        }
+    }
+};
+
+/*
+    Simple implementation of DCT-II (most commonly used form):
+    https://en.wikipedia.org/wiki/Discrete_cosine_transform#DCT-II
+
+    Xk = sum(x[n] * cos((pi / N) * (n + 0.5) * k)) for n ∈ [0 .. N - 1] and k ∈ [0 .. N - 1]
+
+    O(N²) with N² calls to std::cos, kept as the reference the fast transforms are checked against
+*/
+template<typename Iterable>
+std::vector<double> dct_direct(const Iterable& data) noexcept
+{
+    const std::size_t N = data.size();
+    const double scale = std::sqrt(2.0 / static_cast<double>(N));
+
+    std::vector<double> res(N, 0.0);
+
+    for(std::size_t k = 0; k < N; k++)
+    {
+        double sum = 0.0;
+
+        for(std::size_t n = 0; n < N; n++)
+        {
+            sum += data[n] * std::cos((M_PI / static_cast<double>(N)) * (static_cast<double>(n) + 0.5) * static_cast<double>(k));
+        }
+
+        res[k]= sum * scale * ((k == 0) ? (1.0 / std::sqrt(2.0)) : 1.0);
+    }
+
+    return res;
+}
+
+/* Plans are cached per thread, per size and per type, the twiddles and bases are computed once */
+template<typename T>
+DCTPlan<T>& dct_plan(const std::size_t N, const DCTType type = DCTType_II)
+{
+    static thread_local std::unordered_map<std::size_t, std::unique_ptr<DCTPlan<T>>> cache;
+
+    const std::size_t key = N * (DCTType_IV + 1) + type;
+
+    auto it = cache.find(key);
+
+    if(it == cache.end())
+    {
+        it = cache.emplace(key, std::make_unique<DCTPlan<T>>(N, type)).first;
+    }
+
+    return *it->second;
+}
+
+/* Orthonormal transform of type type of any container of values, in O(N log N) */
+template<typename Iterable>
+std::vector<double> dct(const Iterable& data, const DCTType type = DCTType_II)
+{
+    const std::size_t N = data.size();
+
+    std::vector<double> res(N);
+
+    for(std::size_t i = 0; i < N; i++)
+    {
+        res[i] = static_cast<double>(data[i]);
+    }
+
+    dct_plan<double>(N, type).execute(res.data(), res.data());
+
+    return res;
+}
+
+/* Inverse of dct(), the orthonormal DCT-III: idct(dct(x)) = x */
+template<typename Iterable>
+std::vector<double> idct(const Iterable& data)
+{
+    return dct(data, DCTType_III);
+}
+
+/*
+    howmany transforms of size N, element i of transform b is data[b * dist + i * stride], like FFTBatchPlan.
+    Plans keep their scratch so every thread of the pool gets its own, strided transforms are gathered into
+    a per-thread buffer first. Every buffer is allocated by the constructor.
+*/
+template<typename T>
+class DCTBatchPlan
+{
+    std::size_t _N;
+    std::size_t _howmany;
+    std::size_t _stride;
+    std::size_t _dist;
+    FFTThreadPool* _pool;
+
+    std::vector<std::unique_ptr<DCTPlan<T>>> _plans;
+    std::vector<T> _buffers;
+
+public:
+    DCTBatchPlan(const std::size_t N,
+                 const std::size_t howmany,
+                 const std::size_t stride = 1,
+                 const std::size_t dist = 0,
+                 const DCTType type = DCTType_II,
+                 FFTThreadPool& pool = fft_thread_pool()) : _N(N),
+                                                            _howmany(howmany),
+                                                            _stride(stride),
+                                                            _dist(dist != 0 ? dist : N * stride),
+                                                            _pool(&pool)
+    {
+        for(std::size_t i = 0; i < pool.size(); i++)
+        {
+            this->_plans.push_back(std::make_unique<DCTPlan<T>>(N, type));
+        }
+
+        if(stride != 1)
+        {
+            this->_buffers.resize(N * pool.size());
+        }
+    }
+
+    std::size_t size() const noexcept { return this->_N; }
+
+    std::size_t howmany() const noexcept { return this->_howmany; }
+
+    DCTType type() const noexcept { return this->_plans.front()->type(); }
+
+    void execute(T* data) noexcept
+    {
+        const std::size_t N = this->_N;
+
+        this->_pool->parallel_for(this->_howmany, [&](const std::size_t b, const std::size_t thread) {
+            DCTPlan<T>& plan = *this->_plans[thread];
+            T* x = data + b * this->_dist;
+
+            if(this->_stride == 1)
+            {
+                plan.execute(x, x);
+                return;
+            }
+
+            T* buffer = this->_buffers.data() + thread * N;
+
+            for(std::size_t i = 0; i < N; i++)
+            {
+                buffer[i] = x[i * this->_stride];
+            }
+
+            plan.execute(buffer, buffer);
+
+            for(std::size_t i = 0; i < N; i++)
+            {
+                x[i * this->_stride] = buffer[i];
+            }
+        });
+    }
+};
+
+/*
+    Transforms along the first axis of a rows x cols row-major matrix whose rows are row_stride apart
+    (0 when packed): blocked transpose, contiguous row transforms, transpose back, as FFTColumnPlan
+*/
+template<typename T>
+class DCTColumnPlan
+{
+    std::size_t _rows;
+    std::size_t _cols;
+    std::size_t _row_stride;
+    DCTBatchPlan<T> _batch;
+    std::vector<T> _work;
+    FFTThreadPool* _pool;
+
+public:
+    DCTColumnPlan(const std::size_t rows,
+                  const std::size_t cols,
+                  const DCTType type,
+                  const std::size_t row_stride,
+                  FFTThreadPool& pool) : _rows(rows),
+                                         _cols(cols),
+                                         _row_stride(row_stride),
+                                         _batch(rows, cols, 1, rows, type, pool),
+                                         _work(rows * cols),
+                                         _pool(&pool) {}
+
+    void execute(T* data) noexcept
+    {
+        fft_transpose(data, this->_work.data(), this->_rows, this->_cols, *this->_pool, this->_row_stride);
+        this->_batch.execute(this->_work.data());
+        fft_transpose(this->_work.data(), data, this->_cols, this->_rows, *this->_pool, 0, this->_row_stride);
+    }
+};
+
+/*
+    Separable 2D transform of a rows x cols row-major image, rows first, then columns. Rows are row_stride
+    elements apart, 0 when packed, so a plan can run on a window of a larger image.
+*/
+template<typename T>
+class DCTPlan2D
+{
+    DCTBatchPlan<T> _rows;
+    DCTColumnPlan<T> _cols;
+
+public:
+    DCTPlan2D(const std::size_t rows,
+              const std::size_t cols,
+              const DCTType type = DCTType_II,
+              const std::size_t row_stride = 0,
+              FFTThreadPool& pool = fft_thread_pool()) : _rows(cols, rows, 1, row_stride != 0 ? row_stride : cols, type, pool),
+                                                         _cols(rows, cols, type, row_stride, pool) {}
+
+    void execute(T* data) noexcept
+    {
+        this->_rows.execute(data);
+        this->_cols.execute(data);
+    }
+};
+
+/* Separable 3D transform of a packed n0 x n1 x n2 row-major volume, axes in the same order as FFTPlan3D */
+template<typename T>
+class DCTPlan3D
+{
+    std::size_t _n0;
+    std::size_t _n1;
+    std::size_t _n2;
+    DCTBatchPlan<T> _axis2;
+    DCTColumnPlan<T> _axis1;
+    DCTColumnPlan<T> _axis0;
+
+public:
+    DCTPlan3D(const std::size_t n0,
+              const std::size_t n1,
+              const std::size_t n2,
+              const DCTType type = DCTType_II,
+              FFTThreadPool& pool = fft_thread_pool()) : _n0(n0),
+                                                         _n1(n1),
+                                                         _n2(n2),
+                                                         _axis2(n2, n0 * n1, 1, n2, type, pool),
+                                                         _axis1(n1, n2, type, 0, pool),
+                                                         _axis0(n0, n1 * n2, type, 0, pool) {}
+
+    void execute(T* data) noexcept
+    {
+        this->_axis2.execute(data);
+
+        for(std::size_t i = 0; i < this->_n0; i++)
+        {
+            this->_axis1.execute(data + i * this->_n1 * this->_n2);
+        }
+
+        this->_axis0.execute(data);
+    }
+};
+
+/* 2D orthonormal transform of a rows x cols row-major container */
+template<typename Iterable>
+std::vector<double> dct_2d(const Iterable& data,
+                           const std::size_t rows,
+                           const std::size_t cols,
+                           const DCTType type = DCTType_II)
+{
+    std::vector<double> res(rows * cols);
+
+    for(std::size_t i = 0; i < rows * cols; i++)
+    {
+        res[i] = static_cast<double>(data[i]);
+    }
+
+    DCTPlan2D<double>(rows, cols, type).execute(res.data());
+
+    return res;
+}
+
+/* Inverse of dct_2d() */
+template<typename Iterable>
+std::vector<double> idct_2d(const Iterable& data, const std::size_t rows, const std::size_t cols)
+{
+    return dct_2d(data, rows, cols, DCTType_III);
+}
+
+/*
+    Modified DCT, the lapped transform of audio codecs (MP3, AAC, Vorbis, Opus)
+
+    https://en.wikipedia.org/wiki/Modified_discrete_cosine_transform
+    J. Princen, A. Johnson, A. Bradley, "Subband/transform coding using filter bank designs based on time domain aliasing cancellation", 1987
+
+    Frames of 2N samples, N apart, give N coefficients each. With a frame cut in quarters a, b, c, d the MDCT is
+    the DCT-IV of (-c_r - d, a - b_r) (_r for reversed), the inverse is the DCT-IV again, unfolded into
+    (u2, -u2_r, -u1_r, -u1) for u = (u1, u2). With the orthonormal DCT-IV and a window applied on both sides
+    with w[n]² + w[n + N]² = 1 (Princen-Bradley), the aliasing of consecutive frames cancels out in the
+    overlap-add and the input comes back exactly.
+*/
+
+enum MDCTWindow : std::uint8_t
+{
+    MDCTWindow_Sine,
+    MDCTWindow_KBD, /* Kaiser-Bessel derived */
+};
+
+const char* mdct_window_to_string(std::uint8_t window)
+{
+    switch(window)
+    {
+        case MDCTWindow_Sine:
+            return "Sine";
+        case MDCTWindow_KBD:
+            return "KBD";
+        default:
+            return "Unknown Window";
+    }
+}
+
+/* Alpha of the KBD window of AAC long blocks */
+static constexpr double MDCT_KBD_ALPHA = 4.0;
+
+/* Modified Bessel function of the first kind I0, by its power series */
+inline double mdct_bessel_i0(const double x) noexcept
+{
+    const double half_square = x * x / 4.0;
+
+    double sum = 1.0;
+    double term = 1.0;
+
+    for(std::size_t k = 1; term > sum * 1e-17; k++)
+    {
+        term *= half_square / static_cast<double>(k * k);
+        sum += term;
+    }
+
+    return sum;
+}
+
+/* 2N values, symmetric, w[n]² + w[n + N]² = 1 */
+template<typename T>
+std::vector<T> mdct_window(const MDCTWindow window, const std::size_t N, const double alpha = MDCT_KBD_ALPHA) noexcept
+{
+    std::vector<T> w(2 * N);
+
+    if(window == MDCTWindow_KBD)
+    {
+        /* Square root of the running sum of a Kaiser window of N + 1 points */
+        std::vector<double> sums(N + 1);
+
+        double total = 0.0;
+
+        for(std::size_t j = 0; j <= N; j++)
+        {
+            const double r = 2.0 * static_cast<double>(j) / static_cast<double>(N) - 1.0;
+
+            total += mdct_bessel_i0(M_PI * alpha * std::sqrt(std::max(0.0, 1.0 - r * r)));
+            sums[j] = total;
+        }
+
+        for(std::size_t n = 0; n < N; n++)
+        {
+            w[n] = static_cast<T>(std::sqrt(sums[n] / total));
+            w[2 * N - 1 - n] = w[n];
+        }
+
+        return w;
+    }
+
+    for(std::size_t n = 0; n < 2 * N; n++)
+    {
+        w[n] = static_cast<T>(std::sin(M_PI * (static_cast<double>(n) + 0.5) / (2.0 * static_cast<double>(N))));
+    }
+
+    return w;
+}
+
+/*
+    N coefficients from 2N windowed samples through an N-point DCT-IV. N has to be even and non zero: the folding
+    cuts the frame in quarters of N / 2 samples, an odd N would silently drop samples.
+*/
+template<typename T>
+class MDCTPlan
+{
+    std::size_t _N;
+    std::vector<T> _window;
+    DCTPlan<T> _dct;
+    std::vector<T> _folded;
+
+public:
+    MDCTPlan(const std::size_t N,
+             const MDCTWindow window = MDCTWindow_Sine,
+             const double alpha = MDCT_KBD_ALPHA) : _N(N),
+                                                    _window(mdct_window<T>(window, N, alpha)),
+                                                    _dct(N, DCTType_IV),
+                                                    _folded(N)
+    {
+        assert(N > 0 && N % 2 == 0 && "MDCT sizes must be even");
+    }
+
+    /* Number of coefficients, and of samples between frames */
+    std::size_t size() const noexcept { return this->_N; }
+
+    const std::vector<T>& window() const noexcept { return this->_window; }
+
+    /* in holds 2 * size() samples, out receives size() coefficients */
+    void forward(const T* in, T* out) noexcept
+    {
+        const std::size_t N = this->_N;
+        const std::size_t half = N / 2;
+        const T* w = this->_window.data();
+        T* u = this->_folded.data();
+
+        for(std::size_t n = 0; n < half; n++)
+        {
+            const std::size_t c = 3 * half - 1 - n;
+            const std::size_t d = 3 * half + n;
+
+            u[n] = -w[c] * in[c] - w[d] * in[d];
+        }
+
+        for(std::size_t n = 0; n < half; n++)
+        {
+            const std::size_t b = N - 1 - n;
+
+            u[half + n] = w[n] * in[n] - w[b] * in[b];
+        }
+
+        this->_dct.execute(u, out);
+    }
+
+    /* in holds size() coefficients, out receives 2 * size() windowed samples to overlap-add with the neighbour frames */
+    void inverse(const T* in, T* out) noexcept
+    {
+        const std::size_t N = this->_N;
+        const std::size_t half = N / 2;
+        const T* w = this->_window.data();
+        T* u = this->_folded.data();
+
+        this->_dct.execute(in, u);
+
+        for(std::size_t n = 0; n < half; n++)
+        {
+            out[n] = w[n] * u[half + n];
+            out[half + n] = -w[half + n] * u[N - 1 - n];
+            out[N + n] = -w[N + n] * u[half - 1 - n];
+            out[3 * half + n] = -w[3 * half + n] * u[n];
+        }
+    }
+};
+
+/*
+    Streaming MDCT: every N samples the last 2N go through the MDCT. Like STFT, the stream starts with N zeros
+    so the first frame is complete after N samples, and nothing is allocated once constructed.
+*/
+template<typename T>
+class MDCT
+{
+    MDCTPlan<T> _plan;
+
+    std::vector<T> _history;
+    std::size_t _filled;
+
+    std::vector<T> _coefficients;
+
+public:
+    MDCT(const std::size_t N,
+         const MDCTWindow window = MDCTWindow_Sine,
+         const double alpha = MDCT_KBD_ALPHA) : _plan(N, window, alpha),
+                                                _history(2 * N),
+                                                _coefficients(N)
+    {
+        this->reset();
+    }
+
+    std::size_t size() const noexcept { return this->_plan.size(); }
+
+    void reset() noexcept
+    {
+        std::fill(this->_history.begin(), this->_history.end(), static_cast<T>(0));
+        this->_filled = this->size();
+    }
+
+    /* on_frame(const std::vector<T>& coefficients) is called every N samples */
+    template<typename F>
+    void push(const T* samples, std::size_t count, F&& on_frame) noexcept
+    {
+        const std::size_t N = this->size();
+
+        while(count > 0)
+        {
+            const std::size_t n = std::min(count, 2 * N - this->_filled);
+
+            std::memcpy(this->_history.data() + this->_filled, samples, n * sizeof(T));
+            this->_filled += n;
+            samples += n;
+            count -= n;
+
+            if(this->_filled == 2 * N)
+            {
+                this->_plan.forward(this->_history.data(), this->_coefficients.data());
+
+                on_frame(static_cast<const std::vector<T>&>(this->_coefficients));
+
+                std::memcpy(this->_history.data(), this->_history.data() + N, N * sizeof(T));
+                this->_filled = N;
+            }
+        }
+    }
+
+    template<typename F>
+    void push(std::span<const T> samples, F&& on_frame) noexcept
+    {
+        this->push(samples.data(), samples.size(), on_frame);
+    }
+};
+
+/*
+    Streaming IMDCT: each frame of N coefficients completes N samples by overlap-add with the previous one.
+    Fed with the frames of MDCT, the output is the input delayed by N samples (the zeros the MDCT starts with).
+*/
+template<typename T>
+class IMDCT
+{
+    MDCTPlan<T> _plan;
+
+    std::vector<T> _frame;
+
+    /* Second half of the previous frame */
+    std::vector<T> _overlap;
+
+public:
+    IMDCT(const std::size_t N,
+          const MDCTWindow window = MDCTWindow_Sine,
+          const double alpha = MDCT_KBD_ALPHA) : _plan(N, window, alpha),
+                                                 _frame(2 * N),
+                                                 _overlap(N, static_cast<T>(0)) {}
+
+    std::size_t size() const noexcept { return this->_plan.size(); }
+
+    void reset() noexcept
+    {
+        std::fill(this->_overlap.begin(), this->_overlap.end(), static_cast<T>(0));
+    }
+
+    /* coefficients holds N values, on_samples(const T* samples, std::size_t N) gets the completed samples */
+    template<typename F>
+    void push(std::span<const T> coefficients, F&& on_samples) noexcept
+    {
+        const std::size_t N = this->size();
+
+        T* frame = this->_frame.data();
+        T* overlap = this->_overlap.data();
+
+        this->_plan.inverse(coefficients.data(), frame);
+
+        for(std::size_t n = 0; n < N; n++)
+        {
+            frame[n] += overlap[n];
+        }
+
+        on_samples(static_cast<const T*>(frame), N);
+
+        std::memcpy(overlap, frame + N, N * sizeof(T));
+    }
+};
+
+/*
+    8x8 blocks, as in JPEG: 2D orthonormal DCT-II of a block, rows then columns
+
+    https://en.wikipedia.org/wiki/JPEG#Discrete_cosine_transform
+    Y. Arai, T. Agui, M. Nakajima, "A fast DCT-SQ scheme for images", 1988 (float, 5 multiplies per 8 points)
+    C. Loeffler, A. Ligtenberg, G. Moschytz, "Practical fast 1-D DCT algorithms with 11 multiplications", 1989 (fixed point)
+
+    Both follow the IJG libjpeg kernels (jfdctflt / jidctflt / jfdctint / jidctint). The AAN outputs are scaled
+    by aan[u] * aan[v] * 8, aan[0] = 1, aan[k] = sqrt(2) * cos(kπ / 16), these factors are undone by a table
+    of 64 multiplies. Fixed point keeps 13 fractional bits in the constants and 2 extra bits between the passes.
+
+    The 1D kernels are written once for a lane type V: a scalar, or a vector holding one row of W / 8 blocks
+    side by side, so AVX2 transforms one block per 256-bit vector and AVX-512 two per 512-bit vector. The pass
+    runs on the 8 columns at once, and two shuffle transposes (dct8_transpose) turn the rows into columns and back.
+    float blocks use float lanes, int16_t blocks int32 lanes.
+
+    The fixed point paths are bit-identical on every instruction set. The float vector paths are compiled
+    for FMA, which the compiler is free to contract multiplies and adds into, so they agree with the scalar
+    path to within float rounding, not bit for bit.
+
+    int16_t blocks are meant for level shifted 8-bit samples, in [-128, 127], as dct8x8_image_forward makes.
+    Like libjpeg's 8-bit islow, the 13 + 2 fractional bits leave no headroom for wider samples: the int32
+    intermediates and the int16 coefficients overflow (libjpeg's 12-bit build drops to 1 pass bit for this).
+*/
+
+/* Fixed-point constants, round(x * 2^13) */
+static constexpr int DCT_CONST_BITS = 13;
+static constexpr int DCT_PASS1_BITS = 2;
+
+static constexpr std::int32_t DCT_FIX_0_298631336 = 2446;
+static constexpr std::int32_t DCT_FIX_0_390180644 = 3196;
+static constexpr std::int32_t DCT_FIX_0_541196100 = 4433;
+static constexpr std::int32_t DCT_FIX_0_765366865 = 6270;
+static constexpr std::int32_t DCT_FIX_0_899976223 = 7373;
+static constexpr std::int32_t DCT_FIX_1_175875602 = 9633;
+static constexpr std::int32_t DCT_FIX_1_501321110 = 12299;
+static constexpr std::int32_t DCT_FIX_1_847759065 = 15137;
+static constexpr std::int32_t DCT_FIX_1_961570560 = 16069;
+static constexpr std::int32_t DCT_FIX_2_053119869 = 16819;
+static constexpr std::int32_t DCT_FIX_2_562915447 = 20995;
+static constexpr std::int32_t DCT_FIX_3_072711026 = 25172;
+
+/* out = x / 2^n, rounded, through a reference like fft_load: returning a vector by value changes the ABI */
+template<int n, typename V>
+[[gnu::always_inline]] inline void dct_descale(V& out, const V& x) noexcept
+{
+    out = (x + (1 << (n - 1))) >> n;
+}
+
+/* Unscaled AAN forward DCT of x[0], x[s], ..., x[7s] in place */
+template<typename V>
+[[gnu::always_inline]] inline void dct8_aan_forward(V* x, const std::size_t s) noexcept
+{
+    const V tmp0 = x[0] + x[7 * s];
+    const V tmp7 = x[0] - x[7 * s];
+    const V tmp1 = x[s] + x[6 * s];
+    const V tmp6 = x[s] - x[6 * s];
+    const V tmp2 = x[2 * s] + x[5 * s];
+    const V tmp5 = x[2 * s] - x[5 * s];
+    const V tmp3 = x[3 * s] + x[4 * s];
+    const V tmp4 = x[3 * s] - x[4 * s];
+
+    /* Even part */
+    const V tmp10 = tmp0 + tmp3;
+    const V tmp13 = tmp0 - tmp3;
+    const V tmp11 = tmp1 + tmp2;
+    const V tmp12 = tmp1 - tmp2;
+
+    x[0] = tmp10 + tmp11;
+    x[4 * s] = tmp10 - tmp11;
+
+    const V z1 = (tmp12 + tmp13) * 0.707106781f;
+
+    x[2 * s] = tmp13 + z1;
+    x[6 * s] = tmp13 - z1;
+
+    /* Odd part */
+    const V odd10 = tmp4 + tmp5;
+    const V odd11 = tmp5 + tmp6;
+    const V odd12 = tmp6 + tmp7;
+
+    const V z5 = (odd10 - odd12) * 0.382683433f;
+    const V z2 = odd10 * 0.541196100f + z5;
+    const V z4 = odd12 * 1.306562965f + z5;
+    const V z3 = odd11 * 0.707106781f;
+
+    const V z11 = tmp7 + z3;
+    const V z13 = tmp7 - z3;
+
+    x[5 * s] = z13 + z2;
+    x[3 * s] = z13 - z2;
+    x[s] = z11 + z4;
+    x[7 * s] = z11 - z4;
+}
+
+/* AAN inverse DCT in place, the input is expected scaled by aan[k] */
+template<typename V>
+[[gnu::always_inline]] inline void dct8_aan_inverse(V* x, const std::size_t s) noexcept
+{
+    /* Even part */
+    const V tmp10 = x[0] + x[4 * s];
+    const V tmp11 = x[0] - x[4 * s];
+    const V tmp13 = x[2 * s] + x[6 * s];
+    const V tmp12 = (x[2 * s] - x[6 * s]) * 1.414213562f - tmp13;
+
+    const V even0 = tmp10 + tmp13;
+    const V even3 = tmp10 - tmp13;
+    const V even1 = tmp11 + tmp12;
+    const V even2 = tmp11 - tmp12;
+
+    /* Odd part */
+    const V z13 = x[5 * s] + x[3 * s];
+    const V z10 = x[5 * s] - x[3 * s];
+    const V z11 = x[s] + x[7 * s];
+    const V z12 = x[s] - x[7 * s];
+
+    const V odd7 = z11 + z13;
+    const V odd11 = (z11 - z13) * 1.414213562f;
+
+    const V z5 = (z10 + z12) * 1.847759065f;
+    const V odd10 = z12 * 1.082392200f - z5;
+    const V odd12 = z5 - z10 * 2.613125930f;
+
+    const V odd6 = odd12 - odd7;
+    const V odd5 = odd11 - odd6;
+    const V odd4 = odd10 + odd5;
+
+    x[0] = even0 + odd7;
+    x[7 * s] = even0 - odd7;
+    x[s] = even1 + odd6;
+    x[6 * s] = even1 - odd6;
+    x[2 * s] = even2 + odd5;
+    x[5 * s] = even2 - odd5;
+    x[4 * s] = even3 + odd4;
+    x[3 * s] = even3 - odd4;
+}
+
+/* Loeffler forward DCT in place, the first pass keeps DCT_PASS1_BITS more bits, the second one gives orthonormal values */
+template<bool first_pass, typename V>
+[[gnu::always_inline]] inline void dct8_islow_forward(V* x, const std::size_t s) noexcept
+{
+    constexpr int even_shift = first_pass ? -DCT_PASS1_BITS : DCT_PASS1_BITS + 3;
+    constexpr int odd_shift = first_pass ? DCT_CONST_BITS - DCT_PASS1_BITS : DCT_CONST_BITS + DCT_PASS1_BITS + 3;
+
+    V tmp0 = x[0] + x[7 * s];
+    V tmp7 = x[0] - x[7 * s];
+    V tmp1 = x[s] + x[6 * s];
+    V tmp6 = x[s] - x[6 * s];
+    V tmp2 = x[2 * s] + x[5 * s];
+    V tmp5 = x[2 * s] - x[5 * s];
+    V tmp3 = x[3 * s] + x[4 * s];
+    V tmp4 = x[3 * s] - x[4 * s];
+
+    /* Even part */
+    const V tmp10 = tmp0 + tmp3;
+    const V tmp13 = tmp0 - tmp3;
+    const V tmp11 = tmp1 + tmp2;
+    const V tmp12 = tmp1 - tmp2;
+
+    if constexpr(first_pass)
+    {
+        x[0] = (tmp10 + tmp11) << -even_shift;
+        x[4 * s] = (tmp10 - tmp11) << -even_shift;
+    }
+    else
+    {
+        dct_descale<even_shift>(x[0], tmp10 + tmp11);
+        dct_descale<even_shift>(x[4 * s], tmp10 - tmp11);
+    }
+
+    const V z1 = (tmp12 + tmp13) * DCT_FIX_0_541196100;
+
+    dct_descale<odd_shift>(x[2 * s], z1 + tmp13 * DCT_FIX_0_765366865);
+    dct_descale<odd_shift>(x[6 * s], z1 - tmp12 * DCT_FIX_1_847759065);
+
+    /* Odd part */
+    V z1o = tmp4 + tmp7;
+    V z2 = tmp5 + tmp6;
+    V z3 = tmp4 + tmp6;
+    V z4 = tmp5 + tmp7;
+    const V z5 = (z3 + z4) * DCT_FIX_1_175875602;
+
+    tmp4 = tmp4 * DCT_FIX_0_298631336;
+    tmp5 = tmp5 * DCT_FIX_2_053119869;
+    tmp6 = tmp6 * DCT_FIX_3_072711026;
+    tmp7 = tmp7 * DCT_FIX_1_501321110;
+    z1o = z1o * -DCT_FIX_0_899976223;
+    z2 = z2 * -DCT_FIX_2_562915447;
+    z3 = z3 * -DCT_FIX_1_961570560 + z5;
+    z4 = z4 * -DCT_FIX_0_390180644 + z5;
+
+    dct_descale<odd_shift>(x[7 * s], tmp4 + z1o + z3);
+    dct_descale<odd_shift>(x[5 * s], tmp5 + z2 + z4);
+    dct_descale<odd_shift>(x[3 * s], tmp6 + z2 + z3);
+    dct_descale<odd_shift>(x[s], tmp7 + z1o + z4);
+}
+
+/* Loeffler inverse DCT in place, the first pass keeps DCT_PASS1_BITS more bits, the second one gives samples */
+template<bool first_pass, typename V>
+[[gnu::always_inline]] inline void dct8_islow_inverse(V* x, const std::size_t s) noexcept
+{
+    constexpr int shift = first_pass ? DCT_CONST_BITS - DCT_PASS1_BITS : DCT_CONST_BITS + DCT_PASS1_BITS + 3;
+
+    /* Even part */
+    const V z1 = (x[2 * s] + x[6 * s]) * DCT_FIX_0_541196100;
+    const V tmp2e = z1 - x[6 * s] * DCT_FIX_1_847759065;
+    const V tmp3e = z1 + x[2 * s] * DCT_FIX_0_765366865;
+
+    const V tmp0e = (x[0] + x[4 * s]) << DCT_CONST_BITS;
+    const V tmp1e = (x[0] - x[4 * s]) << DCT_CONST_BITS;
+
+    const V tmp10 = tmp0e + tmp3e;
+    const V tmp13 = tmp0e - tmp3e;
+    const V tmp11 = tmp1e + tmp2e;
+    const V tmp12 = tmp1e - tmp2e;
+
+    /* Odd part */
+    V tmp0 = x[7 * s];
+    V tmp1 = x[5 * s];
+    V tmp2 = x[3 * s];
+    V tmp3 = x[s];
+
+    V z1o = tmp0 + tmp3;
+    V z2 = tmp1 + tmp2;
+    V z3 = tmp0 + tmp2;
+    V z4 = tmp1 + tmp3;
+    const V z5 = (z3 + z4) * DCT_FIX_1_175875602;
+
+    tmp0 = tmp0 * DCT_FIX_0_298631336;
+    tmp1 = tmp1 * DCT_FIX_2_053119869;
+    tmp2 = tmp2 * DCT_FIX_3_072711026;
+    tmp3 = tmp3 * DCT_FIX_1_501321110;
+    z1o = z1o * -DCT_FIX_0_899976223;
+    z2 = z2 * -DCT_FIX_2_562915447;
+    z3 = z3 * -DCT_FIX_1_961570560 + z5;
+    z4 = z4 * -DCT_FIX_0_390180644 + z5;
+
+    tmp0 = tmp0 + z1o + z3;
+    tmp1 = tmp1 + z2 + z4;
+    tmp2 = tmp2 + z2 + z3;
+    tmp3 = tmp3 + z1o + z4;
+
+    dct_descale<shift>(x[0], tmp10 + tmp3);
+    dct_descale<shift>(x[7 * s], tmp10 - tmp3);
+    dct_descale<shift>(x[s], tmp11 + tmp2);
+    dct_descale<shift>(x[6 * s], tmp11 - tmp2);
+    dct_descale<shift>(x[2 * s], tmp12 + tmp1);
+    dct_descale<shift>(x[5 * s], tmp12 - tmp1);
+    dct_descale<shift>(x[3 * s], tmp13 + tmp0);
+    dct_descale<shift>(x[4 * s], tmp13 - tmp0);
+}
+
+/* Factors that turn the AAN outputs into orthonormal coefficients, and orthonormal coefficients into AAN inputs */
+struct DCT8x8Scales
+{
+    float forward[64];
+    float inverse[64];
+
+    DCT8x8Scales() noexcept
+    {
+        double aan[8];
+
+        aan[0] = 1.0;
+
+        for(std::size_t k = 1; k < 8; k++)
+        {
+            aan[k] = std::sqrt(2.0) * std::cos(static_cast<double>(k) * M_PI / 16.0);
+        }
+
+        for(std::size_t u = 0; u < 8; u++)
+        {
+            for(std::size_t v = 0; v < 8; v++)
+            {
+                this->forward[u * 8 + v] = static_cast<float>(1.0 / (8.0 * aan[u] * aan[v]));
+                this->inverse[u * 8 + v] = static_cast<float>(aan[u] * aan[v] / 8.0);
+            }
+        }
+    }
+};
+
+inline const DCT8x8Scales& dct8x8_scales() noexcept
+{
+    static const DCT8x8Scales scales;
+    return scales;
+}
+
+/* Lane type of the kernels: float blocks are computed in float, int16_t blocks in int32 */
+template<typename T>
+using DCTLane = std::conditional_t<std::is_same_v<T, float>, float, std::int32_t>;
+
+template<typename T, std::size_t Bytes>
+struct DCTVector;
+
+template<> struct DCTVector<std::int32_t, 16> { typedef std::int32_t type __attribute__((vector_size(16))); };
+template<> struct DCTVector<float, 32> { typedef float type __attribute__((vector_size(32))); };
+template<> struct DCTVector<float, 64> { typedef float type __attribute__((vector_size(64))); };
+template<> struct DCTVector<std::int32_t, 32> { typedef std::int32_t type __attribute__((vector_size(32))); };
+template<> struct DCTVector<std::int32_t, 64> { typedef std::int32_t type __attribute__((vector_size(64))); };
+
+template<typename V, typename M>
+[[gnu::always_inline]] inline void dct8_transpose_rounds(V* x,
+                                                         const M& lo1,
+                                                         const M& hi1,
+                                                         const M& lo2,
+                                                         const M& hi2,
+                                                         const M& lo4,
+                                                         const M& hi4) noexcept
+{
+    /* Pairs of rows interleaved */
+    const V t0 = __builtin_shuffle(x[0], x[1], lo1);
+    const V t1 = __builtin_shuffle(x[0], x[1], hi1);
+    const V t2 = __builtin_shuffle(x[2], x[3], lo1);
+    const V t3 = __builtin_shuffle(x[2], x[3], hi1);
+    const V t4 = __builtin_shuffle(x[4], x[5], lo1);
+    const V t5 = __builtin_shuffle(x[4], x[5], hi1);
+    const V t6 = __builtin_shuffle(x[6], x[7], lo1);
+    const V t7 = __builtin_shuffle(x[6], x[7], hi1);
+
+    /* Columns 0 1 / 2 3 / ... of rows 0 to 3 and 4 to 7, one 128-bit lane each */
+    const V u0 = __builtin_shuffle(t0, t2, lo2);
+    const V u1 = __builtin_shuffle(t0, t2, hi2);
+    const V u2 = __builtin_shuffle(t1, t3, lo2);
+    const V u3 = __builtin_shuffle(t1, t3, hi2);
+    const V u4 = __builtin_shuffle(t4, t6, lo2);
+    const V u5 = __builtin_shuffle(t4, t6, hi2);
+    const V u6 = __builtin_shuffle(t5, t7, lo2);
+    const V u7 = __builtin_shuffle(t5, t7, hi2);
+
+    x[0] = __builtin_shuffle(u0, u4, lo4);
+    x[1] = __builtin_shuffle(u1, u5, lo4);
+    x[2] = __builtin_shuffle(u2, u6, lo4);
+    x[3] = __builtin_shuffle(u3, u7, lo4);
+    x[4] = __builtin_shuffle(u0, u4, hi4);
+    x[5] = __builtin_shuffle(u1, u5, hi4);
+    x[6] = __builtin_shuffle(u2, u6, hi4);
+    x[7] = __builtin_shuffle(u3, u7, hi4);
+}
+
+/* The four 1D passes of a block in the order of dct8x8_impl, x[r * s] holds row r */
+template<bool forward, typename T, typename V>
+[[gnu::always_inline]] inline void dct8_pass(V* x, const std::size_t s, const bool first_pass) noexcept
+{
+    if constexpr(std::is_same_v<T, float>)
+    {
+        if constexpr(forward)
+        {
+            dct8_aan_forward(x, s);
+        }
+        else
+        {
+            dct8_aan_inverse(x, s);
+        }
+    }
+    else
+    {
+        if constexpr(forward)
+        {
+            first_pass ? dct8_islow_forward<true>(x, s) : dct8_islow_forward<false>(x, s);
+        }
+        else
+        {
+            first_pass ? dct8_islow_inverse<true>(x, s) : dct8_islow_inverse<false>(x, s);
+        }
+    }
+}
+
+/*
+    In-place transpose of the 8x8 blocks held in x[0..7], x[r] is row r of W / 8 blocks side by side.
+    Three rounds of two-source shuffles, the unpack / shuffle / permute sequence of the usual AVX transpose.
+*/
+template<typename V>
+[[gnu::always_inline]] inline void dct8_transpose(V* x) noexcept
+{
+    typedef std::remove_reference_t<decltype(x[0][0])> L;
+    constexpr std::size_t W = sizeof(V) / sizeof(L);
+
+    typedef typename DCTVector<std::int32_t, sizeof(V)>::type M;
+
+    static_assert(W == 8 || W == 16);
+
+    if constexpr(W == 8)
+    {
+        constexpr M lo1 = { 0, 8, 1, 9, 4, 12, 5, 13 };
+        constexpr M hi1 = { 2, 10, 3, 11, 6, 14, 7, 15 };
+        constexpr M lo2 = { 0, 1, 8, 9, 4, 5, 12, 13 };
+        constexpr M hi2 = { 2, 3, 10, 11, 6, 7, 14, 15 };
+        constexpr M lo4 = { 0, 1, 2, 3, 8, 9, 10, 11 };
+        constexpr M hi4 = { 4, 5, 6, 7, 12, 13, 14, 15 };
+
+        dct8_transpose_rounds(x, lo1, hi1, lo2, hi2, lo4, hi4);
+    }
+    else
+    {
+        constexpr M lo1 = { 0, 16, 1, 17, 4, 20, 5, 21, 8, 24, 9, 25, 12, 28, 13, 29 };
+        constexpr M hi1 = { 2, 18, 3, 19, 6, 22, 7, 23, 10, 26, 11, 27, 14, 30, 15, 31 };
+        constexpr M lo2 = { 0, 1, 16, 17, 4, 5, 20, 21, 8, 9, 24, 25, 12, 13, 28, 29 };
+        constexpr M hi2 = { 2, 3, 18, 19, 6, 7, 22, 23, 10, 11, 26, 27, 14, 15, 30, 31 };
+        constexpr M lo4 = { 0, 1, 2, 3, 16, 17, 18, 19, 8, 9, 10, 11, 24, 25, 26, 27 };
+        constexpr M hi4 = { 4, 5, 6, 7, 20, 21, 22, 23, 12, 13, 14, 15, 28, 29, 30, 31 };
+
+        dct8_transpose_rounds(x, lo1, hi1, lo2, hi2, lo4, hi4);
+    }
+}
+
+/*
+    x = row r of each of the W / 8 blocks starting at row, side by side, converted to the lane type.
+    Whole-vector loads and stores only: filling a vector piece by piece through memory stalls store forwarding.
+*/
+template<typename V, typename T>
+[[gnu::always_inline]] inline void dct8_load_row(V& x, const T* row) noexcept
+{
+    typedef DCTLane<T> L;
+    constexpr std::size_t W = sizeof(V) / sizeof(L);
+
+    typedef T S __attribute__((vector_size(W * sizeof(T))));
+    typedef T H __attribute__((vector_size(8 * sizeof(T))));
+
+    S narrow;
+
+    if constexpr(W == 8)
+    {
+        std::memcpy(&narrow, row, sizeof(S));
+    }
+    else
+    {
+        H lo, hi;
+        std::memcpy(&lo, row, sizeof(H));
+        std::memcpy(&hi, row + 64, sizeof(H));
+        narrow = __builtin_shufflevector(lo, hi, 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+    }
+
+    x = __builtin_convertvector(narrow, V);
+}
+
+template<typename V, typename T>
+[[gnu::always_inline]] inline void dct8_store_row(T* row, const V& x) noexcept
+{
+    typedef DCTLane<T> L;
+    constexpr std::size_t W = sizeof(V) / sizeof(L);
+
+    typedef T S __attribute__((vector_size(W * sizeof(T))));
+    typedef T H __attribute__((vector_size(8 * sizeof(T))));
+
+    const S narrow = __builtin_convertvector(x, S);
+
+    if constexpr(W == 8)
+    {
+        std::memcpy(row, &narrow, sizeof(S));
+    }
+    else
+    {
+        const H lo = __builtin_shufflevector(narrow, narrow, 0, 1, 2, 3, 4, 5, 6, 7);
+        const H hi = __builtin_shufflevector(narrow, narrow, 8, 9, 10, 11, 12, 13, 14, 15);
+        std::memcpy(row, &lo, sizeof(H));
+        std::memcpy(row + 64, &hi, sizeof(H));
+    }
+}
+
+/*
+    count blocks, in and out hold 64 * count values and can be the same array.
+    V is a scalar: one block at a time in 64 scalars, columns then rows like the vector path so both
+    round the fixed point passes the same way.
+    V is a vector of W lanes: W / 8 blocks at a time, x[r] holds row r of each of them. The 1D passes
+    run on all the columns at once, a transpose turns the rows into columns for the second pass,
+    and another one restores the order.
+*/
+template<typename V, bool forward, typename T>
+[[gnu::always_inline]] inline void dct8x8_impl(const T* in, T* out, const std::size_t count) noexcept
+{
+    typedef DCTLane<T> L;
+    constexpr std::size_t W = sizeof(V) / sizeof(L);
+
+    const DCT8x8Scales& scales = dct8x8_scales();
+
+    if constexpr(W == 1)
+    {
+        for(std::size_t b = 0; b < count; b++)
+        {
+            L x[64];
+
+            for(std::size_t i = 0; i < 64; i++)
+            {
+                x[i] = static_cast<L>(in[b * 64 + i]);
+            }
+
+            if constexpr(std::is_same_v<T, float> && !forward)
+            {
+                for(std::size_t i = 0; i < 64; i++)
+                {
+                    x[i] *= scales.inverse[i];
+                }
+            }
+
+            for(std::size_t c = 0; c < 8; c++)
+            {
+                dct8_pass<forward, T>(x + c, 8, true);
+            }
+
+            for(std::size_t r = 0; r < 8; r++)
+            {
+                dct8_pass<forward, T>(x + r * 8, 1, false);
+            }
+
+            if constexpr(std::is_same_v<T, float> && forward)
+            {
+                for(std::size_t i = 0; i < 64; i++)
+                {
+                    x[i] *= scales.forward[i];
+                }
+            }
+
+            for(std::size_t i = 0; i < 64; i++)
+            {
+                out[b * 64 + i] = static_cast<T>(x[i]);
+            }
+        }
+    }
+    else
+    {
+        constexpr std::size_t P = W / 8;
+
+        /* Rows of the scale table, repeated for each block of a vector */
+        V scale[8];
+
+        if constexpr(std::is_same_v<T, float>)
+        {
+            const float* table = forward ? scales.forward : scales.inverse;
+
+            for(std::size_t r = 0; r < 8; r++)
+            {
+                L repeated[128];
+
+                for(std::size_t p = 0; p < P; p++)
+                {
+                    std::copy(table + r * 8, table + r * 8 + 8, repeated + p * 64);
+                }
+
+                dct8_load_row(scale[r], repeated);
+            }
+        }
+
+        for(std::size_t b0 = 0; b0 + P <= count; b0 += P)
+        {
+            V x[8];
+
+            for(std::size_t r = 0; r < 8; r++)
+            {
+                dct8_load_row(x[r], in + b0 * 64 + r * 8);
+            }
+
+            if constexpr(std::is_same_v<T, float> && !forward)
+            {
+                for(std::size_t r = 0; r < 8; r++)
+                {
+                    x[r] = x[r] * scale[r];
+                }
+            }
+
+            /* Columns, then rows */
+            dct8_pass<forward, T>(x, 1, true);
+            dct8_transpose(x);
+            dct8_pass<forward, T>(x, 1, false);
+            dct8_transpose(x);
+
+            if constexpr(std::is_same_v<T, float> && forward)
+            {
+                for(std::size_t r = 0; r < 8; r++)
+                {
+                    x[r] = x[r] * scale[r];
+                }
+            }
+
+            for(std::size_t r = 0; r < 8; r++)
+            {
+                dct8_store_row(out + b0 * 64 + r * 8, x[r]);
+            }
+        }
+    }
+}
+
+template<bool forward, typename T>
+void dct8x8_scalar(const T* in, T* out, const std::size_t count) noexcept
+{
+    dct8x8_impl<DCTLane<T>, forward>(in, out, count);
+}
+
+#if FFT_HAS_X86_SIMD
+template<bool forward, typename T>
+__attribute__((target("avx2,fma"))) void dct8x8_avx2(const T* in, T* out, const std::size_t count) noexcept
+{
+    dct8x8_impl<typename DCTVector<DCTLane<T>, 32>::type, forward>(in, out, count);
+}
+
+template<bool forward, typename T>
+__attribute__((target("avx512f"))) void dct8x8_avx512(const T* in, T* out, const std::size_t count) noexcept
+{
+    dct8x8_impl<typename DCTVector<DCTLane<T>, 64>::type, forward>(in, out, count);
+}
+#endif /* FFT_HAS_X86_SIMD */
+
+/* count blocks of 64 values, row-major, T is float (AAN) or int16_t (Loeffler fixed point, 8-bit samples) */
+template<bool forward, typename T>
+void dct8x8_blocks(const T* in, T* out, const std::size_t count, const FFTSimd simd) noexcept
+{
+    std::size_t done = 0;
+
+    switch(std::min(simd, fft_detect_simd()))
+    {
+#if FFT_HAS_X86_SIMD
+        case FFTSimd_AVX512:
+            done = count - count % 2;
+            dct8x8_avx512<forward>(in, out, done);
+            break;
+        case FFTSimd_AVX2:
+            done = count;
+            dct8x8_avx2<forward>(in, out, done);
+            break;
+#endif
+        default:
+            break;
+    }
+
+    /* The blocks left over */
+    dct8x8_scalar<forward>(in + done * 64, out + done * 64, count - done);
+}
+
+/* Orthonormal 2D DCT-II of count 8x8 blocks */
+template<typename T>
+void dct8x8_forward(const T* in, T* out, const std::size_t count = 1, const FFTSimd simd = fft_detect_simd()) noexcept
+{
+    dct8x8_blocks<true>(in, out, count, simd);
+}
+
+/* Orthonormal 2D DCT-III of count 8x8 blocks, the inverse of dct8x8_forward */
+template<typename T>
+void dct8x8_inverse(const T* in, T* out, const std::size_t count = 1, const FFTSimd simd = fft_detect_simd()) noexcept
+{
+    dct8x8_blocks<false>(in, out, count, simd);
+}
+
+/* Number of 8x8 blocks covering a width x height image */
+inline std::size_t dct8x8_image_blocks(const std::size_t width, const std::size_t height) noexcept
+{
+    return ((width + 7) / 8) * ((height + 7) / 8);
+}
+
+/*
+    Block row by of an 8-bit image into blocks_x = (width + 7) / 8 blocks of 64 samples, shifted by -128
+    like JPEG does. The partial blocks of the right and bottom edges repeat the last column / row.
+*/
+template<typename T>
+void dct8x8_load_block_row(const std::uint8_t* pixels,
+                           const std::size_t width,
+                           const std::size_t height,
+                           const std::size_t stride,
+                           const std::size_t by,
+                           T* blocks) noexcept
+{
+    const std::size_t blocks_x = (width + 7) / 8;
+
+    for(std::size_t r = 0; r < 8; r++)
+    {
+        const std::uint8_t* line = pixels + std::min(by * 8 + r, height - 1) * stride;
+
+        for(std::size_t bx = 0; bx < blocks_x; bx++)
+        {
+            T* block_row = blocks + bx * 64 + r * 8;
+
+            for(std::size_t c = 0; c < 8; c++)
+            {
+                block_row[c] = static_cast<T>(static_cast<int>(line[std::min(bx * 8 + c, width - 1)]) - 128);
+            }
+        }
+    }
+}
+
+/* Blocks the inverse transforms at once, on the stack */
+static constexpr std::size_t DCT8X8_IMAGE_CHUNK = 16;
+
+/*
+    Inverse DCT of the blocks_x blocks of block row by, written back to the image: samples are shifted
+    back by +128, rounded and clamped to [0, 255], what falls outside of the image is dropped
+*/
+template<typename T>
+void dct8x8_store_block_row(const T* blocks,
+                            std::uint8_t* pixels,
+                            const std::size_t width,
+                            const std::size_t height,
+                            const std::size_t stride,
+                            const std::size_t by,
+                            const FFTSimd simd = fft_detect_simd()) noexcept
+{
+    const std::size_t blocks_x = (width + 7) / 8;
+    const std::size_t rows = std::min<std::size_t>(8, height - by * 8);
+
+    alignas(64) T samples[DCT8X8_IMAGE_CHUNK * 64];
+
+    for(std::size_t bx0 = 0; bx0 < blocks_x; bx0 += DCT8X8_IMAGE_CHUNK)
+    {
+        const std::size_t count = std::min(DCT8X8_IMAGE_CHUNK, blocks_x - bx0);
+
+        dct8x8_inverse(blocks + bx0 * 64, samples, count, simd);
+
+        for(std::size_t r = 0; r < rows; r++)
+        {
+            std::uint8_t* line = pixels + (by * 8 + r) * stride;
+
+            for(std::size_t b = 0; b < count; b++)
+            {
+                const std::size_t x0 = (bx0 + b) * 8;
+                const std::size_t columns = std::min<std::size_t>(8, width - x0);
+
+                for(std::size_t c = 0; c < columns; c++)
+                {
+                    T value = samples[b * 64 + r * 8 + c];
+
+                    if constexpr(std::is_same_v<T, float>)
+                    {
+                        value = std::nearbyint(value);
+                    }
+
+                    line[x0 + c] = static_cast<std::uint8_t>(std::clamp(static_cast<int>(value) + 128, 0, 255));
+                }
+            }
+        }
+    }
+}
+
+/* Forward DCT of a whole 8-bit image, blocks in raster order, 64 coefficients each. Block rows are spread over the threads of the pool. */
+template<typename T>
+void dct8x8_image_forward(const std::uint8_t* pixels,
+                          const std::size_t width,
+                          const std::size_t height,
+                          const std::size_t stride,
+                          T* blocks,
+                          FFTThreadPool& pool = fft_thread_pool(),
+                          const FFTSimd simd = fft_detect_simd()) noexcept
+{
+    if(width == 0 || height == 0)
+    {
+        return;
+    }
+
+    const std::size_t blocks_x = (width + 7) / 8;
+    const std::size_t blocks_y = (height + 7) / 8;
+
+    pool.parallel_for(blocks_y, [&](const std::size_t by, const std::size_t) {
+        T* row_blocks = blocks + by * blocks_x * 64;
+
+        dct8x8_load_block_row(pixels, width, height, stride, by, row_blocks);
+        dct8x8_forward(row_blocks, row_blocks, blocks_x, simd);
+    });
+}
+
+/* Inverse of dct8x8_image_forward */
+template<typename T>
+void dct8x8_image_inverse(const T* blocks,
+                          std::uint8_t* pixels,
+                          const std::size_t width,
+                          const std::size_t height,
+                          const std::size_t stride,
+                          FFTThreadPool& pool = fft_thread_pool(),
+                          const FFTSimd simd = fft_detect_simd()) noexcept
+{
+    if(width == 0 || height == 0)
+    {
+        return;
+    }
+
+    const std::size_t blocks_x = (width + 7) / 8;
+    const std::size_t blocks_y = (height + 7) / 8;
+
+    pool.parallel_for(blocks_y, [&](const std::size_t by, const std::size_t) {
+        dct8x8_store_block_row(blocks + by * blocks_x * 64, pixels, width, height, stride, by, simd);
+    });
+}
+
+/*
+    Integer DCT-II of HEVC (ITU H.265, 8.6.4.2), bit-exact on every platform
+
+    https://en.wikipedia.org/wiki/High_Efficiency_Video_Coding#Transform
+    M. Budagavi, A. Fuldseth, G. Bjøntegaard, V. Sze, M. Sadafale, "Core Transform Design in the HEVC Standard", 2013
+
+    The N x N matrices, N = 4, 8, 16, 32, are integer approximations of 64 * sqrt(N) times the orthonormal DCT-II,
+    the N-point one made of rows 0, 32 / N, 2 * 32 / N... of the 32-point one. Entry (k, n) of the 32-point
+    matrix is T(k * (2n + 1)) with T(m) ~ 64 * sqrt(2) * cos(mπ / 64), folded into [0, 32] by the symmetries of cos.
+
+    They keep the symmetries of the DCT so the partial butterfly applies: the even outputs are the N/2-point
+    transform of x[n] + x[N - 1 - n], the odd ones N/2 x N/2 products with x[n] - x[N - 1 - n].
+
+    Rounding: each 1D stage is followed by (x + 2^(shift - 1)) >> shift and a clip to int16.
+        forward, rows then columns: shift log2(N) - 1 + (bit_depth - 8), then log2(N) + 6
+        inverse, columns then rows: shift 7, then 20 - bit_depth
+    For bit_depth-bit residuals the forward output is 2^(15 - bit_depth - log2(N)) times the orthonormal 2D DCT,
+    128 / N times for 8-bit. The inverse undoes that scaling, the matrices are only nearly orthogonal so forward
+    then inverse is within a few LSB.
+
+    The kernels run in int32 lanes over GCC vectors holding a row of the block: the 1D passes transform all the
+    columns at once, shuffle transposes in registers turn the rows into columns.
+*/
+
+/* Largest transform */
+static constexpr std::size_t DCT_INT_MAX_SIZE = 32;
+
+/* 64 * sqrt(2) * cos(mπ / 64) for m = 0 to 32, rounded so that the rows stay close to orthogonal, T(0) is the DC row */
+static constexpr int DCT_INT_COSINES[33] = {
+    64, 90, 90, 90, 89, 88, 87, 85, 83, 82, 80, 78, 75, 73, 70, 67,
+    64, 61, 57, 54, 50, 46, 43, 38, 36, 31, 25, 22, 18, 13,  9,  4,
+     0,
+};
+
+/* Entry (k, n) of the N-point matrix */
+constexpr int dct_int_coefficient(const std::size_t N, const std::size_t k, const std::size_t n) noexcept
+{
+    std::size_t m = (k * (DCT_INT_MAX_SIZE / N) * (2 * n + 1)) % 128;
+
+    if(m > 64)
+    {
+        m = 128 - m;
+    }
+
+    return m > 32 ? -DCT_INT_COSINES[64 - m] : DCT_INT_COSINES[m];
+}
+
+/* The N-point matrix, row-major, computed at compile time */
+template<std::size_t N>
+struct DCTIntMatrix
+{
+    static constexpr std::array<int, N * N> values = [] {
+        std::array<int, N * N> m{};
+
+        for(std::size_t k = 0; k < N; k++)
+        {
+            for(std::size_t n = 0; n < N; n++)
+            {
+                m[k * N + n] = dct_int_coefficient(N, k, n);
+            }
+        }
+
+        return m;
+    }();
+};
+
+/* y = matrix * x along N lanes or vectors of them, unscaled */
+template<std::size_t N, typename V>
+[[gnu::always_inline]] inline void dct_int_butterfly(const V* x, V* y) noexcept
+{
+    if constexpr(N == 1)
+    {
+        y[0] = x[0] * 64;
+    }
+    else
+    {
+        constexpr std::size_t H = N / 2;
+        constexpr const std::array<int, N * N>& matrix = DCTIntMatrix<N>::values;
+
+        V even[H];
+        V odd[H];
+
+        #pragma GCC unroll 32
+        for(std::size_t n = 0; n < H; n++)
+        {
+            even[n] = x[n] + x[N - 1 - n];
+            odd[n] = x[n] - x[N - 1 - n];
+        }
+
+        V even_out[H];
+        dct_int_butterfly<H>(even, even_out);
+
+        #pragma GCC unroll 32
+        for(std::size_t k = 0; k < H; k++)
+        {
+            y[2 * k] = even_out[k];
+
+            V sum = odd[0] * matrix[(2 * k + 1) * N];
+
+            #pragma GCC unroll 32
+            for(std::size_t n = 1; n < H; n++)
+            {
+                sum += odd[n] * matrix[(2 * k + 1) * N + n];
+            }
+
+            y[2 * k + 1] = sum;
+        }
+    }
+}
+
+/* x = transpose(matrix) * y, unscaled */
+template<std::size_t N, typename V>
+[[gnu::always_inline]] inline void dct_int_butterfly_inverse(const V* y, V* x) noexcept
+{
+    if constexpr(N == 1)
+    {
+        x[0] = y[0] * 64;
+    }
+    else
+    {
+        constexpr std::size_t H = N / 2;
+        constexpr const std::array<int, N * N>& matrix = DCTIntMatrix<N>::values;
+
+        V even_in[H];
+
+        #pragma GCC unroll 32
+        for(std::size_t k = 0; k < H; k++)
+        {
+            even_in[k] = y[2 * k];
+        }
+
+        V even[H];
+        dct_int_butterfly_inverse<H>(even_in, even);
+
+        #pragma GCC unroll 32
+        for(std::size_t n = 0; n < H; n++)
+        {
+            V odd = y[1] * matrix[N + n];
+
+            #pragma GCC unroll 32
+            for(std::size_t k = 1; k < H; k++)
+            {
+                odd += y[2 * k + 1] * matrix[(2 * k + 1) * N + n];
+            }
+
+            x[n] = even[n] + odd;
+            x[N - 1 - n] = even[n] - odd;
+        }
+    }
+}
+
+/* (x + 2^(shift - 1)) >> shift, clipped to int16 */
+template<typename V>
+[[gnu::always_inline]] inline void dct_int_round(V& x, const int shift) noexcept
+{
+    x = (x + (1 << (shift - 1))) >> shift;
+    x = x < -32768 ? -32768 : x;
+    x = x > 32767 ? 32767 : x;
+}
+
+/* W int32 lanes and the int16 vectors they are loaded from, plain integers for scalar code */
+template<std::size_t W>
+struct DCTIntLanes
+{
+    typedef typename DCTVector<std::int32_t, W * sizeof(std::int32_t)>::type type;
+    typedef std::int16_t narrow __attribute__((vector_size(W * sizeof(std::int16_t))));
+};
+
+template<>
+struct DCTIntLanes<1>
+{
+    typedef std::int32_t type;
+    typedef std::int16_t narrow;
+};
+
+/* Masks of the transpose round exchanging the off-diagonal h x h blocks of each 2h x 2h block */
+template<typename V, std::size_t h, typename I>
+struct DCTIntShuffle;
+
+template<typename V, std::size_t h, std::size_t... l>
+struct DCTIntShuffle<V, h, std::index_sequence<l...>>
+{
+    static constexpr std::size_t W = sizeof...(l);
+
+    static constexpr V lo = { static_cast<std::int32_t>((l & h) ? W + l - h : l)... };
+    static constexpr V hi = { static_cast<std::int32_t>((l & h) ? W + l : l + h)... };
+};
+
+/* In-register transpose of the W x W tile held in x[0..W - 1], log2(W) rounds of two-source shuffles */
+template<std::size_t W, std::size_t h = W / 2, typename V>
+[[gnu::always_inline]] inline void dct_int_transpose_tile(V* x) noexcept
+{
+    if constexpr(h > 0)
+    {
+        typedef DCTIntShuffle<V, h, std::make_index_sequence<W>> M;
+
+        #pragma GCC unroll 32
+        for(std::size_t i = 0; i < W; i++)
+        {
+            if((i & h) == 0)
+            {
+                const V a = x[i];
+                const V b = x[i + h];
+
+                x[i] = __builtin_shuffle(a, b, M::lo);
+                x[i + h] = __builtin_shuffle(a, b, M::hi);
+            }
+        }
+
+        dct_int_transpose_tile<W, h / 2>(x);
+    }
+}
+
+/*
+    Transpose of a block held as x[t][r] = columns t * W to t * W + W - 1 of row r: every W x W tile is
+    transposed in registers, then tiles (a, b) and (b, a) trade places.
+*/
+template<std::size_t N, std::size_t W, typename V>
+[[gnu::always_inline]] inline void dct_int_transpose(V (&x)[N / W][N]) noexcept
+{
+    constexpr std::size_t T = N / W;
+
+    for(std::size_t b = 0; b < T; b++)
+    {
+        for(std::size_t a = 0; a < T; a++)
+        {
+            dct_int_transpose_tile<W>(x[b] + a * W);
+        }
+    }
+
+    for(std::size_t a = 0; a < T; a++)
+    {
+        for(std::size_t b = a + 1; b < T; b++)
+        {
+            #pragma GCC unroll 32
+            for(std::size_t i = 0; i < W; i++)
+            {
+                std::swap(x[a][b * W + i], x[b][a * W + i]);
+            }
+        }
+    }
+}
+
+/* One stage on a block held as in dct_int_transpose: the 1D transform of every column, rounded by shift */
+template<std::size_t N, std::size_t W, bool forward, typename V>
+[[gnu::always_inline]] inline void dct_int_stage(V (&x)[N / W][N], const int shift) noexcept
+{
+    for(std::size_t t = 0; t < N / W; t++)
+    {
+        V y[N];
+
+        if constexpr(forward)
+        {
+            dct_int_butterfly<N>(x[t], y);
+        }
+        else
+        {
+            dct_int_butterfly_inverse<N>(x[t], y);
+        }
+
+        #pragma GCC unroll 32
+        for(std::size_t k = 0; k < N; k++)
+        {
+            dct_int_round(y[k], shift);
+            x[t][k] = y[k];
+        }
+    }
+}
+
+/*
+    count N x N blocks, W int32 lanes per vector (1 for scalar code). A block stays in registers (or whole
+    vector spills) from the int16 loads to the int16 stores, the transposes never go through memory.
+*/
+template<std::size_t N, std::size_t W, bool forward>
+[[gnu::always_inline]] inline void dct_int_impl(const std::int16_t* in,
+                                                std::int16_t* out,
+                                                const std::size_t count,
+                                                const int bit_depth) noexcept
+{
+    typedef typename DCTIntLanes<W>::type V;
+    typedef typename DCTIntLanes<W>::narrow S;
+
+    constexpr std::size_t T = N / W;
+    constexpr int log2_size = std::countr_zero(N);
+
+    const int shift1 = forward ? log2_size - 1 + (bit_depth - 8) : 7;
+    const int shift2 = forward ? log2_size + 6 : 20 - bit_depth;
+
+    for(std::size_t b = 0; b < count; b++)
+    {
+        const std::int16_t* src = in + b * N * N;
+        std::int16_t* dst = out + b * N * N;
+
+        V x[T][N];
+
+        for(std::size_t r = 0; r < N; r++)
+        {
+            for(std::size_t t = 0; t < T; t++)
+            {
+                S s;
+                std::memcpy(&s, src + r * N + t * W, sizeof(S));
+
+                if constexpr(W == 1)
+                {
+                    x[t][r] = s;
+                }
+                else
+                {
+                    x[t][r] = __builtin_convertvector(s, V);
+                }
+            }
+        }
+
+        if constexpr(forward)
+        {
+            /* Rows first: transposed, the rows are columns */
+            dct_int_transpose<N, W>(x);
+            dct_int_stage<N, W, true>(x, shift1);
+            dct_int_transpose<N, W>(x);
+            dct_int_stage<N, W, true>(x, shift2);
+        }
+        else
+        {
+            /* Columns first */
+            dct_int_stage<N, W, false>(x, shift1);
+            dct_int_transpose<N, W>(x);
+            dct_int_stage<N, W, false>(x, shift2);
+            dct_int_transpose<N, W>(x);
+        }
+
+        for(std::size_t r = 0; r < N; r++)
+        {
+            for(std::size_t t = 0; t < T; t++)
+            {
+                S s;
+
+                if constexpr(W == 1)
+                {
+                    s = static_cast<std::int16_t>(x[t][r]);
+                }
+                else
+                {
+                    s = __builtin_convertvector(x[t][r], S);
+                }
+
+                std::memcpy(dst + r * N + t * W, &s, sizeof(S));
+            }
+        }
+    }
+}
+
+/* Scalar and vector builds of every size, W = min(N, lanes of the vectors) */
+template<bool forward, std::size_t lanes>
+[[gnu::always_inline]] inline void dct_int_sizes(const std::int16_t* in,
+                                                 std::int16_t* out,
+                                                 const std::size_t N,
+                                                 const std::size_t count,
+                                                 const int bit_depth) noexcept
+{
+    switch(N)
+    {
+        case 4:
+            dct_int_impl<4, std::min<std::size_t>(4, lanes), forward>(in, out, count, bit_depth);
+            break;
+        case 8:
+            dct_int_impl<8, std::min<std::size_t>(8, lanes), forward>(in, out, count, bit_depth);
+            break;
+        case 16:
+            dct_int_impl<16, std::min<std::size_t>(16, lanes), forward>(in, out, count, bit_depth);
+            break;
+        case 32:
+            dct_int_impl<32, std::min<std::size_t>(32, lanes), forward>(in, out, count, bit_depth);
+            break;
+        default:
+            break;
+    }
+}
+
+template<bool forward>
+void dct_int_scalar(const std::int16_t* in, std::int16_t* out, const std::size_t N, const std::size_t count, const int bit_depth) noexcept
+{
+    dct_int_sizes<forward, 1>(in, out, N, count, bit_depth);
+}
+
+#if FFT_HAS_X86_SIMD
+template<bool forward>
+__attribute__((target("avx2,fma"))) void dct_int_avx2(const std::int16_t* in, std::int16_t* out, const std::size_t N, const std::size_t count, const int bit_depth) noexcept
+{
+    dct_int_sizes<forward, 8>(in, out, N, count, bit_depth);
+}
+
+template<bool forward>
+__attribute__((target("avx512f"))) void dct_int_avx512(const std::int16_t* in, std::int16_t* out, const std::size_t N, const std::size_t count, const int bit_depth) noexcept
+{
+    dct_int_sizes<forward, 16>(in, out, N, count, bit_depth);
+}
+#endif /* FFT_HAS_X86_SIMD */
+
+template<bool forward>
+void dct_int_blocks(const std::int16_t* in,
+                    std::int16_t* out,
+                    const std::size_t N,
+                    const std::size_t count,
+                    const int bit_depth,
+                    const FFTSimd simd) noexcept
+{
+    switch(std::min(simd, fft_detect_simd()))
+    {
+#if FFT_HAS_X86_SIMD
+        case FFTSimd_AVX512:
+            dct_int_avx512<forward>(in, out, N, count, bit_depth);
+            return;
+        case FFTSimd_AVX2:
+            dct_int_avx2<forward>(in, out, N, count, bit_depth);
+            return;
+#endif
+        default:
+            dct_int_scalar<forward>(in, out, N, count, bit_depth);
+            return;
+    }
+}
+
+/*
+    HEVC forward transform of count N x N blocks of residuals, N = 4, 8, 16 or 32, row-major, in and out can be
+    the same array. Every platform and SIMD level gives the same result.
+*/
+inline void dct_int_forward(const std::int16_t* in,
+                            std::int16_t* out,
+                            const std::size_t N,
+                            const std::size_t count = 1,
+                            const int bit_depth = 8,
+                            const FFTSimd simd = fft_detect_simd()) noexcept
+{
+    dct_int_blocks<true>(in, out, N, count, bit_depth, simd);
+}
+
+/* HEVC inverse transform, the inverse of dct_int_forward */
+inline void dct_int_inverse(const std::int16_t* in,
+                            std::int16_t* out,
+                            const std::size_t N,
+                            const std::size_t count = 1,
+                            const int bit_depth = 8,
+                            const FFTSimd simd = fft_detect_simd()) noexcept
+{
+    dct_int_blocks<false>(in, out, N, count, bit_depth, simd);
+}
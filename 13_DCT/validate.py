@@ -2,7 +2,7 @@
 
 # python -m venv env && env\bin\activate && python -m pip install scipy
 
-from scipy.fftpack import dct
+from scipy.fftpack import dct, idct, dctn
 
 import numpy as np
 
@@ -15,4 +15,25 @@ if __name__ == "__main__":
 
     dct_res = dct(points, norm="ortho")
 
-    print(f"DCT: {dct_res}")
\ No newline at end of file
+    print(f"DCT: {dct_res}")
+
+    idct_res = idct(dct_res, norm="ortho")
+
+    print(f"IDCT: {idct_res}")
+
+    dct4_res = dct(points, type=4, norm="ortho")
+
+    print(f"DCT-IV: {dct4_res}")
+
+    dct2d_res = dctn(points.reshape(2, 4), norm="ortho")
+
+    print(f"2D DCT (2 x 4): {dct2d_res.flatten()}")
+
+    # No MDCT in scipy, the definition with the sine window and the orthonormal scaling
+    N = points.size // 2
+    n = np.arange(2 * N)
+    k = np.arange(N)
+    window = np.sin(np.pi * (n + 0.5) / (2 * N))
+    mdct_res = np.sqrt(2 / N) * np.cos(np.pi / N * np.outer(k + 0.5, n + 0.5 + N / 2)) @ (window * points)
+
+    print(f"MDCT (sine window): {mdct_res}")
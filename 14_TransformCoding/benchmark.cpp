@@ -0,0 +1,189 @@
+#include <iostream>
+#include <chrono>
+#include <vector>
+#include <random>
+#include <iomanip>
+#include <cmath>
+#include <algorithm>
+#include <cstdint>
+#include <thread>
+
+#include "transform_coding.hpp"
+
+class BenchmarkTimer
+{
+private:
+    std::chrono::high_resolution_clock::time_point start_time;
+
+public:
+    void start() noexcept
+    {
+        this->start_time = std::chrono::high_resolution_clock::now();
+    }
+
+    double elapsed_ms() const noexcept
+    {
+        auto end_time = std::chrono::high_resolution_clock::now();
+        auto duration = std::chrono::duration_cast<std::chrono::microseconds>(end_time - this->start_time);
+        return duration.count() / 1000.0;
+    }
+};
+
+/* Smooth field, a few sharp edges and some sensor noise */
+std::vector<std::uint8_t> generateImage(const std::size_t width, const std::size_t height, const double noise) noexcept
+{
+    std::mt19937 gen(42);
+    std::normal_distribution<double> dist(0.0, noise);
+
+    std::vector<std::uint8_t> pixels(width * height);
+
+    for(std::size_t y = 0; y < height; y++)
+    {
+        for(std::size_t x = 0; x < width; x++)
+        {
+            const double u = static_cast<double>(x) / static_cast<double>(width);
+            const double v = static_cast<double>(y) / static_cast<double>(height);
+
+            double value = 128.0 + 50.0 * std::sin(6.0 * u + 2.0 * v) * std::cos(5.0 * v) + 30.0 * u;
+
+            /* Rectangles and stripes */
+            if(std::fmod(u * 7.0, 1.0) < 0.3 && std::fmod(v * 5.0, 1.0) < 0.4)
+            {
+                value -= 60.0;
+            }
+
+            if(v > 0.8 && (x / 4) % 2 == 0)
+            {
+                value += 40.0;
+            }
+
+            value += dist(gen);
+
+            pixels[y * width + x] = static_cast<std::uint8_t>(std::clamp(std::round(value), 0.0, 255.0));
+        }
+    }
+
+    return pixels;
+}
+
+void runRateDistortion(const char* name, const std::vector<std::uint8_t>& pixels, const std::size_t width, const std::size_t height) noexcept
+{
+    std::cout << "\n=== Rate-distortion, " << name << " " << width << " x " << height << " ===" << std::endl;
+
+    std::vector<std::uint8_t> decoded(width * height);
+    std::vector<std::uint8_t> reloaded(width * height);
+
+    for(const int quality : { 5, 10, 25, 50, 75, 90, 95, 100 })
+    {
+        const TransformCoder coder(quality);
+
+        const TransformCodedImage encoded = coder.encode(pixels.data(), width, height, width);
+
+        coder.decode(encoded, decoded.data(), width);
+
+        /* The stream size() counts, read back it decodes to the same pixels, and truncated it is rejected */
+        const std::vector<std::uint8_t> stream = encoded.serialize();
+
+        TransformCodedImage parsed;
+        bool roundtrip = stream.size() == encoded.size() && parsed.deserialize(stream.data(), stream.size());
+
+        if(roundtrip)
+        {
+            coder.decode(parsed, reloaded.data(), width);
+            roundtrip = reloaded == decoded && !TransformCodedImage().deserialize(stream.data(), stream.size() - 1);
+        }
+
+        const double bytes = static_cast<double>(encoded.size());
+
+        std::cout << "Quality " << std::setw(3) << quality
+                  << std::fixed << std::setprecision(2)
+                  << "  " << std::setw(9) << encoded.size() << " bytes"
+                  << "  " << std::setw(5) << 8.0 * bytes / static_cast<double>(width * height) << " bits/pixel"
+                  << "  ratio " << std::setw(6) << static_cast<double>(width * height) / bytes
+                  << "  PSNR " << std::setw(5) << transform_coding_psnr(pixels.data(), decoded.data(), width, height, width) << " dB"
+                  << (roundtrip ? "" : "  serialization round trip FAILED")
+                  << std::defaultfloat << std::endl;
+    }
+}
+
+void runThroughputBenchmark() noexcept
+{
+    const std::size_t width = 4096;
+    const std::size_t height = 4096;
+
+    std::cout << "\n=== Throughput, " << width << " x " << height << ", quality 75 ===" << std::endl;
+
+    const std::vector<std::uint8_t> pixels = generateImage(width, height, 2.0);
+    std::vector<std::uint8_t> decoded(width * height);
+
+    const double megapixels = static_cast<double>(width * height) / 1e6;
+
+    const std::size_t max_threads = std::max(1u, std::thread::hardware_concurrency());
+
+    for(std::size_t num_threads = 1; ; num_threads = std::min(2 * num_threads, max_threads))
+    {
+        FFTThreadPool pool(num_threads);
+
+        const TransformCoder coder(75, pool);
+
+        BenchmarkTimer timer;
+
+        /* Best of 3 */
+        double encode_time = 0.0;
+        double decode_time = 0.0;
+        std::size_t bytes = 0;
+
+        for(std::size_t i = 0; i < 3; i++)
+        {
+            timer.start();
+            const TransformCodedImage encoded = coder.encode(pixels.data(), width, height, width);
+            const double t_encode = timer.elapsed_ms();
+
+            timer.start();
+            coder.decode(encoded, decoded.data(), width);
+            const double t_decode = timer.elapsed_ms();
+
+            encode_time = i == 0 ? t_encode : std::min(encode_time, t_encode);
+            decode_time = i == 0 ? t_decode : std::min(decode_time, t_decode);
+            bytes = encoded.size();
+        }
+
+        std::cout << std::setw(3) << num_threads << " threads"
+                  << std::fixed << std::setprecision(1)
+                  << "  encode: " << std::setw(7) << encode_time << " ms (" << std::setw(6) << megapixels * 1000.0 / encode_time << " MP/s)"
+                  << "  decode: " << std::setw(7) << decode_time << " ms (" << std::setw(6) << megapixels * 1000.0 / decode_time << " MP/s)"
+                  << "  " << bytes << " bytes"
+                  << std::defaultfloat << std::endl;
+
+        if(num_threads == max_threads)
+        {
+            break;
+        }
+    }
+}
+
+int main(int argc, char** argv) noexcept
+{
+    std::cout << "Transform Coding Benchmark" << std::endl;
+
+    const std::size_t size = 1024;
+
+    runRateDistortion("smooth + edges", generateImage(size, size, 2.0), size, size);
+
+    /* White noise, the worst case: long runs are rare, every AC symbol shows up */
+    std::mt19937 gen(7);
+    std::uniform_int_distribution<int> dist(0, 255);
+
+    std::vector<std::uint8_t> noise(size * size);
+
+    for(auto& p : noise)
+    {
+        p = static_cast<std::uint8_t>(dist(gen));
+    }
+
+    runRateDistortion("white noise", noise, size, size);
+
+    runThroughputBenchmark();
+
+    return 0;
+}
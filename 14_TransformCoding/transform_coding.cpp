@@ -0,0 +1,50 @@
+#include <vector>
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include <iomanip>
+
+#include "transform_coding.hpp"
+
+int main(int argc, char** argv) noexcept
+{
+    /* A smooth gradient with a bright disc, 100 x 60 so that the right and bottom blocks are partial */
+    const std::size_t width = 100;
+    const std::size_t height = 60;
+
+    std::vector<std::uint8_t> pixels(width * height);
+
+    for(std::size_t y = 0; y < height; y++)
+    {
+        for(std::size_t x = 0; x < width; x++)
+        {
+            const double dx = static_cast<double>(x) - 60.0;
+            const double dy = static_cast<double>(y) - 30.0;
+
+            const double value = 40.0 + 1.2 * static_cast<double>(x) + 0.8 * static_cast<double>(y) + (dx * dx + dy * dy < 300.0 ? 60.0 : 0.0);
+
+            pixels[y * width + x] = static_cast<std::uint8_t>(std::min(255.0, value));
+        }
+    }
+
+    std::cout << "Image: " << width << " x " << height << ", " << pixels.size() << " bytes\n";
+
+    for(const int quality : { 25, 50, 75, 95 })
+    {
+        const TransformCoder coder(quality);
+
+        const TransformCodedImage encoded = coder.encode(pixels.data(), width, height, width);
+
+        std::vector<std::uint8_t> decoded(width * height);
+
+        coder.decode(encoded, decoded.data(), width);
+
+        std::cout << "Quality " << std::setw(2) << quality
+                  << ": " << std::setw(5) << encoded.size() << " bytes, "
+                  << std::fixed << std::setprecision(2) << 8.0 * static_cast<double>(encoded.size()) / static_cast<double>(width * height) << " bits/pixel, "
+                  << "PSNR " << transform_coding_psnr(pixels.data(), decoded.data(), width, height, width) << " dB"
+                  << std::defaultfloat << "\n";
+    }
+
+    return 0;
+}
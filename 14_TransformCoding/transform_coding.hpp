@@ -0,0 +1,571 @@
+#pragma once
+
+#include <vector>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <cstddef>
+#include <cstdlib>
+#include <algorithm>
+#include <limits>
+
+#include "../06_HuffmanCoding/huffman.hpp"
+#include "../13_DCT/dct.hpp"
+
+/*
+    Lossy transform coding of 8-bit images, the baseline JPEG pipeline for one channel
+
+    https://en.wikipedia.org/wiki/Transform_coding
+    https://en.wikipedia.org/wiki/JPEG#JPEG_codec_example
+    ITU T.81, Annex F (coding of the coefficients) and Annex K (quantization tables)
+
+    8x8 blocks go through the fixed point DCT of 13_DCT, the coefficients are divided by a quantization
+    table scaled by a quality factor and read in zig-zag order. DC values are coded as the difference with
+    the previous block, AC values as (run of zeros, size) symbols, both followed by size extra bits.
+    Symbols are Huffman coded with tables optimized for the image, built by 06_HuffmanCoding.
+
+    The image is cut in tiles of TRANSFORM_CODING_TILE_ROWS block rows, coded independently (like JPEG restart
+    intervals) and in parallel: a first pass streams the blocks of each tile through the DCT and only counts
+    their run-length symbols, the Huffman tables are built from the counts of all the tiles, a second pass
+    transforms the blocks again and writes the bits. Nothing but the counts is kept between the passes, the
+    encoder needs a block row per thread whatever the size of the image, for the price of a second DCT.
+*/
+
+/* Block rows of a tile, 64 pixel rows */
+static constexpr std::size_t TRANSFORM_CODING_TILE_ROWS = 8;
+
+/* Natural (row-major) index of the k-th coefficient in zig-zag order */
+static constexpr std::uint8_t TRANSFORM_CODING_ZIGZAG[64] = {
+     0,  1,  8, 16,  9,  2,  3, 10,
+    17, 24, 32, 25, 18, 11,  4,  5,
+    12, 19, 26, 33, 40, 48, 41, 34,
+    27, 20, 13,  6,  7, 14, 21, 28,
+    35, 42, 49, 56, 57, 50, 43, 36,
+    29, 22, 15, 23, 30, 37, 44, 51,
+    58, 59, 52, 45, 38, 31, 39, 46,
+    53, 60, 61, 54, 47, 55, 62, 63,
+};
+
+/* Annex K luminance table, natural order, the quality 50 table */
+static constexpr std::uint8_t TRANSFORM_CODING_LUMINANCE[64] = {
+    16, 11, 10, 16,  24,  40,  51,  61,
+    12, 12, 14, 19,  26,  58,  60,  55,
+    14, 13, 16, 24,  40,  57,  69,  56,
+    14, 17, 22, 29,  51,  87,  80,  62,
+    18, 22, 37, 56,  68, 109, 103,  77,
+    24, 35, 55, 64,  81, 104, 113,  92,
+    49, 64, 78, 87, 103, 121, 120, 101,
+    72, 92, 95, 98, 112, 100, 103,  99,
+};
+
+/* Symbols of the AC table: end of block and run of 16 zeros */
+static constexpr std::uint8_t TRANSFORM_CODING_EOB = 0x00;
+static constexpr std::uint8_t TRANSFORM_CODING_ZRL = 0xF0;
+
+/* Tiles of a width x height image, every tile but the last one has TRANSFORM_CODING_TILE_ROWS block rows */
+inline std::size_t transform_coding_num_tiles(const std::size_t width, const std::size_t height) noexcept
+{
+    const std::size_t blocks_y = (height + 7) / 8;
+
+    return width == 0 ? 0 : (blocks_y + TRANSFORM_CODING_TILE_ROWS - 1) / TRANSFORM_CODING_TILE_ROWS;
+}
+
+/* Number of bits of |value|, the size category of a coefficient */
+inline std::uint32_t transform_coding_size(const int value) noexcept
+{
+    const unsigned int magnitude = static_cast<unsigned int>(std::abs(value));
+
+    return magnitude == 0 ? 0 : 32 - static_cast<std::uint32_t>(__builtin_clz(magnitude));
+}
+
+/* Negative values are sent as value - 1 on size bits, so that their first bit is 0 */
+inline std::uint32_t transform_coding_extra(const int value, const std::uint32_t size) noexcept
+{
+    return static_cast<std::uint32_t>(value < 0 ? value + (1 << size) - 1 : value);
+}
+
+inline int transform_coding_extend(const std::uint32_t extra, const std::uint32_t size) noexcept
+{
+    if(size == 0)
+    {
+        return 0;
+    }
+
+    return extra < (1u << (size - 1)) ? static_cast<int>(extra) - (1 << size) + 1 : static_cast<int>(extra);
+}
+
+/* IJG scaling of the luminance table: 5000 / quality below 50, 200 - 2 * quality above, in percents */
+inline std::array<std::uint8_t, 64> transform_coding_quant_table(const int quality) noexcept
+{
+    const int q = std::clamp(quality, 1, 100);
+    const int scale = q < 50 ? 5000 / q : 200 - 2 * q;
+
+    std::array<std::uint8_t, 64> table;
+
+    for(std::size_t i = 0; i < 64; i++)
+    {
+        table[i] = static_cast<std::uint8_t>(std::clamp((TRANSFORM_CODING_LUMINANCE[i] * scale + 50) / 100, 1, 255));
+    }
+
+    return table;
+}
+
+/* Peak signal to noise ratio between two 8-bit images, in dB, infinity when they are equal */
+inline double transform_coding_psnr(const std::uint8_t* a,
+                                    const std::uint8_t* b,
+                                    const std::size_t width,
+                                    const std::size_t height,
+                                    const std::size_t stride) noexcept
+{
+    double squared_error = 0.0;
+
+    for(std::size_t y = 0; y < height; y++)
+    {
+        for(std::size_t x = 0; x < width; x++)
+        {
+            const double diff = static_cast<double>(a[y * stride + x]) - static_cast<double>(b[y * stride + x]);
+            squared_error += diff * diff;
+        }
+    }
+
+    if(squared_error == 0.0)
+    {
+        return std::numeric_limits<double>::infinity();
+    }
+
+    const double mse = squared_error / static_cast<double>(width * height);
+
+    return 10.0 * std::log10(255.0 * 255.0 / mse);
+}
+
+struct TransformCodedImage
+{
+    std::size_t width;
+    std::size_t height;
+
+    /* Natural order */
+    std::array<std::uint8_t, 64> quant;
+
+    /* Code lengths of the DC (sizes 0 to 15) and AC ((run << 4) | size) symbols */
+    std::vector<std::uint8_t> dc_lengths;
+    std::vector<std::uint8_t> ac_lengths;
+
+    /* Bitstream of each tile */
+    std::vector<std::vector<std::uint8_t>> tiles;
+
+    /*
+        Bytes of serialize(): width and height on 4 bytes each, the quantization table, each Huffman table as in
+        JPEG (number of codes of each length from 1 to 16, then the symbols), each tile with its size on 4 bytes.
+        Integers are big-endian like in JPEG, the number of tiles follows from the height.
+    */
+    std::size_t size() const noexcept
+    {
+        std::size_t bytes = 8 + 64;
+
+        for(const auto* lengths : { &this->dc_lengths, &this->ac_lengths })
+        {
+            bytes += HUFFMAN_MAX_LENGTH + static_cast<std::size_t>(std::count_if(lengths->begin(), lengths->end(), [](const std::uint8_t l) { return l != 0; }));
+        }
+
+        for(const auto& tile : this->tiles)
+        {
+            bytes += 4 + tile.size();
+        }
+
+        return bytes;
+    }
+
+    std::vector<std::uint8_t> serialize() const noexcept
+    {
+        std::vector<std::uint8_t> bytes;
+        bytes.reserve(this->size());
+
+        const auto put32 = [&](const std::size_t value) {
+            for(int shift = 24; shift >= 0; shift -= 8)
+            {
+                bytes.push_back(static_cast<std::uint8_t>(value >> shift));
+            }
+        };
+
+        put32(this->width);
+        put32(this->height);
+
+        bytes.insert(bytes.end(), this->quant.begin(), this->quant.end());
+
+        for(const auto* lengths : { &this->dc_lengths, &this->ac_lengths })
+        {
+            for(std::size_t length = 1; length <= HUFFMAN_MAX_LENGTH; length++)
+            {
+                bytes.push_back(static_cast<std::uint8_t>(std::count(lengths->begin(), lengths->end(), length)));
+            }
+
+            for(std::size_t length = 1; length <= HUFFMAN_MAX_LENGTH; length++)
+            {
+                for(std::size_t symbol = 0; symbol < lengths->size(); symbol++)
+                {
+                    if((*lengths)[symbol] == length)
+                    {
+                        bytes.push_back(static_cast<std::uint8_t>(symbol));
+                    }
+                }
+            }
+        }
+
+        for(const auto& tile : this->tiles)
+        {
+            put32(tile.size());
+            bytes.insert(bytes.end(), tile.begin(), tile.end());
+        }
+
+        return bytes;
+    }
+
+    /*
+        Reads what serialize() wrote. Returns false, and leaves the image in an unspecified state, when the
+        stream is truncated or too long, or a table is not a valid prefix code
+    */
+    bool deserialize(const std::uint8_t* data, const std::size_t size) noexcept
+    {
+        const std::uint8_t* end = data + size;
+
+        const auto get32 = [&](std::size_t& value) {
+            if(end - data < 4)
+            {
+                return false;
+            }
+
+            value = (std::size_t(data[0]) << 24) | (std::size_t(data[1]) << 16) | (std::size_t(data[2]) << 8) | std::size_t(data[3]);
+            data += 4;
+
+            return true;
+        };
+
+        if(!get32(this->width) || !get32(this->height) || end - data < 64)
+        {
+            return false;
+        }
+
+        std::copy(data, data + 64, this->quant.begin());
+        data += 64;
+
+        /* 0 would divide the coefficients by 0 in the encoder, it never writes it */
+        if(std::find(this->quant.begin(), this->quant.end(), 0) != this->quant.end())
+        {
+            return false;
+        }
+
+        for(auto [lengths, num_symbols] : { std::make_pair(&this->dc_lengths, std::size_t(16)),
+                                            std::make_pair(&this->ac_lengths, std::size_t(256)) })
+        {
+            if(end - data < static_cast<std::ptrdiff_t>(HUFFMAN_MAX_LENGTH))
+            {
+                return false;
+            }
+
+            const std::uint8_t* counts = data;
+            data += HUFFMAN_MAX_LENGTH;
+
+            lengths->assign(num_symbols, 0);
+
+            /* Kraft: the codes of each length must fit in what the shorter ones left */
+            std::size_t free_codes = 1;
+
+            for(std::size_t length = 1; length <= HUFFMAN_MAX_LENGTH; length++)
+            {
+                free_codes = 2 * free_codes;
+
+                if(counts[length - 1] > free_codes || end - data < counts[length - 1])
+                {
+                    return false;
+                }
+
+                free_codes -= counts[length - 1];
+
+                for(std::size_t i = 0; i < counts[length - 1]; i++)
+                {
+                    const std::uint8_t symbol = *data++;
+
+                    if(symbol >= num_symbols || (*lengths)[symbol] != 0)
+                    {
+                        return false;
+                    }
+
+                    (*lengths)[symbol] = static_cast<std::uint8_t>(length);
+                }
+            }
+        }
+
+        this->tiles.resize(transform_coding_num_tiles(this->width, this->height));
+
+        for(auto& tile : this->tiles)
+        {
+            std::size_t tile_size = 0;
+
+            if(!get32(tile_size) || static_cast<std::size_t>(end - data) < tile_size)
+            {
+                return false;
+            }
+
+            tile.assign(data, data + tile_size);
+            data += tile_size;
+        }
+
+        return data == end;
+    }
+};
+
+class TransformCoder
+{
+    /* Run-length symbol before entropy coding, followed by symbol & 15 extra bits */
+    struct Symbol
+    {
+        std::uint8_t symbol;
+        std::uint8_t ac;
+        std::uint16_t extra;
+    };
+
+    std::array<std::uint8_t, 64> _quant;
+
+    /* round(2^16 / quant), quantization by a multiply and a shift */
+    std::array<std::int32_t, 64> _reciprocal;
+
+    FFTThreadPool* _pool;
+    FFTSimd _simd;
+
+    /* Quantized coefficients of one block, in zig-zag order, to symbols given to emit(const Symbol&) */
+    template<typename Emit>
+    void _run_length(const std::int16_t* block, int& previous_dc, Emit& emit) const noexcept
+    {
+        /* Rounded to nearest, away from zero on ties, vectorized over the natural order */
+        std::int16_t quantized[64];
+
+        for(std::size_t i = 0; i < 64; i++)
+        {
+            const std::int32_t c = block[i];
+            const std::int32_t magnitude = ((c < 0 ? -c : c) * this->_reciprocal[i] + (1 << 15)) >> 16;
+
+            quantized[i] = static_cast<std::int16_t>(c < 0 ? -magnitude : magnitude);
+        }
+
+        const int diff = quantized[0] - previous_dc;
+        previous_dc = quantized[0];
+
+        const std::uint32_t dc_size = transform_coding_size(diff);
+
+        emit(Symbol{ static_cast<std::uint8_t>(dc_size), 0, static_cast<std::uint16_t>(transform_coding_extra(diff, dc_size)) });
+
+        std::uint32_t run = 0;
+
+        for(std::size_t k = 1; k < 64; k++)
+        {
+            const int value = quantized[TRANSFORM_CODING_ZIGZAG[k]];
+
+            if(value == 0)
+            {
+                run++;
+                continue;
+            }
+
+            while(run > 15)
+            {
+                emit(Symbol{ TRANSFORM_CODING_ZRL, 1, 0 });
+                run -= 16;
+            }
+
+            const std::uint32_t size = transform_coding_size(value);
+            const std::uint8_t symbol = static_cast<std::uint8_t>((run << 4) | size);
+
+            emit(Symbol{ symbol, 1, static_cast<std::uint16_t>(transform_coding_extra(value, size)) });
+
+            run = 0;
+        }
+
+        if(run > 0)
+        {
+            emit(Symbol{ TRANSFORM_CODING_EOB, 1, 0 });
+        }
+    }
+
+    /* Block rows of a tile through the DCT, the symbols of its blocks in order to emit */
+    template<typename Emit>
+    void _code_tile(const std::uint8_t* pixels,
+                    const std::size_t width,
+                    const std::size_t height,
+                    const std::size_t stride,
+                    const std::size_t tile,
+                    std::vector<std::int16_t>& blocks,
+                    Emit& emit) const noexcept
+    {
+        const std::size_t blocks_x = (width + 7) / 8;
+        const std::size_t blocks_y = (height + 7) / 8;
+
+        int previous_dc = 0;
+
+        const std::size_t by1 = std::min(blocks_y, (tile + 1) * TRANSFORM_CODING_TILE_ROWS);
+
+        for(std::size_t by = tile * TRANSFORM_CODING_TILE_ROWS; by < by1; by++)
+        {
+            dct8x8_load_block_row(pixels, width, height, stride, by, blocks.data());
+            dct8x8_forward(blocks.data(), blocks.data(), blocks_x, this->_simd);
+
+            for(std::size_t bx = 0; bx < blocks_x; bx++)
+            {
+                this->_run_length(blocks.data() + bx * 64, previous_dc, emit);
+            }
+        }
+    }
+
+public:
+    /* quality from 1 to 100, 50 is the table of Annex K */
+    explicit TransformCoder(const int quality = 75,
+                            FFTThreadPool& pool = fft_thread_pool(),
+                            const FFTSimd simd = fft_detect_simd()) : _quant(transform_coding_quant_table(quality)),
+                                                                      _pool(&pool),
+                                                                      _simd(simd)
+    {
+        for(std::size_t i = 0; i < 64; i++)
+        {
+            this->_reciprocal[i] = ((1 << 16) + this->_quant[i] / 2) / this->_quant[i];
+        }
+    }
+
+    const std::array<std::uint8_t, 64>& quant_table() const noexcept { return this->_quant; }
+
+    TransformCodedImage encode(const std::uint8_t* pixels,
+                               const std::size_t width,
+                               const std::size_t height,
+                               const std::size_t stride) const noexcept
+    {
+        TransformCodedImage image;
+        image.width = width;
+        image.height = height;
+        image.quant = this->_quant;
+
+        const std::size_t blocks_x = (width + 7) / 8;
+        const std::size_t num_tiles = transform_coding_num_tiles(width, height);
+
+        std::vector<std::array<std::size_t, 16>> dc_counts(num_tiles);
+        std::vector<std::array<std::size_t, 256>> ac_counts(num_tiles);
+
+        this->_pool->parallel_for(num_tiles, [&](const std::size_t tile, const std::size_t) {
+            std::vector<std::int16_t> blocks(blocks_x * 64);
+
+            dc_counts[tile].fill(0);
+            ac_counts[tile].fill(0);
+
+            auto count = [&](const Symbol& s) {
+                (s.ac ? ac_counts[tile].data() : dc_counts[tile].data())[s.symbol]++;
+            };
+
+            this->_code_tile(pixels, width, height, stride, tile, blocks, count);
+        });
+
+        std::vector<std::size_t> dc_total(16, 0);
+        std::vector<std::size_t> ac_total(256, 0);
+
+        for(std::size_t tile = 0; tile < num_tiles; tile++)
+        {
+            for(std::size_t s = 0; s < 16; s++)
+            {
+                dc_total[s] += dc_counts[tile][s];
+            }
+
+            for(std::size_t s = 0; s < 256; s++)
+            {
+                ac_total[s] += ac_counts[tile][s];
+            }
+        }
+
+        image.dc_lengths = huffman_code_lengths(dc_total, HUFFMAN_MAX_LENGTH);
+        image.ac_lengths = huffman_code_lengths(ac_total, HUFFMAN_MAX_LENGTH);
+
+        const HuffmanTable dc_table(image.dc_lengths);
+        const HuffmanTable ac_table(image.ac_lengths);
+
+        image.tiles.resize(num_tiles);
+
+        this->_pool->parallel_for(num_tiles, [&](const std::size_t tile, const std::size_t) {
+            std::vector<std::int16_t> blocks(blocks_x * 64);
+
+            HuffmanBitWriter writer(image.tiles[tile]);
+
+            auto write = [&](const Symbol& s) {
+                (s.ac ? ac_table : dc_table).encode(writer, s.symbol);
+                writer.put(s.extra, s.ac ? s.symbol & 15 : s.symbol);
+            };
+
+            this->_code_tile(pixels, width, height, stride, tile, blocks, write);
+
+            writer.flush();
+        });
+
+        return image;
+    }
+
+    /* pixels holds image.height rows of stride >= image.width bytes */
+    void decode(const TransformCodedImage& image, std::uint8_t* pixels, const std::size_t stride) const noexcept
+    {
+        const std::size_t width = image.width;
+        const std::size_t height = image.height;
+        const std::size_t blocks_x = (width + 7) / 8;
+        const std::size_t blocks_y = (height + 7) / 8;
+
+        const HuffmanTable dc_table(image.dc_lengths);
+        const HuffmanTable ac_table(image.ac_lengths);
+
+        this->_pool->parallel_for(image.tiles.size(), [&](const std::size_t tile, const std::size_t) {
+            std::vector<std::int16_t> blocks(blocks_x * 64);
+
+            HuffmanBitReader reader(image.tiles[tile].data(), image.tiles[tile].size());
+
+            int previous_dc = 0;
+
+            const std::size_t by1 = std::min(blocks_y, (tile + 1) * TRANSFORM_CODING_TILE_ROWS);
+
+            for(std::size_t by = tile * TRANSFORM_CODING_TILE_ROWS; by < by1; by++)
+            {
+                std::fill(blocks.begin(), blocks.end(), 0);
+
+                for(std::size_t bx = 0; bx < blocks_x; bx++)
+                {
+                    std::int16_t* block = blocks.data() + bx * 64;
+
+                    const std::uint32_t dc_size = dc_table.decode(reader);
+
+                    previous_dc += transform_coding_extend(reader.read(dc_size), dc_size);
+                    block[0] = static_cast<std::int16_t>(previous_dc * image.quant[0]);
+
+                    for(std::size_t k = 1; k < 64; k++)
+                    {
+                        const std::uint32_t symbol = ac_table.decode(reader);
+                        const std::uint32_t size = symbol & 15;
+
+                        if(size == 0)
+                        {
+                            if(symbol != TRANSFORM_CODING_ZRL)
+                            {
+                                break;
+                            }
+
+                            k += 15;
+                            continue;
+                        }
+
+                        k += symbol >> 4;
+
+                        if(k >= 64)
+                        {
+                            break;
+                        }
+
+                        const std::size_t i = TRANSFORM_CODING_ZIGZAG[k];
+
+                        block[i] = static_cast<std::int16_t>(transform_coding_extend(reader.read(size), size) * image.quant[i]);
+                    }
+                }
+
+                dct8x8_store_block_row(blocks.data(), pixels, width, height, stride, by, this->_simd);
+            }
+        });
+    }
+};